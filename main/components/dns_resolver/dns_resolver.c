@@ -0,0 +1,311 @@
+#include "dns_resolver.h"
+#include "dns_message.h"
+#include "lwip/sockets.h"
+#include "lwip/dns.h"
+#include "lwip/api.h"
+#include "lwip/ip_addr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+
+static const char *TAG = "DNS_RESOLVER";
+
+#define DNS_RESOLVER_PORT 53
+#define DNS_RESOLVER_TIMEOUT_MS 2000
+#define DNS_RESOLVER_RETRIES 2             // Tentatives par serveur
+#define DNS_RESOLVER_PACKET_SIZE 512
+
+// Bornes appliquées au TTL reçu: évite de réinterroger en boucle un TTL nul
+// et de garder une adresse trop longtemps si le serveur annonce un TTL énorme
+#define DNS_RESOLVER_MIN_TTL_SEC 10
+#define DNS_RESOLVER_MAX_TTL_SEC 3600
+
+typedef struct {
+    char host[DNS_RESOLVER_MAX_HOST_LEN];
+    uint8_t ip[4];
+    int64_t expires_us;             // 0 = entrée libre
+    uint32_t resolve_ms;            // Temps de la résolution amont d'origine
+} dns_resolver_entry_t;
+
+static dns_resolver_entry_t s_cache[DNS_RESOLVER_CACHE_SIZE];
+static dns_resolver_stats_t s_stats = {0};
+static SemaphoreHandle_t s_lock = NULL;
+static portMUX_TYPE s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void dns_resolver_lock(void)
+{
+    if (!s_lock) {
+        SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) {
+            s_lock = lock;
+            lock = NULL;
+        }
+        portEXIT_CRITICAL(&s_init_mux);
+        if (lock) {
+            vSemaphoreDelete(lock);
+        }
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void dns_resolver_unlock(void)
+{
+    xSemaphoreGive(s_lock);
+}
+
+static bool dns_resolver_is_server(const struct sockaddr_in *addr, const struct sockaddr_in *servers,
+                                   int server_count)
+{
+    for (int i = 0; i < server_count; i++) {
+        if (addr->sin_addr.s_addr == servers[i].sin_addr.s_addr && addr->sin_port == servers[i].sin_port) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Attend la réponse à la requête jusqu'au timeout du socket
+ * Les paquets d'une autre source ou qui ne reprennent pas l'ID et la question
+ * sont ignorés
+ */
+static esp_err_t dns_resolver_wait_response(int sock, const struct sockaddr_in *servers, int server_count,
+                                            const uint8_t *query, size_t query_len,
+                                            uint8_t ip[4], uint32_t *ttl)
+{
+    uint8_t buffer[DNS_RESOLVER_PACKET_SIZE];
+
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&from, &from_len);
+        if (len < 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (!dns_resolver_is_server(&from, servers, server_count)) {
+            continue;
+        }
+
+        esp_err_t ret = dns_message_parse_a_response(buffer, len, query, query_len, ip, ttl);
+        if (ret != ESP_ERR_INVALID_RESPONSE) {
+            return ret;
+        }
+    }
+}
+
+/**
+ * Interroge les serveurs DNS amont (configurés par DHCP) pour un enregistrement A
+ * Chaque tentative passe au serveur suivant: un primaire muet ou en échec
+ * (SERVFAIL, REFUSED...) ne coûte qu'une tentative avant le secondaire
+ */
+static esp_err_t dns_resolver_query_upstream(const char *host, uint8_t ip[4], uint32_t *ttl)
+{
+    struct sockaddr_in servers[DNS_MAX_SERVERS];
+    int server_count = 0;
+
+    for (int i = 0; i < DNS_MAX_SERVERS; i++) {
+        const ip_addr_t *server = dns_getserver(i);
+        if (server && IP_IS_V4(server) && !ip4_addr_isany_val(*ip_2_ip4(server))) {
+            servers[server_count++] = (struct sockaddr_in) {
+                .sin_family = AF_INET,
+                .sin_port = htons(DNS_RESOLVER_PORT),
+                .sin_addr.s_addr = ip4_addr_get_u32(ip_2_ip4(server)),
+            };
+        }
+    }
+    if (server_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t query[DNS_HEADER_SIZE + DNS_MAX_NAME_LEN + 4];
+    size_t query_len = dns_message_build_a_query(query, sizeof(query), (uint16_t)esp_random(), host);
+    if (query_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct timeval timeout = {
+        .tv_sec = DNS_RESOLVER_TIMEOUT_MS / 1000,
+        .tv_usec = (DNS_RESOLVER_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    for (int attempt = 0; attempt < DNS_RESOLVER_RETRIES * server_count; attempt++) {
+        const struct sockaddr_in *server = &servers[attempt % server_count];
+        if (sendto(sock, query, query_len, 0, (const struct sockaddr *)server, sizeof(*server)) < 0) {
+            ESP_LOGE(TAG, "sendto failed: errno %d", errno);
+            ret = ESP_FAIL;
+            continue;
+        }
+
+        ret = dns_resolver_wait_response(sock, servers, server_count, query, query_len, ip, ttl);
+        if (ret == ESP_OK || ret == ESP_ERR_NOT_FOUND) {
+            break;
+        }
+        ESP_LOGD(TAG, "Upstream server %d failed for %s: %s",
+                 attempt % server_count, host, esp_err_to_name(ret));
+    }
+
+    close(sock);
+    return ret;
+}
+
+/**
+ * Entrée où ranger une résolution, à choisir avec le verrou pris: celle du même
+ * nom si une autre tâche l'a déjà résolu, sinon celle qui expire le plus tôt
+ */
+static dns_resolver_entry_t *dns_resolver_pick_entry(const char *host)
+{
+    dns_resolver_entry_t *victim = &s_cache[0];
+
+    for (int i = 0; i < DNS_RESOLVER_CACHE_SIZE; i++) {
+        dns_resolver_entry_t *entry = &s_cache[i];
+        if (entry->expires_us != 0 && strcasecmp(entry->host, host) == 0) {
+            return entry;
+        }
+        if (entry->expires_us < victim->expires_us) {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+esp_err_t dns_resolver_lookup(const char *host, uint8_t ip[4])
+{
+    if (!host || !ip) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Nom absolu ("api.github.com."): même entrée de cache que sans le point final
+    char name[DNS_RESOLVER_MAX_HOST_LEN];
+    size_t host_len = strlen(host);
+    if (host_len > 1 && host[host_len - 1] == '.') {
+        host_len--;
+    }
+    if (host_len == 0 || host_len >= DNS_RESOLVER_MAX_HOST_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(name, host, host_len);
+    name[host_len] = '\0';
+
+    int64_t now = esp_timer_get_time();
+
+    dns_resolver_lock();
+    for (int i = 0; i < DNS_RESOLVER_CACHE_SIZE; i++) {
+        dns_resolver_entry_t *entry = &s_cache[i];
+        if (entry->expires_us > now && strcasecmp(entry->host, name) == 0) {
+            memcpy(ip, entry->ip, 4);
+            s_stats.hits++;
+            s_stats.saved_ms += entry->resolve_ms;
+            dns_resolver_unlock();
+            ESP_LOGD(TAG, "Cache hit: %s", name);
+            return ESP_OK;
+        }
+    }
+    s_stats.misses++;
+    dns_resolver_unlock();
+
+    // Résolution hors verrou: les autres tâches peuvent continuer à lire le cache
+    uint32_t ttl = 0;
+    esp_err_t ret = dns_resolver_query_upstream(name, ip, &ttl);
+    int64_t done = esp_timer_get_time();
+
+    if (ret != ESP_OK) {
+        dns_resolver_lock();
+        s_stats.failures++;
+        dns_resolver_unlock();
+        return ret;
+    }
+
+    if (ttl < DNS_RESOLVER_MIN_TTL_SEC) {
+        ttl = DNS_RESOLVER_MIN_TTL_SEC;
+    } else if (ttl > DNS_RESOLVER_MAX_TTL_SEC) {
+        ttl = DNS_RESOLVER_MAX_TTL_SEC;
+    }
+
+    uint32_t resolve_ms = (uint32_t)((done - now) / 1000);
+
+    // Le cache a pu changer pendant la requête amont: l'entrée est choisie maintenant
+    dns_resolver_lock();
+    dns_resolver_entry_t *entry = dns_resolver_pick_entry(name);
+    strcpy(entry->host, name);
+    memcpy(entry->ip, ip, 4);
+    entry->resolve_ms = resolve_ms;
+    entry->expires_us = done + (int64_t)ttl * 1000000;
+    dns_resolver_unlock();
+
+    ESP_LOGI(TAG, "Resolved %s -> %d.%d.%d.%d (TTL %" PRIu32 " s, %" PRIu32 " ms)",
+             name, ip[0], ip[1], ip[2], ip[3], ttl, resolve_ms);
+    return ESP_OK;
+}
+
+void dns_resolver_flush(void)
+{
+    dns_resolver_lock();
+    memset(s_cache, 0, sizeof(s_cache));
+    dns_resolver_unlock();
+}
+
+void dns_resolver_get_stats(dns_resolver_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    dns_resolver_lock();
+    *stats = s_stats;
+    dns_resolver_unlock();
+}
+
+/**
+ * Hook lwIP appelé par netconn_gethostbyname() (donc getaddrinfo) dans le
+ * contexte de la tâche appelante
+ * Retourne 1 si la résolution a été traitée ici, 0 pour laisser lwIP résoudre
+ */
+int lwip_hook_netconn_external_resolve(const char *name, ip_addr_t *addr, u8_t addrtype, err_t *err)
+{
+    if (addrtype != NETCONN_DNS_IPV4 && addrtype != NETCONN_DNS_IPV4_IPV6) {
+        return 0;
+    }
+
+    // Adresses littérales, noms courts et mDNS (.local): laisser lwIP les traiter
+    ip4_addr_t literal;
+    size_t name_len = strlen(name);
+    if (name_len > 1 && name[name_len - 1] == '.') {
+        name_len--;
+    }
+    if (ip4addr_aton(name, &literal) || memchr(name, '.', name_len) == NULL ||
+        (name_len > 6 && strncasecmp(name + name_len - 6, ".local", 6) == 0)) {
+        return 0;
+    }
+
+    uint8_t ip[4];
+    esp_err_t ret = dns_resolver_lookup(name, ip);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        // Réponse négative (NXDOMAIN ou NODATA): inutile de réinterroger via lwIP
+        *err = ERR_VAL;
+        return 1;
+    }
+    if (ret != ESP_OK) {
+        // Pas de serveur amont, échec des serveurs (SERVFAIL...) ou timeout:
+        // repli sur le résolveur lwIP
+        return 0;
+    }
+
+    IP_ADDR4(addr, ip[0], ip[1], ip[2], ip[3]);
+    *err = ERR_OK;
+    return 1;
+}
@@ -0,0 +1,49 @@
+#ifndef DNS_RESOLVER_H
+#define DNS_RESOLVER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#define DNS_RESOLVER_CACHE_SIZE 8
+#define DNS_RESOLVER_MAX_HOST_LEN 64
+
+/**
+ * @brief Métriques du cache de résolution
+ */
+typedef struct {
+    uint32_t hits;              // Résolutions servies depuis le cache
+    uint32_t misses;            // Résolutions envoyées au serveur DNS amont
+    uint32_t failures;          // Échecs de résolution amont (repli sur lwIP)
+    uint32_t saved_ms;          // Latence économisée (somme des temps de résolution évités)
+} dns_resolver_stats_t;
+
+/**
+ * @brief Résout un nom en IPv4 en passant par le cache
+ *
+ * En cas d'absence dans le cache, interroge directement les serveurs DNS
+ * configurés par DHCP (le secondaire si le primaire ne répond pas ou échoue)
+ * et conserve la réponse pendant son TTL.
+ * Appelé automatiquement par lwIP pour chaque getaddrinfo() (hook
+ * LWIP_HOOK_NETCONN_EXTERNAL_RESOLVE), donc aussi par esp_http_client.
+ *
+ * @param host Nom à résoudre (ex: "api.github.com")
+ * @param ip Adresse IPv4 résolue (ordre réseau)
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_STATE si aucun serveur DNS amont n'est configuré
+ *         ESP_ERR_NOT_FOUND si le nom n'existe pas ou n'a pas d'adresse IPv4
+ *         ESP_ERR_TIMEOUT ou ESP_FAIL si aucun serveur n'a répondu sur le fond
+ */
+esp_err_t dns_resolver_lookup(const char *host, uint8_t ip[4]);
+
+/**
+ * @brief Vide le cache (ex: changement de réseau)
+ */
+void dns_resolver_flush(void);
+
+/**
+ * @brief Récupère les métriques du cache
+ * @param stats Structure où copier les métriques
+ */
+void dns_resolver_get_stats(dns_resolver_stats_t *stats);
+
+#endif // DNS_RESOLVER_H
@@ -0,0 +1,461 @@
+#include "dns_message.h"
+#include <string.h>
+#include <ctype.h>
+
+// Bits des flags d'en-tête (RFC 1035 §4.1.1)
+#define DNS_FLAG_QR 0x8000
+#define DNS_FLAG_OPCODE_MASK 0x7800
+#define DNS_FLAG_TC 0x0200
+#define DNS_FLAG_RD 0x0100
+#define DNS_FLAG_RA 0x0080
+
+// Taille UDP annoncée dans notre OPT (on ne répond jamais au-delà de 512 octets)
+#define DNS_EDNS_UDP_SIZE 512
+#define DNS_EXT_RCODE_BADVERS 1
+
+// Taille fixe d'un RR après le nom: type(2) + classe(2) + TTL(4) + RDLENGTH(2)
+#define DNS_RR_FIXED_SIZE 10
+
+static inline uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void write_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static inline void write_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)(v & 0xFF);
+}
+
+/**
+ * Parcourt un nom encodé en labels à partir de off
+ * Retourne l'offset juste après le nom, ou 0 si le nom est invalide/tronqué
+ * (0 ne peut jamais être un offset valide puisque l'en-tête fait 12 octets)
+ */
+static size_t skip_name(const uint8_t *msg, size_t len, size_t off, bool allow_pointer)
+{
+    size_t name_len = 0;
+
+    while (off < len) {
+        uint8_t label = msg[off];
+
+        if (label == 0) {
+            return off + 1;
+        }
+
+        if ((label & 0xC0) == 0xC0) {
+            // Pointeur de compression: termine le nom, la cible a déjà été validée
+            if (!allow_pointer || off + 2 > len) {
+                return 0;
+            }
+            return off + 2;
+        }
+
+        if (label & 0xC0) {
+            // Types de labels étendus (0x40, 0x80) non supportés
+            return 0;
+        }
+
+        name_len += label + 1;
+        if (name_len > DNS_MAX_NAME_LEN) {
+            return 0;
+        }
+        off += label + 1;
+    }
+
+    return 0;
+}
+
+esp_err_t dns_message_parse_query(const uint8_t *msg, size_t len, dns_query_t *query)
+{
+    if (!msg || !query) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (len < DNS_HEADER_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(query, 0, sizeof(dns_query_t));
+    query->id = read_u16(msg);
+    query->flags = read_u16(msg + 2);
+    query->qdcount = read_u16(msg + 4);
+
+    uint16_t ancount = read_u16(msg + 6);
+    uint16_t nscount = read_u16(msg + 8);
+    uint16_t arcount = read_u16(msg + 10);
+
+    if (query->flags & DNS_FLAG_QR) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (query->flags & DNS_FLAG_OPCODE_MASK) {
+        // Seul l'opcode QUERY (0) est supporté
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (query->qdcount == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Première question: pas de pointeur possible, rien ne la précède
+    size_t off = skip_name(msg, len, DNS_HEADER_SIZE, false);
+    if (off == 0 || off + 4 > len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    query->qname_len = off - DNS_HEADER_SIZE;
+    query->qtype = read_u16(msg + off);
+    query->qclass = read_u16(msg + off + 2);
+    off += 4;
+    query->question_end = off;
+
+    // Questions supplémentaires: validées puis ignorées (on ne répond qu'à la première)
+    for (uint16_t i = 1; i < query->qdcount; i++) {
+        off = skip_name(msg, len, off, true);
+        if (off == 0 || off + 4 > len) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        off += 4;
+    }
+
+    // Sections answer/authority/additional: on cherche uniquement l'OPT
+    uint32_t rr_count = (uint32_t)ancount + nscount + arcount;
+    for (uint32_t i = 0; i < rr_count; i++) {
+        size_t name_start = off;
+        off = skip_name(msg, len, off, true);
+        if (off == 0 || off + DNS_RR_FIXED_SIZE > len) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uint16_t type = read_u16(msg + off);
+        uint16_t rdlength = read_u16(msg + off + 8);
+
+        if (type == DNS_TYPE_OPT) {
+            // OPT: nom racine, uniquement dans la section additional, une seule fois
+            bool in_additional = i >= (uint32_t)ancount + nscount;
+            if (!in_additional || query->has_edns || msg[name_start] != 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            query->has_edns = true;
+            query->edns_udp_size = read_u16(msg + off + 2);
+            query->edns_version = msg[off + 5];
+        }
+
+        off += DNS_RR_FIXED_SIZE;
+        if (off + rdlength > len) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        off += rdlength;
+    }
+
+    return ESP_OK;
+}
+
+void dns_message_begin_response(dns_writer_t *writer, uint8_t *buf, size_t size,
+                                const dns_query_t *query, uint8_t rcode)
+{
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = query->question_end;
+    writer->ancount = 0;
+    writer->overflow = query->question_end > size;
+
+    if (writer->overflow) {
+        return;
+    }
+
+    // L'ID et la première question sont déjà en place dans le buffer
+    uint16_t flags = DNS_FLAG_QR | (query->flags & DNS_FLAG_RD) | DNS_FLAG_RA | (rcode & 0x0F);
+    write_u16(buf + 2, flags);
+    write_u16(buf + 4, 1);
+    write_u16(buf + 6, 0);
+    write_u16(buf + 8, 0);
+    write_u16(buf + 10, 0);
+}
+
+static uint8_t *writer_reserve(dns_writer_t *writer, size_t n)
+{
+    if (writer->overflow || writer->len + n > writer->size) {
+        writer->overflow = true;
+        return NULL;
+    }
+
+    uint8_t *p = writer->buf + writer->len;
+    writer->len += n;
+    return p;
+}
+
+void dns_message_add_a(dns_writer_t *writer, const uint8_t ip[4], uint32_t ttl)
+{
+    uint8_t *p = writer_reserve(writer, 2 + DNS_RR_FIXED_SIZE + 4);
+    if (!p) {
+        return;
+    }
+
+    // Pointeur vers le nom de la question (offset 12)
+    p[0] = 0xC0;
+    p[1] = DNS_HEADER_SIZE;
+    write_u16(p + 2, DNS_TYPE_A);
+    write_u16(p + 4, DNS_CLASS_IN);
+    write_u32(p + 6, ttl);
+    write_u16(p + 10, 4);
+    memcpy(p + 12, ip, 4);
+
+    writer->ancount++;
+}
+
+size_t dns_message_encode_name(uint8_t *out, size_t size, const char *name)
+{
+    size_t name_len = strlen(name);
+    // Nom absolu ("api.github.com."): le point final est le label racine
+    if (name_len > 1 && name[name_len - 1] == '.') {
+        name_len--;
+    }
+    // Un octet de longueur par label + label final vide
+    size_t wire_len = name_len + 2;
+    if (name_len == 0 || wire_len > DNS_MAX_NAME_LEN || wire_len > size) {
+        return 0;
+    }
+
+    uint8_t *label_len = out;
+    uint8_t *p = out + 1;
+    *label_len = 0;
+    for (const char *c = name; c < name + name_len; c++) {
+        if (*c == '.') {
+            if (*label_len == 0) {
+                return 0;
+            }
+            label_len = p++;
+            *label_len = 0;
+        } else {
+            if (*label_len == DNS_MAX_LABEL_LEN) {
+                return 0;
+            }
+            *p++ = (uint8_t)*c;
+            (*label_len)++;
+        }
+    }
+    if (*label_len == 0) {
+        return 0;
+    }
+    *p = 0;
+
+    return wire_len;
+}
+
+void dns_message_add_ptr(dns_writer_t *writer, const char *name, uint32_t ttl)
+{
+    size_t header_len = 2 + DNS_RR_FIXED_SIZE;
+    uint8_t *p = writer_reserve(writer, header_len);
+    if (!p) {
+        return;
+    }
+
+    size_t rdlength = dns_message_encode_name(p + header_len, writer->size - writer->len, name);
+    if (rdlength == 0) {
+        writer->overflow = true;
+        return;
+    }
+    writer->len += rdlength;
+
+    p[0] = 0xC0;
+    p[1] = DNS_HEADER_SIZE;
+    write_u16(p + 2, DNS_TYPE_PTR);
+    write_u16(p + 4, DNS_CLASS_IN);
+    write_u32(p + 6, ttl);
+    write_u16(p + 10, (uint16_t)rdlength);
+
+    writer->ancount++;
+}
+
+uint32_t dns_message_qname_hash(const uint8_t *msg, const dns_query_t *query)
+{
+    // FNV-1a 32 bits, les octets de longueur (< 64) ne sont pas affectés par tolower
+    uint32_t hash = 2166136261u;
+    const uint8_t *p = msg + DNS_HEADER_SIZE;
+
+    for (size_t i = 0; i < query->qname_len; i++) {
+        hash ^= (uint8_t)tolower(p[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+bool dns_message_qname_equals(const uint8_t *msg, const dns_query_t *query, const char *name)
+{
+    const uint8_t *p = msg + DNS_HEADER_SIZE;
+    const uint8_t *end = p + query->qname_len;
+
+    while (p < end && *p != 0) {
+        uint8_t label = *p++;
+        for (uint8_t i = 0; i < label; i++) {
+            if (*name == '\0' || tolower(p[i]) != tolower((unsigned char)*name)) {
+                return false;
+            }
+            name++;
+        }
+        p += label;
+
+        if (*p != 0) {
+            if (*name != '.') {
+                return false;
+            }
+            name++;
+        }
+    }
+
+    return *name == '\0';
+}
+
+size_t dns_message_finish(dns_writer_t *writer, const dns_query_t *query)
+{
+    uint16_t arcount = 0;
+
+    if (query->has_edns) {
+        // Écho d'un OPT minimal: taille UDP, code étendu, version 0, aucun flag
+        uint8_t *p = writer_reserve(writer, 1 + DNS_RR_FIXED_SIZE);
+        if (p) {
+            uint8_t ext_rcode = (query->edns_version != 0) ? DNS_EXT_RCODE_BADVERS : 0;
+            p[0] = 0;
+            write_u16(p + 1, DNS_TYPE_OPT);
+            write_u16(p + 3, DNS_EDNS_UDP_SIZE);
+            write_u32(p + 5, (uint32_t)ext_rcode << 24);
+            write_u16(p + 9, 0);
+            arcount = 1;
+        }
+    }
+
+    if (writer->overflow) {
+        return 0;
+    }
+
+    write_u16(writer->buf + 6, writer->ancount);
+    write_u16(writer->buf + 10, arcount);
+    return writer->len;
+}
+
+size_t dns_message_build_error(uint8_t *buf, size_t len, uint8_t rcode)
+{
+    if (len < DNS_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint16_t flags = read_u16(buf + 2);
+    flags = DNS_FLAG_QR | (flags & (DNS_FLAG_OPCODE_MASK | DNS_FLAG_RD)) | (rcode & 0x0F);
+    write_u16(buf + 2, flags);
+    write_u16(buf + 4, 0);
+    write_u16(buf + 6, 0);
+    write_u16(buf + 8, 0);
+    write_u16(buf + 10, 0);
+
+    return DNS_HEADER_SIZE;
+}
+
+size_t dns_message_build_a_query(uint8_t *buf, size_t size, uint16_t id, const char *name)
+{
+    if (size < DNS_HEADER_SIZE + 4) {
+        return 0;
+    }
+
+    memset(buf, 0, DNS_HEADER_SIZE);
+    write_u16(buf, id);
+    write_u16(buf + 2, DNS_FLAG_RD);
+    write_u16(buf + 4, 1);
+
+    size_t name_len = dns_message_encode_name(buf + DNS_HEADER_SIZE, size - DNS_HEADER_SIZE - 4, name);
+    if (name_len == 0) {
+        return 0;
+    }
+
+    size_t off = DNS_HEADER_SIZE + name_len;
+    write_u16(buf + off, DNS_TYPE_A);
+    write_u16(buf + off + 2, DNS_CLASS_IN);
+    return off + 4;
+}
+
+esp_err_t dns_message_parse_a_response(const uint8_t *msg, size_t len, const uint8_t *query,
+                                       size_t query_len, uint8_t ip[4], uint32_t *ttl)
+{
+    if (len < DNS_HEADER_SIZE || query_len < DNS_HEADER_SIZE + 5 || memcmp(msg, query, 2) != 0) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    uint16_t flags = read_u16(msg + 2);
+    uint16_t qdcount = read_u16(msg + 4);
+    uint8_t rcode = flags & 0x0F;
+    if (!(flags & DNS_FLAG_QR)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (qdcount == 0 && rcode != DNS_RCODE_NOERROR) {
+        // Une erreur (FORMERR, NOTIMP...) peut ne pas reprendre la question
+        return ESP_FAIL;
+    }
+    if (qdcount != 1 || len < query_len) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // La question doit être celle envoyée: nom insensible à la casse, type et classe exacts
+    size_t qtype_off = query_len - 4;
+    for (size_t i = DNS_HEADER_SIZE; i < qtype_off; i++) {
+        if (tolower(msg[i]) != tolower(query[i])) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    if (memcmp(msg + qtype_off, query + qtype_off, 4) != 0) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (rcode == DNS_RCODE_NXDOMAIN) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (rcode != DNS_RCODE_NOERROR) {
+        // SERVFAIL, REFUSED...: le serveur n'a pas répondu sur le fond
+        return ESP_FAIL;
+    }
+
+    uint16_t ancount = read_u16(msg + 6);
+    size_t off = query_len;
+
+    uint32_t min_ttl = UINT32_MAX;
+    for (uint16_t i = 0; i < ancount; i++) {
+        off = skip_name(msg, len, off, true);
+        if (off == 0 || off + DNS_RR_FIXED_SIZE > len) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        uint16_t type = read_u16(msg + off);
+        uint16_t rrclass = read_u16(msg + off + 2);
+        uint32_t rr_ttl = ((uint32_t)read_u16(msg + off + 4) << 16) | read_u16(msg + off + 6);
+        uint16_t rdlength = read_u16(msg + off + 8);
+        off += DNS_RR_FIXED_SIZE;
+        if (off + rdlength > len) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        if (rrclass == DNS_CLASS_IN && (type == DNS_TYPE_CNAME || type == DNS_TYPE_A)) {
+            if (rr_ttl < min_ttl) {
+                min_ttl = rr_ttl;
+            }
+            if (type == DNS_TYPE_A && rdlength == 4) {
+                memcpy(ip, msg + off, 4);
+                *ttl = min_ttl;
+                return ESP_OK;
+            }
+        }
+
+        off += rdlength;
+    }
+
+    // NODATA, sauf si la réponse a été tronquée avant l'adresse
+    return (flags & DNS_FLAG_TC) ? ESP_FAIL : ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,184 @@
+#ifndef DNS_MESSAGE_H
+#define DNS_MESSAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define DNS_HEADER_SIZE 12
+#define DNS_MAX_NAME_LEN 255
+#define DNS_MAX_LABEL_LEN 63
+
+// Types de requêtes (RFC 1035, RFC 3596, RFC 9460)
+#define DNS_TYPE_A 1
+#define DNS_TYPE_CNAME 5
+#define DNS_TYPE_PTR 12
+#define DNS_TYPE_AAAA 28
+#define DNS_TYPE_OPT 41
+#define DNS_TYPE_HTTPS 65
+#define DNS_CLASS_IN 1
+
+// Codes de réponse
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_FORMERR 1
+#define DNS_RCODE_SERVFAIL 2
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_NOTIMP 4
+#define DNS_RCODE_REFUSED 5
+
+/**
+ * @brief Résultat du parsing d'une requête DNS
+ * Tous les offsets pointent dans le buffer reçu (aucune copie)
+ */
+typedef struct {
+    uint16_t id;                // Identifiant de la requête
+    uint16_t flags;             // Flags de la requête (ordre hôte)
+    uint16_t qdcount;           // Nombre de questions annoncées
+    uint16_t qtype;             // Type de la première question
+    uint16_t qclass;            // Classe de la première question
+    size_t qname_len;           // Longueur wire du QNAME (label final inclus)
+    size_t question_end;        // Offset de fin de la première question
+    bool has_edns;              // True si un enregistrement OPT est présent
+    uint8_t edns_version;       // Version EDNS demandée
+    uint16_t edns_udp_size;     // Taille UDP annoncée par le client
+} dns_query_t;
+
+/**
+ * @brief Writer de réponse construit directement dans le buffer d'envoi
+ */
+typedef struct {
+    uint8_t *buf;               // Buffer de sortie (contient déjà la requête)
+    size_t size;                // Taille totale du buffer
+    size_t len;                 // Longueur écrite
+    uint16_t ancount;           // Nombre de réponses ajoutées
+    bool overflow;              // True si une écriture a dépassé le buffer
+} dns_writer_t;
+
+/**
+ * @brief Parse une requête DNS sans copie
+ *
+ * Parcourt les labels du QNAME de la première question en vérifiant les bornes,
+ * puis les sections suivantes pour détecter un enregistrement OPT (EDNS0).
+ *
+ * @param msg Paquet reçu
+ * @param len Longueur du paquet
+ * @param query Structure remplie avec le résultat
+ * @return ESP_OK si la requête est valide
+ *         ESP_ERR_INVALID_SIZE si le paquet est tronqué
+ *         ESP_ERR_INVALID_RESPONSE si le paquet est une réponse (QR=1)
+ *         ESP_ERR_INVALID_ARG si le paquet est malformé (FORMERR)
+ */
+esp_err_t dns_message_parse_query(const uint8_t *msg, size_t len, dns_query_t *query);
+
+/**
+ * @brief Commence une réponse en place à partir de la requête parsée
+ *
+ * Réécrit l'en-tête, conserve uniquement la première question et tronque le
+ * reste du paquet. Les enregistrements sont ensuite ajoutés à la suite.
+ *
+ * @param writer Writer à initialiser
+ * @param buf Buffer contenant la requête (réutilisé pour la réponse)
+ * @param size Taille totale du buffer
+ * @param query Requête parsée
+ * @param rcode Code de réponse
+ */
+void dns_message_begin_response(dns_writer_t *writer, uint8_t *buf, size_t size,
+                                const dns_query_t *query, uint8_t rcode);
+
+/**
+ * @brief Ajoute une réponse de type A pointant sur la question (compression 0xC00C)
+ * @param writer Writer de réponse
+ * @param ip Adresse IPv4 (4 octets, ordre réseau)
+ * @param ttl TTL en secondes
+ */
+void dns_message_add_a(dns_writer_t *writer, const uint8_t ip[4], uint32_t ttl);
+
+/**
+ * @brief Ajoute une réponse de type PTR pointant sur la question
+ * @param writer Writer de réponse
+ * @param name Nom cible en notation pointée (ex: "miniot.local")
+ * @param ttl TTL en secondes
+ */
+void dns_message_add_ptr(dns_writer_t *writer, const char *name, uint32_t ttl);
+
+/**
+ * @brief Encode un nom en notation pointée au format wire (labels)
+ * @param out Buffer de sortie
+ * @param size Taille du buffer de sortie
+ * @param name Nom à encoder (ex: "captive.apple.com", ou "captive.apple.com." absolu)
+ * @return Longueur encodée (label final inclus), 0 si le nom est invalide ou trop long
+ */
+size_t dns_message_encode_name(uint8_t *out, size_t size, const char *name);
+
+/**
+ * @brief Calcule le hash (FNV-1a, insensible à la casse) du QNAME de la requête
+ * @param msg Paquet contenant la requête
+ * @param query Requête parsée
+ * @return Hash du QNAME
+ */
+uint32_t dns_message_qname_hash(const uint8_t *msg, const dns_query_t *query);
+
+/**
+ * @brief Compare le QNAME de la requête à un nom en notation pointée
+ * La comparaison est insensible à la casse (RFC 4343)
+ * @param msg Paquet contenant la requête
+ * @param query Requête parsée
+ * @param name Nom à comparer (ex: "1.4.168.192.in-addr.arpa")
+ * @return true si les noms sont identiques
+ */
+bool dns_message_qname_equals(const uint8_t *msg, const dns_query_t *query, const char *name);
+
+/**
+ * @brief Termine la réponse: compteurs d'en-tête et OPT si le client utilise EDNS
+ * @param writer Writer de réponse
+ * @param query Requête parsée
+ * @return Longueur du paquet à envoyer, 0 si le buffer a débordé
+ */
+size_t dns_message_finish(dns_writer_t *writer, const dns_query_t *query);
+
+/**
+ * @brief Construit une réponse d'erreur minimale (en-tête seul)
+ *
+ * Utilisé quand la question n'a pas pu être parsée (FORMERR) : seul l'ID et
+ * l'opcode de la requête sont repris.
+ *
+ * @param buf Buffer contenant la requête
+ * @param len Longueur de la requête (au moins DNS_HEADER_SIZE)
+ * @param rcode Code de réponse
+ * @return Longueur du paquet à envoyer, 0 si la requête est trop courte
+ */
+size_t dns_message_build_error(uint8_t *buf, size_t len, uint8_t rcode);
+
+/**
+ * @brief Construit une requête récursive (RD) de type A pour un nom
+ * @param buf Buffer de sortie
+ * @param size Taille du buffer
+ * @param id Identifiant de la requête
+ * @param name Nom à résoudre en notation pointée
+ * @return Longueur de la requête, 0 si le nom est invalide ou trop long
+ */
+size_t dns_message_build_a_query(uint8_t *buf, size_t size, uint16_t id, const char *name);
+
+/**
+ * @brief Extrait la première adresse A d'une réponse
+ *
+ * Le TTL retourné est le minimum de la chaîne (CNAME inclus) pour ne jamais
+ * garder l'adresse plus longtemps que l'enregistrement le plus court.
+ *
+ * @param msg Paquet reçu
+ * @param len Longueur du paquet
+ * @param query Requête envoyée (dns_message_build_a_query), dont l'ID et la
+ *              question doivent se retrouver dans la réponse
+ * @param query_len Longueur de la requête
+ * @param ip Adresse IPv4 trouvée (ordre réseau)
+ * @param ttl TTL en secondes
+ * @return ESP_OK si une adresse a été trouvée
+ *         ESP_ERR_INVALID_RESPONSE si le paquet n'est pas la réponse attendue
+ *         ESP_ERR_NOT_FOUND si le nom n'existe pas (NXDOMAIN) ou n'a pas d'adresse A (NODATA)
+ *         ESP_FAIL si le serveur a échoué (SERVFAIL, REFUSED...) ou tronqué sa réponse
+ */
+esp_err_t dns_message_parse_a_response(const uint8_t *msg, size_t len, const uint8_t *query,
+                                       size_t query_len, uint8_t ip[4], uint32_t *ttl);
+
+#endif // DNS_MESSAGE_H
@@ -1,7 +1,11 @@
 #include "dns_server.h"
+#include "dns_message.h"
+#include "mdns_service.h"
+#include "net_reactor.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -10,117 +14,326 @@ static const char *TAG = "DNS_SERVER";
 
 #define DNS_SERVER_PORT 53
 #define DNS_MAX_PACKET_SIZE 512
-#define DNS_QUERY_FLAG 0x0100
-#define DNS_RESPONSE_FLAG 0x8180
-#define DNS_QR_QUERY 0
-#define DNS_QR_RESPONSE 1
+#define DNS_ANSWER_TTL 60
+
+// Nom retourné pour la résolution inverse de l'IP de l'AP
+#define DNS_PTR_HOSTNAME MDNS_HOSTNAME ".local"
+#define DNS_AP_REVERSE_NAME "1.4.168.192.in-addr.arpa"
 
 static int s_dns_socket = -1;
-static TaskHandle_t s_dns_task_handle = NULL;
 static bool s_running = false;
+static dns_server_stats_t s_stats = {0};
+
+// IP de l'AP (192.168.4.1), ordre réseau
+static const uint8_t s_ap_ip[4] = {192, 168, 4, 1};
+
+// Cache des noms de détection de portail captif: réponses A précalculées
+#define DNS_HOT_CACHE_SLOTS 32          // Puissance de 2, facteur de charge < 0.5
+#define DNS_HOT_TEMPLATE_SIZE 112       // En-tête + question + réponse A + OPT
+#define DNS_HOT_SLOT_EMPTY 0xFF
+#define DNS_OPT_RECORD_SIZE 11
+
+static const char *const s_hot_names[] = {
+    "connectivitycheck.gstatic.com",
+    "connectivitycheck.android.com",
+    "clients3.google.com",
+    "clients1.google.com",
+    "www.google.com",
+    "captive.apple.com",
+    "www.apple.com",
+    "www.appleiphonecell.com",
+    "www.msftconnecttest.com",
+    "www.msftncsi.com",
+    "detectportal.firefox.com",
+    "nmcheck.gnome.org",
+    "connectivity-check.ubuntu.com",
+};
+
+#define DNS_HOT_NAMES_COUNT (sizeof(s_hot_names) / sizeof(s_hot_names[0]))
+
+typedef struct {
+    uint32_t hash;                  // Hash du QNAME (insensible à la casse)
+    uint16_t qname_len;             // Longueur wire du QNAME
+    uint16_t len;                   // Longueur de la réponse avec OPT
+    uint8_t response[DNS_HOT_TEMPLATE_SIZE];
+} dns_hot_entry_t;
+
+static dns_hot_entry_t s_hot_entries[DNS_HOT_NAMES_COUNT];
+static uint8_t s_hot_slots[DNS_HOT_CACHE_SLOTS];
+static bool s_hot_cache_ready = false;
+
+/**
+ * Précalcule les réponses A des noms les plus demandés
+ * Chaque template contient un OPT final, retiré à l'envoi si le client n'utilise pas EDNS
+ */
+static void dns_hot_cache_init(void)
+{
+    memset(s_hot_slots, DNS_HOT_SLOT_EMPTY, sizeof(s_hot_slots));
+
+    for (size_t i = 0; i < DNS_HOT_NAMES_COUNT; i++) {
+        dns_hot_entry_t *entry = &s_hot_entries[i];
+        uint8_t *buf = entry->response;
+
+        // Requête synthétique: en-tête (RD) + question A/IN, puis réponse en place
+        memset(buf, 0, DNS_HEADER_SIZE);
+        buf[2] = 0x01;
+        buf[5] = 1;
+        size_t qname_len = dns_message_encode_name(buf + DNS_HEADER_SIZE,
+                                                   DNS_HOT_TEMPLATE_SIZE - DNS_HEADER_SIZE - 4,
+                                                   s_hot_names[i]);
+        if (qname_len == 0) {
+            ESP_LOGW(TAG, "Hot name too long, skipped: %s", s_hot_names[i]);
+            continue;
+        }
 
-// Structure DNS Header (12 octets)
-typedef struct __attribute__((packed)) {
-    uint16_t id;           // Identification
-    uint16_t flags;        // Flags
-    uint16_t qdcount;      // Number of questions
-    uint16_t ancount;      // Number of answers
-    uint16_t nscount;      // Number of authority records
-    uint16_t arcount;      // Number of additional records
-} dns_header_t;
+        size_t off = DNS_HEADER_SIZE + qname_len;
+        buf[off++] = 0;
+        buf[off++] = DNS_TYPE_A;
+        buf[off++] = 0;
+        buf[off++] = DNS_CLASS_IN;
 
-// IP de l'AP (192.168.4.1)
-#define AP_IP_ADDR 0x0104A8C0  // 192.168.4.1 en little-endian
+        dns_query_t query;
+        if (dns_message_parse_query(buf, off, &query) != ESP_OK) {
+            continue;
+        }
+        query.has_edns = true;
+
+        dns_writer_t writer;
+        dns_message_begin_response(&writer, buf, DNS_HOT_TEMPLATE_SIZE, &query, DNS_RCODE_NOERROR);
+        dns_message_add_a(&writer, s_ap_ip, DNS_ANSWER_TTL);
+        size_t len = dns_message_finish(&writer, &query);
+        if (len == 0) {
+            continue;
+        }
+
+        entry->hash = dns_message_qname_hash(buf, &query);
+        entry->qname_len = (uint16_t)qname_len;
+        entry->len = (uint16_t)len;
+
+        // Insertion par sondage linéaire
+        uint32_t slot = entry->hash & (DNS_HOT_CACHE_SLOTS - 1);
+        while (s_hot_slots[slot] != DNS_HOT_SLOT_EMPTY) {
+            slot = (slot + 1) & (DNS_HOT_CACHE_SLOTS - 1);
+        }
+        s_hot_slots[slot] = (uint8_t)i;
+    }
+
+    s_hot_cache_ready = true;
+    ESP_LOGI(TAG, "Hot-name cache ready (%d names)", (int)DNS_HOT_NAMES_COUNT);
+}
 
-static void dns_server_task(void *pvParameters)
+/**
+ * Cherche une réponse précalculée pour une requête A/IN
+ * Le QNAME doit correspondre octet pour octet (casse incluse, cf. 0x20) pour que la
+ * question renvoyée soit identique à celle du client.
+ * Seuls l'ID, le bit RD et ARCOUNT sont patchés dans le template.
+ */
+static size_t dns_hot_cache_lookup(const uint8_t *buf, const dns_query_t *query,
+                                   const uint8_t **response)
 {
-    char rx_buffer[DNS_MAX_PACKET_SIZE];
-    char tx_buffer[DNS_MAX_PACKET_SIZE];
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
-
-    ESP_LOGI(TAG, "DNS server task started");
-
-    while (s_running) {
-        // Recevoir une requête DNS
-        int len = recvfrom(s_dns_socket, rx_buffer, sizeof(rx_buffer) - 1, 0,
-                          (struct sockaddr *)&source_addr, &socklen);
-
-        if (len < 0) {
-            if (s_running) {
-                ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            }
+    uint32_t hash = dns_message_qname_hash(buf, query);
+    uint32_t slot = hash & (DNS_HOT_CACHE_SLOTS - 1);
+
+    for (int probes = 0; probes < DNS_HOT_CACHE_SLOTS; probes++) {
+        uint8_t index = s_hot_slots[slot];
+        if (index == DNS_HOT_SLOT_EMPTY) {
             break;
         }
 
-        if (len < sizeof(dns_header_t)) {
-            ESP_LOGW(TAG, "Received packet too small");
-            continue;
+        dns_hot_entry_t *entry = &s_hot_entries[index];
+        if (entry->hash == hash && entry->qname_len == query->qname_len &&
+            memcmp(entry->response + DNS_HEADER_SIZE, buf + DNS_HEADER_SIZE, query->qname_len) == 0) {
+            uint8_t *tpl = entry->response;
+            tpl[0] = buf[0];
+            tpl[1] = buf[1];
+            tpl[2] = (tpl[2] & ~0x01) | (buf[2] & 0x01);
+            tpl[11] = query->has_edns ? 1 : 0;
+            *response = tpl;
+            return query->has_edns ? entry->len : entry->len - DNS_OPT_RECORD_SIZE;
         }
 
-        dns_header_t *header = (dns_header_t *)rx_buffer;
+        slot = (slot + 1) & (DNS_HOT_CACHE_SLOTS - 1);
+    }
 
-        // Vérifier que c'est une requête (pas une réponse)
-        if ((ntohs(header->flags) & 0x8000) != 0) {
-            continue;  // C'est une réponse, on ignore
-        }
+    return 0;
+}
 
-        ESP_LOGD(TAG, "DNS query received, ID: 0x%04X", ntohs(header->id));
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT
+// Token bucket par IP source, en milli-jetons pour rester en arithmétique entière
+#define DNS_RL_TOKEN_COST 1000
+#define DNS_RL_BUCKET_MAX (CONFIG_MINIOT_DNS_RATE_LIMIT_BURST * DNS_RL_TOKEN_COST)
 
-        // Préparer la réponse
-        memcpy(tx_buffer, rx_buffer, len);
-        dns_header_t *response_header = (dns_header_t *)tx_buffer;
+typedef struct {
+    uint32_t addr;                  // IP source (ordre réseau), 0 = entrée libre
+    uint32_t last_ms;               // Dernier passage (sert aussi à l'éviction LRU)
+    uint32_t tokens;                // Milli-jetons disponibles
+} dns_rl_client_t;
 
-        // Modifier les flags pour une réponse
-        response_header->flags = htons(DNS_RESPONSE_FLAG);
-        response_header->ancount = htons(1);  // 1 réponse
-        response_header->nscount = 0;
-        response_header->arcount = 0;
+static dns_rl_client_t s_rl_clients[CONFIG_MINIOT_DNS_RATE_LIMIT_CLIENTS];
 
-        // Ajouter la réponse DNS (pointeur vers la question + type A + classe IN + TTL + IP)
-        int response_len = len;
+/**
+ * Consomme un jeton pour ce client
+ * Retourne false si le client a dépassé sa limite
+ */
+static bool dns_rate_limit_allow(uint32_t addr)
+{
+    uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    dns_rl_client_t *client = NULL;
+    dns_rl_client_t *oldest = &s_rl_clients[0];
+
+    for (int i = 0; i < CONFIG_MINIOT_DNS_RATE_LIMIT_CLIENTS; i++) {
+        dns_rl_client_t *entry = &s_rl_clients[i];
+        if (entry->addr == addr) {
+            client = entry;
+            break;
+        }
+        if (entry->addr == 0 || (oldest->addr != 0 && now_ms - entry->last_ms > now_ms - oldest->last_ms)) {
+            oldest = entry;
+        }
+    }
 
-        // Pointeur vers le nom de domaine dans la question (compression DNS)
-        tx_buffer[response_len++] = 0xC0;  // Pointeur
-        tx_buffer[response_len++] = 0x0C;  // Offset vers la question (12 octets après le début)
+    if (!client) {
+        // Nouveau client: remplace l'entrée libre ou la moins récemment vue
+        client = oldest;
+        client->addr = addr;
+        client->last_ms = now_ms;
+        client->tokens = DNS_RL_BUCKET_MAX;
+    }
 
-        // Type A (IPv4)
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x01;
+    uint32_t elapsed_ms = now_ms - client->last_ms;
+    client->last_ms = now_ms;
 
-        // Classe IN (Internet)
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x01;
+    // Recharge: QPS jetons/s = QPS milli-jetons/ms, plafonné pour éviter le débordement
+    if (elapsed_ms >= DNS_RL_BUCKET_MAX / CONFIG_MINIOT_DNS_RATE_LIMIT_QPS) {
+        client->tokens = DNS_RL_BUCKET_MAX;
+    } else {
+        client->tokens += elapsed_ms * CONFIG_MINIOT_DNS_RATE_LIMIT_QPS;
+        if (client->tokens > DNS_RL_BUCKET_MAX) {
+            client->tokens = DNS_RL_BUCKET_MAX;
+        }
+    }
 
-        // TTL (60 secondes)
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x3C;
+    if (client->tokens < DNS_RL_TOKEN_COST) {
+        return false;
+    }
 
-        // Longueur des données (4 octets pour IPv4)
-        tx_buffer[response_len++] = 0x00;
-        tx_buffer[response_len++] = 0x04;
+    client->tokens -= DNS_RL_TOKEN_COST;
+    return true;
+}
+#endif // CONFIG_MINIOT_DNS_RATE_LIMIT
+
+/**
+ * Construit la réponse en place dans le buffer de la requête, ou pointe sur un
+ * template du cache
+ * Retourne la longueur à envoyer, 0 si le paquet doit être ignoré
+ */
+static size_t dns_handle_query(uint8_t *buf, size_t len, size_t size, const uint8_t **response)
+{
+    *response = buf;
+
+    dns_query_t query;
+    esp_err_t ret = dns_message_parse_query(buf, len, &query);
+
+    switch (ret) {
+    case ESP_OK:
+        break;
+    case ESP_ERR_NOT_SUPPORTED:
+        s_stats.errors++;
+        return dns_message_build_error(buf, len, DNS_RCODE_NOTIMP);
+    case ESP_ERR_INVALID_ARG:
+        s_stats.errors++;
+        ESP_LOGW(TAG, "Malformed DNS query, ID: 0x%04X", query.id);
+        return dns_message_build_error(buf, len, DNS_RCODE_FORMERR);
+    default:
+        // Trop court ou réponse: on ignore
+        return 0;
+    }
+
+    ESP_LOGD(TAG, "DNS query received, ID: 0x%04X, type: %u", query.id, query.qtype);
+
+    dns_writer_t writer;
 
-        // Adresse IP (192.168.4.1)
-        tx_buffer[response_len++] = 192;
-        tx_buffer[response_len++] = 168;
-        tx_buffer[response_len++] = 4;
-        tx_buffer[response_len++] = 1;
+    // Version EDNS inconnue: réponse BADVERS sans données (RFC 6891 §6.1.3)
+    if (query.has_edns && query.edns_version != 0) {
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+        return dns_message_finish(&writer, &query);
+    }
 
-        // Envoyer la réponse
-        int err = sendto(s_dns_socket, tx_buffer, response_len, 0,
-                        (struct sockaddr *)&source_addr, socklen);
+    if (query.qclass != DNS_CLASS_IN) {
+        s_stats.other++;
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOTIMP);
+        return dns_message_finish(&writer, &query);
+    }
 
-        if (err < 0) {
-            ESP_LOGE(TAG, "sendto failed: errno %d", errno);
+    // Politique par type: seul A reçoit l'IP de l'AP, les autres types reçoivent
+    // NODATA (NOERROR sans réponse) pour que le client ne relance pas la requête
+    switch (query.qtype) {
+    case DNS_TYPE_A: {
+        s_stats.a++;
+        size_t cached_len = dns_hot_cache_lookup(buf, &query, response);
+        if (cached_len > 0) {
+            s_stats.cache_hits++;
+            return cached_len;
+        }
+        s_stats.cache_misses++;
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+        dns_message_add_a(&writer, s_ap_ip, DNS_ANSWER_TTL);
+        break;
+    }
+
+    case DNS_TYPE_AAAA:
+        s_stats.aaaa++;
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+        break;
+
+    case DNS_TYPE_HTTPS:
+        s_stats.https++;
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+        break;
+
+    case DNS_TYPE_PTR:
+        s_stats.ptr++;
+        if (dns_message_qname_equals(buf, &query, DNS_AP_REVERSE_NAME)) {
+            dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+            dns_message_add_ptr(&writer, DNS_PTR_HOSTNAME, DNS_ANSWER_TTL);
         } else {
-            ESP_LOGD(TAG, "DNS response sent: 192.168.4.1");
+            dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NXDOMAIN);
         }
+        break;
+
+    default:
+        s_stats.other++;
+        dns_message_begin_response(&writer, buf, size, &query, DNS_RCODE_NOERROR);
+        break;
     }
 
-    ESP_LOGI(TAG, "DNS server task stopped");
-    vTaskDelete(NULL);
+    return dns_message_finish(&writer, &query);
+}
+
+/**
+ * Callback du reactor pour chaque datagramme reçu sur le port 53
+ * La réponse est construite en place dans le buffer de réception partagé
+ */
+static void dns_server_on_packet(net_reactor_packet_t *packet, void *ctx)
+{
+    uint8_t *buffer = packet->rx;
+    size_t len = packet->rx_len;
+    size_t size = packet->rx_size < DNS_MAX_PACKET_SIZE ? packet->rx_size : DNS_MAX_PACKET_SIZE;
+
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT
+    // Limitation avant tout parsing: un flood coûte le moins de CPU possible
+    if (!dns_rate_limit_allow(packet->from->sin_addr.s_addr)) {
+        s_stats.rate_limited++;
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT_REFUSE
+        if (len >= DNS_HEADER_SIZE && (buffer[2] & 0x80) == 0) {
+            packet->response_len = dns_message_build_error(buffer, len, DNS_RCODE_REFUSED);
+        }
+#endif
+        return;
+    }
+#endif
+
+    packet->response_len = dns_handle_query(buffer, len, size, &packet->response);
 }
 
 esp_err_t dns_server_start(void)
@@ -132,6 +345,14 @@ esp_err_t dns_server_start(void)
 
     ESP_LOGI(TAG, "Starting DNS server on port %d", DNS_SERVER_PORT);
 
+    if (!s_hot_cache_ready) {
+        dns_hot_cache_init();
+    }
+
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT
+    memset(s_rl_clients, 0, sizeof(s_rl_clients));
+#endif
+
     // Créer le socket UDP
     s_dns_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
     if (s_dns_socket < 0) {
@@ -156,17 +377,20 @@ esp_err_t dns_server_start(void)
 
     ESP_LOGI(TAG, "Socket bound to port %d", DNS_SERVER_PORT);
 
-    // Créer la tâche DNS
-    s_running = true;
-    BaseType_t ret = xTaskCreate(dns_server_task, "dns_server", 4096, NULL, 5, &s_dns_task_handle);
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create DNS server task");
+    // Confier le socket au reactor (une seule tâche pour tous les services UDP)
+    esp_err_t ret = net_reactor_start();
+    if (ret == ESP_OK) {
+        ret = net_reactor_add_udp(s_dns_socket, dns_server_on_packet, NULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register DNS socket: %s", esp_err_to_name(ret));
         close(s_dns_socket);
         s_dns_socket = -1;
-        s_running = false;
         return ESP_FAIL;
     }
 
+    s_running = true;
+
     ESP_LOGI(TAG, "DNS server started successfully");
     return ESP_OK;
 }
@@ -182,19 +406,20 @@ esp_err_t dns_server_stop(void)
 
     s_running = false;
 
-    // Fermer le socket pour débloquer recvfrom()
+    // Au retour, le reactor n'utilise plus le socket: on peut le fermer
     if (s_dns_socket >= 0) {
+        net_reactor_remove_udp(s_dns_socket);
         close(s_dns_socket);
         s_dns_socket = -1;
     }
 
-    // Attendre que la tâche se termine
-    if (s_dns_task_handle) {
-        // La tâche va se terminer toute seule
-        vTaskDelay(pdMS_TO_TICKS(100));
-        s_dns_task_handle = NULL;
-    }
-
     ESP_LOGI(TAG, "DNS server stopped");
     return ESP_OK;
 }
+
+void dns_server_get_stats(dns_server_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_stats;
+    }
+}
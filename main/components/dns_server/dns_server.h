@@ -2,6 +2,22 @@
 #define DNS_SERVER_H
 
 #include "esp_err.h"
+#include <stdint.h>
+
+/**
+ * @brief Compteurs de requêtes DNS par type
+ */
+typedef struct {
+    uint32_t a;                 // Requêtes A (réponse: IP de l'AP)
+    uint32_t aaaa;              // Requêtes AAAA (réponse: NODATA)
+    uint32_t https;             // Requêtes HTTPS/SVCB type 65 (réponse: NODATA)
+    uint32_t ptr;               // Requêtes PTR
+    uint32_t other;             // Autres types (réponse: NODATA)
+    uint32_t errors;            // Requêtes malformées ou opcode non supporté
+    uint32_t cache_hits;        // Requêtes A servies depuis le cache de noms fréquents
+    uint32_t cache_misses;      // Requêtes A construites paquet par paquet
+    uint32_t rate_limited;      // Requêtes rejetées par la limitation par client
+} dns_server_stats_t;
 
 /**
  * @brief Démarre le serveur DNS captif
@@ -16,4 +32,10 @@ esp_err_t dns_server_start(void);
  */
 esp_err_t dns_server_stop(void);
 
+/**
+ * @brief Récupère les compteurs de requêtes DNS depuis le démarrage
+ * @param stats Structure où copier les compteurs
+ */
+void dns_server_get_stats(dns_server_stats_t *stats);
+
 #endif // DNS_SERVER_H
@@ -4,9 +4,15 @@
 #include <string.h>
 
 static const char *TAG = "MDNS_SERVICE";
+static bool s_initialized = false;
 
 esp_err_t mdns_service_init(void)
 {
+    if (s_initialized) {
+        // Déjà actif: permet de conserver mDNS lors d'une bascule de mode
+        return ESP_OK;
+    }
+
     ESP_LOGI(TAG, "Initializing mDNS service...");
 
     // Initialiser mDNS
@@ -30,6 +36,7 @@ esp_err_t mdns_service_init(void)
         return ret;
     }
 
+    s_initialized = true;
     ESP_LOGI(TAG, "mDNS initialized successfully");
     ESP_LOGI(TAG, "Device accessible at: http://%s.local", MDNS_HOSTNAME);
 
@@ -38,6 +45,11 @@ esp_err_t mdns_service_init(void)
 
 esp_err_t mdns_service_announce_http(uint16_t port)
 {
+    if (mdns_service_exists("_http", "_tcp", NULL)) {
+        ESP_LOGD(TAG, "HTTP service already announced");
+        return ESP_OK;
+    }
+
     ESP_LOGI(TAG, "Announcing HTTP service on port %d", port);
 
     // Annoncer le service HTTP
@@ -66,7 +78,13 @@ esp_err_t mdns_service_announce_http(uint16_t port)
 
 esp_err_t mdns_service_stop(void)
 {
+    if (!s_initialized) {
+        return ESP_OK;
+    }
+
+    // mdns_free() attend la fin de la tâche mDNS avant de retourner
     ESP_LOGI(TAG, "Stopping mDNS service");
     mdns_free();
+    s_initialized = false;
     return ESP_OK;
 }
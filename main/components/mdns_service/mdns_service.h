@@ -9,6 +9,7 @@
 /**
  * @brief Initialise le service mDNS
  * Permet d'accéder à l'ESP32 via miniot.local
+ * Sans effet si le service est déjà initialisé
  * @return ESP_OK si succès
  */
 esp_err_t mdns_service_init(void);
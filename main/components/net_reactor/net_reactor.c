@@ -0,0 +1,327 @@
+#include "net_reactor.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "NET_REACTOR";
+
+#define NET_REACTOR_TASK_PRIORITY 5
+#define NET_REACTOR_SYNC_TIMEOUT_MS 1000
+
+typedef struct {
+    int sock;                           // -1 = entrée libre
+    net_reactor_udp_handler_t handler;
+    void *ctx;
+} net_reactor_entry_t;
+
+static net_reactor_entry_t s_entries[NET_REACTOR_MAX_SOCKETS];
+static SemaphoreHandle_t s_lock = NULL;
+static TaskHandle_t s_task_handle = NULL;
+static TaskHandle_t s_sync_waiter = NULL;
+static volatile bool s_running = false;
+static UBaseType_t s_reported_stack_hwm;    // Dernière marge de stack affichée en info
+
+// Socket de contrôle sur 127.0.0.1 pour réveiller select() (même principe qu'esp_http_server)
+static int s_ctrl_sock = -1;
+static struct sockaddr_in s_ctrl_addr;
+
+// Buffer partagé par tous les services: un seul datagramme traité à la fois
+static uint8_t s_rx_buffer[NET_REACTOR_RX_BUFFER_SIZE];
+
+static void net_reactor_wakeup(void)
+{
+    static const uint8_t msg = 0;
+    sendto(s_ctrl_sock, &msg, sizeof(msg), 0,
+           (struct sockaddr *)&s_ctrl_addr, sizeof(s_ctrl_addr));
+}
+
+static esp_err_t net_reactor_create_ctrl_socket(void)
+{
+    s_ctrl_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_ctrl_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create control socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    memset(&s_ctrl_addr, 0, sizeof(s_ctrl_addr));
+    s_ctrl_addr.sin_family = AF_INET;
+    s_ctrl_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    s_ctrl_addr.sin_port = 0;
+
+    socklen_t addr_len = sizeof(s_ctrl_addr);
+    if (bind(s_ctrl_sock, (struct sockaddr *)&s_ctrl_addr, sizeof(s_ctrl_addr)) < 0 ||
+        getsockname(s_ctrl_sock, (struct sockaddr *)&s_ctrl_addr, &addr_len) < 0) {
+        ESP_LOGE(TAG, "Unable to bind control socket: errno %d", errno);
+        close(s_ctrl_sock);
+        s_ctrl_sock = -1;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static void net_reactor_dispatch(net_reactor_entry_t *entry)
+{
+    struct sockaddr_in source_addr;
+    socklen_t socklen = sizeof(source_addr);
+
+    int len = recvfrom(entry->sock, s_rx_buffer, sizeof(s_rx_buffer), MSG_DONTWAIT,
+                       (struct sockaddr *)&source_addr, &socklen);
+    if (len < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            ESP_LOGE(TAG, "recvfrom failed on socket %d: errno %d", entry->sock, errno);
+        }
+        return;
+    }
+
+    net_reactor_packet_t packet = {
+        .rx = s_rx_buffer,
+        .rx_len = len,
+        .rx_size = sizeof(s_rx_buffer),
+        .from = &source_addr,
+        .response = s_rx_buffer,
+        .response_len = 0,
+    };
+
+    entry->handler(&packet, entry->ctx);
+
+    if (packet.response_len > 0) {
+        int err = sendto(entry->sock, packet.response, packet.response_len, 0,
+                         (struct sockaddr *)&source_addr, socklen);
+        if (err < 0) {
+            ESP_LOGE(TAG, "sendto failed on socket %d: errno %d", entry->sock, errno);
+        }
+    }
+}
+
+static void net_reactor_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Network reactor task started");
+
+    while (s_running) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(s_ctrl_sock, &readfds);
+        int maxfd = s_ctrl_sock;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        for (int i = 0; i < NET_REACTOR_MAX_SOCKETS; i++) {
+            if (s_entries[i].sock >= 0) {
+                FD_SET(s_entries[i].sock, &readfds);
+                if (s_entries[i].sock > maxfd) {
+                    maxfd = s_entries[i].sock;
+                }
+            }
+        }
+        xSemaphoreGive(s_lock);
+
+        int ready = select(maxfd + 1, &readfds, NULL, NULL, NULL);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+
+        // Un appelant de net_reactor_remove_udp() attend que select() soit relâché
+        // (en cas d'arrêt, il est notifié après la fermeture des sockets)
+        if (s_sync_waiter && s_running) {
+            xTaskNotifyGive(s_sync_waiter);
+            s_sync_waiter = NULL;
+        }
+
+        if (ready < 0) {
+            xSemaphoreGive(s_lock);
+            if (errno != EBADF && s_running) {
+                ESP_LOGE(TAG, "select failed: errno %d", errno);
+                vTaskDelay(pdMS_TO_TICKS(10));
+            }
+            continue;
+        }
+
+        if (FD_ISSET(s_ctrl_sock, &readfds)) {
+            uint8_t drain[4];
+            while (recv(s_ctrl_sock, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+            }
+        }
+
+        for (int i = 0; i < NET_REACTOR_MAX_SOCKETS && s_running; i++) {
+            if (s_entries[i].sock >= 0 && FD_ISSET(s_entries[i].sock, &readfds)) {
+                net_reactor_dispatch(&s_entries[i]);
+            }
+        }
+
+        xSemaphoreGive(s_lock);
+    }
+
+    // Fermer les sockets restants
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < NET_REACTOR_MAX_SOCKETS; i++) {
+        if (s_entries[i].sock >= 0) {
+            close(s_entries[i].sock);
+            s_entries[i].sock = -1;
+        }
+    }
+    close(s_ctrl_sock);
+    s_ctrl_sock = -1;
+
+    if (s_sync_waiter) {
+        xTaskNotifyGive(s_sync_waiter);
+        s_sync_waiter = NULL;
+    }
+    s_task_handle = NULL;
+    xSemaphoreGive(s_lock);
+
+    ESP_LOGI(TAG, "Network reactor task stopped");
+    vTaskDelete(NULL);
+}
+
+/**
+ * Réveille la tâche et attend qu'elle ait quitté select()
+ * Doit être appelé avec s_lock pris, qui est relâché pendant l'attente
+ */
+static void net_reactor_sync_locked(void)
+{
+    s_sync_waiter = xTaskGetCurrentTaskHandle();
+    xSemaphoreGive(s_lock);
+
+    net_reactor_wakeup();
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NET_REACTOR_SYNC_TIMEOUT_MS)) == 0) {
+        ESP_LOGW(TAG, "Reactor did not acknowledge within %d ms", NET_REACTOR_SYNC_TIMEOUT_MS);
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_sync_waiter = NULL;
+}
+
+esp_err_t net_reactor_start(void)
+{
+    if (s_running) {
+        return ESP_OK;
+    }
+
+    if (!s_lock) {
+        s_lock = xSemaphoreCreateMutex();
+        if (!s_lock) {
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    for (int i = 0; i < NET_REACTOR_MAX_SOCKETS; i++) {
+        s_entries[i].sock = -1;
+    }
+
+    esp_err_t ret = net_reactor_create_ctrl_socket();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_running = true;
+    s_reported_stack_hwm = NET_REACTOR_TASK_STACK_SIZE;
+    BaseType_t created = xTaskCreate(net_reactor_task, "net_reactor", NET_REACTOR_TASK_STACK_SIZE,
+                                     NULL, NET_REACTOR_TASK_PRIORITY, &s_task_handle);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create reactor task");
+        s_running = false;
+        close(s_ctrl_sock);
+        s_ctrl_sock = -1;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Network reactor started (stack %d bytes, %d socket slots)",
+             NET_REACTOR_TASK_STACK_SIZE, NET_REACTOR_MAX_SOCKETS);
+    return ESP_OK;
+}
+
+esp_err_t net_reactor_stop(void)
+{
+    if (!s_running) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_running = false;
+    net_reactor_sync_locked();
+    xSemaphoreGive(s_lock);
+
+    ESP_LOGI(TAG, "Network reactor stopped");
+    return ESP_OK;
+}
+
+esp_err_t net_reactor_add_udp(int sock, net_reactor_udp_handler_t handler, void *ctx)
+{
+    if (sock < 0 || !handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!s_running) {
+        ESP_LOGE(TAG, "Reactor not started");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < NET_REACTOR_MAX_SOCKETS; i++) {
+        if (s_entries[i].sock < 0) {
+            s_entries[i].handler = handler;
+            s_entries[i].ctx = ctx;
+            s_entries[i].sock = sock;
+            xSemaphoreGive(s_lock);
+
+            // Prendre en compte le nouveau socket dans le prochain select()
+            net_reactor_wakeup();
+            ESP_LOGI(TAG, "Socket %d registered (slot %d)", sock, i);
+            return ESP_OK;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    ESP_LOGE(TAG, "No free slot for socket %d", sock);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t net_reactor_remove_udp(int sock)
+{
+    if (!s_lock) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (xTaskGetCurrentTaskHandle() == s_task_handle) {
+        // Appel depuis un callback: le mutex est déjà pris par la tâche
+        ESP_LOGE(TAG, "Cannot remove a socket from a reactor callback");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < NET_REACTOR_MAX_SOCKETS; i++) {
+        if (s_entries[i].sock == sock) {
+            s_entries[i].sock = -1;
+            // Le socket peut ensuite être fermé sans que select() l'attende encore
+            if (s_running) {
+                net_reactor_sync_locked();
+            }
+            xSemaphoreGive(s_lock);
+            ESP_LOGI(TAG, "Socket %d unregistered", sock);
+            return ESP_OK;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+void net_reactor_log_usage(void)
+{
+    if (s_task_handle) {
+        UBaseType_t hwm = uxTaskGetStackHighWaterMark(s_task_handle);
+        // Chaque nouveau minimum est affiché en info pour relever la mesure sur la cible
+        if (hwm < s_reported_stack_hwm) {
+            s_reported_stack_hwm = hwm;
+            ESP_LOGI(TAG, "Reactor stack: %u bytes used of %d (high water mark %u)",
+                     (unsigned)(NET_REACTOR_TASK_STACK_SIZE - hwm), NET_REACTOR_TASK_STACK_SIZE,
+                     (unsigned)hwm);
+        }
+    }
+    ESP_LOGD(TAG, "Heap: %" PRIu32 " bytes free, %" PRIu32 " bytes minimum since boot",
+             esp_get_free_heap_size(), esp_get_minimum_free_heap_size());
+}
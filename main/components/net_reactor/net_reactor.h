@@ -0,0 +1,76 @@
+#ifndef NET_REACTOR_H
+#define NET_REACTOR_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define NET_REACTOR_MAX_SOCKETS 4
+#define NET_REACTOR_RX_BUFFER_SIZE 512     // Message DNS max sans EDNS, le seul service enregistré
+
+// Pic mesuré (test/host/net_reactor_stack) 608 octets sous celui de l'ancienne
+// tâche DNS de 4096 octets: même marge, vérifiable avec net_reactor_log_usage()
+#define NET_REACTOR_TASK_STACK_SIZE 3584
+
+/**
+ * @brief Paquet UDP reçu, passé au callback du service
+ *
+ * Le buffer est partagé entre tous les services et n'est valide que pendant
+ * l'appel du callback. Le service peut construire sa réponse en place dans rx
+ * ou pointer sur ses propres données (response).
+ */
+typedef struct {
+    uint8_t *rx;                        // Données reçues (modifiables)
+    size_t rx_len;                      // Longueur reçue
+    size_t rx_size;                     // Capacité du buffer rx
+    const struct sockaddr_in *from;     // Adresse de l'émetteur
+    const uint8_t *response;            // Réponse à envoyer (par défaut rx)
+    size_t response_len;                // 0 = aucune réponse
+} net_reactor_packet_t;
+
+/**
+ * @brief Callback appelé depuis la tâche du reactor pour chaque datagramme
+ * @param packet Paquet reçu, la réponse est renseignée par le callback
+ * @param ctx Contexte fourni à l'enregistrement
+ */
+typedef void (*net_reactor_udp_handler_t)(net_reactor_packet_t *packet, void *ctx);
+
+/**
+ * @brief Démarre la tâche du reactor (idempotent)
+ * @return ESP_OK si succès
+ */
+esp_err_t net_reactor_start(void);
+
+/**
+ * @brief Arrête la tâche du reactor et attend sa terminaison
+ * Les sockets encore enregistrés sont fermés.
+ * @return ESP_OK si succès
+ */
+esp_err_t net_reactor_stop(void);
+
+/**
+ * @brief Confie un socket UDP déjà lié au reactor
+ * @param sock Socket UDP (bind déjà effectué)
+ * @param handler Callback appelé pour chaque datagramme reçu
+ * @param ctx Contexte passé au callback
+ * @return ESP_OK si succès, ESP_ERR_NO_MEM si la table est pleine
+ */
+esp_err_t net_reactor_add_udp(int sock, net_reactor_udp_handler_t handler, void *ctx);
+
+/**
+ * @brief Retire un socket du reactor
+ * Au retour, le callback n'est plus en cours d'exécution et ne sera plus appelé.
+ * Le socket n'est pas fermé.
+ * @param sock Socket à retirer
+ * @return ESP_OK si succès, ESP_ERR_NOT_FOUND si le socket n'est pas enregistré
+ */
+esp_err_t net_reactor_remove_udp(int sock);
+
+/**
+ * @brief Affiche l'utilisation mémoire: marge de stack de la tâche (niveau info à
+ * chaque nouveau minimum), heap libre et minimum (niveau debug)
+ */
+void net_reactor_log_usage(void);
+
+#endif // NET_REACTOR_H
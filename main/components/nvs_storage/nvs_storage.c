@@ -6,6 +6,7 @@
 
 static const char *TAG = "NVS_STORAGE";
 static const char *NVS_NAMESPACE = "wifi_config";
+static const char *NVS_OTA_NAMESPACE = "ota_resume";     // Hors factory reset: lié à la partition
 
 esp_err_t nvs_storage_init(void)
 {
@@ -191,3 +192,66 @@ bool nvs_storage_is_configured(void)
 
     return (ret == ESP_OK && configured == 1);
 }
+
+esp_err_t nvs_storage_save_ota_checkpoint(const void *data, size_t len)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_OTA_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS handle: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_blob(nvs_handle, "checkpoint", data, len);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save OTA checkpoint: %s", esp_err_to_name(ret));
+    }
+
+    nvs_close(nvs_handle);
+    return ret;
+}
+
+esp_err_t nvs_storage_load_ota_checkpoint(void *data, size_t len)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_OTA_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (ret != ESP_OK) {
+        // Namespace absent tant qu'aucun point de reprise n'a été écrit
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    size_t stored_len = len;
+    ret = nvs_get_blob(nvs_handle, "checkpoint", data, &stored_len);
+    nvs_close(nvs_handle);
+
+    if (ret == ESP_OK && stored_len != len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ret == ESP_ERR_NVS_INVALID_LENGTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ret;
+}
+
+esp_err_t nvs_storage_clear_ota_checkpoint(void)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t ret = nvs_open(NVS_OTA_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS handle: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_erase_key(nvs_handle, "checkpoint");
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs_handle);
+    } else if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+
+    nvs_close(nvs_handle);
+    return ret;
+}
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 
 #define MAX_SSID_LEN 32
@@ -48,4 +49,25 @@ esp_err_t nvs_storage_factory_reset(void);
  */
 bool nvs_storage_is_configured(void);
 
+/**
+ * @brief Sauvegarde le point de reprise d'une mise à jour OTA interrompue
+ * @param data,len Enregistrement opaque défini par ota_manager
+ * @return ESP_OK si succès
+ */
+esp_err_t nvs_storage_save_ota_checkpoint(const void *data, size_t len);
+
+/**
+ * @brief Charge le point de reprise OTA
+ * @return ESP_OK si succès
+ *         ESP_ERR_NVS_NOT_FOUND si aucun point de reprise
+ *         ESP_ERR_INVALID_SIZE si l'enregistrement n'a pas la taille attendue
+ */
+esp_err_t nvs_storage_load_ota_checkpoint(void *data, size_t len);
+
+/**
+ * @brief Efface le point de reprise OTA (mise à jour terminée ou abandonnée)
+ * @return ESP_OK si succès ou si aucun point de reprise
+ */
+esp_err_t nvs_storage_clear_ota_checkpoint(void);
+
 #endif // NVS_STORAGE_H
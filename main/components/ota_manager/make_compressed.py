@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""
+Compresse une image ou un patch OTA (format MDZ1, voir ota_inflate.h)
+
+- Flux deflate brut dont la fenêtre ne dépasse pas OTA_INFLATE_WINDOW_BITS:
+  le device décompresse dans une fenêtre circulaire de taille fixe
+- Découpé en blocs indépendants de FRAME_SIZE octets décompressés: un
+  téléchargement interrompu reprend au début du dernier bloc écrit en flash
+- Le flux est redécompressé avant d'être écrit pour vérifier le résultat
+
+Usage: make_compressed.py <entrée> <sortie>
+"""
+
+import struct
+import sys
+import zlib
+
+MAGIC = b'MDZ1'
+WINDOW_BITS = 14        # Doit rester <= OTA_INFLATE_WINDOW_BITS
+FRAME_SIZE = 64 * 1024  # Multiple d'un secteur flash (4 KB)
+
+
+def compress(data):
+    out = bytearray(MAGIC + struct.pack('<IB3x', len(data), WINDOW_BITS))
+    for pos in range(0, len(data), FRAME_SIZE):
+        c = zlib.compressobj(9, zlib.DEFLATED, -WINDOW_BITS, 9)
+        frame = c.compress(data[pos:pos + FRAME_SIZE]) + c.flush()
+        out += struct.pack('<I', len(frame)) + frame
+    return bytes(out)
+
+
+def decompress(blob):
+    """Implémentation de référence de ota_inflate.c"""
+    assert blob[:4] == MAGIC
+    size, window_bits = struct.unpack_from('<IB', blob, 4)
+    out = bytearray()
+    pos = 12
+    while pos < len(blob):
+        length, = struct.unpack_from('<I', blob, pos)
+        d = zlib.decompressobj(-window_bits)
+        out += d.decompress(blob[pos + 4:pos + 4 + length]) + d.flush()
+        assert d.eof and not d.unused_data
+        pos += 4 + length
+    assert len(out) == size
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+
+    blob = compress(data)
+    if decompress(blob) != data:
+        print('Compression verification failed', file=sys.stderr)
+        return 1
+
+    with open(sys.argv[2], 'wb') as f:
+        f.write(blob)
+    print('Compressed: %d -> %d bytes (%.1f%%)'
+          % (len(data), len(blob), 100.0 * len(blob) / len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+Produit un patch OTA (format MDL1, voir ota_delta.h) entre deux firmwares
+
+- Recherche de correspondances approximatives à la manière de bsdiff: une
+  graine exacte de SEED octets est étendue tant que plus de la moitié des
+  octets coïncident, ce qui absorbe les adresses décalées par une recompilation
+- La zone diff est codée en jetons (copie de la source / octets de
+  différence), les octets sans correspondance sont copiés tels quels
+- Le patch est réappliqué avant d'être écrit pour vérifier le résultat
+
+Le firmware source doit être exactement l'image .bin de la version installée
+sur le device: son SHA-256 est vérifié avant toute écriture.
+
+Usage: make_delta.py <ancien.bin> <nouveau.bin> <patch>
+"""
+
+import hashlib
+import re
+import struct
+import sys
+
+MAGIC = b'MDL1'
+SEED = 16               # Longueur d'une graine exacte
+INDEX_STEP = 4          # Positions de la source indexées
+MIN_MATCH = 32          # Correspondance plus courte: octets copiés tels quels
+MAX_CANDIDATES = 8      # Positions gardées par graine
+FAST_BLOCK = 64         # Comparaison par blocs dans les zones identiques
+GIVE_UP = 256           # Extension arrêtée après autant d'octets sans amélioration
+ZERO_RUN = 4            # Différences nulles plus courtes: gardées dans le littéral
+
+
+def build_index(src):
+    index = {}
+    for i in range(0, len(src) - SEED + 1, INDEX_STEP):
+        index.setdefault(src[i:i + SEED], []).append(i)
+    for key, offsets in index.items():
+        if len(offsets) > MAX_CANDIDATES:
+            index[key] = offsets[:MAX_CANDIDATES]
+    return index
+
+
+def extend(src, s, dst, p, limit, step):
+    """Longueur de la meilleure correspondance approximative (step = 1 ou -1)"""
+    i = matches = best_len = best_score = 0
+    while i < limit:
+        if step > 0:
+            while (i + FAST_BLOCK <= limit and
+                   src[s + i:s + i + FAST_BLOCK] == dst[p + i:p + i + FAST_BLOCK]):
+                i += FAST_BLOCK
+                matches += FAST_BLOCK
+            if i < limit:
+                matches += src[s + i] == dst[p + i]
+                i += 1
+        else:
+            matches += src[s - 1 - i] == dst[p - 1 - i]
+            i += 1
+        score = 2 * matches - i
+        if score > best_score:
+            best_score, best_len = score, i
+        elif i - best_len > GIVE_UP:
+            break
+    return best_len
+
+
+def find_matches(src, dst):
+    """Liste de (position cible, position source, longueur)"""
+    index = build_index(src)
+    matches = []
+    p = 0
+    gap_start = 0
+    next_src = 0        # Position source qui prolongerait la correspondance précédente
+
+    while p <= len(dst) - SEED:
+        candidates = list(index.get(dst[p:p + SEED], ()))
+        cont = next_src + (p - gap_start)
+        if cont + SEED <= len(src) and src[cont:cont + SEED] == dst[p:p + SEED]:
+            candidates.insert(0, cont)
+
+        best_s, best_len = None, 0
+        for s in candidates:
+            length = extend(src, s, dst, p, min(len(src) - s, len(dst) - p), 1)
+            if length > best_len:
+                best_s, best_len = s, length
+
+        if best_len < MIN_MATCH:
+            p += 1
+            continue
+
+        back = extend(src, best_s, dst, p, min(p - gap_start, best_s), -1)
+        matches.append((p - back, best_s - back, best_len + back))
+        p += best_len
+        gap_start = p
+        next_src = best_s + best_len
+
+    return matches
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def encode_diff(src, s, dst, p, length):
+    diff = bytes((dst[p + i] - src[s + i]) & 0xFF for i in range(length))
+    out = bytearray()
+    pos = 0
+    for run in re.finditer(b'\x00{%d,}' % ZERO_RUN, diff):
+        if run.start() > pos:
+            out += varint((run.start() - pos) << 1 | 1) + diff[pos:run.start()]
+        out += varint((run.end() - run.start()) << 1)
+        pos = run.end()
+    if pos < length:
+        out += varint((length - pos) << 1 | 1) + diff[pos:]
+    return bytes(out)
+
+
+def make_patch(src, dst):
+    matches = find_matches(src, dst)
+    body = bytearray()
+    src_pos = 0
+
+    # Octets sans correspondance avant la première
+    first = matches[0][0] if matches else len(dst)
+    if first > 0 or not matches or matches[0][1] != 0:
+        seek = matches[0][1] if matches else 0
+        body += struct.pack('<IIi', 0, first, seek)
+        body += dst[:first]
+        src_pos = seek
+
+    for k, (p, s, length) in enumerate(matches):
+        end = p + length
+        next_p = matches[k + 1][0] if k + 1 < len(matches) else len(dst)
+        next_s = matches[k + 1][1] if k + 1 < len(matches) else s + length
+        assert s == src_pos
+        body += struct.pack('<IIi', length, next_p - end, next_s - (s + length))
+        body += encode_diff(src, s, dst, p, length)
+        body += dst[end:next_p]
+        src_pos = next_s
+
+    header = MAGIC + struct.pack('<II', len(src), len(dst))
+    header += hashlib.sha256(src).digest() + hashlib.sha256(dst).digest()
+    return header + bytes(body), len(matches)
+
+
+def apply_patch(src, patch):
+    """Implémentation de référence de ota_delta.c"""
+    assert patch[:4] == MAGIC
+    source_size, target_size = struct.unpack_from('<II', patch, 4)
+    assert hashlib.sha256(src[:source_size]).digest() == patch[12:44]
+    out = bytearray()
+    pos = 76
+    src_pos = 0
+    while pos < len(patch):
+        diff_len, extra_len, seek = struct.unpack_from('<IIi', patch, pos)
+        pos += 12
+        while diff_len > 0:
+            token = shift = 0
+            while True:
+                byte = patch[pos]
+                pos += 1
+                token |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    break
+            run = token >> 1
+            if token & 1:
+                out += bytes((src[src_pos + i] + patch[pos + i]) & 0xFF for i in range(run))
+                pos += run
+            else:
+                out += src[src_pos:src_pos + run]
+            src_pos += run
+            diff_len -= run
+        out += patch[pos:pos + extra_len]
+        pos += extra_len
+        src_pos += seek
+    assert len(out) == target_size
+    assert hashlib.sha256(out).digest() == patch[44:76]
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 4:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    with open(sys.argv[1], 'rb') as f:
+        src = f.read()
+    with open(sys.argv[2], 'rb') as f:
+        dst = f.read()
+
+    patch, count = make_patch(src, dst)
+    if apply_patch(src, patch) != dst:
+        print('Patch verification failed', file=sys.stderr)
+        return 1
+
+    with open(sys.argv[3], 'wb') as f:
+        f.write(patch)
+    print('Delta: %d -> %d bytes, patch %d bytes (%.1f%%), %d matches'
+          % (len(src), len(dst), len(patch), 100.0 * len(patch) / len(dst), count))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,290 @@
+#include "ota_delta.h"
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include <string.h>
+
+static const char *TAG = "OTA_DELTA";
+
+enum {
+    DELTA_CONTROL,                      // Lecture du bloc de contrôle
+    DELTA_TOKEN,                        // Lecture d'un jeton de la zone diff
+    DELTA_LITERAL,                      // Octets de différence d'un jeton littéral
+    DELTA_EXTRA,                        // Octets copiés tels quels
+};
+
+#define DELTA_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+bool ota_delta_is_patch(const void *data)
+{
+    return memcmp(data, OTA_DELTA_MAGIC, 4) == 0;
+}
+
+static esp_err_t ota_delta_flush(ota_delta_t *d)
+{
+    if (d->out_len == 0) {
+        return ESP_OK;
+    }
+    esp_err_t err = d->output(d->out, d->out_len);
+    d->out_len = 0;
+    return err;
+}
+
+/**
+ * Rend disponible la source à partir de source_pos
+ * @param count Octets dont l'appelant a besoin (vérifiés contre source_size)
+ * @param avail Octets contigus disponibles dans la fenêtre, au plus count
+ */
+static esp_err_t ota_delta_source(ota_delta_t *d, uint32_t count, const uint8_t **ptr, size_t *avail)
+{
+    if (d->source_pos >= d->source_size || count > d->source_size - d->source_pos) {
+        ESP_LOGE(TAG, "Patch reads past the source image");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (d->source_pos < d->window_start || d->source_pos >= d->window_start + d->window_len) {
+        size_t n = DELTA_MIN(OTA_DELTA_WINDOW, d->source_size - d->source_pos);
+        esp_err_t err = esp_partition_read(d->source, d->source_pos, d->window, n);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Source read failed: %s", esp_err_to_name(err));
+            return err;
+        }
+        d->window_start = d->source_pos;
+        d->window_len = n;
+    }
+
+    size_t offset = d->source_pos - d->window_start;
+    *ptr = d->window + offset;
+    *avail = DELTA_MIN(d->window_len - offset, count);
+    return ESP_OK;
+}
+
+/**
+ * Copie une suite d'octets inchangés de la source vers la sortie
+ */
+static esp_err_t ota_delta_copy(ota_delta_t *d, uint32_t count)
+{
+    esp_err_t err = ota_delta_flush(d);
+
+    while (err == ESP_OK && count > 0) {
+        const uint8_t *src;
+        size_t n;
+        err = ota_delta_source(d, count, &src, &n);
+        if (err == ESP_OK) {
+            err = d->output(src, n);
+        }
+        d->source_pos += n;
+        d->written += n;
+        count -= n;
+    }
+    return err;
+}
+
+/**
+ * Enchaîne les étapes terminées qui ne consomment pas d'octets du patch
+ */
+static esp_err_t ota_delta_advance(ota_delta_t *d)
+{
+    while (1) {
+        if (d->state == DELTA_TOKEN && d->diff_left == 0) {
+            d->state = DELTA_EXTRA;
+        } else if (d->state == DELTA_EXTRA && d->extra_left == 0) {
+            int64_t pos = (int64_t)d->source_pos + d->seek;
+            if (pos < 0 || pos > d->source_size) {
+                ESP_LOGE(TAG, "Invalid seek %ld at source offset %lu",
+                         (long)d->seek, (unsigned long)d->source_pos);
+                return ESP_ERR_INVALID_ARG;
+            }
+            d->source_pos = (uint32_t)pos;
+            d->state = DELTA_CONTROL;
+            d->control_len = 0;
+        } else {
+            return ESP_OK;
+        }
+    }
+}
+
+static esp_err_t ota_delta_check_source(ota_delta_t *d, const uint8_t expected[32])
+{
+    mbedtls_sha256_context ctx;
+    uint8_t digest[32];
+    esp_err_t err = ESP_OK;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    for (uint32_t pos = 0; pos < d->source_size && err == ESP_OK; pos += OTA_DELTA_WINDOW) {
+        size_t n = DELTA_MIN(OTA_DELTA_WINDOW, d->source_size - pos);
+        err = esp_partition_read(d->source, pos, d->window, n);
+        if (err == ESP_OK) {
+            mbedtls_sha256_update(&ctx, d->window, n);
+        }
+    }
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Source read failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (memcmp(digest, expected, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Patch was made for another firmware");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_delta_begin(ota_delta_t *d, const ota_delta_header_t *header,
+                          const esp_partition_t *source, ota_delta_output_t output)
+{
+    memset(d, 0, sizeof(*d));
+    d->source = source;
+    d->source_size = header->source_size;
+    d->target_size = header->target_size;
+    d->output = output;
+    d->state = DELTA_CONTROL;
+
+    if (d->source_size == 0 || d->source_size > source->size || d->target_size == 0) {
+        ESP_LOGE(TAG, "Invalid patch sizes (source %lu, target %lu)",
+                 (unsigned long)d->source_size, (unsigned long)d->target_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = ota_delta_check_source(d, header->source_sha256);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Applying patch: %lu -> %lu bytes from partition %s",
+             (unsigned long)d->source_size, (unsigned long)d->target_size, source->label);
+    return ESP_OK;
+}
+
+esp_err_t ota_delta_feed(ota_delta_t *d, const uint8_t *data, size_t len)
+{
+    esp_err_t err = ESP_OK;
+
+    while (len > 0 && err == ESP_OK) {
+        switch (d->state) {
+        case DELTA_CONTROL: {
+            size_t n = DELTA_MIN(sizeof(d->control) - d->control_len, len);
+            memcpy(d->control + d->control_len, data, n);
+            d->control_len += n;
+            data += n;
+            len -= n;
+            if (d->control_len < sizeof(d->control)) {
+                break;
+            }
+
+            memcpy(&d->diff_left, d->control, 4);
+            memcpy(&d->extra_left, d->control + 4, 4);
+            memcpy(&d->seek, d->control + 8, 4);
+            if ((uint64_t)d->written + d->diff_left + d->extra_left > d->target_size) {
+                ESP_LOGE(TAG, "Patch produces more than %lu bytes", (unsigned long)d->target_size);
+                return ESP_ERR_INVALID_ARG;
+            }
+            d->state = DELTA_TOKEN;
+            d->token = 0;
+            d->token_shift = 0;
+            err = ota_delta_advance(d);
+            break;
+        }
+
+        case DELTA_TOKEN: {
+            uint8_t b = *data++;
+            len--;
+            if (d->token_shift > 28) {
+                ESP_LOGE(TAG, "Invalid token");
+                return ESP_ERR_INVALID_ARG;
+            }
+            d->token |= (uint32_t)(b & 0x7F) << d->token_shift;
+            d->token_shift += 7;
+            if (b & 0x80) {
+                break;
+            }
+
+            uint32_t run = d->token >> 1;
+            bool literal = d->token & 1;
+            d->token = 0;
+            d->token_shift = 0;
+            if (run == 0 || run > d->diff_left) {
+                ESP_LOGE(TAG, "Invalid run length %lu", (unsigned long)run);
+                return ESP_ERR_INVALID_ARG;
+            }
+            d->diff_left -= run;
+
+            if (literal) {
+                d->run_left = run;
+                d->state = DELTA_LITERAL;
+            } else {
+                err = ota_delta_copy(d, run);
+                if (err == ESP_OK) {
+                    err = ota_delta_advance(d);
+                }
+            }
+            break;
+        }
+
+        case DELTA_LITERAL: {
+            const uint8_t *src;
+            size_t n;
+            err = ota_delta_source(d, DELTA_MIN(d->run_left, len), &src, &n);
+            if (err != ESP_OK) {
+                break;
+            }
+            n = DELTA_MIN(n, sizeof(d->out) - d->out_len);
+            for (size_t i = 0; i < n; i++) {
+                d->out[d->out_len + i] = src[i] + data[i];
+            }
+            d->out_len += n;
+            d->source_pos += n;
+            d->written += n;
+            d->run_left -= n;
+            data += n;
+            len -= n;
+
+            if (d->out_len == sizeof(d->out)) {
+                err = ota_delta_flush(d);
+            }
+            if (err == ESP_OK && d->run_left == 0) {
+                d->state = DELTA_TOKEN;
+                err = ota_delta_advance(d);
+            }
+            break;
+        }
+
+        case DELTA_EXTRA: {
+            size_t n = DELTA_MIN(d->extra_left, len);
+            err = ota_delta_flush(d);
+            if (err == ESP_OK) {
+                err = d->output(data, n);
+            }
+            d->written += n;
+            d->extra_left -= n;
+            data += n;
+            len -= n;
+            if (err == ESP_OK) {
+                err = ota_delta_advance(d);
+            }
+            break;
+        }
+
+        default:
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    return err;
+}
+
+esp_err_t ota_delta_finish(ota_delta_t *d)
+{
+    esp_err_t err = ota_delta_flush(d);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (d->state != DELTA_CONTROL || d->control_len != 0 || d->written != d->target_size) {
+        ESP_LOGE(TAG, "Patch incomplete (%lu / %lu bytes produced)",
+                 (unsigned long)d->written, (unsigned long)d->target_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,99 @@
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#define OTA_DELTA_MAGIC "MDL1"
+#define OTA_DELTA_WINDOW 1024           // Fenêtre de lecture de la source et tampon de sortie
+
+/**
+ * @brief En-tête d'un patch (produit par make_delta.py), little-endian
+ *
+ * Suivi d'une suite de blocs à la manière de bsdiff:
+ *   contrôle: uint32 diff_len, uint32 extra_len, int32 seek
+ *   diff_len octets de sortie = source + différence, codés en jetons varint
+ *     (longueur << 1 | littéral): littéral = octets de différence à ajouter
+ *     à la source, sinon copie directe de la source
+ *   extra_len octets de sortie copiés tels quels du patch
+ *   position source += seek
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];                      // OTA_DELTA_MAGIC
+    uint32_t source_size;               // Taille de l'image source (partition courante)
+    uint32_t target_size;               // Taille de l'image produite
+    uint8_t source_sha256[32];          // SHA-256 des source_size premiers octets de la source
+    uint8_t target_sha256[32];          // SHA-256 de l'image produite
+} ota_delta_header_t;
+
+/**
+ * @brief Reçoit les octets de l'image produite, dans l'ordre
+ */
+typedef esp_err_t (*ota_delta_output_t)(const void *data, size_t len);
+
+/**
+ * @brief Application d'un patch en flux, mémoire constante
+ *
+ * La source est relue dans la partition par fenêtres de OTA_DELTA_WINDOW
+ * octets: seuls le patch et l'image produite transitent en flux.
+ */
+typedef struct {
+    const esp_partition_t *source;
+    uint32_t source_size;
+    uint32_t target_size;
+    ota_delta_output_t output;
+
+    // État interne
+    uint8_t state;
+    uint8_t control[12];
+    uint8_t control_len;
+    uint32_t diff_left;                 // Octets de sortie restants dans la zone diff
+    uint32_t extra_left;
+    int32_t seek;
+    uint32_t token;                     // Jeton varint en cours de lecture
+    uint8_t token_shift;
+    uint32_t run_left;                  // Octets restants du jeton littéral en cours
+    uint32_t source_pos;
+    uint32_t written;
+    uint32_t window_start;
+    uint32_t window_len;
+    uint8_t window[OTA_DELTA_WINDOW];
+    size_t out_len;
+    uint8_t out[OTA_DELTA_WINDOW];
+} ota_delta_t;
+
+/**
+ * @brief Indique si le début d'un flux est un patch
+ * @param data Au moins 4 octets
+ */
+bool ota_delta_is_patch(const void *data);
+
+/**
+ * @brief Prépare l'application d'un patch
+ *
+ * Vérifie que la source correspond (taille et SHA-256) avant que quoi que
+ * ce soit ne soit écrit: un patch prévu pour une autre version est refusé.
+ *
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_VERSION si la source ne correspond pas au patch
+ *         ESP_ERR_INVALID_SIZE si les tailles sont incohérentes
+ */
+esp_err_t ota_delta_begin(ota_delta_t *d, const ota_delta_header_t *header,
+                          const esp_partition_t *source, ota_delta_output_t output);
+
+/**
+ * @brief Fournit le morceau suivant du patch (après l'en-tête)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si le patch est corrompu, ou l'erreur de output
+ */
+esp_err_t ota_delta_feed(ota_delta_t *d, const uint8_t *data, size_t len);
+
+/**
+ * @brief Termine l'application (vide le tampon de sortie)
+ * @return ESP_OK si le patch est complet et a produit target_size octets
+ */
+esp_err_t ota_delta_finish(ota_delta_t *d);
+
+#endif // OTA_DELTA_H
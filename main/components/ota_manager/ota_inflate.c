@@ -0,0 +1,171 @@
+#include "ota_inflate.h"
+#include "esp_log.h"
+#include "rom/miniz.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "OTA_INFLATE";
+
+#define INFLATE_WINDOW_SIZE (1u << OTA_INFLATE_WINDOW_BITS)
+#define INFLATE_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+bool ota_inflate_is_compressed(const void *data)
+{
+    return memcmp(data, OTA_INFLATE_MAGIC, 4) == 0;
+}
+
+esp_err_t ota_inflate_begin(ota_inflate_t *z, const ota_inflate_header_t *header,
+                            ota_inflate_output_t output, ota_inflate_frame_t frame)
+{
+    memset(z, 0, sizeof(*z));
+    z->size = header->size;
+    z->output = output;
+    z->frame = frame;
+
+    if (header->window_bits > OTA_INFLATE_WINDOW_BITS) {
+        ESP_LOGE(TAG, "Compression window of %u bytes exceeds %u",
+                 1u << header->window_bits, INFLATE_WINDOW_SIZE);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (z->size == 0) {
+        ESP_LOGE(TAG, "Invalid decompressed size");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    z->decomp = malloc(sizeof(tinfl_decompressor));
+    z->window = malloc(INFLATE_WINDOW_SIZE);
+    if (z->decomp == NULL || z->window == NULL) {
+        ESP_LOGE(TAG, "Not enough memory for decompression");
+        ota_inflate_end(z);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Decompressing stream: %lu bytes, %u byte window",
+             (unsigned long)z->size, 1u << header->window_bits);
+    return ESP_OK;
+}
+
+void ota_inflate_resume(ota_inflate_t *z, uint32_t consumed, uint32_t produced)
+{
+    z->consumed = consumed;
+    z->produced = produced;
+    ESP_LOGI(TAG, "Resuming at stream offset %lu (%lu bytes already produced)",
+             (unsigned long)consumed, (unsigned long)produced);
+}
+
+/**
+ * Décompresse tout ce que permet l'entrée et transmet la sortie
+ * @param flags TINFL_FLAG_HAS_MORE_INPUT tant que le bloc n'est pas terminé
+ */
+static esp_err_t ota_inflate_run(ota_inflate_t *z, const uint8_t *data, size_t len, uint32_t flags)
+{
+    tinfl_status status;
+
+    do {
+        if (z->done) {
+            ESP_LOGE(TAG, "Data after the end of a compressed frame");
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // La fenêtre est circulaire: tinfl s'arrête en fin de tampon
+        // (HAS_MORE_OUTPUT) et reprend au début une fois la sortie transmise
+        size_t in_bytes = len;
+        size_t out_bytes = INFLATE_WINDOW_SIZE - z->window_pos;
+        status = tinfl_decompress((tinfl_decompressor *)z->decomp, data, &in_bytes,
+                                  z->window, z->window + z->window_pos, &out_bytes, flags);
+        data += in_bytes;
+        len -= in_bytes;
+
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Corrupted compressed stream (status %d)", (int)status);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (out_bytes > z->size - z->produced) {
+            ESP_LOGE(TAG, "Stream decompresses to more than %lu bytes", (unsigned long)z->size);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (out_bytes > 0) {
+            esp_err_t err = z->output(z->window + z->window_pos, out_bytes);
+            if (err != ESP_OK) {
+                return err;
+            }
+            z->produced += out_bytes;
+            z->window_pos = (z->window_pos + out_bytes) & (INFLATE_WINDOW_SIZE - 1);
+        }
+        z->done = status == TINFL_STATUS_DONE;
+    } while (len > 0 || status == TINFL_STATUS_HAS_MORE_OUTPUT);
+
+    return ESP_OK;
+}
+
+esp_err_t ota_inflate_feed(ota_inflate_t *z, const uint8_t *data, size_t len)
+{
+    if (z->decomp == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    while (len > 0) {
+        if (z->frame_left == 0) {
+            if (z->frame_head_len == 0 && z->frame) {
+                z->frame(z->consumed, z->produced);
+            }
+
+            size_t n = INFLATE_MIN(sizeof(z->frame_head) - z->frame_head_len, len);
+            memcpy(z->frame_head + z->frame_head_len, data, n);
+            z->frame_head_len += n;
+            z->consumed += n;
+            data += n;
+            len -= n;
+            if (z->frame_head_len < sizeof(z->frame_head)) {
+                break;
+            }
+
+            memcpy(&z->frame_left, z->frame_head, 4);
+            z->frame_head_len = 0;
+            if (z->frame_left == 0) {
+                ESP_LOGE(TAG, "Empty compressed frame");
+                return ESP_ERR_INVALID_ARG;
+            }
+            tinfl_init((tinfl_decompressor *)z->decomp);
+            z->window_pos = 0;
+            z->done = false;
+            continue;
+        }
+
+        // Le dernier morceau du bloc est fourni sans HAS_MORE_INPUT: tinfl
+        // doit alors terminer le flux deflate, sinon le bloc est tronqué
+        size_t n = INFLATE_MIN(z->frame_left, len);
+        bool last = n == z->frame_left;
+        esp_err_t err = ota_inflate_run(z, data, n, last ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (last && !z->done) {
+            ESP_LOGE(TAG, "Compressed frame ends before its data");
+            return ESP_ERR_INVALID_ARG;
+        }
+        z->frame_left -= n;
+        z->consumed += n;
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_inflate_finish(ota_inflate_t *z)
+{
+    if (z->frame_left != 0 || z->frame_head_len != 0 || z->produced != z->size) {
+        ESP_LOGE(TAG, "Compressed stream incomplete (%lu / %lu bytes produced)",
+                 (unsigned long)z->produced, (unsigned long)z->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+void ota_inflate_end(ota_inflate_t *z)
+{
+    free(z->decomp);
+    free(z->window);
+    z->decomp = NULL;
+    z->window = NULL;
+}
@@ -0,0 +1,112 @@
+#ifndef OTA_INFLATE_H
+#define OTA_INFLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define OTA_INFLATE_MAGIC "MDZ1"
+#define OTA_INFLATE_WINDOW_BITS 14      // Fenêtre de décompression: 16 KB
+
+/**
+ * @brief En-tête d'un flux compressé (produit par make_compressed.py), little-endian
+ *
+ * Suivi d'une suite de blocs indépendants:
+ *   uint32 longueur compressée du bloc
+ *   flux deflate brut (sans en-tête zlib), terminé dans le bloc, dont les
+ *   références ne remontent pas plus loin que 1 << window_bits octets
+ *
+ * Chaque bloc repart d'un dictionnaire vide: la décompression peut reprendre
+ * au début de n'importe quel bloc (téléchargement interrompu). Le flux
+ * décompressé est une image complète ou un patch (ota_delta), vérifiés comme
+ * s'ils avaient été reçus tels quels: le format n'ajoute pas de somme de
+ * contrôle.
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];                      // OTA_INFLATE_MAGIC
+    uint32_t size;                      // Taille du flux décompressé
+    uint8_t window_bits;                // Fenêtre utilisée à la compression
+    uint8_t reserved[3];
+} ota_inflate_header_t;
+
+/**
+ * @brief Reçoit les octets décompressés, dans l'ordre
+ */
+typedef esp_err_t (*ota_inflate_output_t)(const void *data, size_t len);
+
+/**
+ * @brief Signale le début d'un bloc, où la décompression pourrait reprendre
+ * @param consumed Octets du flux lus jusqu'ici (après l'en-tête)
+ * @param produced Octets décompressés transmis jusqu'ici
+ */
+typedef void (*ota_inflate_frame_t)(uint32_t consumed, uint32_t produced);
+
+/**
+ * @brief Décompression en flux, mémoire constante
+ *
+ * Le décompresseur de la ROM (tinfl) écrit dans une fenêtre circulaire de
+ * 1 << OTA_INFLATE_WINDOW_BITS octets, transmise à output au fil de l'eau.
+ * Fenêtre et état sont alloués par ota_inflate_begin(), libérés par
+ * ota_inflate_end().
+ */
+typedef struct {
+    uint32_t size;
+    ota_inflate_output_t output;
+    ota_inflate_frame_t frame;
+
+    // État interne
+    void *decomp;                       // tinfl_decompressor (~11 KB)
+    uint8_t *window;
+    size_t window_pos;
+    uint32_t consumed;
+    uint32_t produced;
+    uint8_t frame_head[4];              // Longueur du bloc suivant en cours de lecture
+    uint8_t frame_head_len;
+    uint32_t frame_left;                // Octets compressés restants dans le bloc
+    bool done;                          // Fin du flux deflate du bloc atteinte
+} ota_inflate_t;
+
+/**
+ * @brief Indique si le début d'un flux est compressé
+ * @param data Au moins 4 octets
+ */
+bool ota_inflate_is_compressed(const void *data);
+
+/**
+ * @brief Prépare la décompression
+ * @param frame Appelé au début de chaque bloc, peut être NULL
+ * @return ESP_OK si succès
+ *         ESP_ERR_NOT_SUPPORTED si la fenêtre dépasse OTA_INFLATE_WINDOW_BITS
+ *         ESP_ERR_INVALID_SIZE si la taille annoncée est nulle
+ *         ESP_ERR_NO_MEM
+ */
+esp_err_t ota_inflate_begin(ota_inflate_t *z, const ota_inflate_header_t *header,
+                            ota_inflate_output_t output, ota_inflate_frame_t frame);
+
+/**
+ * @brief Reprend la décompression au début d'un bloc signalé par frame
+ *
+ * À appeler juste après ota_inflate_begin(); le flux est ensuite fourni à
+ * partir de l'octet consumed (après l'en-tête).
+ */
+void ota_inflate_resume(ota_inflate_t *z, uint32_t consumed, uint32_t produced);
+
+/**
+ * @brief Fournit le morceau suivant du flux (après l'en-tête)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si le flux est corrompu, ou l'erreur de output
+ */
+esp_err_t ota_inflate_feed(ota_inflate_t *z, const uint8_t *data, size_t len);
+
+/**
+ * @brief Termine la décompression
+ * @return ESP_OK si le flux est complet et a produit size octets
+ */
+esp_err_t ota_inflate_finish(ota_inflate_t *z);
+
+/**
+ * @brief Libère la fenêtre et l'état (sans effet si déjà libérés)
+ */
+void ota_inflate_end(ota_inflate_t *z);
+
+#endif // OTA_INFLATE_H
@@ -1,13 +1,22 @@
 #include "ota_manager.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
+#include "esp_partition.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
 #include "esp_app_format.h"
 #include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "cJSON.h"
+#include "mbedtls/sha256.h"
+#include "ota_delta.h"
+#include "ota_inflate.h"
+#include "nvs_storage.h"
 #include "version.h"
+#include "sdkconfig.h"
 #include <string.h>
+#include <stdlib.h>
 
 static const char *TAG = "OTA_MANAGER";
 
@@ -17,7 +26,8 @@ static const char *TAG = "OTA_MANAGER";
 static char http_response_buffer[HTTP_RESPONSE_BUFFER_SIZE];
 static int http_response_len = 0;
 
-// Variable globale pour la progression OTA (accessible depuis le serveur web)
+// Progression OTA, écrite par la tâche OTA et lue par le serveur web
+// (copie sous s_progress_lock: ota_manager_get_progress)
 static ota_progress_t ota_progress = {
     .in_progress = false,
     .total_size = 0,
@@ -25,6 +35,67 @@ static ota_progress_t ota_progress = {
     .percent = 0,
     .status = "Idle"
 };
+static portMUX_TYPE s_progress_lock = portMUX_INITIALIZER_UNLOCKED;
+static ota_progress_cb_t s_progress_callback = NULL;
+
+// Résultat de la dernière vérification GitHub réussie (servi par /api/bootstrap)
+static ota_update_info_t s_last_check;
+static int64_t s_last_check_us = 0;         // 0 = aucune vérification réussie
+static portMUX_TYPE s_last_check_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// En-têtes de la dernière réponse utiles à la reprise (relevés par ota_http_event_handler)
+static char s_http_etag[64];
+static char s_http_content_range[64];
+
+/**
+ * Notifie le changement de progression (pourcentage ou status)
+ */
+static void ota_progress_notify(void)
+{
+    ota_progress_cb_t callback = s_progress_callback;
+    if (callback) {
+        ota_progress_t progress;
+        ota_manager_get_progress(&progress);
+        callback(&progress);
+    }
+}
+
+/**
+ * Met à jour le status de la progression et le notifie
+ */
+static void ota_progress_set_status(const char *status, bool in_progress)
+{
+    taskENTER_CRITICAL(&s_progress_lock);
+    strlcpy(ota_progress.status, status, sizeof(ota_progress.status));
+    ota_progress.in_progress = in_progress;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    ota_progress_notify();
+}
+
+/**
+ * Réserve la progression pour une nouvelle mise à jour
+ * Test et marquage sous le même verrou: deux requêtes simultanées (URL et
+ * upload, ou deux uploads) ne peuvent pas démarrer toutes les deux
+ * @return false si une mise à jour est déjà en cours
+ */
+static bool ota_progress_claim(void)
+{
+    taskENTER_CRITICAL(&s_progress_lock);
+    bool claimed = !ota_progress.in_progress;
+    ota_progress.in_progress = true;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    return claimed;
+}
+
+/**
+ * Libère la progression réservée par ota_progress_claim() sans changer le status
+ */
+static void ota_progress_release(void)
+{
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.in_progress = false;
+    taskEXIT_CRITICAL(&s_progress_lock);
+}
 
 /**
  * ÉTAPE A : Initialisation - Valider le firmware actuel
@@ -73,6 +144,11 @@ static esp_err_t ota_http_event_handler(esp_http_client_event_t *evt)
         break;
     case HTTP_EVENT_ON_HEADER:
         ESP_LOGD(TAG, "Header: %s: %s", evt->header_key, evt->header_value);
+        if (strcasecmp(evt->header_key, "ETag") == 0) {
+            snprintf(s_http_etag, sizeof(s_http_etag), "%s", evt->header_value);
+        } else if (strcasecmp(evt->header_key, "Content-Range") == 0) {
+            snprintf(s_http_content_range, sizeof(s_http_content_range), "%s", evt->header_value);
+        }
         break;
     case HTTP_EVENT_ON_DATA:
         // Ne rien afficher ici, on gère la progression dans la fonction principale
@@ -90,7 +166,899 @@ static esp_err_t ota_http_event_handler(esp_http_client_event_t *evt)
 }
 
 /**
- * ÉTAPE C : Lancer la mise à jour OTA
+ * ÉTAPE C : Écrire l'image reçue dans la partition inactive
+ *
+ * Partagé par le téléchargement (URL) et l'envoi direct (POST /api/ota_upload).
+ * Le flux reçu est soit une image complète, soit un patch (ota_delta) appliqué
+ * contre la partition courante: seul le patch transite alors sur le réseau.
+ * L'un ou l'autre peut être compressé (ota_inflate): le flux décompressé
+ * repasse alors par la même détection de format.
+ *
+ * Le début de l'image (en-tête, premier segment, description de l'app) est
+ * gardé en mémoire jusqu'à sa validation: une image étrangère est refusée
+ * avant tout effacement. Le reste est écrit en flash au fil de la réception,
+ * par secteurs entiers effacés juste avant: sans esp_ota_begin(), un
+ * téléchargement interrompu peut reprendre dans la même partition (ÉTAPE C bis).
+ * esp_ota_set_boot_partition() vérifie l'image complète avant de la retenir.
+ */
+#define OTA_IMAGE_HEADER_SIZE (sizeof(esp_image_header_t) + \
+                               sizeof(esp_image_segment_header_t) + \
+                               sizeof(esp_app_desc_t))
+#define OTA_FLASH_SECTOR_SIZE 4096
+
+typedef enum {
+    OTA_PAYLOAD_UNKNOWN,        // Format pas encore identifié
+    OTA_PAYLOAD_IMAGE,          // Image complète
+    OTA_PAYLOAD_DELTA,          // Patch contre la partition courante
+} ota_payload_t;
+
+static const esp_partition_t *s_image_partition = NULL;
+static bool s_image_opened = false;             // En-tête validé, écriture en flash commencée
+static uint8_t s_image_header[OTA_IMAGE_HEADER_SIZE];
+static size_t s_image_header_len = 0;
+static int64_t s_image_start_us = 0;
+static uint32_t s_image_written = 0;            // Octets de l'image produits
+static mbedtls_sha256_context s_image_sha;      // Image produite, au fil des secteurs écrits
+static bool s_image_sha_active = false;
+
+static uint8_t s_flash_buffer[OTA_FLASH_SECTOR_SIZE];  // Secteur en cours de remplissage
+static size_t s_flash_buffer_len = 0;
+static uint32_t s_flash_offset = 0;             // Octets de l'image écrits en flash
+
+static ota_payload_t s_payload = OTA_PAYLOAD_UNKNOWN;
+static ota_delta_header_t s_delta_header;       // Début du flux tant que le format est inconnu
+static size_t s_payload_head_len = 0;
+static ota_delta_t s_delta;
+static bool s_compressed = false;               // s_payload décrit alors le flux décompressé
+static ota_inflate_t s_inflate;
+
+/**
+ * Point de reprise d'un téléchargement, gardé en NVS (nvs_storage)
+ *
+ * Seule une image complète, compressée ou non, peut reprendre: à image_offset
+ * (secteurs déjà écrits) correspond un octet du flux à partir duquel tout
+ * l'état du pipeline se reconstruit. Un patch recommence depuis le début.
+ */
+#define OTA_CHECKPOINT_MAGIC 0x4f545031         // "OTP1"
+#define OTA_CHECKPOINT_INTERVAL (64 * 1024)     // Octets d'image entre deux sauvegardes
+
+typedef struct {
+    uint32_t magic;                     // OTA_CHECKPOINT_MAGIC
+    uint32_t partition_address;
+    char url[256];
+    char etag[64];                      // Envoyé en If-Range, vide si le serveur n'en donne pas
+    uint32_t payload_size;              // Taille du fichier téléchargé
+    uint32_t payload_offset;            // Octets du fichier à ne pas retélécharger
+    uint32_t image_offset;              // Octets de l'image écrits en flash (secteurs complets)
+    uint8_t image_sha256[32];           // SHA-256 de ces octets, vérifié avant la reprise
+    ota_inflate_header_t inflate_header;    // Fichier compressé, magic nul sinon
+} ota_checkpoint_t;
+
+static ota_checkpoint_t s_checkpoint;
+static bool s_checkpoint_enabled = false;       // Téléchargement depuis une URL
+static uint32_t s_checkpoint_saved = 0;         // image_offset du dernier point sauvegardé
+
+static esp_err_t ota_payload_write(const void *data, size_t len);
+
+static esp_err_t ota_image_validate_header(void)
+{
+    const esp_image_header_t *header = (const esp_image_header_t *)s_image_header;
+    const esp_app_desc_t *desc = (const esp_app_desc_t *)(s_image_header +
+        sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t));
+
+    if (header->magic != ESP_IMAGE_HEADER_MAGIC) {
+        ESP_LOGE(TAG, "Invalid image magic 0x%02x", header->magic);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (header->chip_id != CONFIG_IDF_FIRMWARE_CHIP_ID) {
+        ESP_LOGE(TAG, "Image built for chip id %d, expected %d",
+                 header->chip_id, CONFIG_IDF_FIRMWARE_CHIP_ID);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (desc->magic_word != ESP_APP_DESC_MAGIC_WORD) {
+        ESP_LOGE(TAG, "Missing application description");
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+
+    const esp_app_desc_t *running = esp_app_get_description();
+    if (strncmp(desc->project_name, running->project_name, sizeof(desc->project_name)) != 0) {
+        ESP_LOGE(TAG, "Image is for project '%.32s', not '%.32s'",
+                 desc->project_name, running->project_name);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+
+    ESP_LOGI(TAG, "New image: %.32s %.32s", desc->project_name, desc->version);
+    return ESP_OK;
+}
+
+/**
+ * Retient le point de reprise courant: secteurs écrits jusqu'à s_flash_offset,
+ * atteint après payload_offset octets du fichier
+ */
+static void ota_checkpoint_mark(uint32_t payload_offset)
+{
+    if (!s_checkpoint_enabled || s_payload != OTA_PAYLOAD_IMAGE ||
+        s_flash_buffer_len != 0 || s_flash_offset == 0) {
+        return;
+    }
+
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_clone(&ctx, &s_image_sha);
+    mbedtls_sha256_finish(&ctx, s_checkpoint.image_sha256);
+    mbedtls_sha256_free(&ctx);
+
+    s_checkpoint.payload_offset = payload_offset;
+    s_checkpoint.image_offset = s_flash_offset;
+}
+
+static void ota_checkpoint_save(void)
+{
+    if (!s_checkpoint_enabled || s_checkpoint.image_offset == s_checkpoint_saved) {
+        return;
+    }
+    if (nvs_storage_save_ota_checkpoint(&s_checkpoint, sizeof(s_checkpoint)) == ESP_OK) {
+        s_checkpoint_saved = s_checkpoint.image_offset;
+        ESP_LOGD(TAG, "Checkpoint saved at %lu bytes", (unsigned long)s_checkpoint.payload_offset);
+    }
+}
+
+/**
+ * Écrit le secteur en cours de remplissage, effacé juste avant
+ */
+static esp_err_t ota_flash_flush(void)
+{
+    if (s_flash_buffer_len == 0) {
+        return ESP_OK;
+    }
+    if (s_flash_offset + s_flash_buffer_len > s_image_partition->size) {
+        ESP_LOGE(TAG, "Image too large for partition %s", s_image_partition->label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    mbedtls_sha256_update(&s_image_sha, s_flash_buffer, s_flash_buffer_len);
+
+    // Flash chiffrée: écritures par multiples de 16 octets (dernier secteur)
+    size_t len = (s_flash_buffer_len + 15) & ~(size_t)15;
+    memset(s_flash_buffer + s_flash_buffer_len, 0xff, len - s_flash_buffer_len);
+
+    esp_err_t ret = esp_partition_erase_range(s_image_partition, s_flash_offset, OTA_FLASH_SECTOR_SIZE);
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(s_image_partition, s_flash_offset, s_flash_buffer, len);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Flash write failed at 0x%lx: %s",
+                 (unsigned long)s_flash_offset, esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_flash_offset += s_flash_buffer_len;
+    s_flash_buffer_len = 0;
+
+    // Image non compressée: l'octet d'image est aussi l'octet du fichier
+    if (!s_compressed) {
+        ota_checkpoint_mark(s_flash_offset);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_flash_write(const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        size_t n = OTA_FLASH_SECTOR_SIZE - s_flash_buffer_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s_flash_buffer + s_flash_buffer_len, data, n);
+        s_flash_buffer_len += n;
+        data += n;
+        len -= n;
+
+        if (s_flash_buffer_len == OTA_FLASH_SECTOR_SIZE) {
+            esp_err_t ret = ota_flash_flush();
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * Reçoit les octets de l'image, directement ou produits par le patch
+ */
+static esp_err_t ota_image_output(const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    s_image_written += len;
+
+    if (!s_image_opened) {
+        size_t n = OTA_IMAGE_HEADER_SIZE - s_image_header_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s_image_header + s_image_header_len, bytes, n);
+        s_image_header_len += n;
+        bytes += n;
+        len -= n;
+
+        if (s_image_header_len < OTA_IMAGE_HEADER_SIZE) {
+            return ESP_OK;
+        }
+
+        esp_err_t ret = ota_image_validate_header();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        s_image_opened = true;
+
+        ret = ota_flash_write(s_image_header, s_image_header_len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    return ota_flash_write(bytes, len);
+}
+
+/**
+ * Début d'un bloc compressé: point de reprise si les blocs précédents sont en flash
+ */
+static void ota_inflate_on_frame(uint32_t consumed, uint32_t produced)
+{
+    if (produced == s_flash_offset) {
+        ota_checkpoint_mark(sizeof(ota_inflate_header_t) + consumed);
+    }
+}
+
+/**
+ * En-tête de compression complet: la suite du flux passe par ota_inflate
+ */
+static esp_err_t ota_compressed_detect(void)
+{
+    if (s_compressed) {
+        ESP_LOGE(TAG, "Nested compressed stream");
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (s_payload_head_len < sizeof(ota_inflate_header_t)) {
+        return ESP_OK;
+    }
+
+    ota_inflate_header_t header;
+    memcpy(&header, &s_delta_header, sizeof(header));
+    esp_err_t ret = ota_inflate_begin(&s_inflate, &header, ota_payload_write, ota_inflate_on_frame);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Nouvelle détection sur le flux décompressé
+    s_checkpoint.inflate_header = header;
+    s_compressed = true;
+    s_payload_head_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * Identifie le format du flux à partir de ses premiers octets
+ * @param data,len Octets reçus, *consumed: octets gardés pour l'identification
+ */
+static esp_err_t ota_payload_detect(const uint8_t *data, size_t len, size_t *consumed)
+{
+    uint8_t *head = (uint8_t *)&s_delta_header;
+    size_t want = s_payload_head_len < 4 ? 4 :
+                  ota_inflate_is_compressed(head) ? sizeof(ota_inflate_header_t) :
+                  sizeof(s_delta_header);
+    size_t n = want - s_payload_head_len;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(head + s_payload_head_len, data, n);
+    s_payload_head_len += n;
+    *consumed = n;
+
+    if (s_payload_head_len >= 1 && head[0] == ESP_IMAGE_HEADER_MAGIC) {
+        s_payload = OTA_PAYLOAD_IMAGE;
+        return ota_image_output(head, s_payload_head_len);
+    }
+    if (s_payload_head_len < 4) {
+        return ESP_OK;
+    }
+    if (ota_inflate_is_compressed(head)) {
+        return ota_compressed_detect();
+    }
+    if (!ota_delta_is_patch(head)) {
+        ESP_LOGE(TAG, "Unknown image format");
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (s_payload_head_len < sizeof(s_delta_header)) {
+        return ESP_OK;
+    }
+
+    if (s_delta_header.target_size > s_image_partition->size) {
+        ESP_LOGE(TAG, "Patched image too large for partition %s", s_image_partition->label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = ota_delta_begin(&s_delta, &s_delta_header,
+                                    esp_ota_get_running_partition(), ota_image_output);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_payload = OTA_PAYLOAD_DELTA;
+    return ESP_OK;
+}
+
+/**
+ * Libère ce que la réception en cours a alloué
+ */
+static void ota_image_release(void)
+{
+    if (s_image_sha_active) {
+        mbedtls_sha256_free(&s_image_sha);
+        s_image_sha_active = false;
+    }
+    if (s_compressed) {
+        ota_inflate_end(&s_inflate);
+        s_compressed = false;
+    }
+    s_image_opened = false;
+}
+
+/**
+ * Prépare la réception d'un flux de payload_size octets
+ */
+static esp_err_t ota_image_begin(size_t payload_size)
+{
+    ota_image_release();
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "No OTA partition available");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (payload_size < sizeof(ota_inflate_header_t) || payload_size > partition->size) {
+        ESP_LOGE(TAG, "Invalid image size %u (partition %s: %lu bytes)",
+                 (unsigned)payload_size, partition->label, (unsigned long)partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    s_image_partition = partition;
+    s_image_header_len = 0;
+    s_payload = OTA_PAYLOAD_UNKNOWN;
+    s_payload_head_len = 0;
+    s_image_start_us = esp_timer_get_time();
+    s_image_written = 0;
+    s_flash_buffer_len = 0;
+    s_flash_offset = 0;
+
+    mbedtls_sha256_init(&s_image_sha);
+    mbedtls_sha256_starts(&s_image_sha, 0);
+    s_image_sha_active = true;
+
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.total_size = payload_size;
+    ota_progress.downloaded = 0;
+    ota_progress.percent = 0;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    return ESP_OK;
+}
+
+/**
+ * Transmet le flux, tel que reçu ou décompressé, à l'étape qui correspond à son format
+ */
+static esp_err_t ota_payload_write(const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+
+    while (len > 0 && s_payload == OTA_PAYLOAD_UNKNOWN) {
+        bool compressed = s_compressed;
+        size_t consumed;
+        esp_err_t ret = ota_payload_detect(bytes, len, &consumed);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        bytes += consumed;
+        len -= consumed;
+
+        if (s_compressed != compressed) {
+            return len > 0 ? ota_inflate_feed(&s_inflate, bytes, len) : ESP_OK;
+        }
+    }
+
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (s_payload == OTA_PAYLOAD_DELTA) {
+        return ota_delta_feed(&s_delta, bytes, len);
+    }
+    return ota_image_output(bytes, len);
+}
+
+/**
+ * Écrit le morceau suivant du flux, dans l'ordre de réception
+ */
+static esp_err_t ota_image_write(const void *data, size_t len)
+{
+    esp_err_t ret = s_compressed ? ota_inflate_feed(&s_inflate, data, len) :
+                                   ota_payload_write(data, len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    int percent = ota_progress.total_size > 0 ?
+                  (int)((int64_t)(ota_progress.downloaded + len) * 100 / ota_progress.total_size) : 0;
+    bool changed = percent != ota_progress.percent;
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.downloaded += len;
+    ota_progress.percent = percent;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    if (changed) {
+        ota_progress_notify();
+    }
+
+    if (s_checkpoint.image_offset >= s_checkpoint_saved + OTA_CHECKPOINT_INTERVAL) {
+        ota_checkpoint_save();
+    }
+    return ESP_OK;
+}
+
+/**
+ * Vérifie l'image complète et la sélectionne pour le prochain boot
+ */
+static esp_err_t ota_image_end(void)
+{
+    if (ota_progress.downloaded != ota_progress.total_size) {
+        ESP_LOGE(TAG, "Image incomplete (%d / %d bytes)",
+                 ota_progress.downloaded, ota_progress.total_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool compressed = s_compressed;
+    esp_err_t ret = ESP_OK;
+    if (compressed) {
+        ret = ota_inflate_finish(&s_inflate);
+        ota_inflate_end(&s_inflate);
+        s_compressed = false;
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    int64_t elapsed_ms = (esp_timer_get_time() - s_image_start_us) / 1000;
+    ESP_LOGI(TAG, "Transfer took %lld ms: %d wire bytes -> %lu image bytes (%lld KB/s, %s%s)",
+             elapsed_ms, ota_progress.total_size, (unsigned long)s_image_written,
+             elapsed_ms > 0 ? (int64_t)ota_progress.total_size / elapsed_ms : 0,
+             compressed ? "compressed " : "",
+             s_payload == OTA_PAYLOAD_DELTA ? "delta" : "full image");
+    ota_progress_set_status("Verifying...", true);
+
+    if (s_payload == OTA_PAYLOAD_DELTA) {
+        ret = ota_delta_finish(&s_delta);
+    }
+    if (ret == ESP_OK && !s_image_opened) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret == ESP_OK) {
+        ret = ota_flash_flush();
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&s_image_sha, digest);
+    mbedtls_sha256_free(&s_image_sha);
+    s_image_sha_active = false;
+    if (s_payload == OTA_PAYLOAD_DELTA) {
+        if (memcmp(digest, s_delta_header.target_sha256, sizeof(digest)) != 0) {
+            ESP_LOGE(TAG, "Patched image SHA-256 mismatch");
+            return ESP_ERR_OTA_VALIDATE_FAILED;
+        }
+        ESP_LOGI(TAG, "Patched image verified (%lu bytes)", (unsigned long)s_delta_header.target_size);
+    }
+
+    // esp_ota_set_boot_partition() vérifie l'image écrite (segments, SHA-256 ajouté au build)
+    s_image_opened = false;
+    return esp_ota_set_boot_partition(s_image_partition);
+}
+
+static void ota_image_abort(const char *status)
+{
+    ota_image_release();
+    ota_progress_set_status(status, false);
+}
+
+/**
+ * Message de progression pour une erreur d'écriture
+ */
+static const char *ota_image_error_status(esp_err_t err)
+{
+    switch (err) {
+    case ESP_ERR_INVALID_VERSION: return "Patch does not match installed firmware";
+    case ESP_ERR_OTA_VALIDATE_FAILED: return "Invalid firmware image";
+    case ESP_ERR_INVALID_SIZE: return "Invalid firmware size";
+    default: return "Update failed";
+    }
+}
+
+/**
+ * ÉTAPE C bis : Reprendre un téléchargement depuis son point de reprise
+ *
+ * Les secteurs déjà écrits sont relus et comparés au SHA-256 enregistré:
+ * l'état du pipeline (hash de l'image, en-tête validé, décompression) est
+ * reconstruit et le téléchargement continue avec Range.
+ */
+static esp_err_t ota_checkpoint_resume(const char *url)
+{
+    if (nvs_storage_load_ota_checkpoint(&s_checkpoint, sizeof(s_checkpoint)) != ESP_OK ||
+        s_checkpoint.magic != OTA_CHECKPOINT_MAGIC || strcmp(s_checkpoint.url, url) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL || partition->address != s_checkpoint.partition_address ||
+        s_checkpoint.image_offset % OTA_FLASH_SECTOR_SIZE != 0 ||
+        s_checkpoint.image_offset > partition->size ||
+        s_checkpoint.payload_offset >= s_checkpoint.payload_size) {
+        ESP_LOGW(TAG, "Checkpoint does not apply to partition layout, restarting download");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ota_image_begin(s_checkpoint.payload_size);
+    for (uint32_t pos = 0; ret == ESP_OK && pos < s_checkpoint.image_offset; pos += OTA_FLASH_SECTOR_SIZE) {
+        ret = esp_partition_read(partition, pos, s_flash_buffer, OTA_FLASH_SECTOR_SIZE);
+        if (ret == ESP_OK) {
+            mbedtls_sha256_update(&s_image_sha, s_flash_buffer, OTA_FLASH_SECTOR_SIZE);
+        }
+    }
+    if (ret == ESP_OK) {
+        uint8_t digest[32];
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_clone(&ctx, &s_image_sha);
+        mbedtls_sha256_finish(&ctx, digest);
+        mbedtls_sha256_free(&ctx);
+        if (memcmp(digest, s_checkpoint.image_sha256, sizeof(digest)) != 0) {
+            ESP_LOGW(TAG, "Partition content changed since checkpoint, restarting download");
+            ret = ESP_ERR_INVALID_CRC;
+        }
+    }
+    if (ret == ESP_OK) {
+        s_image_header_len = OTA_IMAGE_HEADER_SIZE;
+        ret = esp_partition_read(partition, 0, s_image_header, OTA_IMAGE_HEADER_SIZE);
+    }
+    if (ret == ESP_OK) {
+        ret = ota_image_validate_header();
+    }
+    if (ret == ESP_OK && ota_inflate_is_compressed(&s_checkpoint.inflate_header)) {
+        ret = ota_inflate_begin(&s_inflate, &s_checkpoint.inflate_header,
+                                ota_payload_write, ota_inflate_on_frame);
+        if (ret == ESP_OK) {
+            s_compressed = true;
+            ota_inflate_resume(&s_inflate, s_checkpoint.payload_offset - sizeof(ota_inflate_header_t),
+                               s_checkpoint.image_offset);
+        }
+    }
+    if (ret != ESP_OK) {
+        ota_image_release();
+        return ret;
+    }
+
+    s_image_opened = true;
+    s_payload = OTA_PAYLOAD_IMAGE;
+    s_image_written = s_checkpoint.image_offset;
+    s_flash_offset = s_checkpoint.image_offset;
+    s_checkpoint_saved = s_checkpoint.image_offset;
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.downloaded = s_checkpoint.payload_offset;
+    ota_progress.percent = (int)((int64_t)ota_progress.downloaded * 100 / ota_progress.total_size);
+    taskEXIT_CRITICAL(&s_progress_lock);
+
+    ESP_LOGI(TAG, "Resuming update from checkpoint: %lu / %lu bytes already downloaded",
+             (unsigned long)s_checkpoint.payload_offset, (unsigned long)s_checkpoint.payload_size);
+    return ESP_OK;
+}
+
+/**
+ * ÉTAPE C ter : Suivre les redirections (GitHub renvoie vers son stockage)
+ */
+#define OTA_MAX_REDIRECTS 5
+#define OTA_MAX_RETRIES 6               // Échecs consécutifs sans progression avant abandon
+#define OTA_RETRY_DELAY_MS 1000         // Doublé à chaque échec
+#define OTA_RETRY_MAX_DELAY_MS 30000
+#define OTA_CHUNK_MIN 2048
+#define OTA_CHUNK_MAX 8192              // Tampon alloué le temps du téléchargement
+#define OTA_CHUNK_INITIAL 4096
+#define OTA_CHUNK_PERIOD (64 * 1024)    // Octets reçus entre deux ajustements
+#define OTA_CHUNK_SLOW_MS 1000          // Lecture plus longue: taille réduite
+
+static esp_err_t ota_http_open(esp_http_client_handle_t client, int64_t *content_length, int *status_code)
+{
+    for (int redirects = 0; ; redirects++) {
+        s_http_etag[0] = '\0';
+        s_http_content_range[0] = '\0';
+
+        esp_err_t err = esp_http_client_open(client, 0);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Connection failed: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        int64_t length = esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+
+        if (status == 301 || status == 302 || status == 303 || status == 307 || status == 308) {
+            if (redirects >= OTA_MAX_REDIRECTS) {
+                ESP_LOGE(TAG, "Too many redirects");
+                return ESP_FAIL;
+            }
+            esp_http_client_flush_response(client, NULL);
+            err = esp_http_client_set_redirection(client);
+            if (err != ESP_OK) {
+                return err;
+            }
+            continue;
+        }
+
+        *status_code = status;
+        if (status != 200 && status != 206) {
+            ESP_LOGE(TAG, "Download failed with status code: %d", status);
+            return ESP_FAIL;
+        }
+        *content_length = length;
+        return ESP_OK;
+    }
+}
+
+/**
+ * Affiche la barre de progression quand le pourcentage change
+ */
+static void ota_log_progress(int *last_percent)
+{
+    int percent = ota_progress.percent;
+    if (percent == *last_percent) {
+        return;
+    }
+
+    // Créer une barre visuelle [=====>    ]
+    char progress_bar[53];  // [ + 50 caractères + ] + \0
+    int filled = percent / 2;  // 50 caractères max
+    int i;
+
+    progress_bar[0] = '[';
+    for (i = 1; i <= 50; i++) {
+        if (i < filled) {
+            progress_bar[i] = '=';
+        } else if (i == filled) {
+            progress_bar[i] = '>';
+        } else {
+            progress_bar[i] = ' ';
+        }
+    }
+    progress_bar[51] = ']';
+    progress_bar[52] = '\0';
+
+    ESP_LOGI(TAG, "Progress: %s %d%% (%d / %d bytes)",
+             progress_bar, percent, ota_progress.downloaded, ota_progress.total_size);
+    *last_percent = percent;
+}
+
+/**
+ * Taille de lecture adaptée au débit mesuré
+ *
+ * Toute l'image passe par une seule requête (keep-alive): la taille de lecture
+ * fixe le nombre d'appels à esp_http_client_read() et d'écritures de l'image.
+ * Elle double tant que le débit de bout en bout (écriture en flash comprise)
+ * progresse de plus de 5 % d'une période à l'autre. Une hausse sans gain est
+ * conservée, une hausse suivie d'une baisse est annulée; la taille ne bouge
+ * plus ensuite, sauf lecture lente ou coupure: elle diminue alors de moitié
+ * et la recherche reprend.
+ */
+typedef struct {
+    int size;
+    int64_t period_start_us;
+    int period_bytes;
+    int last_throughput;            // Débit de la période précédente (bytes/s)
+    bool grown;                     // Taille doublée à la fin de la période précédente
+    bool settled;                   // Hausse annulée: taille conservée
+} ota_chunk_t;
+
+static ota_chunk_t s_chunk;
+
+static void ota_chunk_reset(void)
+{
+    memset(&s_chunk, 0, sizeof(s_chunk));
+    s_chunk.size = OTA_CHUNK_INITIAL;
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.chunk_size = s_chunk.size;
+    ota_progress.chunk_latency_ms = 0;
+    ota_progress.throughput = 0;
+    taskEXIT_CRITICAL(&s_progress_lock);
+}
+
+static void ota_chunk_resize(int size, const char *reason)
+{
+    if (size < OTA_CHUNK_MIN) {
+        size = OTA_CHUNK_MIN;
+    } else if (size > OTA_CHUNK_MAX) {
+        size = OTA_CHUNK_MAX;
+    }
+    if (size != s_chunk.size) {
+        ESP_LOGI(TAG, "Read size %d -> %d bytes (%s, %d KB/s)",
+                 s_chunk.size, size, reason, ota_progress.throughput / 1024);
+        s_chunk.size = size;
+        taskENTER_CRITICAL(&s_progress_lock);
+        ota_progress.chunk_size = size;
+        taskEXIT_CRITICAL(&s_progress_lock);
+    }
+}
+
+/**
+ * Réduit la taille de lecture après une coupure; la mesure repart de zéro
+ */
+static void ota_chunk_shrink(const char *reason)
+{
+    ota_chunk_resize(s_chunk.size / 2, reason);
+    s_chunk.period_start_us = 0;
+    s_chunk.last_throughput = 0;
+    s_chunk.grown = false;
+    s_chunk.settled = false;
+}
+
+/**
+ * Enregistre une lecture et ajuste la taille à la fin de chaque période
+ * @param start_us Début de la lecture, après obtention du tampon
+ */
+static void ota_chunk_record(int len, int64_t start_us)
+{
+    int64_t now = esp_timer_get_time();
+    int latency_ms = (int)((now - start_us) / 1000);
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.chunk_latency_ms = latency_ms;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    ESP_LOGD(TAG, "Read %d bytes in %d ms", len, latency_ms);
+
+    if (latency_ms > OTA_CHUNK_SLOW_MS) {
+        ota_chunk_shrink("slow read");
+        return;
+    }
+
+    if (s_chunk.period_start_us == 0) {
+        // Première lecture: la période commence à sa fin (connexion exclue)
+        s_chunk.period_start_us = now;
+        s_chunk.period_bytes = 0;
+        return;
+    }
+    s_chunk.period_bytes += len;
+    if (s_chunk.period_bytes < OTA_CHUNK_PERIOD) {
+        return;
+    }
+
+    int throughput = (int)((int64_t)s_chunk.period_bytes * 1000000 / (now - s_chunk.period_start_us));
+    int last = s_chunk.last_throughput;
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.throughput = throughput;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    s_chunk.period_start_us = now;
+    s_chunk.period_bytes = 0;
+    s_chunk.last_throughput = throughput;
+
+    bool improved = last == 0 || throughput > last + last / 20;
+    if (s_chunk.grown && throughput < last - last / 20) {
+        ota_chunk_resize(s_chunk.size / 2, "throughput dropped");
+        s_chunk.settled = true;
+    } else if (s_chunk.grown && !improved) {
+        s_chunk.settled = true;     // Hausse sans gain: taille conservée
+    }
+    s_chunk.grown = false;
+
+    if (!s_chunk.settled && improved && s_chunk.size < OTA_CHUNK_MAX) {
+        ota_chunk_resize(s_chunk.size * 2, "throughput improved");
+        s_chunk.grown = true;
+    }
+}
+
+/**
+ * Une tentative de téléchargement, à partir de l'octet où la précédente s'est arrêtée
+ * @param buffer Tampon de OTA_CHUNK_MAX octets
+ * @param started Flux déjà commencé (tentative précédente ou point de reprise)
+ * @param retry Mis à true si l'échec vient du réseau et justifie une nouvelle tentative
+ */
+static esp_err_t ota_download(esp_http_client_handle_t client, char *buffer, bool *started, bool *retry)
+{
+    // Chaque tentative repart de l'URL d'origine: une redirection signée peut avoir expiré
+    esp_http_client_set_url(client, s_checkpoint.url);
+    if (*started) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%d-", ota_progress.downloaded);
+        esp_http_client_set_header(client, "Range", range);
+        if (s_checkpoint.etag[0] != '\0') {
+            // Fichier modifié depuis: le serveur renvoie tout (200)
+            esp_http_client_set_header(client, "If-Range", s_checkpoint.etag);
+        } else {
+            esp_http_client_delete_header(client, "If-Range");
+        }
+    }
+
+    int64_t length = 0;
+    int status = 0;
+    esp_err_t ret = ota_http_open(client, &length, &status);
+    if (ret != ESP_OK) {
+        // Pas de réponse ou erreur du serveur: passagères, contrairement à un 404
+        *retry = status == 0 || status >= 500;
+        return ret;
+    }
+
+    *retry = false;
+    if (status == 206 && *started) {
+        // Content-Range: bytes <premier>-<dernier>/<total>
+        long long first = -1, total = -1;
+        sscanf(s_http_content_range, "bytes %lld-%*d/%lld", &first, &total);
+        if (first != ota_progress.downloaded || total != ota_progress.total_size) {
+            ESP_LOGE(TAG, "Unexpected range in response: '%s'", s_http_content_range);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        ESP_LOGI(TAG, "Resuming download at %d / %d bytes",
+                 ota_progress.downloaded, ota_progress.total_size);
+    } else if (status == 200) {
+        if (*started) {
+            ESP_LOGW(TAG, "Server sent the whole file, restarting from the beginning");
+        }
+        if (length <= 0) {
+            ESP_LOGE(TAG, "Unknown firmware size");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        ret = ota_image_begin(length);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        *started = true;
+
+        s_checkpoint.magic = OTA_CHECKPOINT_MAGIC;
+        s_checkpoint.partition_address = s_image_partition->address;
+        snprintf(s_checkpoint.etag, sizeof(s_checkpoint.etag), "%s", s_http_etag);
+        s_checkpoint.payload_size = length;
+        s_checkpoint.payload_offset = 0;
+        s_checkpoint.image_offset = 0;
+        memset(&s_checkpoint.inflate_header, 0, sizeof(s_checkpoint.inflate_header));
+        s_checkpoint_saved = 0;
+
+        ESP_LOGI(TAG, "Firmware size: %lld bytes (%.2f KB)", length, length / 1024.0);
+    } else {
+        ESP_LOGE(TAG, "Unexpected status code: %d", status);
+        return ESP_FAIL;
+    }
+
+    ota_progress_set_status("Downloading...", true);
+
+    // Télécharger et flasher par petits morceaux avec barre de progression
+    int last_percent = -1;
+    while (ota_progress.downloaded < ota_progress.total_size) {
+        int64_t read_start_us = esp_timer_get_time();
+        int len = esp_http_client_read(client, buffer, s_chunk.size);
+        if (len <= 0) {
+            ESP_LOGW(TAG, "Connection lost at %d / %d bytes",
+                     ota_progress.downloaded, ota_progress.total_size);
+            ota_chunk_shrink("connection lost");
+            *retry = true;
+            return ESP_FAIL;
+        }
+
+        ret = ota_image_write(buffer, len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        ota_chunk_record(len, read_start_us);
+        ota_log_progress(&last_percent);
+    }
+    return ESP_OK;
+}
+
+/**
+ * ÉTAPE C quater : Lancer la mise à jour OTA depuis une URL
+ *
+ * Les coupures réseau sont retentées avec un délai croissant; chaque reprise
+ * demande la suite du fichier (Range) sans rien perdre de ce qui est reçu.
  */
 esp_err_t ota_manager_start_update(const char *url)
 {
@@ -98,8 +1066,13 @@ esp_err_t ota_manager_start_update(const char *url)
         ESP_LOGE(TAG, "URL cannot be NULL");
         return ESP_ERR_INVALID_ARG;
     }
+    if (!ota_progress_claim()) {
+        ESP_LOGW(TAG, "Update refused: an update is already in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
 
     ESP_LOGI(TAG, "Starting OTA update from: %s", url);
+    int64_t start_us = esp_timer_get_time();    // Connexion comprise
 
     // Configuration du client HTTP
     esp_http_client_config_t config = {
@@ -111,126 +1084,235 @@ esp_err_t ota_manager_start_update(const char *url)
         .buffer_size_tx = 2048,      // Buffer d'émission (2KB)
     };
 
-    // Déterminer si c'est HTTP ou HTTPS
+    // HTTPS : utiliser le bundle de certificats pour une connexion sécurisée
     if (strncmp(url, "https://", 8) == 0) {
-        // HTTPS : utiliser le bundle de certificats pour une connexion sécurisée
         config.crt_bundle_attach = esp_crt_bundle_attach;
-    } else if (strncmp(url, "http://", 7) == 0) {
-        // HTTP simple : définir cert_pem pour passer la validation
-        static const char dummy_cert[] = "";
-        config.cert_pem = dummy_cert;
-        config.skip_cert_common_name_check = true;
-    }
-
-    // Configuration OTA
-    esp_https_ota_config_t ota_config = {
-        .http_config = &config,
-        .bulk_flash_erase = false,            // Effacer par petits blocs
-        .partial_http_download = true,        // Téléchargement progressif
-        .max_http_request_size = 4096,        // Télécharger par chunks de 4KB
-    };
+    }
 
     ESP_LOGI(TAG, "Attempting to download firmware...");
 
     // Initialiser la progression
-    ota_progress.in_progress = true;
+    taskENTER_CRITICAL(&s_progress_lock);
     ota_progress.total_size = 0;
     ota_progress.downloaded = 0;
     ota_progress.percent = 0;
-    snprintf(ota_progress.status, sizeof(ota_progress.status), "Connecting...");
+    taskEXIT_CRITICAL(&s_progress_lock);
+    ota_progress_set_status("Connecting...", true);
 
-    // Démarrer l'OTA avec l'API avancée pour avoir le contrôle de la progression
-    esp_https_ota_handle_t ota_handle = NULL;
-    esp_err_t ret = esp_https_ota_begin(&ota_config, &ota_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "OTA begin failed: %s", esp_err_to_name(ret));
-        snprintf(ota_progress.status, sizeof(ota_progress.status), "Failed to start");
-        ota_progress.in_progress = false;
-        return ret;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    char *buffer = malloc(OTA_CHUNK_MAX);
+    if (client == NULL || buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        if (client) {
+            esp_http_client_cleanup(client);
+        }
+        free(buffer);
+        ota_progress_set_status("Failed to start", false);
+        return ESP_ERR_NO_MEM;
     }
 
-    // Obtenir la taille totale de l'image
-    int total_size = esp_https_ota_get_image_size(ota_handle);
-    ESP_LOGI(TAG, "Firmware size: %d bytes (%.2f KB)", total_size, total_size / 1024.0);
-
-    ota_progress.total_size = total_size;
-    snprintf(ota_progress.status, sizeof(ota_progress.status), "Downloading...");
+    ota_chunk_reset();
 
-    // Télécharger et flasher par petits morceaux avec barre de progression
-    int downloaded = 0;
-    int last_percent = -1;
+    // Reprendre un téléchargement interrompu de la même URL, reboot compris
+    s_checkpoint_enabled = true;
+    bool started = ota_checkpoint_resume(url) == ESP_OK;
+    if (!started) {
+        nvs_storage_clear_ota_checkpoint();
+        memset(&s_checkpoint, 0, sizeof(s_checkpoint));
+        snprintf(s_checkpoint.url, sizeof(s_checkpoint.url), "%s", url);
+    }
 
+    esp_err_t ret;
+    bool retry = false;
+    int failures = 0;
     while (1) {
-        ret = esp_https_ota_perform(ota_handle);
-        if (ret != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
+        int before = ota_progress.downloaded;
+        ret = ota_download(client, buffer, &started, &retry);
+        if (ret == ESP_OK || !retry) {
             break;
         }
 
-        // Calculer la progression
-        downloaded = esp_https_ota_get_image_len_read(ota_handle);
-        int percent = (downloaded * 100) / total_size;
-
-        // Mettre à jour la progression globale
-        ota_progress.downloaded = downloaded;
-        ota_progress.percent = percent;
-
-        // Afficher la barre de progression uniquement quand le pourcentage change
-        if (percent != last_percent) {
-            // Créer une barre visuelle [=====>    ]
-            char progress_bar[52];  // [50 caractères] + \0
-            int filled = percent / 2;  // 50 caractères max
-            int i;
-
-            progress_bar[0] = '[';
-            for (i = 1; i <= 50; i++) {
-                if (i < filled) {
-                    progress_bar[i] = '=';
-                } else if (i == filled) {
-                    progress_bar[i] = '>';
-                } else {
-                    progress_bar[i] = ' ';
-                }
-            }
-            progress_bar[51] = ']';
-            progress_bar[52] = '\0';
+        if (ota_progress.downloaded > before) {
+            failures = 0;
+        }
+        if (++failures > OTA_MAX_RETRIES) {
+            ESP_LOGE(TAG, "Giving up after %d failed attempts", failures);
+            break;
+        }
+
+        // Un reboot pendant l'attente reprendra au dernier point sauvegardé
+        ota_checkpoint_save();
+        esp_http_client_close(client);
 
-            ESP_LOGI(TAG, "Progress: %s %d%% (%d / %d bytes)",
-                     progress_bar, percent, downloaded, total_size);
-            last_percent = percent;
+        int delay_ms = OTA_RETRY_DELAY_MS << (failures - 1);
+        if (delay_ms > OTA_RETRY_MAX_DELAY_MS) {
+            delay_ms = OTA_RETRY_MAX_DELAY_MS;
         }
+        char status[64];
+        snprintf(status, sizeof(status), "Connection lost, retrying in %d s...", delay_ms / 1000);
+        ESP_LOGW(TAG, "%s (attempt %d/%d)", status, failures, OTA_MAX_RETRIES);
+        ota_progress_set_status(status, true);
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
     }
 
-    if (esp_https_ota_is_complete_data_received(ota_handle) != true) {
-        ESP_LOGE(TAG, "Complete data was not received");
-        snprintf(ota_progress.status, sizeof(ota_progress.status), "Download incomplete");
-        ota_progress.in_progress = false;
-        esp_https_ota_abort(ota_handle);
-        return ESP_FAIL;
-    }
+    esp_http_client_cleanup(client);
+    free(buffer);
 
-    snprintf(ota_progress.status, sizeof(ota_progress.status), "Verifying...");
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "OTA update failed: %s", esp_err_to_name(ret));
+        if (retry) {
+            // Coupure durable: la prochaine tentative (ou le reboot) reprendra ici
+            ota_checkpoint_save();
+            s_checkpoint_enabled = false;
+            ota_image_abort("Download interrupted");
+        } else {
+            s_checkpoint_enabled = false;
+            nvs_storage_clear_ota_checkpoint();
+            ota_image_abort(ota_image_error_status(ret));
+        }
+        return ret;
+    }
 
     // Finaliser l'OTA
-    ret = esp_https_ota_finish(ota_handle);
+    s_checkpoint_enabled = false;
+    ret = ota_image_end();
+    nvs_storage_clear_ota_checkpoint();
 
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "OTA update completed successfully!");
-        snprintf(ota_progress.status, sizeof(ota_progress.status), "Success! Rebooting...");
+        ESP_LOGI(TAG, "OTA update completed successfully in %lld ms end-to-end (%d bytes downloaded)",
+                 (esp_timer_get_time() - start_us) / 1000, ota_progress.downloaded);
+        taskENTER_CRITICAL(&s_progress_lock);
         ota_progress.percent = 100;
+        taskEXIT_CRITICAL(&s_progress_lock);
+        ota_progress_set_status("Success! Rebooting...", true);
         ESP_LOGI(TAG, "Rebooting in 3 seconds...");
         vTaskDelay(3000 / portTICK_PERIOD_MS);
         esp_restart();  // Redémarrer pour booter sur le nouveau firmware
     } else {
         ESP_LOGE(TAG, "OTA update failed: %s", esp_err_to_name(ret));
-        snprintf(ota_progress.status, sizeof(ota_progress.status), "Update failed");
-        ota_progress.in_progress = false;
-        esp_https_ota_abort(ota_handle);
+        ota_image_abort(ota_image_error_status(ret));
         return ret;
     }
 
     return ESP_OK;
 }
 
+static void ota_resume_task(void *param)
+{
+    char *url = param;
+
+    esp_err_t ret = ota_manager_start_update(url);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Resumed update failed: %s", esp_err_to_name(ret));
+    }
+
+    free(url);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ota_manager_resume_pending(void)
+{
+    ota_checkpoint_t *checkpoint = malloc(sizeof(*checkpoint));
+    if (checkpoint == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = nvs_storage_load_ota_checkpoint(checkpoint, sizeof(*checkpoint));
+    if (ret == ESP_OK && (checkpoint->magic != OTA_CHECKPOINT_MAGIC || checkpoint->image_offset == 0)) {
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    char *url = ret == ESP_OK ? strdup(checkpoint->url) : NULL;
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Interrupted update found: %lu / %lu bytes of %s",
+                 (unsigned long)checkpoint->payload_offset, (unsigned long)checkpoint->payload_size, url);
+    }
+    free(checkpoint);
+
+    if (ret != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (url == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(ota_resume_task, "ota_resume", 8192, url, 5, NULL) != pdPASS) {
+        free(url);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * ÉTAPE C quinquies : Recevoir une image poussée par le client
+ */
+esp_err_t ota_manager_upload_begin(size_t image_size)
+{
+    if (!ota_progress_claim()) {
+        ESP_LOGW(TAG, "Upload refused: an update is already in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ota_image_begin(image_size);
+    if (ret != ESP_OK) {
+        ota_progress_release();
+        return ret;
+    }
+
+    // La partition va être réécrite: un téléchargement interrompu ne pourra plus reprendre
+    s_checkpoint_enabled = false;
+    nvs_storage_clear_ota_checkpoint();
+
+    ESP_LOGI(TAG, "Receiving firmware upload: %u bytes to partition %s",
+             (unsigned)image_size, s_image_partition->label);
+    ota_progress_set_status("Uploading...", true);
+    return ESP_OK;
+}
+
+esp_err_t ota_manager_upload_write(const void *data, size_t len)
+{
+    int last_percent = ota_progress.percent;
+    esp_err_t ret = ota_image_write(data, len);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "OTA upload failed: %s", esp_err_to_name(ret));
+        ota_image_abort(ota_image_error_status(ret));
+        return ret;
+    }
+
+    if (ota_progress.percent != last_percent && ota_progress.percent % 10 == 0) {
+        ESP_LOGI(TAG, "Upload progress: %d%% (%d / %d bytes)",
+                 ota_progress.percent, ota_progress.downloaded, ota_progress.total_size);
+    }
+    return ret;
+}
+
+esp_err_t ota_manager_upload_end(void)
+{
+    if (ota_progress.downloaded != ota_progress.total_size) {
+        ESP_LOGE(TAG, "Upload incomplete (%d / %d bytes)",
+                 ota_progress.downloaded, ota_progress.total_size);
+        ota_image_abort("Upload incomplete");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = ota_image_end();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "OTA upload failed: %s", esp_err_to_name(ret));
+        ota_image_abort(ota_image_error_status(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "OTA upload completed successfully!");
+    taskENTER_CRITICAL(&s_progress_lock);
+    ota_progress.percent = 100;
+    taskEXIT_CRITICAL(&s_progress_lock);
+    ota_progress_set_status("Success! Rebooting...", true);
+    return ESP_OK;
+}
+
+void ota_manager_upload_abort(const char *status)
+{
+    ota_image_abort(status);
+}
+
 /**
  * ÉTAPE D : Obtenir la version
  */
@@ -384,6 +1466,10 @@ esp_err_t ota_manager_check_github_update(const char *owner, const char *repo, o
         // Chercher l'asset .bin dans les assets
         cJSON *assets = cJSON_GetObjectItem(json, "assets");
         if (assets != NULL && cJSON_IsArray(assets)) {
+            // Nom publié par le workflow de release: miniot-<nouvelle>-from-<installée>.mdl
+            char delta_suffix[48];
+            snprintf(delta_suffix, sizeof(delta_suffix), "-from-%s.mdl", FIRMWARE_VERSION);
+
             int asset_count = cJSON_GetArraySize(assets);
             for (int i = 0; i < asset_count; i++) {
                 cJSON *asset = cJSON_GetArrayItem(assets, i);
@@ -393,12 +1479,20 @@ esp_err_t ota_manager_check_github_update(const char *owner, const char *repo, o
                 if (name != NULL && download_url != NULL &&
                     cJSON_IsString(name) && cJSON_IsString(download_url)) {
 
-                    // Chercher un fichier .bin
-                    if (strstr(name->valuestring, ".bin") != NULL) {
+                    // Chercher l'image (compressée de préférence), et un patch
+                    // depuis la version installée
+                    if (strstr(name->valuestring, ".mdz") != NULL) {
+                        strncpy(info->download_url, download_url->valuestring,
+                                sizeof(info->download_url) - 1);
+                        ESP_LOGI(TAG, "Compressed firmware found: %s", info->download_url);
+                    } else if (strstr(name->valuestring, ".bin") != NULL && info->download_url[0] == '\0') {
                         strncpy(info->download_url, download_url->valuestring,
                                 sizeof(info->download_url) - 1);
                         ESP_LOGI(TAG, "Firmware binary found: %s", info->download_url);
-                        break;
+                    } else if (strstr(name->valuestring, delta_suffix) != NULL) {
+                        strncpy(info->delta_url, download_url->valuestring,
+                                sizeof(info->delta_url) - 1);
+                        ESP_LOGI(TAG, "Delta patch found: %s", info->delta_url);
                     }
                 }
             }
@@ -415,9 +1509,33 @@ esp_err_t ota_manager_check_github_update(const char *owner, const char *repo, o
     }
 
     cJSON_Delete(json);
+
+    taskENTER_CRITICAL(&s_last_check_lock);
+    s_last_check = *info;
+    s_last_check_us = esp_timer_get_time();
+    taskEXIT_CRITICAL(&s_last_check_lock);
+
     return ESP_OK;
 }
 
+bool ota_manager_get_last_check(ota_update_info_t *info, int64_t *age_ms)
+{
+    taskENTER_CRITICAL(&s_last_check_lock);
+    int64_t checked_us = s_last_check_us;
+    if (checked_us) {
+        *info = s_last_check;
+    }
+    taskEXIT_CRITICAL(&s_last_check_lock);
+
+    if (!checked_us) {
+        return false;
+    }
+    if (age_ms) {
+        *age_ms = (esp_timer_get_time() - checked_us) / 1000;
+    }
+    return true;
+}
+
 /**
  * ÉTAPE H : Mise à jour depuis GitHub (raccourci)
  */
@@ -435,6 +1553,13 @@ esp_err_t ota_manager_update_from_github(const char *owner, const char *repo)
         return ESP_OK;
     }
 
+    if (info.delta_url[0] != '\0') {
+        // Le patch ne s'applique qu'au firmware exact de la version installée
+        ESP_LOGI(TAG, "Starting delta update to version %s", info.version);
+        err = ota_manager_start_update(info.delta_url);
+        ESP_LOGW(TAG, "Delta update failed (%s), downloading full image", esp_err_to_name(err));
+    }
+
     ESP_LOGI(TAG, "Starting update to version %s", info.version);
     return ota_manager_start_update(info.download_url);
 }
@@ -442,7 +1567,14 @@ esp_err_t ota_manager_update_from_github(const char *owner, const char *repo)
 /**
  * ÉTAPE I : Obtenir la progression OTA
  */
-const ota_progress_t* ota_manager_get_progress(void)
+void ota_manager_get_progress(ota_progress_t *progress)
+{
+    taskENTER_CRITICAL(&s_progress_lock);
+    *progress = ota_progress;
+    taskEXIT_CRITICAL(&s_progress_lock);
+}
+
+void ota_manager_set_progress_callback(ota_progress_cb_t callback)
 {
-    return &ota_progress;
+    s_progress_callback = callback;
 }
@@ -3,13 +3,16 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Structure contenant les informations d'une mise à jour disponible
  */
 typedef struct {
     char version[32];           // Version disponible (ex: "v1.0.1")
-    char download_url[256];     // URL de téléchargement du .bin
+    char download_url[256];     // URL de téléchargement de l'image (.mdz de préférence, sinon .bin)
+    char delta_url[256];        // URL du patch depuis la version installée, vide si absent
     bool update_available;      // True si une nouvelle version existe
 } ota_update_info_t;
 
@@ -22,8 +25,17 @@ typedef struct {
     int downloaded;             // Octets téléchargés
     int percent;                // Pourcentage (0-100)
     char status[64];            // Message de status
+    int chunk_size;             // Taille de lecture courante, adaptée au débit (bytes)
+    int chunk_latency_ms;       // Durée de la dernière lecture
+    int throughput;             // Débit mesuré sur la dernière période (bytes/s)
 } ota_progress_t;
 
+/**
+ * @brief Callback appelé quand la progression change (pourcentage ou status)
+ * Appelé depuis la tâche OTA avec une copie de la progression: ne doit pas bloquer
+ */
+typedef void (*ota_progress_cb_t)(const ota_progress_t *progress);
+
 /**
  * @brief Initialiser le gestionnaire OTA
  *
@@ -34,11 +46,77 @@ esp_err_t ota_manager_init(void);
 /**
  * @brief Lancer une mise à jour OTA depuis une URL
  *
+ * Le fichier est une image complète ou un patch (make_delta.py) appliqué
+ * contre la partition courante, éventuellement compressé (make_compressed.py);
+ * le format est détecté à la réception.
+ * Une coupure réseau est retentée avec un délai croissant et le téléchargement
+ * reprend où il s'était arrêté (Range). Une image complète, compressée ou non,
+ * reprend aussi après un reboot (point de reprise en NVS, voir
+ * ota_manager_resume_pending()).
+ * Redémarre le device en cas de succès.
+ *
  * @param url URL du fichier .bin à télécharger (ex: "http://192.168.1.100:8000/firmware.bin")
  * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_STATE si une mise à jour est déjà en cours
  */
 esp_err_t ota_manager_start_update(const char *url);
 
+/**
+ * @brief Reprendre en tâche de fond un téléchargement interrompu par un reboot
+ *
+ * À appeler une fois le réseau disponible. Les secteurs déjà écrits sont
+ * vérifiés avant de reprendre; sinon le téléchargement recommence.
+ * @return ESP_OK si une reprise est lancée
+ *         ESP_ERR_NOT_FOUND si aucun téléchargement n'était en cours
+ */
+esp_err_t ota_manager_resume_pending(void);
+
+/**
+ * @brief Démarrer la réception d'une image poussée par le client (POST /api/ota_upload)
+ *
+ * Rien n'est effacé à ce stade: la partition n'est ouverte qu'une fois
+ * l'en-tête de l'image reçu et validé par ota_manager_upload_write().
+ *
+ * @param image_size Taille de l'image en octets
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_STATE si une mise à jour est déjà en cours
+ *         ESP_ERR_INVALID_SIZE si l'image ne tient pas dans la partition
+ */
+esp_err_t ota_manager_upload_begin(size_t image_size);
+
+/**
+ * @brief Écrire le morceau suivant de l'image, dans l'ordre de réception
+ *
+ * En cas d'échec, la réception est abandonnée (inutile d'appeler
+ * ota_manager_upload_abort()).
+ *
+ * @return ESP_OK si succès
+ *         ESP_ERR_OTA_VALIDATE_FAILED si l'en-tête n'est pas celui d'un firmware MiniOT
+ *         ESP_ERR_INVALID_VERSION si le patch a été produit pour un autre firmware
+ *         ESP_ERR_INVALID_SIZE si l'image ne tient pas dans la partition
+ *         autre code si l'écriture en flash ou la décompression échoue
+ */
+esp_err_t ota_manager_upload_write(const void *data, size_t len);
+
+/**
+ * @brief Vérifier l'image complète et la sélectionner pour le prochain boot
+ *
+ * Le redémarrage est laissé à l'appelant, pour qu'il puisse répondre au client.
+ * En cas d'échec, la réception est abandonnée.
+ *
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_SIZE si l'image reçue est incomplète
+ *         ESP_ERR_OTA_VALIDATE_FAILED si l'image écrite est invalide
+ *         autre code si la finalisation échoue (flash, décompression)
+ */
+esp_err_t ota_manager_upload_end(void);
+
+/**
+ * @brief Abandonner la réception en cours
+ * @param status Message de status affiché dans la progression
+ */
+void ota_manager_upload_abort(const char *status);
+
 /**
  * @brief Obtenir la version du firmware actuel
  *
@@ -56,10 +134,21 @@ const char* ota_manager_get_version(void);
  */
 esp_err_t ota_manager_check_github_update(const char *owner, const char *repo, ota_update_info_t *info);
 
+/**
+ * @brief Obtenir le résultat de la dernière vérification GitHub réussie
+ *
+ * Ne fait aucune requête réseau.
+ * @param info Structure remplie avec le résultat
+ * @param age_ms Âge du résultat en ms, peut être NULL
+ * @return false si aucune vérification n'a encore réussi
+ */
+bool ota_manager_get_last_check(ota_update_info_t *info, int64_t *age_ms);
+
 /**
  * @brief Lancer une mise à jour depuis GitHub (raccourci)
  *
- * Vérifie s'il y a une mise à jour et la télécharge si disponible
+ * Vérifie s'il y a une mise à jour et la télécharge si disponible: le patch
+ * depuis la version installée s'il est publié, l'image complète sinon
  * @param owner Propriétaire du repository
  * @param repo Nom du repository
  * @return ESP_OK si succès
@@ -69,8 +158,15 @@ esp_err_t ota_manager_update_from_github(const char *owner, const char *repo);
 /**
  * @brief Obtenir la progression actuelle de l'OTA
  *
- * @return Pointeur vers la structure de progression (lecture seule)
+ * Copie cohérente, utilisable depuis n'importe quelle tâche
+ * @param progress Structure à remplir
+ */
+void ota_manager_get_progress(ota_progress_t *progress);
+
+/**
+ * @brief Enregistre un callback pour les changements de progression
+ * @param callback Fonction à appeler (NULL pour désactiver)
  */
-const ota_progress_t* ota_manager_get_progress(void);
+void ota_manager_set_progress_callback(ota_progress_cb_t callback);
 
 #endif // OTA_MANAGER_H
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+Génère la table de hachage parfait des routes HTTP (web_router)
+
+- Lecture de web_routes.def: WEB_ROUTE(HTTP_<méthode>, "<chemin>", handler),
+  dans l'ordre du fichier (l'index d'une route est celui du tableau construit
+  par web_server.c avec la même X-macro)
+- Les routes exactes sont placées dans une table de hachage parfait minimale
+  (hash and displace): un seed par bucket, une case par route, donc une seule
+  comparaison de chaîne par requête quel que soit le nombre de routes
+- Les routes préfixe (chemin terminé par '*') sont listées à part
+- Le hash doit rester identique à web_router_hash()/web_router_mix()
+
+Usage: build_routes.py <web_routes.def> <dossier de sortie>
+"""
+
+import os
+import re
+import sys
+
+ROUTE_RE = re.compile(r'^\s*WEB_ROUTE\(\s*HTTP_(\w+)\s*,\s*"([^"]*)"\s*,\s*(\w+)\s*\)')
+MAX_SEED = 0xFFFF
+
+
+def fnv1a(method, path):
+    h = 0x811C9DC5
+    for b in method.encode('ascii') + b' ' + path.encode('utf-8'):
+        h ^= b
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def mix(h, seed):
+    h ^= (seed * 0x9E3779B9) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def parse(path):
+    routes = []
+    with open(path, encoding='utf-8') as f:
+        for number, line in enumerate(f, 1):
+            m = ROUTE_RE.match(line)
+            if m:
+                routes.append((m.group(1), m.group(2), m.group(3)))
+            elif 'WEB_ROUTE(' in line and not line.lstrip().startswith(('*', '/')):
+                raise SystemExit('%s:%d: route illisible' % (path, number))
+    return routes
+
+
+def build(keys):
+    """Seeds par bucket et case -> index de route, pour des clés (index, hash)"""
+    n = len(keys)
+    buckets = [[] for _ in range(n)]
+    for key in keys:
+        buckets[mix(key[1], 0) % n].append(key)
+
+    seeds = [0] * n
+    slots = [None] * n
+    # Les buckets les plus chargés d'abord, tant qu'il reste des cases libres
+    for b in sorted(range(n), key=lambda i: -len(buckets[i])):
+        if not buckets[b]:
+            break
+        for seed in range(1, MAX_SEED + 1):
+            taken = [mix(h, seed) % n for _, h in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[s] is None for s in taken):
+                break
+        else:
+            raise SystemExit('Aucun seed trouvé pour le bucket %d' % b)
+        seeds[b] = seed
+        for (index, _), s in zip(buckets[b], taken):
+            slots[s] = index
+    return seeds, slots
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    def_path, out_dir = sys.argv[1:]
+    routes = parse(def_path)
+
+    exact = []
+    prefixes = []
+    seen = set()
+    for index, (method, path, _) in enumerate(routes):
+        if (method, path) in seen:
+            raise SystemExit('Route en double: %s %s' % (method, path))
+        seen.add((method, path))
+        if path.endswith('*'):
+            prefixes.append(index)
+        else:
+            exact.append((index, fnv1a(method, path)))
+
+    if len({h for _, h in exact}) != len(exact):
+        raise SystemExit('Collision FNV-1a entre deux routes, changer un chemin')
+
+    seeds, slots = build(exact) if exact else ([], [])
+    methods = sorted({method for method, _, _ in routes})
+
+    with open(os.path.join(out_dir, 'web_routes_hash.h'), 'w', encoding='utf-8') as f:
+        f.write('// Fichier généré par build_routes.py, ne pas modifier\n')
+        f.write('#pragma once\n\n')
+        f.write('#define WEB_ROUTES_COUNT %d\n' % len(routes))
+        f.write('#define WEB_ROUTES_HASH_SIZE %d\n' % len(exact))
+        f.write('#define WEB_ROUTES_PREFIX_COUNT %d\n' % len(prefixes))
+        f.write('#define WEB_ROUTES_METHOD_COUNT %d\n\n' % len(methods))
+        f.write('static const uint16_t s_route_seeds[WEB_ROUTES_HASH_SIZE + 1] = {%s};\n'
+                % ', '.join(str(s) for s in seeds + [0]))
+        f.write('static const uint16_t s_route_slots[WEB_ROUTES_HASH_SIZE + 1] = {%s};\n'
+                % ', '.join(str(s) for s in slots + [0]))
+        f.write('static const uint16_t s_route_prefixes[WEB_ROUTES_PREFIX_COUNT + 1] = {%s};\n'
+                % ', '.join(str(p) for p in prefixes + [0]))
+        f.write('static const httpd_method_t s_route_methods[WEB_ROUTES_METHOD_COUNT] = {%s};\n'
+                % ', '.join('HTTP_' + m for m in methods))
+
+    print('Routes: %d exactes, %d préfixes, méthodes %s'
+          % (len(exact), len(prefixes), ' '.join(methods)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
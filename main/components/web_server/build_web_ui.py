@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Prépare l'interface web pour l'intégration dans le firmware
+
+- Minification légère: espaces en début/fin de ligne, lignes vides et
+  commentaires (HTML, CSS, JS sur une ligne entière)
+- Compression gzip déterministe (mtime=0) pour des hash stables entre builds,
+  fenêtre limitée à WINDOW_BITS: le device décompresse les assets pour les
+  clients qui refusent gzip avec une fenêtre de 16 KB (WEB_UI_WINDOW_BITS)
+- app.css et app.js sont servis sous /assets/app.<hash>.{css,js} (cache
+  immutable), la page HTML est réécrite pour pointer sur ces URIs
+- Génération de web_assets.c: table URI -> données embarquées, taille,
+  type, encodage, ETag et Cache-Control (voir web_assets.h)
+
+Les fichiers compressés gardent un nom fixe (index.html.gz, app.css.gz,
+app.js.gz) pour que les symboles _binary_*_start soient connus de CMake.
+
+Usage: build_web_ui.py <dossier www> <dossier de sortie>
+"""
+
+import hashlib
+import os
+import re
+import sys
+import zlib
+
+CACHE_IMMUTABLE = 'public, max-age=31536000, immutable'
+CACHE_REVALIDATE = 'no-cache'
+WINDOW_BITS = 14        # Doit rester <= WEB_UI_WINDOW_BITS (web_ui.h)
+
+# (fichier source, type MIME, servi sous un nom hashé)
+ASSETS = [
+    ('app.css', 'text/css', True),
+    ('app.js', 'application/javascript', True),
+    ('index.html', 'text/html', False),
+]
+
+
+def minify(name, text):
+    if name.endswith('.html'):
+        text = re.sub(r'<!--.*?-->', '', text, flags=re.S)
+    elif name.endswith('.css'):
+        text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if not line or (name.endswith('.js') and line.startswith('//')):
+            continue
+        lines.append(line)
+
+    # Conserver les retours à la ligne hors CSS: le JS peut dépendre de l'insertion de ';'.
+    # En CSS, une espace: une valeur ou un sélecteur peut continuer à la ligne suivante
+    # ("margin: 0\n  auto", "h1,\nh2 a") et les deux mots ne doivent pas être collés
+    return (' ' if name.endswith('.css') else '\n').join(lines)
+
+
+def gzip_compress(data):
+    # En-tête gzip minimal (sans nom ni date): web_ui.c en saute 10 octets
+    z = zlib.compressobj(9, zlib.DEFLATED, 16 + WINDOW_BITS)
+    return z.compress(data) + z.flush()
+
+
+def symbol(name):
+    return re.sub(r'[^A-Za-z0-9]', '_', name + '.gz')
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    www_dir, out_dir = sys.argv[1:]
+    uris = {}
+    entries = []
+
+    # Les assets hashés d'abord: la page HTML référence leurs URIs
+    for name, mime, hashed in ASSETS:
+        with open(os.path.join(www_dir, name), encoding='utf-8') as f:
+            text = f.read()
+
+        for src, uri in uris.items():
+            text = text.replace("'%s'" % src, "'%s'" % uri)
+
+        raw_size = len(text.encode('utf-8'))
+        compressed = gzip_compress(minify(name, text).encode('utf-8'))
+        digest = hashlib.sha256(compressed).hexdigest()
+
+        if hashed:
+            base, ext = os.path.splitext(name)
+            uri = '/assets/%s.%s%s' % (base, digest[:8], ext)
+            uris[name] = uri
+        else:
+            uri = '/'
+
+        with open(os.path.join(out_dir, name + '.gz'), 'wb') as f:
+            f.write(compressed)
+
+        entries.append((uri, symbol(name), len(compressed), mime, digest[:16],
+                        CACHE_IMMUTABLE if hashed else CACHE_REVALIDATE))
+        print('Web UI: %-10s -> %-28s %5d -> %5d bytes' % (name, uri, raw_size, len(compressed)))
+
+    with open(os.path.join(out_dir, 'web_assets.c'), 'w', encoding='utf-8') as f:
+        f.write('// Fichier généré par build_web_ui.py, ne pas modifier\n')
+        f.write('#include "web_assets.h"\n\n')
+        for _, sym, _, _, _, _ in entries:
+            f.write('extern const uint8_t %s_start[] asm("_binary_%s_start");\n' % (sym, sym))
+        f.write('\nconst web_asset_t web_assets[] = {\n')
+        for uri, sym, size, mime, etag, cache in entries:
+            f.write('    {\n')
+            f.write('        .uri = "%s",\n' % uri)
+            f.write('        .data = %s_start,\n' % sym)
+            f.write('        .len = %d,\n' % size)
+            f.write('        .content_type = "%s",\n' % mime)
+            f.write('        .encoding = "gzip",\n')
+            f.write('        .etag = "\\"%s\\"",\n' % etag)
+            f.write('        .cache_control = "%s",\n' % cache)
+            f.write('    },\n')
+        f.write('};\n\n')
+        f.write('const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);\n')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
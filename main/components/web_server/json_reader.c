@@ -0,0 +1,504 @@
+#include "json_reader.h"
+#include <string.h>
+
+#define JSON_READER_RECV_CHUNK 64
+#define JSON_READER_MAX_TIMEOUTS 3      // Délais de réception consécutifs tolérés
+
+enum {
+    ST_START,           // Attend '{'
+    ST_FIRST_KEY,       // Attend une clé ou '}'
+    ST_NEXT_KEY,        // Attend une clé (après ',')
+    ST_KEY,             // Dans une clé
+    ST_KEY_ESCAPE,      // Après '\' dans une clé
+    ST_COLON,           // Attend ':'
+    ST_VALUE,           // Attend une valeur
+    ST_STRING,          // Dans une chaîne
+    ST_STRING_ESCAPE,   // Après '\' dans une chaîne
+    ST_STRING_HEX,      // Dans \uXXXX
+    ST_NUMBER,
+    ST_LITERAL,         // true, false ou null
+    ST_NESTED,          // Objet ou tableau ignoré
+    ST_AFTER_VALUE,     // Attend ',' ou '}'
+    ST_DONE,
+    ST_ERROR,
+};
+
+// Position dans un nombre (grammaire JSON: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?)
+enum {
+    NUM_MINUS,          // Après '-': attend un chiffre
+    NUM_ZERO,           // '0' initial: pas d'autre chiffre avant '.' ou 'e'
+    NUM_INT,
+    NUM_FRAC_START,     // Après '.': attend un chiffre
+    NUM_FRAC,
+    NUM_EXP_START,      // Après 'e': attend un signe ou un chiffre
+    NUM_EXP_SIGN,       // Après le signe de l'exposant: attend un chiffre
+    NUM_EXP,
+};
+
+static bool json_reader_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void json_reader_mark_invalid(json_reader_t *r)
+{
+    if (r->field >= 0) {
+        const json_field_t *f = &r->fields[r->field];
+        if (f->type == JSON_FIELD_STRING && f->size > 0) {
+            ((char *)f->dest)[0] = '\0';
+        }
+        r->invalid |= 1u << r->field;
+        r->field = -1;
+    }
+}
+
+/**
+ * Écrit un octet dans la chaîne de destination
+ * Une chaîne qui ne tient pas dans dest rend le champ invalide
+ */
+static void json_reader_put_byte(json_reader_t *r, uint8_t byte)
+{
+    if (r->field < 0) {
+        return;
+    }
+
+    const json_field_t *f = &r->fields[r->field];
+    if (r->len + 1 >= f->size) {
+        json_reader_mark_invalid(r);
+        return;
+    }
+    ((char *)f->dest)[r->len++] = (char)byte;
+}
+
+static void json_reader_put_codepoint(json_reader_t *r, uint32_t cp)
+{
+    if (cp < 0x80) {
+        json_reader_put_byte(r, cp);
+    } else if (cp < 0x800) {
+        json_reader_put_byte(r, 0xC0 | (cp >> 6));
+        json_reader_put_byte(r, 0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        json_reader_put_byte(r, 0xE0 | (cp >> 12));
+        json_reader_put_byte(r, 0x80 | ((cp >> 6) & 0x3F));
+        json_reader_put_byte(r, 0x80 | (cp & 0x3F));
+    } else {
+        json_reader_put_byte(r, 0xF0 | (cp >> 18));
+        json_reader_put_byte(r, 0x80 | ((cp >> 12) & 0x3F));
+        json_reader_put_byte(r, 0x80 | ((cp >> 6) & 0x3F));
+        json_reader_put_byte(r, 0x80 | (cp & 0x3F));
+    }
+}
+
+// Une moitié haute de paire UTF-16 non suivie de sa moitié basse devient U+FFFD
+static void json_reader_flush_surrogate(json_reader_t *r)
+{
+    if (r->high_surrogate) {
+        r->high_surrogate = 0;
+        json_reader_put_codepoint(r, 0xFFFD);
+    }
+}
+
+static void json_reader_escaped_codepoint(json_reader_t *r, uint32_t cp)
+{
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        json_reader_flush_surrogate(r);
+        r->high_surrogate = cp;
+        return;
+    }
+
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        if (r->high_surrogate) {
+            cp = 0x10000 + ((r->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+            r->high_surrogate = 0;
+        } else {
+            cp = 0xFFFD;
+        }
+    } else {
+        json_reader_flush_surrogate(r);
+    }
+    json_reader_put_codepoint(r, cp);
+}
+
+static void json_reader_end_key(json_reader_t *r)
+{
+    r->field = -1;
+    if (r->key_len > JSON_READER_MAX_KEY) {
+        return;
+    }
+    for (size_t i = 0; i < r->count; i++) {
+        const char *key = r->fields[i].key;
+        if (strlen(key) == r->key_len && memcmp(key, r->key, r->key_len) == 0) {
+            r->field = (int8_t)i;
+            return;
+        }
+    }
+}
+
+static void json_reader_end_string(json_reader_t *r)
+{
+    json_reader_flush_surrogate(r);
+    if (r->field >= 0) {
+        ((char *)r->fields[r->field].dest)[r->len] = '\0';
+        r->found |= 1u << r->field;
+    }
+    r->state = ST_AFTER_VALUE;
+}
+
+static void json_reader_end_number(json_reader_t *r)
+{
+    if (r->field >= 0) {
+        *(uint32_t *)r->fields[r->field].dest = (uint32_t)r->number;
+        r->found |= 1u << r->field;
+    }
+    r->state = ST_AFTER_VALUE;
+}
+
+/**
+ * Avance dans un nombre
+ * @return false si c ne fait pas partie du nombre (qui se termine alors)
+ */
+static bool json_reader_number_char(json_reader_t *r, char c)
+{
+    bool digit = c >= '0' && c <= '9';
+
+    switch (r->number_pos) {
+    case NUM_MINUS:
+        if (digit) {
+            r->number_pos = c == '0' ? NUM_ZERO : NUM_INT;
+            return true;
+        }
+        return false;
+
+    case NUM_INT:
+        if (digit) {
+            r->number = r->number * 10 + (c - '0');
+            if (r->number > UINT32_MAX) {
+                json_reader_mark_invalid(r);
+                r->number = 0;
+            }
+            return true;
+        }
+        // fallthrough
+    case NUM_ZERO:
+        if (c == '.' || c == 'e' || c == 'E') {
+            // Nombre non entier: ignoré, seul un entier est accepté
+            json_reader_mark_invalid(r);
+            r->number_pos = c == '.' ? NUM_FRAC_START : NUM_EXP_START;
+            return true;
+        }
+        return false;
+
+    case NUM_FRAC_START:
+    case NUM_FRAC:
+        if (digit) {
+            r->number_pos = NUM_FRAC;
+            return true;
+        }
+        if ((c == 'e' || c == 'E') && r->number_pos == NUM_FRAC) {
+            r->number_pos = NUM_EXP_START;
+            return true;
+        }
+        return false;
+
+    case NUM_EXP_START:
+        if (c == '+' || c == '-') {
+            r->number_pos = NUM_EXP_SIGN;
+            return true;
+        }
+        // fallthrough
+    default:
+        if (digit) {
+            r->number_pos = NUM_EXP;
+            return true;
+        }
+        return false;
+    }
+}
+
+static void json_reader_start_value(json_reader_t *r, char c)
+{
+    json_field_type_t type = JSON_FIELD_STRING;
+    if (r->field >= 0) {
+        // Une clé répétée remplace la valeur précédente
+        r->found &= ~(1u << r->field);
+        r->invalid &= ~(1u << r->field);
+        type = r->fields[r->field].type;
+    }
+
+    if (c == '"') {
+        if (type != JSON_FIELD_STRING) {
+            json_reader_mark_invalid(r);
+        }
+        r->len = 0;
+        r->high_surrogate = 0;
+        r->state = ST_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        if (type != JSON_FIELD_UINT32 || c == '-') {
+            json_reader_mark_invalid(r);
+        }
+        r->number = c == '-' ? 0 : (uint64_t)(c - '0');
+        r->number_pos = c == '-' ? NUM_MINUS : c == '0' ? NUM_ZERO : NUM_INT;
+        r->state = ST_NUMBER;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        json_reader_mark_invalid(r);
+        r->literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+        r->literal_pos = 1;
+        r->state = ST_LITERAL;
+    } else if (c == '{' || c == '[') {
+        json_reader_mark_invalid(r);
+        r->depth = 1;
+        r->skip_string = false;
+        r->skip_escape = false;
+        r->state = ST_NESTED;
+    } else {
+        r->state = ST_ERROR;
+    }
+}
+
+static void json_reader_step(json_reader_t *r, char c)
+{
+    switch (r->state) {
+    case ST_START:
+        if (c == '{') {
+            r->state = ST_FIRST_KEY;
+        } else if (!json_reader_is_space(c)) {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    case ST_FIRST_KEY:
+    case ST_NEXT_KEY:
+        if (c == '"') {
+            r->key_len = 0;
+            r->state = ST_KEY;
+        } else if (c == '}' && r->state == ST_FIRST_KEY) {
+            r->state = ST_DONE;
+        } else if (!json_reader_is_space(c)) {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    case ST_KEY:
+        if (c == '"') {
+            json_reader_end_key(r);
+            r->state = ST_COLON;
+        } else if (c == '\\') {
+            // Les clés extraites n'ont pas d'échappement: celle-ci sera ignorée
+            r->key_len = JSON_READER_MAX_KEY + 1;
+            r->state = ST_KEY_ESCAPE;
+        } else if ((uint8_t)c < 0x20) {
+            r->state = ST_ERROR;
+        } else if (r->key_len < JSON_READER_MAX_KEY) {
+            r->key[r->key_len++] = c;
+        } else {
+            r->key_len = JSON_READER_MAX_KEY + 1;
+        }
+        break;
+
+    case ST_KEY_ESCAPE:
+        r->state = ST_KEY;
+        break;
+
+    case ST_COLON:
+        if (c == ':') {
+            r->state = ST_VALUE;
+        } else if (!json_reader_is_space(c)) {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    case ST_VALUE:
+        if (!json_reader_is_space(c)) {
+            json_reader_start_value(r, c);
+        }
+        break;
+
+    case ST_STRING:
+        if (c == '"') {
+            json_reader_end_string(r);
+        } else if (c == '\\') {
+            r->state = ST_STRING_ESCAPE;
+        } else if ((uint8_t)c < 0x20) {
+            r->state = ST_ERROR;
+        } else {
+            json_reader_flush_surrogate(r);
+            json_reader_put_byte(r, (uint8_t)c);
+        }
+        break;
+
+    case ST_STRING_ESCAPE: {
+        char decoded;
+        switch (c) {
+        case '"':  decoded = '"';  break;
+        case '\\': decoded = '\\'; break;
+        case '/':  decoded = '/';  break;
+        case 'b':  decoded = '\b'; break;
+        case 'f':  decoded = '\f'; break;
+        case 'n':  decoded = '\n'; break;
+        case 'r':  decoded = '\r'; break;
+        case 't':  decoded = '\t'; break;
+        case 'u':
+            r->hex_count = 0;
+            r->codepoint = 0;
+            r->state = ST_STRING_HEX;
+            return;
+        default:
+            r->state = ST_ERROR;
+            return;
+        }
+        json_reader_flush_surrogate(r);
+        json_reader_put_byte(r, (uint8_t)decoded);
+        r->state = ST_STRING;
+        break;
+    }
+
+    case ST_STRING_HEX: {
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            r->state = ST_ERROR;
+            return;
+        }
+        r->codepoint = (r->codepoint << 4) | digit;
+        if (++r->hex_count == 4) {
+            if (r->codepoint == 0) {
+                // Non représentable dans une chaîne C
+                r->state = ST_ERROR;
+                return;
+            }
+            json_reader_escaped_codepoint(r, r->codepoint);
+            r->state = ST_STRING;
+        }
+        break;
+    }
+
+    case ST_NUMBER:
+        if (json_reader_number_char(r, c)) {
+            break;
+        }
+        // Fin du nombre: il doit être complet ("-", "1e" et "1." sont refusés),
+        // et un chiffre ne peut suivre un 0 initial ("01")
+        if ((r->number_pos != NUM_ZERO && r->number_pos != NUM_INT &&
+             r->number_pos != NUM_FRAC && r->number_pos != NUM_EXP) || (c >= '0' && c <= '9')) {
+            r->state = ST_ERROR;
+            break;
+        }
+        json_reader_end_number(r);
+        json_reader_step(r, c);
+        break;
+
+    case ST_LITERAL:
+        if (r->literal[r->literal_pos] == '\0') {
+            r->state = ST_AFTER_VALUE;
+            json_reader_step(r, c);
+        } else if (c == r->literal[r->literal_pos]) {
+            r->literal_pos++;
+        } else {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    case ST_NESTED:
+        if (r->skip_string) {
+            if (r->skip_escape) {
+                r->skip_escape = false;
+            } else if (c == '\\') {
+                r->skip_escape = true;
+            } else if (c == '"') {
+                r->skip_string = false;
+            }
+        } else if (c == '"') {
+            r->skip_string = true;
+        } else if (c == '{' || c == '[') {
+            r->depth++;
+        } else if (c == '}' || c == ']') {
+            if (--r->depth == 0) {
+                r->state = ST_AFTER_VALUE;
+            }
+        }
+        break;
+
+    case ST_AFTER_VALUE:
+        if (c == ',') {
+            r->state = ST_NEXT_KEY;
+        } else if (c == '}') {
+            r->state = ST_DONE;
+        } else if (!json_reader_is_space(c)) {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    case ST_DONE:
+        if (!json_reader_is_space(c)) {
+            r->state = ST_ERROR;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void json_reader_init(json_reader_t *r, const json_field_t *fields, size_t count)
+{
+    memset(r, 0, sizeof(*r));
+    r->fields = fields;
+    r->count = count < JSON_READER_MAX_FIELDS ? count : JSON_READER_MAX_FIELDS;
+    r->field = -1;
+    r->state = ST_START;
+}
+
+esp_err_t json_reader_feed(json_reader_t *r, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && r->state != ST_ERROR; i++) {
+        json_reader_step(r, data[i]);
+    }
+    return r->state == ST_ERROR ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t json_reader_finish(json_reader_t *r)
+{
+    return r->state == ST_DONE ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t json_reader_parse_http(json_reader_t *r, httpd_req_t *req,
+                                 const json_field_t *fields, size_t count)
+{
+    json_reader_init(r, fields, count);
+
+    if (req->content_len == 0 || req->content_len > JSON_READER_MAX_BODY) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char chunk[JSON_READER_RECV_CHUNK];
+    size_t remaining = req->content_len;
+    int timeouts = 0;
+
+    while (remaining > 0) {
+        size_t want = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+        int ret = httpd_req_recv(req, chunk, want);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            if (++timeouts > JSON_READER_MAX_TIMEOUTS) {
+                return ESP_ERR_TIMEOUT;
+            }
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        timeouts = 0;
+
+        remaining -= ret;
+        esp_err_t err = json_reader_feed(r, chunk, ret);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return json_reader_finish(r);
+}
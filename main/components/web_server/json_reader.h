@@ -0,0 +1,109 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define JSON_READER_MAX_KEY 24          // Clés plus longues: ignorées
+#define JSON_READER_MAX_FIELDS 32       // Taille des masques found/invalid
+#define JSON_READER_MAX_BODY 4096       // Corps HTTP accepté par json_reader_parse_http
+
+typedef enum {
+    JSON_FIELD_STRING,                  // dest: char[size], toujours terminé par '\0'
+    JSON_FIELD_UINT32,                  // dest: uint32_t, entier positif uniquement
+} json_field_type_t;
+
+/**
+ * @brief Champ à extraire d'un objet JSON
+ */
+typedef struct {
+    const char *key;
+    json_field_type_t type;
+    void *dest;
+    size_t size;                        // Taille de dest (chaînes)
+} json_field_t;
+
+/**
+ * @brief Extracteur de champs JSON en flux, mémoire constante
+ *
+ * Lit un objet JSON de premier niveau octet par octet et écrit directement
+ * les valeurs des clés connues dans leurs destinations. Les autres clés
+ * (y compris objets et tableaux imbriqués) sont sautées sans être stockées.
+ * Le corps peut être fourni en morceaux de taille quelconque.
+ *
+ * Pour le champ i, le bit i de found indique une valeur valide, celui de
+ * invalid une valeur présente mais inutilisable (mauvais type, chaîne trop
+ * longue pour dest, entier hors limites). Une chaîne trop longue n'est
+ * jamais tronquée silencieusement.
+ */
+typedef struct {
+    const json_field_t *fields;
+    size_t count;
+    uint32_t found;
+    uint32_t invalid;
+
+    // État interne
+    uint8_t state;
+    int8_t field;                       // Champ de la valeur en cours, -1 si ignorée
+    char key[JSON_READER_MAX_KEY];
+    uint8_t key_len;                    // > JSON_READER_MAX_KEY: clé trop longue
+    size_t len;                         // Octets écrits dans la chaîne en cours
+    uint64_t number;
+    uint8_t number_pos;                 // Position dans la grammaire des nombres
+    const char *literal;                // true/false/null en cours de lecture
+    uint8_t literal_pos;
+    uint16_t depth;                     // Profondeur d'une valeur imbriquée ignorée
+    bool skip_string;
+    bool skip_escape;
+    uint8_t hex_count;
+    uint32_t codepoint;
+    uint32_t high_surrogate;
+} json_reader_t;
+
+/**
+ * @brief Initialise le lecteur (fields doit rester valide pendant la lecture)
+ */
+void json_reader_init(json_reader_t *r, const json_field_t *fields, size_t count);
+
+/**
+ * @brief Fournit un morceau du document
+ * @return ESP_OK, ou ESP_ERR_INVALID_ARG si le JSON est mal formé
+ */
+esp_err_t json_reader_feed(json_reader_t *r, const char *data, size_t len);
+
+/**
+ * @brief Termine la lecture
+ * @return ESP_OK si un objet complet a été lu
+ */
+esp_err_t json_reader_finish(json_reader_t *r);
+
+static inline bool json_reader_found(const json_reader_t *r, size_t index)
+{
+    return (r->found >> index) & 1;
+}
+
+static inline bool json_reader_invalid(const json_reader_t *r, size_t index)
+{
+    return (r->invalid >> index) & 1;
+}
+
+/**
+ * @brief Lit le corps d'une requête HTTP en flux et en extrait les champs
+ *
+ * Le corps est reçu par petits blocs (httpd_req_recv) jusqu'à content_len,
+ * quelle que soit sa découpe en segments TCP. Quelques délais de réception
+ * consécutifs sont tolérés, pas un client qui cesse d'émettre.
+ *
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_SIZE si le corps est vide ou dépasse JSON_READER_MAX_BODY
+ *         ESP_ERR_INVALID_ARG si le JSON est mal formé
+ *         ESP_ERR_TIMEOUT si le client n'envoie plus rien
+ *         ESP_FAIL si la réception a échoué
+ */
+esp_err_t json_reader_parse_http(json_reader_t *r, httpd_req_t *req,
+                                 const json_field_t *fields, size_t count);
+
+#endif // JSON_READER_H
@@ -0,0 +1,231 @@
+#include "json_writer.h"
+#include <string.h>
+
+static esp_err_t json_writer_http_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+static void json_writer_flush_buffer(json_writer_t *w)
+{
+    if (w->len == 0 || w->err != ESP_OK) {
+        return;
+    }
+    w->err = w->flush(w->ctx, w->buf, w->len);
+    w->flushed += w->len;
+    w->len = 0;
+}
+
+static void json_writer_raw(json_writer_t *w, const char *data, size_t len)
+{
+    while (len > 0 && w->err == ESP_OK) {
+        size_t room = sizeof(w->buf) - w->len;
+        if (room == 0) {
+            json_writer_flush_buffer(w);
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void json_writer_char(json_writer_t *w, char c)
+{
+    json_writer_raw(w, &c, 1);
+}
+
+/**
+ * Ajoute le séparateur si une valeur précède au même niveau
+ */
+static void json_writer_separator(json_writer_t *w)
+{
+    if (w->need_comma) {
+        json_writer_char(w, ',');
+    }
+}
+
+static void json_writer_escaped(json_writer_t *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_writer_char(w, '"');
+    while (*s) {
+        // Copier d'un bloc les caractères qui n'ont pas besoin d'échappement
+        const char *start = s;
+        while (*s && *s != '"' && *s != '\\' && (unsigned char)*s >= 0x20) {
+            s++;
+        }
+        json_writer_raw(w, start, s - start);
+        if (!*s) {
+            break;
+        }
+
+        char esc[6] = {'\\', *s, 0, 0, 0, 0};
+        size_t esc_len = 2;
+        switch (*s) {
+            case '"':
+            case '\\':
+                break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[(*s >> 4) & 0x0F];
+                esc[5] = hex[*s & 0x0F];
+                esc_len = 6;
+                break;
+        }
+        json_writer_raw(w, esc, esc_len);
+        s++;
+    }
+    json_writer_char(w, '"');
+}
+
+void json_writer_init(json_writer_t *w, json_writer_flush_t flush, void *ctx)
+{
+    w->len = 0;
+    w->flushed = 0;
+    w->need_comma = false;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->req = NULL;
+    w->err = ESP_OK;
+}
+
+void json_writer_init_http(json_writer_t *w, httpd_req_t *req)
+{
+    json_writer_init(w, json_writer_http_flush, req);
+    w->req = req;
+    httpd_resp_set_type(req, "application/json");
+}
+
+void json_writer_begin_object(json_writer_t *w)
+{
+    json_writer_separator(w);
+    json_writer_char(w, '{');
+    w->need_comma = false;
+}
+
+void json_writer_end_object(json_writer_t *w)
+{
+    json_writer_char(w, '}');
+    w->need_comma = true;
+}
+
+void json_writer_begin_array(json_writer_t *w)
+{
+    json_writer_separator(w);
+    json_writer_char(w, '[');
+    w->need_comma = false;
+}
+
+void json_writer_end_array(json_writer_t *w)
+{
+    json_writer_char(w, ']');
+    w->need_comma = true;
+}
+
+void json_writer_key(json_writer_t *w, const char *key)
+{
+    json_writer_separator(w);
+    json_writer_escaped(w, key);
+    json_writer_char(w, ':');
+    w->need_comma = false;
+}
+
+void json_writer_string(json_writer_t *w, const char *value)
+{
+    if (!value) {
+        json_writer_null(w);
+        return;
+    }
+    json_writer_separator(w);
+    json_writer_escaped(w, value);
+    w->need_comma = true;
+}
+
+void json_writer_int(json_writer_t *w, int64_t value)
+{
+    char digits[21];
+    size_t pos = sizeof(digits);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+    do {
+        digits[--pos] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+
+    json_writer_separator(w);
+    json_writer_raw(w, digits + pos, sizeof(digits) - pos);
+    w->need_comma = true;
+}
+
+void json_writer_bool(json_writer_t *w, bool value)
+{
+    json_writer_separator(w);
+    if (value) {
+        json_writer_raw(w, "true", 4);
+    } else {
+        json_writer_raw(w, "false", 5);
+    }
+    w->need_comma = true;
+}
+
+void json_writer_null(json_writer_t *w)
+{
+    json_writer_separator(w);
+    json_writer_raw(w, "null", 4);
+    w->need_comma = true;
+}
+
+void json_writer_fragment(json_writer_t *w, const char *json, size_t len)
+{
+    json_writer_separator(w);
+    json_writer_raw(w, json, len);
+    w->need_comma = true;
+}
+
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value)
+{
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_int(w, value);
+}
+
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+esp_err_t json_writer_finish(json_writer_t *w)
+{
+    if (w->req && w->flushed == 0) {
+        // Réponse complète dans le buffer: un seul envoi avec Content-Length
+        if (w->err == ESP_OK) {
+            w->err = httpd_resp_send(w->req, w->buf, w->len);
+        }
+        w->len = 0;
+        return w->err;
+    }
+
+    json_writer_flush_buffer(w);
+    if (w->req && w->err == ESP_OK) {
+        w->err = httpd_resp_send_chunk(w->req, NULL, 0);
+    }
+    return w->err;
+}
@@ -0,0 +1,88 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define JSON_WRITER_BUFFER_SIZE 256
+
+/**
+ * @brief Fonction de sortie appelée quand le buffer est plein
+ * @param ctx Contexte fourni à l'initialisation
+ * @param data Données à émettre
+ * @param len Longueur des données
+ * @return ESP_OK si succès
+ */
+typedef esp_err_t (*json_writer_flush_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Émetteur JSON en flux, sans allocation
+ *
+ * Le JSON est écrit sans espaces dans un buffer fixe (sur la pile de
+ * l'appelant) qui est vidé par la fonction de sortie quand il est plein.
+ * Les séparateurs sont gérés automatiquement: il suffit d'enchaîner clés
+ * et valeurs. La première erreur de sortie est conservée et les écritures
+ * suivantes sont ignorées.
+ */
+typedef struct {
+    char buf[JSON_WRITER_BUFFER_SIZE];
+    size_t len;                     // Octets en attente dans buf
+    size_t flushed;                 // Octets déjà émis
+    bool need_comma;                // Une valeur précède: séparateur requis
+    json_writer_flush_t flush;
+    void *ctx;
+    httpd_req_t *req;               // Requête HTTP (json_writer_init_http), sinon NULL
+    esp_err_t err;
+} json_writer_t;
+
+/**
+ * @brief Initialise un writer avec une fonction de sortie quelconque
+ */
+void json_writer_init(json_writer_t *w, json_writer_flush_t flush, void *ctx);
+
+/**
+ * @brief Initialise un writer qui répond à une requête HTTP (application/json)
+ *
+ * Si la réponse tient dans le buffer, elle est envoyée en une fois avec
+ * Content-Length; sinon elle est émise en chunks (httpd_resp_send_chunk).
+ */
+void json_writer_init_http(json_writer_t *w, httpd_req_t *req);
+
+void json_writer_begin_object(json_writer_t *w);
+void json_writer_end_object(json_writer_t *w);
+void json_writer_begin_array(json_writer_t *w);
+void json_writer_end_array(json_writer_t *w);
+
+/**
+ * @brief Écrit une clé d'objet, la valeur suivante lui est associée
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+/**
+ * @brief Écrit une chaîne échappée (NULL produit null)
+ */
+void json_writer_string(json_writer_t *w, const char *value);
+void json_writer_int(json_writer_t *w, int64_t value);
+void json_writer_bool(json_writer_t *w, bool value);
+void json_writer_null(json_writer_t *w);
+
+/**
+ * @brief Écrit une valeur JSON déjà formée (fragment mis en cache), sans vérification
+ */
+void json_writer_fragment(json_writer_t *w, const char *json, size_t len);
+
+// Raccourcis clé + valeur
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value);
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value);
+
+/**
+ * @brief Émet les données restantes et termine la réponse
+ * @return ESP_OK si tout a été émis, sinon la première erreur de sortie
+ */
+esp_err_t json_writer_finish(json_writer_t *w);
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,26 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Fichier de l'interface web embarqué dans le firmware
+ *
+ * La table est générée au build par build_web_ui.py (web_assets.c) et reste
+ * en flash: tous les en-têtes sont des chaînes constantes précalculées.
+ */
+typedef struct {
+    const char *uri;            // URI servie (ex: "/assets/app.1a2b3c4d.js")
+    const uint8_t *data;        // Contenu tel qu'envoyé sur le réseau
+    size_t len;                 // Taille du contenu
+    const char *content_type;   // Type MIME
+    const char *encoding;       // Content-Encoding ("gzip") ou NULL
+    const char *etag;           // ETag fort (hash du contenu, guillemets inclus)
+    const char *cache_control;  // Cache-Control (immutable pour les assets hashés)
+} web_asset_t;
+
+extern const web_asset_t web_assets[];
+extern const size_t web_assets_count;
+
+#endif // WEB_ASSETS_H
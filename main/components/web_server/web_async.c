@@ -0,0 +1,121 @@
+#include "web_async.h"
+#include "web_metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+
+static const char *TAG = "WEB_ASYNC";
+
+// Même taille que la tâche httpd: la vérification GitHub fait un handshake TLS
+#define WEB_ASYNC_TASK_STACK_SIZE 8192
+#define WEB_ASYNC_TASK_PRIORITY 5
+
+typedef struct {
+    httpd_req_t *req;               // Copie obtenue par httpd_req_async_handler_begin
+    esp_err_t (*handler)(httpd_req_t *req);
+    web_metrics_sample_t sample;    // Mesure depuis la réception par le serveur
+} web_async_job_t;
+
+static QueueHandle_t s_queue = NULL;
+static TaskHandle_t s_workers[WEB_ASYNC_WORKERS];
+
+static void web_async_worker(void *pvParameters)
+{
+    web_async_job_t job;
+
+    while (1) {
+        if (xQueueReceive(s_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        job.handler(job.req);
+        int64_t end_us = esp_timer_get_time();
+
+        ESP_LOGD(TAG, "%s handled in %lld ms (queued %lld ms)", job.req->uri,
+                 (long long)((end_us - start_us) / 1000),
+                 (long long)((start_us - job.sample.start_us) / 1000));
+
+        web_metrics_end(job.req, &job.sample);
+        httpd_req_async_handler_complete(job.req);
+    }
+}
+
+esp_err_t web_async_start(void)
+{
+    if (s_queue) {
+        return ESP_OK;
+    }
+
+    s_queue = xQueueCreate(WEB_ASYNC_QUEUE_SIZE, sizeof(web_async_job_t));
+    if (!s_queue) {
+        ESP_LOGE(TAG, "Failed to create queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < WEB_ASYNC_WORKERS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "web_async_%d", i);
+        if (xTaskCreate(web_async_worker, name, WEB_ASYNC_TASK_STACK_SIZE, NULL,
+                        WEB_ASYNC_TASK_PRIORITY, &s_workers[i]) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            return ESP_FAIL;
+        }
+    }
+
+    ESP_LOGI(TAG, "Started %d async workers", WEB_ASYNC_WORKERS);
+    return ESP_OK;
+}
+
+bool web_async_is_worker(void)
+{
+    if (!s_queue) {
+        // Pool non démarré: le handler s'exécute dans la tâche du serveur
+        // (web_async_submit le rappellerait sans fin)
+        return true;
+    }
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < WEB_ASYNC_WORKERS; i++) {
+        if (s_workers[i] == current) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t web_async_submit(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req))
+{
+    if (!s_queue) {
+        // Pool non démarré: traitement direct (comportement historique)
+        return handler(req);
+    }
+
+    httpd_req_t *async_req = NULL;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start async request for %s", req->uri);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    web_async_job_t job = {
+        .req = async_req,
+        .handler = handler,
+    };
+    web_metrics_begin(&job.sample);
+
+    if (xQueueSend(s_queue, &job, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "All workers busy, rejecting %s", req->uri);
+        httpd_req_async_handler_complete(async_req);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_sendstr(req, "Server busy");
+        return ESP_OK;
+    }
+
+    // La mesure sera terminée par le worker
+    web_metrics_defer();
+    return ESP_OK;
+}
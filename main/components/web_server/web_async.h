@@ -0,0 +1,46 @@
+#ifndef WEB_ASYNC_H
+#define WEB_ASYNC_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define WEB_ASYNC_WORKERS 2
+#define WEB_ASYNC_QUEUE_SIZE 4
+
+/**
+ * @brief Démarre les tâches de traitement asynchrone (idempotent)
+ *
+ * Les workers restent actifs ensuite: ils ne font qu'attendre sur leur file
+ * et peuvent servir un serveur HTTP redémarré.
+ *
+ * @return ESP_OK si succès
+ */
+esp_err_t web_async_start(void);
+
+/**
+ * @brief Indique si l'appelant est un worker du pool
+ *
+ * Vrai aussi tant que le pool n'est pas démarré: les handlers s'exécutent
+ * alors directement dans la tâche du serveur.
+ */
+bool web_async_is_worker(void);
+
+/**
+ * @brief Confie une requête à un worker
+ *
+ * Les handlers lents (attente, TLS) commencent par:
+ *     if (!web_async_is_worker()) {
+ *         return web_async_submit(req, mon_handler);
+ *     }
+ * Le handler est alors rappelé depuis un worker avec une copie de la
+ * requête, et la tâche du serveur reste disponible pour les autres clients.
+ * Si tous les workers sont occupés et la file pleine, 503 est renvoyé.
+ *
+ * @param req Requête reçue par le serveur
+ * @param handler Handler à exécuter dans le worker
+ * @return ESP_OK si la requête a été confiée ou refusée proprement
+ */
+esp_err_t web_async_submit(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req));
+
+#endif // WEB_ASYNC_H
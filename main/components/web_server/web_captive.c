@@ -0,0 +1,163 @@
+#include "web_captive.h"
+#include "wifi_manager.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "WEB_CAPTIVE";
+
+#define WEB_CAPTIVE_BLOB_SIZE 256
+#define WEB_CAPTIVE_MAX_HOST 64
+
+typedef enum {
+    PROBE_REDIRECT,             // Mode AP: ouvre l'interface de configuration
+    PROBE_NO_CONTENT,           // Android, ChromeOS, Samsung
+    PROBE_APPLE,                // iOS, macOS
+    PROBE_MSFT_CONNECT,         // Windows 10+
+    PROBE_MSFT_NCSI,            // Windows (ancien NCSI)
+    PROBE_FIREFOX,
+    PROBE_NETWORK_MANAGER,      // Linux (GNOME, Ubuntu)
+    PROBE_RESPONSE_COUNT
+} probe_response_t;
+
+typedef struct {
+    const char *status;
+    const char *headers;        // En-têtes supplémentaires, chacun terminé par \r\n
+    const char *body;
+} probe_template_t;
+
+static const probe_template_t s_templates[PROBE_RESPONSE_COUNT] = {
+    [PROBE_REDIRECT] = { "302 Found", "Location: http://" WEB_CAPTIVE_AP_IP "/\r\n", "" },
+    [PROBE_NO_CONTENT] = { "204 No Content", "", "" },
+    [PROBE_APPLE] = { "200 OK", "Content-Type: text/html\r\n",
+                      "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>" },
+    [PROBE_MSFT_CONNECT] = { "200 OK", "Content-Type: text/plain\r\n", "Microsoft Connect Test" },
+    [PROBE_MSFT_NCSI] = { "200 OK", "Content-Type: text/plain\r\n", "Microsoft NCSI" },
+    [PROBE_FIREFOX] = { "200 OK", "Content-Type: text/plain\r\n", "success\n" },
+    [PROBE_NETWORK_MANAGER] = { "200 OK", "Content-Type: text/plain\r\nX-NetworkManager-Status: online\r\n",
+                                "NetworkManager is online\n" },
+};
+
+typedef struct {
+    const char *host;
+    probe_response_t response;  // Réponse "pas de portail" en mode STA
+} probe_host_t;
+
+// Mêmes noms que le cache DNS captif (dns_server.c), plus quelques variantes
+static const probe_host_t s_probe_hosts[] = {
+    { "connectivitycheck.gstatic.com", PROBE_NO_CONTENT },
+    { "connectivitycheck.android.com", PROBE_NO_CONTENT },
+    { "clients3.google.com", PROBE_NO_CONTENT },
+    { "clients1.google.com", PROBE_NO_CONTENT },
+    { "www.google.com", PROBE_NO_CONTENT },
+    { "connectivity.samsung.com", PROBE_NO_CONTENT },
+    { "captive.apple.com", PROBE_APPLE },
+    { "www.apple.com", PROBE_APPLE },
+    { "www.appleiphonecell.com", PROBE_APPLE },
+    { "www.msftconnecttest.com", PROBE_MSFT_CONNECT },
+    { "ipv6.msftconnecttest.com", PROBE_MSFT_CONNECT },
+    { "www.msftncsi.com", PROBE_MSFT_NCSI },
+    { "detectportal.firefox.com", PROBE_FIREFOX },
+    { "nmcheck.gnome.org", PROBE_NETWORK_MANAGER },
+    { "connectivity-check.ubuntu.com", PROBE_NETWORK_MANAGER },
+};
+
+#define PROBE_HOSTS_COUNT (sizeof(s_probe_hosts) / sizeof(s_probe_hosts[0]))
+
+static char s_blobs[PROBE_RESPONSE_COUNT][WEB_CAPTIVE_BLOB_SIZE];
+static size_t s_blob_len[PROBE_RESPONSE_COUNT];
+static bool s_ready = false;
+
+void web_captive_init(void)
+{
+    if (s_ready) {
+        return;
+    }
+
+    for (int i = 0; i < PROBE_RESPONSE_COUNT; i++) {
+        const probe_template_t *t = &s_templates[i];
+        char length[32] = "";
+        // Pas de Content-Length sur un 204 (RFC 9110)
+        if (i != PROBE_NO_CONTENT) {
+            snprintf(length, sizeof(length), "Content-Length: %u\r\n", (unsigned)strlen(t->body));
+        }
+
+        int n = snprintf(s_blobs[i], WEB_CAPTIVE_BLOB_SIZE,
+                         "HTTP/1.1 %s\r\n%sCache-Control: no-store\r\n%s\r\n%s",
+                         t->status, t->headers, length, t->body);
+        if (n < 0 || n >= WEB_CAPTIVE_BLOB_SIZE) {
+            ESP_LOGE(TAG, "Probe response %d too long", i);
+            return;
+        }
+        s_blob_len[i] = n;
+    }
+    s_ready = true;
+}
+
+/**
+ * Lit l'en-tête Host sans le port
+ * @return false si absent ou trop long
+ */
+static bool web_captive_get_host(httpd_req_t *req, char *host, size_t size)
+{
+    if (httpd_req_get_hdr_value_str(req, "Host", host, size) != ESP_OK) {
+        return false;
+    }
+    host[strcspn(host, ":")] = '\0';
+    return host[0] != '\0';
+}
+
+/**
+ * Noms sous lesquels l'interface est normalement ouverte
+ */
+static bool web_captive_is_local_host(const char *host)
+{
+    size_t len = strlen(host);
+    return strcmp(host, WEB_CAPTIVE_AP_IP) == 0 ||
+           (len > 6 && strcasecmp(host + len - 6, ".local") == 0);
+}
+
+#ifdef CONFIG_MINIOT_CAPTIVE_STA_ANSWERS
+static probe_response_t web_captive_find_probe(const char *host)
+{
+    for (size_t i = 0; i < PROBE_HOSTS_COUNT; i++) {
+        if (strcasecmp(s_probe_hosts[i].host, host) == 0) {
+            return s_probe_hosts[i].response;
+        }
+    }
+    return PROBE_RESPONSE_COUNT;
+}
+#endif
+
+esp_err_t web_captive_handler(httpd_req_t *req)
+{
+    char host[WEB_CAPTIVE_MAX_HOST];
+    probe_response_t response = PROBE_RESPONSE_COUNT;
+
+    if (s_ready && web_captive_get_host(req, host, sizeof(host))) {
+        if (wifi_manager_get_state() == WIFI_STATE_STA_CONNECTED) {
+#ifdef CONFIG_MINIOT_CAPTIVE_STA_ANSWERS
+            response = web_captive_find_probe(host);
+#endif
+        } else if (!web_captive_is_local_host(host)) {
+            response = PROBE_REDIRECT;
+        }
+    }
+
+    if (response == PROBE_RESPONSE_COUNT) {
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+
+    ESP_LOGD(TAG, "Probe %s%s -> %s", host, req->uri, s_templates[response].status);
+
+    // Réponse complète en un seul envoi, sans passer par httpd_resp_*
+    int sent = httpd_send(req, s_blobs[response], s_blob_len[response]);
+    if (sent != (int)s_blob_len[response]) {
+        ESP_LOGW(TAG, "Failed to send probe response (%d)", sent);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
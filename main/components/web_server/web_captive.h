@@ -0,0 +1,32 @@
+#ifndef WEB_CAPTIVE_H
+#define WEB_CAPTIVE_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define WEB_CAPTIVE_AP_IP "192.168.4.1"
+
+/**
+ * @brief Prépare les réponses aux sondes de portail captif
+ *
+ * Chaque réponse (ligne de statut, en-têtes et corps) est formatée une
+ * seule fois: une sonde est ensuite servie en un seul envoi.
+ */
+void web_captive_init(void);
+
+/**
+ * @brief Handler des requêtes sans route (fallback de web_router)
+ *
+ * Reconnaît une sonde de détection de portail captif à son en-tête Host,
+ * quel que soit le chemin demandé:
+ * - mode AP: tout Host étranger (le DNS captif renvoie tous les noms vers
+ *   l'AP) reçoit une redirection vers l'interface, ce qui couvre aussi les
+ *   OS non listés
+ * - mode STA (CONFIG_MINIOT_CAPTIVE_STA_ANSWERS): les hôtes de sonde connus
+ *   reçoivent la réponse "pas de portail" attendue par leur OS, pour que le
+ *   client cesse de sonder
+ * Les autres requêtes reçoivent un 404.
+ */
+esp_err_t web_captive_handler(httpd_req_t *req);
+
+#endif // WEB_CAPTIVE_H
@@ -0,0 +1,338 @@
+#include "web_events.h"
+#include "wifi_scan.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "WEB_EVENTS";
+
+#define WEB_EVENTS_TASK_STACK_SIZE 3072
+#define WEB_EVENTS_TASK_PRIORITY 4
+#define WEB_EVENTS_BUFFER_SIZE 320
+
+// Commentaire SSE périodique: garde la connexion active sans renvoyer l'état
+#define WEB_EVENTS_KEEPALIVE_MS 5000
+
+// Événements en attente (bits de la notification de la tâche)
+#define WEB_EVENTS_PENDING_OTA BIT0
+#define WEB_EVENTS_PENDING_SCAN BIT1
+#define WEB_EVENTS_PENDING_PING BIT2
+
+typedef struct {
+    char data[WEB_EVENTS_BUFFER_SIZE];
+    size_t len;
+} web_event_buffer_t;
+
+typedef struct {
+    httpd_req_t *req;               // Requête asynchrone, NULL = slot libre
+    uint32_t events_sent;
+} web_events_client_t;
+
+static web_events_client_t s_clients[WEB_EVENTS_MAX_CLIENTS];
+static SemaphoreHandle_t s_lock = NULL;         // Slots (jamais pris pendant un envoi)
+static SemaphoreHandle_t s_send_lock = NULL;    // Diffusion en cours: retient la fermeture des requêtes
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+static volatile size_t s_scan_count = 0;
+static volatile uint32_t s_ota_changes = 0;     // Notifications de progression OTA reçues
+
+static esp_err_t web_event_buffer_append(void *ctx, const char *data, size_t len)
+{
+    web_event_buffer_t *buf = (web_event_buffer_t *)ctx;
+    if (buf->len + len > sizeof(buf->data)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return ESP_OK;
+}
+
+/**
+ * Formate un événement: "ota" (progression courante), "scan" (fin de scan
+ * WiFi) ou commentaire de keepalive, ignoré par EventSource
+ */
+static esp_err_t web_events_format(web_event_buffer_t *buf, uint32_t event)
+{
+    static const char ota_header[] = "event: ota\ndata: ";
+    static const char scan_header[] = "event: scan\ndata: ";
+    static const char ping[] = ": ping\n\n";
+
+    buf->len = 0;
+    if (event == WEB_EVENTS_PENDING_PING) {
+        return web_event_buffer_append(buf, ping, sizeof(ping) - 1);
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, web_event_buffer_append, buf);
+
+    if (event == WEB_EVENTS_PENDING_SCAN) {
+        web_event_buffer_append(buf, scan_header, sizeof(scan_header) - 1);
+        json_writer_begin_object(&w);
+        json_writer_kv_int(&w, "count", s_scan_count);
+        json_writer_end_object(&w);
+    } else {
+        ota_progress_t progress;
+        ota_manager_get_progress(&progress);
+        web_event_buffer_append(buf, ota_header, sizeof(ota_header) - 1);
+        web_events_write_ota_progress(&w, &progress);
+    }
+
+    esp_err_t ret = json_writer_finish(&w);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return web_event_buffer_append(buf, "\n\n", 2);
+}
+
+/**
+ * Termine la requête asynchrone et libère le slot (s_lock pris)
+ */
+static void web_events_close_client_locked(web_events_client_t *client)
+{
+    ESP_LOGI(TAG, "Event stream closed after %" PRIu32 " events", client->events_sent);
+    httpd_req_async_handler_complete(client->req);
+    client->req = NULL;
+}
+
+/**
+ * Diffuse un événement à tous les flux ouverts
+ *
+ * Les requêtes sont copiées sous s_lock puis les envois sont faits hors de
+ * celui-ci: un client lent ne bloque pas l'ouverture d'un nouveau flux.
+ * s_send_lock empêche web_events_stop de terminer une requête en cours d'envoi.
+ */
+static void web_events_broadcast(uint32_t event)
+{
+    httpd_req_t *reqs[WEB_EVENTS_MAX_CLIENTS];
+    int count = 0;
+
+    xSemaphoreTake(s_send_lock, portMAX_DELAY);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        if (s_clients[i].req) {
+            reqs[count++] = s_clients[i].req;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    // Un seul formatage pour tous les clients
+    web_event_buffer_t buf;
+    if (count > 0 && web_events_format(&buf, event) != ESP_OK) {
+        ESP_LOGE(TAG, "Event does not fit in %d bytes", WEB_EVENTS_BUFFER_SIZE);
+        count = 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        esp_err_t ret = httpd_resp_send_chunk(reqs[i], buf.data, buf.len);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        for (int j = 0; j < WEB_EVENTS_MAX_CLIENTS; j++) {
+            web_events_client_t *client = &s_clients[j];
+            if (client->req != reqs[i]) {
+                continue;
+            }
+            if (ret == ESP_OK) {
+                client->events_sent += event != WEB_EVENTS_PENDING_PING;
+            } else {
+                // Client parti (onglet fermé, socket purgé par le serveur)
+                web_events_close_client_locked(client);
+            }
+        }
+        xSemaphoreGive(s_lock);
+    }
+    xSemaphoreGive(s_send_lock);
+}
+
+static void web_events_task(void *pvParameters)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    // Quitter aussi si un redémarrage rapide a déjà créé une nouvelle tâche
+    while (s_running && s_task_handle == self) {
+        uint32_t pending = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &pending, pdMS_TO_TICKS(WEB_EVENTS_KEEPALIVE_MS)) == pdFALSE) {
+            pending = WEB_EVENTS_PENDING_PING;
+        }
+        if (!s_running || s_task_handle != self) {
+            break;
+        }
+        if (pending & WEB_EVENTS_PENDING_OTA) {
+            web_events_broadcast(WEB_EVENTS_PENDING_OTA);
+        }
+        if (pending & WEB_EVENTS_PENDING_SCAN) {
+            web_events_broadcast(WEB_EVENTS_PENDING_SCAN);
+        }
+        if (pending & WEB_EVENTS_PENDING_PING) {
+            web_events_broadcast(WEB_EVENTS_PENDING_PING);
+        }
+    }
+
+    if (s_task_handle == self) {
+        s_task_handle = NULL;
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * Appelé depuis la tâche OTA: réveille simplement la tâche de diffusion, qui
+ * enverra l'état le plus récent (les changements rapprochés sont regroupés)
+ */
+static void web_events_on_ota_progress(const ota_progress_t *progress)
+{
+    s_ota_changes++;
+    TaskHandle_t task = s_task_handle;
+    if (task) {
+        xTaskNotify(task, WEB_EVENTS_PENDING_OTA, eSetBits);
+    }
+}
+
+/**
+ * Appelé depuis la boucle d'événements à la fin d'un scan WiFi
+ */
+static void web_events_on_scan_done(size_t count)
+{
+    s_scan_count = count;
+    TaskHandle_t task = s_task_handle;
+    if (task) {
+        xTaskNotify(task, WEB_EVENTS_PENDING_SCAN, eSetBits);
+    }
+}
+
+void web_events_write_ota_progress(json_writer_t *w, const ota_progress_t *progress)
+{
+    json_writer_begin_object(w);
+    json_writer_kv_bool(w, "in_progress", progress->in_progress);
+    json_writer_kv_int(w, "total_size", progress->total_size);
+    json_writer_kv_int(w, "downloaded", progress->downloaded);
+    json_writer_kv_int(w, "percent", progress->percent);
+    json_writer_kv_string(w, "status", progress->status);
+    json_writer_kv_int(w, "chunk_size", progress->chunk_size);
+    json_writer_kv_int(w, "chunk_latency_ms", progress->chunk_latency_ms);
+    json_writer_kv_int(w, "throughput", progress->throughput);
+    json_writer_end_object(w);
+}
+
+esp_err_t web_events_handler(httpd_req_t *req)
+{
+    if (!s_running) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Events not available");
+        return ESP_FAIL;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    web_events_client_t *client = NULL;
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        if (!s_clients[i].req) {
+            client = &s_clients[i];
+            break;
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    if (!client) {
+        ESP_LOGW(TAG, "Too many event streams (max %d)", WEB_EVENTS_MAX_CLIENTS);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "Too many event streams");
+        return ESP_OK;
+    }
+
+    // La connexion reste ouverte après le retour du handler
+    httpd_req_t *async_req = NULL;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start async request");
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(async_req, "text/event-stream");
+    httpd_resp_set_hdr(async_req, "Cache-Control", "no-cache");
+
+    // État initial envoyé immédiatement (l'en-tête HTTP part avec le premier chunk)
+    uint32_t ota_changes = s_ota_changes;
+    web_event_buffer_t buf;
+    if (web_events_format(&buf, WEB_EVENTS_PENDING_OTA) != ESP_OK ||
+        httpd_resp_send_chunk(async_req, buf.data, buf.len) != ESP_OK) {
+        httpd_req_async_handler_complete(async_req);
+        return ESP_FAIL;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (client->req || !s_running) {
+        // Slot pris entre-temps ou arrêt en cours
+        xSemaphoreGive(s_lock);
+        httpd_req_async_handler_complete(async_req);
+        return ESP_OK;
+    }
+    client->req = async_req;
+    client->events_sent = 1;
+    xSemaphoreGive(s_lock);
+
+    // Progression changée avant l'inscription du flux: diffusion manquée, on la redemande
+    TaskHandle_t task = s_task_handle;
+    if (s_ota_changes != ota_changes && task) {
+        xTaskNotify(task, WEB_EVENTS_PENDING_OTA, eSetBits);
+    }
+
+    ESP_LOGI(TAG, "Event stream opened");
+    return ESP_OK;
+}
+
+esp_err_t web_events_start(void)
+{
+    if (s_running) {
+        return ESP_OK;
+    }
+
+    if (!s_lock) {
+        s_lock = xSemaphoreCreateMutex();
+        s_send_lock = xSemaphoreCreateMutex();
+        if (!s_lock || !s_send_lock) {
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_running = true;
+    BaseType_t created = xTaskCreate(web_events_task, "web_events", WEB_EVENTS_TASK_STACK_SIZE,
+                                     NULL, WEB_EVENTS_TASK_PRIORITY, &s_task_handle);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create events task");
+        s_running = false;
+        return ESP_FAIL;
+    }
+
+    ota_manager_set_progress_callback(web_events_on_ota_progress);
+    wifi_scan_set_done_callback(web_events_on_scan_done);
+    return ESP_OK;
+}
+
+void web_events_stop(void)
+{
+    if (!s_running) {
+        return;
+    }
+
+    ota_manager_set_progress_callback(NULL);
+    wifi_scan_set_done_callback(NULL);
+
+    // Attend la fin d'une diffusion en cours avant de terminer ses requêtes
+    xSemaphoreTake(s_send_lock, portMAX_DELAY);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_running = false;
+    for (int i = 0; i < WEB_EVENTS_MAX_CLIENTS; i++) {
+        if (s_clients[i].req) {
+            web_events_close_client_locked(&s_clients[i]);
+        }
+    }
+    xSemaphoreGive(s_lock);
+    xSemaphoreGive(s_send_lock);
+
+    TaskHandle_t task = s_task_handle;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
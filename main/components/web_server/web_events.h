@@ -0,0 +1,38 @@
+#ifndef WEB_EVENTS_H
+#define WEB_EVENTS_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "json_writer.h"
+#include "ota_manager.h"
+
+#define WEB_EVENTS_MAX_CLIENTS 2
+
+/**
+ * @brief Démarre la tâche de diffusion des événements (Server-Sent Events)
+ * et s'abonne à la progression OTA et à la fin des scans WiFi
+ * @return ESP_OK si succès
+ */
+esp_err_t web_events_start(void);
+
+/**
+ * @brief Ferme les flux ouverts et arrête la tâche de diffusion
+ */
+void web_events_stop(void);
+
+/**
+ * @brief Handler pour GET /api/events
+ *
+ * Garde la connexion ouverte (httpd_req_async_handler_begin) et envoie un
+ * événement "ota" à la connexion puis à chaque changement de progression,
+ * un événement "scan" à chaque fin de scan WiFi, et un commentaire ": ping"
+ * après 5 s sans événement.
+ */
+esp_err_t web_events_handler(httpd_req_t *req);
+
+/**
+ * @brief Écrit la progression OTA en JSON (partagé avec /api/ota_progress)
+ */
+void web_events_write_ota_progress(json_writer_t *w, const ota_progress_t *progress);
+
+#endif // WEB_EVENTS_H
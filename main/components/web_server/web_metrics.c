@@ -0,0 +1,375 @@
+#include "web_metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "dns_resolver.h"
+#include "dns_server.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+static const char *TAG = "WEB_METRICS";
+
+// Bornes supérieures des buckets de latence en µs (+Inf implicite)
+static const uint32_t s_bucket_bounds_us[] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000
+};
+#define WEB_METRICS_BUCKETS (sizeof(s_bucket_bounds_us) / sizeof(s_bucket_bounds_us[0]) + 1)
+
+#define WEB_METRICS_BUFFER_SIZE 256
+
+/**
+ * Statistiques d'une URI
+ * Compteurs atomiques: mis à jour sans verrou depuis la tâche httpd, les
+ * workers et la tâche des événements. La somme des latences et les octets
+ * émis sont sur 64 bits (un compteur 32 bits d'octets déborde après 4 GB);
+ * les autres compteurs repartent à zéro en débordant, ce que Prometheus
+ * traite comme un redémarrage de compteur.
+ */
+struct web_metrics_entry {
+    const char *uri;                            // NULL = entrée libre
+    httpd_method_t method;
+    atomic_uint buckets[WEB_METRICS_BUCKETS];   // Non cumulés
+    atomic_ullong latency_sum_us;
+    atomic_ullong bytes_out;
+    atomic_int heap_delta;                      // Dernière variation du heap libre
+    atomic_uint heap_drop_max;                  // Plus forte baisse du heap libre
+    atomic_uint min_free_heap;                  // Minimum historique observé en fin de requête
+};
+
+static web_metrics_entry_t s_entries[WEB_METRICS_MAX_URIS];
+
+// URI de la dernière requête de chaque socket, pour attribuer les octets émis
+static web_metrics_entry_t *_Atomic s_socket_entries[CONFIG_LWIP_MAX_SOCKETS];
+
+// Coût de l'enregistrement lui-même
+static atomic_uint s_overhead_us;
+static atomic_uint s_overhead_count;
+
+// Écrit uniquement depuis la tâche httpd (wrapper et handlers)
+static bool s_deferred = false;
+
+static web_metrics_entry_t *web_metrics_entry_of(httpd_req_t *req)
+{
+    web_metrics_entry_t *entry = (web_metrics_entry_t *)req->user_ctx;
+    if (entry < s_entries || entry >= s_entries + WEB_METRICS_MAX_URIS) {
+        return NULL;
+    }
+    return entry;
+}
+
+static web_metrics_entry_t *_Atomic *web_metrics_socket_slot(int sockfd)
+{
+    int index = sockfd - LWIP_SOCKET_OFFSET;
+    if (index < 0 || index >= CONFIG_LWIP_MAX_SOCKETS) {
+        return NULL;
+    }
+    return &s_socket_entries[index];
+}
+
+/**
+ * Fonction d'émission de la session: identique à celle par défaut du
+ * serveur, avec comptage des octets émis (en-têtes compris)
+ */
+static int web_metrics_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    if (buf == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    int ret = send(sockfd, buf, buf_len, flags);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return HTTPD_SOCK_ERR_TIMEOUT;
+        }
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+
+    web_metrics_entry_t *_Atomic *slot = web_metrics_socket_slot(sockfd);
+    if (slot) {
+        web_metrics_entry_t *entry = atomic_load_explicit(slot, memory_order_relaxed);
+        if (entry) {
+            atomic_fetch_add_explicit(&entry->bytes_out, (unsigned long long)ret, memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+esp_err_t web_metrics_call(web_metrics_entry_t *entry, httpd_req_t *req,
+                           esp_err_t (*handler)(httpd_req_t *req))
+{
+    if (!entry) {
+        return handler(req);
+    }
+    // Retrouvée par web_metrics_end(), y compris sur la copie d'une requête asynchrone
+    req->user_ctx = entry;
+
+    web_metrics_sample_t sample;
+    web_metrics_begin(&sample);
+
+    int sockfd = httpd_req_to_sockfd(req);
+    web_metrics_entry_t *_Atomic *slot = web_metrics_socket_slot(sockfd);
+    if (slot) {
+        atomic_store_explicit(slot, entry, memory_order_relaxed);
+        httpd_sess_set_send_override(req->handle, sockfd, web_metrics_send);
+    }
+
+    s_deferred = false;
+    esp_err_t ret = handler(req);
+    if (!s_deferred) {
+        web_metrics_end(req, &sample);
+    }
+    return ret;
+}
+
+web_metrics_entry_t *web_metrics_entry(httpd_method_t method, const char *uri)
+{
+    for (int i = 0; i < WEB_METRICS_MAX_URIS; i++) {
+        if (s_entries[i].uri == NULL) {
+            s_entries[i].uri = uri;
+            s_entries[i].method = method;
+            atomic_store(&s_entries[i].min_free_heap, UINT32_MAX);
+            return &s_entries[i];
+        }
+        if (s_entries[i].method == method && strcmp(s_entries[i].uri, uri) == 0) {
+            // Serveur redémarré: on garde les statistiques
+            return &s_entries[i];
+        }
+    }
+
+    ESP_LOGW(TAG, "Metrics table full, %s not measured", uri);
+    return NULL;
+}
+
+void web_metrics_begin(web_metrics_sample_t *sample)
+{
+    sample->start_us = esp_timer_get_time();
+    sample->free_heap = esp_get_free_heap_size();
+}
+
+void web_metrics_end(httpd_req_t *req, const web_metrics_sample_t *sample)
+{
+    web_metrics_entry_t *entry = web_metrics_entry_of(req);
+    if (!entry) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint64_t elapsed_us = (uint64_t)(now - sample->start_us);
+    uint32_t free_heap = esp_get_free_heap_size();
+    uint32_t min_free_heap = esp_get_minimum_free_heap_size();
+
+    // Au-delà de la dernière borne, quelle que soit la durée: bucket +Inf
+    size_t bucket = 0;
+    while (bucket < WEB_METRICS_BUCKETS - 1 && elapsed_us > s_bucket_bounds_us[bucket]) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&entry->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->latency_sum_us, elapsed_us, memory_order_relaxed);
+
+    // Indicatif si plusieurs requêtes sont traitées en même temps
+    int32_t delta = (int32_t)(free_heap - sample->free_heap);
+    atomic_store_explicit(&entry->heap_delta, delta, memory_order_relaxed);
+
+    if (delta < 0) {
+        unsigned drop = (unsigned)-delta;
+        unsigned prev = atomic_load_explicit(&entry->heap_drop_max, memory_order_relaxed);
+        while (drop > prev &&
+               !atomic_compare_exchange_weak(&entry->heap_drop_max, &prev, drop)) {
+        }
+    }
+
+    unsigned prev_min = atomic_load_explicit(&entry->min_free_heap, memory_order_relaxed);
+    while (min_free_heap < prev_min &&
+           !atomic_compare_exchange_weak(&entry->min_free_heap, &prev_min, min_free_heap)) {
+    }
+
+    atomic_fetch_add_explicit(&s_overhead_us, (uint32_t)(esp_timer_get_time() - now),
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_overhead_count, 1, memory_order_relaxed);
+}
+
+void web_metrics_defer(void)
+{
+    s_deferred = true;
+}
+
+/* Sortie texte en chunks, sur le modèle de json_writer */
+typedef struct {
+    httpd_req_t *req;
+    char buf[WEB_METRICS_BUFFER_SIZE];
+    size_t len;
+    esp_err_t err;
+} web_metrics_output_t;
+
+static void web_metrics_flush(web_metrics_output_t *out)
+{
+    if (out->len > 0 && out->err == ESP_OK) {
+        out->err = httpd_resp_send_chunk(out->req, out->buf, out->len);
+    }
+    out->len = 0;
+}
+
+static void web_metrics_printf(web_metrics_output_t *out, const char *fmt, ...)
+{
+    for (int attempt = 0; attempt < 2 && out->err == ESP_OK; attempt++) {
+        size_t room = sizeof(out->buf) - out->len;
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(out->buf + out->len, room, fmt, args);
+        va_end(args);
+
+        if (n >= 0 && (size_t)n < room) {
+            out->len += n;
+            return;
+        }
+        // Ligne incomplète: vider le buffer et réessayer une fois
+        web_metrics_flush(out);
+    }
+}
+
+static void web_metrics_family(web_metrics_output_t *out, const char *name,
+                               const char *type, const char *help)
+{
+    web_metrics_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Secondes avec 6 décimales, à partir de µs
+#define WEB_METRICS_SECONDS_FMT "%" PRIu64 ".%06" PRIu32
+#define WEB_METRICS_SECONDS(us) (uint64_t)((us) / 1000000), (uint32_t)((us) % 1000000)
+
+esp_err_t web_metrics_handler(httpd_req_t *req)
+{
+    web_metrics_output_t out = { .req = req, .len = 0, .err = ESP_OK };
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    web_metrics_family(&out, "miniot_http_request_duration_seconds", "histogram",
+                       "HTTP handler latency by URI");
+    for (int i = 0; i < WEB_METRICS_MAX_URIS && s_entries[i].uri; i++) {
+        web_metrics_entry_t *e = &s_entries[i];
+        const char *method = http_method_str(e->method);
+        uint32_t cumulative = 0;
+
+        for (size_t b = 0; b < WEB_METRICS_BUCKETS; b++) {
+            cumulative += atomic_load_explicit(&e->buckets[b], memory_order_relaxed);
+            if (b < WEB_METRICS_BUCKETS - 1) {
+                web_metrics_printf(&out, "miniot_http_request_duration_seconds_bucket"
+                                   "{method=\"%s\",uri=\"%s\",le=\"" WEB_METRICS_SECONDS_FMT "\"} %" PRIu32 "\n",
+                                   method, e->uri, WEB_METRICS_SECONDS(s_bucket_bounds_us[b]), cumulative);
+            } else {
+                web_metrics_printf(&out, "miniot_http_request_duration_seconds_bucket"
+                                   "{method=\"%s\",uri=\"%s\",le=\"+Inf\"} %" PRIu32 "\n",
+                                   method, e->uri, cumulative);
+            }
+        }
+
+        uint64_t sum_us = atomic_load_explicit(&e->latency_sum_us, memory_order_relaxed);
+        web_metrics_printf(&out, "miniot_http_request_duration_seconds_sum{method=\"%s\",uri=\"%s\"} "
+                           WEB_METRICS_SECONDS_FMT "\n", method, e->uri, WEB_METRICS_SECONDS(sum_us));
+        web_metrics_printf(&out, "miniot_http_request_duration_seconds_count{method=\"%s\",uri=\"%s\"} %"
+                           PRIu32 "\n", method, e->uri, cumulative);
+    }
+
+    web_metrics_family(&out, "miniot_http_response_bytes_total", "counter",
+                       "Bytes sent including headers, by URI");
+    for (int i = 0; i < WEB_METRICS_MAX_URIS && s_entries[i].uri; i++) {
+        uint64_t bytes_out = atomic_load_explicit(&s_entries[i].bytes_out, memory_order_relaxed);
+        web_metrics_printf(&out, "miniot_http_response_bytes_total{method=\"%s\",uri=\"%s\"} %" PRIu64 "\n",
+                           http_method_str(s_entries[i].method), s_entries[i].uri, bytes_out);
+    }
+
+    web_metrics_family(&out, "miniot_http_heap_delta_bytes", "gauge",
+                       "Free heap change across the last request, by URI");
+    for (int i = 0; i < WEB_METRICS_MAX_URIS && s_entries[i].uri; i++) {
+        web_metrics_printf(&out, "miniot_http_heap_delta_bytes{method=\"%s\",uri=\"%s\"} %d\n",
+                           http_method_str(s_entries[i].method), s_entries[i].uri,
+                           atomic_load_explicit(&s_entries[i].heap_delta, memory_order_relaxed));
+    }
+
+    web_metrics_family(&out, "miniot_http_heap_drop_max_bytes", "gauge",
+                       "Largest free heap drop across a request, by URI");
+    for (int i = 0; i < WEB_METRICS_MAX_URIS && s_entries[i].uri; i++) {
+        web_metrics_printf(&out, "miniot_http_heap_drop_max_bytes{method=\"%s\",uri=\"%s\"} %u\n",
+                           http_method_str(s_entries[i].method), s_entries[i].uri,
+                           atomic_load_explicit(&s_entries[i].heap_drop_max, memory_order_relaxed));
+    }
+
+    web_metrics_family(&out, "miniot_http_min_free_heap_bytes", "gauge",
+                       "Minimum free heap ever seen at the end of a request, by URI");
+    for (int i = 0; i < WEB_METRICS_MAX_URIS && s_entries[i].uri; i++) {
+        unsigned min_free = atomic_load_explicit(&s_entries[i].min_free_heap, memory_order_relaxed);
+        if (min_free == UINT32_MAX) {
+            continue;
+        }
+        web_metrics_printf(&out, "miniot_http_min_free_heap_bytes{method=\"%s\",uri=\"%s\"} %u\n",
+                           http_method_str(s_entries[i].method), s_entries[i].uri, min_free);
+    }
+
+    uint32_t overhead_us = atomic_load_explicit(&s_overhead_us, memory_order_relaxed);
+    web_metrics_family(&out, "miniot_http_metrics_overhead_seconds_total", "counter",
+                       "Time spent recording request metrics");
+    web_metrics_printf(&out, "miniot_http_metrics_overhead_seconds_total " WEB_METRICS_SECONDS_FMT "\n",
+                       WEB_METRICS_SECONDS(overhead_us));
+    web_metrics_family(&out, "miniot_http_metrics_recorded_total", "counter",
+                       "Requests recorded");
+    web_metrics_printf(&out, "miniot_http_metrics_recorded_total %u\n",
+                       atomic_load_explicit(&s_overhead_count, memory_order_relaxed));
+
+    web_metrics_family(&out, "miniot_heap_free_bytes", "gauge", "Current free heap");
+    web_metrics_printf(&out, "miniot_heap_free_bytes %" PRIu32 "\n", esp_get_free_heap_size());
+    web_metrics_family(&out, "miniot_heap_min_free_bytes", "gauge", "Minimum free heap since boot");
+    web_metrics_printf(&out, "miniot_heap_min_free_bytes %" PRIu32 "\n", esp_get_minimum_free_heap_size());
+
+    // Serveur DNS captif (mode AP): compteurs depuis le boot, mis à jour par la tâche du reactor
+    dns_server_stats_t dns;
+    dns_server_get_stats(&dns);
+    web_metrics_family(&out, "miniot_dns_server_queries_total", "counter",
+                       "Captive DNS queries by type");
+    web_metrics_printf(&out, "miniot_dns_server_queries_total{type=\"A\"} %" PRIu32 "\n"
+                       "miniot_dns_server_queries_total{type=\"AAAA\"} %" PRIu32 "\n"
+                       "miniot_dns_server_queries_total{type=\"HTTPS\"} %" PRIu32 "\n",
+                       dns.a, dns.aaaa, dns.https);
+    web_metrics_printf(&out, "miniot_dns_server_queries_total{type=\"PTR\"} %" PRIu32 "\n"
+                       "miniot_dns_server_queries_total{type=\"other\"} %" PRIu32 "\n",
+                       dns.ptr, dns.other);
+    web_metrics_family(&out, "miniot_dns_server_errors_total", "counter",
+                       "Malformed captive DNS queries or unsupported opcodes");
+    web_metrics_printf(&out, "miniot_dns_server_errors_total %" PRIu32 "\n", dns.errors);
+    web_metrics_family(&out, "miniot_dns_server_cache_hits_total", "counter",
+                       "A queries answered from the hot name cache");
+    web_metrics_printf(&out, "miniot_dns_server_cache_hits_total %" PRIu32 "\n", dns.cache_hits);
+    web_metrics_family(&out, "miniot_dns_server_cache_misses_total", "counter",
+                       "A queries answered by building the response");
+    web_metrics_printf(&out, "miniot_dns_server_cache_misses_total %" PRIu32 "\n", dns.cache_misses);
+    web_metrics_family(&out, "miniot_dns_server_rate_limited_total", "counter",
+                       "Captive DNS queries dropped by the per-client rate limit");
+    web_metrics_printf(&out, "miniot_dns_server_rate_limited_total %" PRIu32 "\n", dns.rate_limited);
+
+    // Cache du résolveur DNS amont (mode STA)
+    dns_resolver_stats_t resolver;
+    dns_resolver_get_stats(&resolver);
+    web_metrics_family(&out, "miniot_dns_resolver_cache_hits_total", "counter",
+                       "Upstream DNS lookups answered from the cache");
+    web_metrics_printf(&out, "miniot_dns_resolver_cache_hits_total %" PRIu32 "\n", resolver.hits);
+    web_metrics_family(&out, "miniot_dns_resolver_cache_misses_total", "counter",
+                       "Upstream DNS lookups sent to the DHCP servers");
+    web_metrics_printf(&out, "miniot_dns_resolver_cache_misses_total %" PRIu32 "\n", resolver.misses);
+    web_metrics_family(&out, "miniot_dns_resolver_failures_total", "counter",
+                       "Upstream DNS lookups that failed (lwIP fallback)");
+    web_metrics_printf(&out, "miniot_dns_resolver_failures_total %" PRIu32 "\n", resolver.failures);
+    web_metrics_family(&out, "miniot_dns_resolver_saved_seconds_total", "counter",
+                       "Resolution time avoided by cache hits");
+    web_metrics_printf(&out, "miniot_dns_resolver_saved_seconds_total %" PRIu32 ".%03" PRIu32 "\n",
+                       resolver.saved_ms / 1000, resolver.saved_ms % 1000);
+
+    web_metrics_flush(&out);
+    if (out.err != ESP_OK) {
+        return out.err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
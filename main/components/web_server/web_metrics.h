@@ -0,0 +1,68 @@
+#ifndef WEB_METRICS_H
+#define WEB_METRICS_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define WEB_METRICS_MAX_URIS 24
+
+/**
+ * @brief Début de mesure d'une requête
+ */
+typedef struct {
+    int64_t start_us;
+    uint32_t free_heap;
+} web_metrics_sample_t;
+
+/**
+ * @brief Statistiques d'une route (structure opaque)
+ */
+typedef struct web_metrics_entry web_metrics_entry_t;
+
+/**
+ * @brief Crée ou retrouve l'entrée de statistiques d'une route
+ *
+ * Les statistiques survivent à un redémarrage du serveur.
+ *
+ * @return Entrée, ou NULL si la table est pleine (route alors non mesurée)
+ */
+web_metrics_entry_t *web_metrics_entry(httpd_method_t method, const char *uri);
+
+/**
+ * @brief Appelle le handler d'une route en mesurant la requête
+ *
+ * Mesure nombre d'appels, latence (histogramme), octets émis (en-têtes
+ * compris), variation du heap et heap libre minimum. req->user_ctx est
+ * remplacé par l'entrée: aucun handler ne l'utilise.
+ *
+ * @param entry Entrée de la route (NULL: handler appelé sans mesure)
+ * @return Valeur de retour du handler
+ */
+esp_err_t web_metrics_call(web_metrics_entry_t *entry, httpd_req_t *req,
+                           esp_err_t (*handler)(httpd_req_t *req));
+
+/**
+ * @brief Début de mesure (requête confiée à un worker, voir web_async)
+ */
+void web_metrics_begin(web_metrics_sample_t *sample);
+
+/**
+ * @brief Fin de mesure: enregistre la requête dans les statistiques de son URI
+ */
+void web_metrics_end(httpd_req_t *req, const web_metrics_sample_t *sample);
+
+/**
+ * @brief Signale depuis un handler que la requête sera terminée plus tard
+ *
+ * Le wrapper n'enregistre alors rien au retour du handler: c'est à celui qui
+ * termine la requête d'appeler web_metrics_end().
+ */
+void web_metrics_defer(void);
+
+/**
+ * @brief Handler pour GET /api/metrics (format texte Prometheus)
+ */
+esp_err_t web_metrics_handler(httpd_req_t *req);
+
+#endif // WEB_METRICS_H
@@ -0,0 +1,114 @@
+#include "web_router.h"
+#include "web_metrics.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdint.h>
+#include "web_routes_hash.h"
+
+static const char *TAG = "WEB_ROUTER";
+
+static const web_route_t *s_routes = NULL;
+static esp_err_t (*s_fallback)(httpd_req_t *req) = NULL;
+
+// Statistiques de chaque route (NULL si la table web_metrics est pleine)
+static web_metrics_entry_t *s_route_metrics[WEB_ROUTES_COUNT];
+
+/* Doivent rester identiques à fnv1a()/mix() de build_routes.py */
+static uint32_t web_router_hash(const char *method, const char *path, size_t len)
+{
+    uint32_t h = 0x811C9DC5;
+    for (; *method; method++) {
+        h = (h ^ (uint8_t)*method) * 0x01000193;
+    }
+    h = (h ^ ' ') * 0x01000193;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)path[i]) * 0x01000193;
+    }
+    return h;
+}
+
+static uint32_t web_router_mix(uint32_t h, uint32_t seed)
+{
+    h ^= seed * 0x9E3779B9;
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+const web_route_t *web_router_lookup(httpd_method_t method, const char *uri)
+{
+    if (!s_routes) {
+        return NULL;
+    }
+
+    size_t len = strcspn(uri, "?");
+
+    if (WEB_ROUTES_HASH_SIZE > 0) {
+        // Une seule case candidate: il suffit de vérifier qu'elle correspond
+        uint32_t h = web_router_hash(http_method_str(method), uri, len);
+        uint16_t seed = s_route_seeds[web_router_mix(h, 0) % WEB_ROUTES_HASH_SIZE];
+        const web_route_t *route = &s_routes[s_route_slots[web_router_mix(h, seed) % WEB_ROUTES_HASH_SIZE]];
+        if (route->method == method && strncmp(route->path, uri, len) == 0 && route->path[len] == '\0') {
+            return route;
+        }
+    }
+
+    for (size_t i = 0; i < WEB_ROUTES_PREFIX_COUNT; i++) {
+        const web_route_t *route = &s_routes[s_route_prefixes[i]];
+        size_t prefix_len = strlen(route->path) - 1;
+        if (route->method == method && len >= prefix_len && strncmp(route->path, uri, prefix_len) == 0) {
+            return route;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t web_router_dispatch(httpd_req_t *req)
+{
+    const web_route_t *route = web_router_lookup(req->method, req->uri);
+    if (!route) {
+        if (s_fallback) {
+            return s_fallback(req);
+        }
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+    return web_metrics_call(s_route_metrics[route - s_routes], req, route->handler);
+}
+
+esp_err_t web_router_start(httpd_handle_t server, const web_route_t *routes, size_t count,
+                           esp_err_t (*fallback)(httpd_req_t *req))
+{
+    if (count != WEB_ROUTES_COUNT) {
+        ESP_LOGE(TAG, "Route table mismatch (%d routes, %d generated)", (int)count, WEB_ROUTES_COUNT);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    s_routes = routes;
+    s_fallback = fallback;
+    for (size_t i = 0; i < count; i++) {
+        s_route_metrics[i] = web_metrics_entry(routes[i].method, routes[i].path);
+    }
+
+    for (size_t i = 0; i < WEB_ROUTES_METHOD_COUNT; i++) {
+        const httpd_uri_t uri = {
+            .uri = "/*",
+            .method = s_route_methods[i],
+            .handler = web_router_dispatch,
+            .user_ctx = NULL,
+        };
+        esp_err_t err = httpd_register_uri_handler(server, &uri);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s handler: %s",
+                     http_method_str(s_route_methods[i]), esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    ESP_LOGI(TAG, "%d routes (%d exact, %d prefix)", WEB_ROUTES_COUNT,
+             WEB_ROUTES_HASH_SIZE, WEB_ROUTES_PREFIX_COUNT);
+    return ESP_OK;
+}
@@ -0,0 +1,43 @@
+#ifndef WEB_ROUTER_H
+#define WEB_ROUTER_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @brief Route HTTP (voir web_routes.def)
+ */
+typedef struct {
+    httpd_method_t method;
+    const char *path;                       // Exact, ou préfixe si terminé par '*'
+    esp_err_t (*handler)(httpd_req_t *req);
+} web_route_t;
+
+/**
+ * @brief Enregistre le routeur sur le serveur
+ *
+ * Un seul handler générique (toutes URIs) est enregistré par méthode: la
+ * route est ensuite trouvée par hachage parfait du couple (méthode, chemin),
+ * table générée au build par build_routes.py. Le coût de sélection ne
+ * dépend donc pas du nombre de routes, ni de max_uri_handlers.
+ * Chaque route est instrumentée (web_metrics).
+ *
+ * @param server Serveur démarré, avec config.uri_match_fn = httpd_uri_match_wildcard
+ * @param routes Tableau construit depuis web_routes.def, dans le même ordre
+ * @param count Nombre de routes
+ * @param fallback Handler des requêtes sans route (NULL: 404)
+ * @return ESP_OK si succès
+ *         ESP_ERR_INVALID_SIZE si le tableau ne correspond pas à la table générée
+ */
+esp_err_t web_router_start(httpd_handle_t server, const web_route_t *routes, size_t count,
+                           esp_err_t (*fallback)(httpd_req_t *req));
+
+/**
+ * @brief Recherche la route d'une requête
+ * @param method Méthode HTTP
+ * @param uri URI de la requête (la query string est ignorée)
+ * @return Route trouvée, ou NULL
+ */
+const web_route_t *web_router_lookup(httpd_method_t method, const char *uri);
+
+#endif // WEB_ROUTER_H
@@ -2,12 +2,24 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_system.h"
-#include "cJSON.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "web_events.h"
+#include "web_async.h"
+#include "web_metrics.h"
+#include "web_router.h"
+#include "web_captive.h"
+#include "web_ui.h"
+#include "wifi_scan.h"
 #include "wifi_manager.h"
 #include "nvs_storage.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <inttypes.h>
 #include "ota_manager.h"
@@ -17,316 +29,18 @@
 static const char *TAG = "WEB_SERVER";
 static httpd_handle_t s_server = NULL;
 
-// Constants
-#define OTA_START_TIMEOUT_SEC 2
-#define OTA_COMPLETION_TIMEOUT_SEC 5
-#define OTA_PROGRESS_POLL_INTERVAL_MS 500
-
-// Macro pour convertir les nombres en chaînes
-#define XSTR(x) #x
-#define STR(x) XSTR(x)
-
-// Déclarations des pages HTML (définis plus bas)
-extern const char index_html_start[] asm("_binary_index_html_start");
-extern const char index_html_end[] asm("_binary_index_html_end");
-
-// Page HTML principale (sera intégrée plus tard)
-static const char *html_page =
-"<!DOCTYPE html>"
-"<html>"
-"<head>"
-"<meta charset='UTF-8'>"
-"<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-"<title>Miniot Configuration</title>"
-"<style>"
-"body{font-family:Arial,sans-serif;margin:0;padding:20px;background:#f0f0f0}"
-".container{max-width:600px;margin:0 auto;background:white;padding:20px;border-radius:8px;box-shadow:0 2px 4px rgba(0,0,0,0.1)}"
-"h1{color:#333;margin-top:0}"
-".section{margin:20px 0;padding:15px;background:#f9f9f9;border-radius:4px}"
-"label{display:block;margin:10px 0 5px;font-weight:bold}"
-"input,select{width:100%;padding:8px;border:1px solid #ddd;border-radius:4px;box-sizing:border-box}"
-"button{background:#007bff;color:white;padding:10px 20px;border:none;border-radius:4px;cursor:pointer;margin:5px 5px 5px 0}"
-"button:hover{background:#0056b3}"
-"button.danger{background:#dc3545}"
-"button.danger:hover{background:#c82333}"
-".info{background:#e7f3ff;padding:10px;border-radius:4px;margin:10px 0}"
-".status{padding:10px;margin:10px 0;border-radius:4px}"
-".success{background:#d4edda;color:#155724}"
-".error{background:#f8d7da;color:#721c24}"
-"#networks{max-height:200px;overflow-y:auto}"
-".network-item{padding:8px;margin:5px 0;background:white;border:1px solid #ddd;border-radius:4px;cursor:pointer}"
-".network-item:hover{background:#f0f0f0}"
-".loading{display:none;text-align:center;padding:20px}"
-"</style>"
-"</head>"
-"<body>"
-"<div class='container'>"
-"<h1>MiniOT Configuration</h1>"
-"<div id='statusMsg'></div>"
-"<div class='info' id='deviceInfo'>"
-"<strong>Device Info:</strong><br>"
-"IP: <span id= 'ipAddr'>Loading...</span><br>"
-"MAC: <span id='macAddr'>Loading...</span><br>"
-"State: <span id='wifiState'>Loading...</span>"
-"</div>"
-"<div class='section'>"
-"<h2>WiFi Configuration</h2>"
-"<button onclick='scanNetworks()'>🔍 Scan WiFi Networks</button>"
-"<div id='networks'></div>"
-"<label>SSID:</label>"
-"<input type='text' id='ssid' placeholder='Enter WiFi SSID'>"
-"<label>Password:</label>"
-"<input type='password' id='password' placeholder='Enter WiFi Password'>"
-"<label>AP Timeout (seconds):</label>"
-"<input type='number' id='apTimeout' value='60' min='10' max='300'>"
-"<button onclick='saveWifiConfig()'>💾 Save WiFi Config</button>"
-"</div>"
-"<div class='section'>"
-"<h2>System Actions</h2>"
-"<button onclick='rebootDevice()'>🔄 Reboot Device</button>"
-"<button class='danger' onclick='factoryReset()'>⚠️ Factory Reset</button>"
-"</div>"
-"<div class='section'>"
-"<h2>Firmware Update (OTA)</h2>"
-"<div class='info'>"
-"Version: <span id='firmwareVersion'>Loading...</span><br>"
-"Partition: <span id='runningPartition'>Loading...</span>"
-"</div>"
-"<button onclick='checkGithubUpdate()'>🔍 Check GitHub for Updates</button>"
-"<div id='githubUpdateInfo' style='margin:10px 0'></div>"
-"<div id='otaProgressContainer' style='display:none;margin:15px 0;padding:15px;background:#e7f3ff;border-radius:4px'>"
-"<div style='font-weight:bold;margin-bottom:10px' id='otaStatus'>Downloading...</div>"
-"<div style='background:#ddd;border-radius:10px;overflow:hidden;height:30px'>"
-"<div id='otaProgressBar' style='background:#007bff;height:100%;width:0%;transition:width 0.3s;display:flex;align-items:center;justify-content:center;color:white;font-weight:bold'>"
-"<span id='otaPercent'>0%</span>"
-"</div>"
-"</div>"
-"<div style='margin-top:8px;font-size:0.9em;color:#666' id='otaDetails'>0 / 0 KB</div>"
-"</div>"
-"<hr style='margin:20px 0'>"
-"<h3>Manual Update</h3>"
-"<label>Firmware URL:</label>"
-"<input type='text' id='firmwareUrl' placeholder='http://192.168.1.100:8000/firmware.bin'>"
-"<button onclick='startOtaUpdate()'>⬆️ Update Firmware</button>"
-"</div>"
-"</div>"
-"<script>"
-"function showStatus(msg,isError){"
-"const div=document.getElementById('statusMsg');"
-"div.className=isError?'status error':'status success';"
-"div.textContent=msg;"
-"setTimeout(()=>div.textContent='',5000);"
-"}"
-"async function loadDeviceInfo(){"
-"try{"
-"const res=await fetch('/api/status');"
-"const data=await res.json();"
-"document.getElementById('ipAddr').textContent=data.ip||'N/A';"
-"document.getElementById('macAddr').textContent=data.mac||'N/A';"
-"document.getElementById('wifiState').textContent=data.state||'N/A';"
-"}catch(e){console.error('Failed to load device info',e);}"
-"}"
-"async function scanNetworks(){"
-"const div=document.getElementById('networks');"
-"div.innerHTML='<div class=\"loading\" style=\"display:block\">Scanning...</div>';"
-"try{"
-"const res=await fetch('/api/scan');"
-"const data=await res.json();"
-"if(data.networks&&data.networks.length>0){"
-"div.innerHTML=data.networks.map(n=>"
-"`<div class='network-item' onclick='selectNetwork(\"${n.ssid}\",${n.rssi})'>"
-"${n.ssid} (${n.rssi} dBm) ${n.auth?'🔒':''}</div>`"
-").join('');"
-"}else{div.innerHTML='<p>No networks found</p>';}"
-"}catch(e){"
-"div.innerHTML='<p class=\"error\">Scan failed</p>';"
-"console.error('Scan failed',e);"
-"}"
-"}"
-"function selectNetwork(ssid,rssi){"
-"document.getElementById('ssid').value=ssid;"
-"document.getElementById('password').focus();"
-"}"
-"async function saveWifiConfig(){"
-"const ssid=document.getElementById('ssid').value;"
-"const password=document.getElementById('password').value;"
-"const apTimeout=document.getElementById('apTimeout').value;"
-"if(!ssid){showStatus('Please enter SSID',true);return;}"
-"try{"
-"const res=await fetch('/api/configure',{"
-"method:'POST',"
-"headers:{'Content-Type':'application/json'},"
-"body:JSON.stringify({ssid,password,ap_timeout:parseInt(apTimeout)})"
-"});"
-"const data=await res.json();"
-"if(data.success){"
-"showStatus('Configuration saved! Rebooting...',false);"
-"setTimeout(()=>location.reload(),3000);"
-"}else{showStatus('Failed to save configuration',true);}"
-"}catch(e){"
-"showStatus('Error saving configuration',true);"
-"console.error('Save failed',e);"
-"}"
-"}"
-"async function rebootDevice(){"
-"if(confirm('Reboot the device?')){"
-"try{"
-"await fetch('/api/reboot',{method:'POST'});"
-"showStatus('Rebooting...',false);"
-"}catch(e){console.error('Reboot failed',e);}"
-"}"
-"}"
-"async function factoryReset(){"
-"if(confirm('Factory reset will erase all settings. Continue?')){"
-"try{"
-"await fetch('/api/factory_reset',{method:'POST'});"
-"showStatus('Factory reset completed. Rebooting...',false);"
-"setTimeout(()=>location.reload(),3000);"
-"}catch(e){console.error('Factory reset failed',e);}"
-"}"
-"}"
-"async function loadFirmwareInfo(){"
-"const res=await fetch('/api/ota_version');"
-"const data=await res.json();"
-"document.getElementById('firmwareVersion').textContent=data.version||'N/A';"
-"document.getElementById('runningPartition').textContent=data.partition||'N/A';"
-"}"
-"async function startOtaUpdate(){"
-"const url=document.getElementById('firmwareUrl').value;"
-"if(!url){showStatus('Please enter firmware URL',true);return;}"
-"if(confirm('Start OTA update? Device will reboot after update.')){"
-"try{"
-"const res=await fetch('/api/ota_update',{"
-"method:'POST',"
-"headers:{'Content-Type':'application/json'},"
-"body:JSON.stringify({url})"
-"});"
-"const data=await res.json();"
-"if(data.success){"
-"showStatus('OTA update in progress... Device will reboot automatically.',false);"
-"startProgressMonitoring();"
-"}else{showStatus('Failed to start OTA update',true);}"
-"}catch(e){showStatus('Error starting OTA update',true);console.error('OTA failed',e);}"
-"}"
-"}"
-"async function checkGithubUpdate(){"
-"const div=document.getElementById('githubUpdateInfo');"
-"div.innerHTML='<div class=\"loading\" style=\"display:block\">Checking GitHub...</div>';"
-"try{"
-"const res=await fetch('/api/check_github_update');"
-"const data=await res.json();"
-"if(data.success){"
-"if(data.update_available){"
-"div.innerHTML='<div class=\"status success\">✅ New version available: <strong>'+data.new_version+'</strong><br>'"
-"+'Current: '+data.current_version+'<br>'"
-"+'<button onclick=\"installGithubUpdate()\">⬆️ Install Update</button></div>';"
-"}else{"
-"div.innerHTML='<div class=\"info\">✓ You are running the latest version ('+data.current_version+')</div>';"
-"}"
-"}else{"
-"div.innerHTML='<div class=\"status error\">❌ '+data.error+'</div>';"
-"}"
-"}catch(e){"
-"div.innerHTML='<div class=\"status error\">❌ Failed to check for updates</div>';"
-"console.error('Update check failed',e);"
-"}"
-"}"
-"let progressInterval=null;"
-"let otaStartTime=0;"
-"function startProgressMonitoring(){"
-"document.getElementById('otaProgressContainer').style.display='block';"
-"document.getElementById('otaProgressBar').style.width='0%';"
-"document.getElementById('otaPercent').textContent='0%';"
-"document.getElementById('otaStatus').textContent='Starting...';"
-"document.getElementById('otaDetails').textContent='Initializing...';"
-"otaStartTime=Date.now();"
-"if(progressInterval)clearInterval(progressInterval);"
-"progressInterval=setInterval(async()=>{"
-"try{"
-"const res=await fetch('/api/ota_progress');"
-"const data=await res.json();"
-"if(data.in_progress){"
-"document.getElementById('otaProgressBar').style.width=data.percent+'%';"
-"document.getElementById('otaPercent').textContent=data.percent+'%';"
-"document.getElementById('otaStatus').textContent=data.status;"
-"const downloadedKB=(data.downloaded/1024).toFixed(1);"
-"const totalKB=(data.total_size/1024).toFixed(1);"
-"document.getElementById('otaDetails').textContent=downloadedKB+' / '+totalKB+' KB';"
-"}else{"
-"const elapsed=(Date.now()-otaStartTime)/1000;"
-// Wait OTA_START_TIMEOUT_SEC for OTA task to start
-"if(elapsed<2){return;}"
-"clearInterval(progressInterval);"
-"if(data.percent===100){"
-"document.getElementById('otaStatus').textContent='✅ '+data.status;"
-// Hide progress after OTA_COMPLETION_TIMEOUT_SEC if not complete
-"}else if(elapsed>5){"
-"document.getElementById('otaProgressContainer').style.display='none';"
-"}"
-"}"
-"}catch(e){console.error('Progress fetch failed',e);}"
-// Poll interval: OTA_PROGRESS_POLL_INTERVAL_MS
-"},500);"
-"}"
-"async function installGithubUpdate(){"
-"if(confirm('Install update from GitHub? Device will reboot after update.')){"
-"try{"
-"const res=await fetch('/api/install_github_update',{method:'POST'});"
-"const data=await res.json();"
-"if(data.success){"
-"document.getElementById('githubUpdateInfo').innerHTML='<div class=\"status success\">⏳ Installing update...</div>';"
-"startProgressMonitoring();"
-"}else{showStatus('Failed to start GitHub update',true);}"
-"}catch(e){showStatus('Error starting GitHub update',true);console.error('GitHub OTA failed',e);}"
-"}"
-"}"
-"async function checkOngoingOta(){"
-"try{"
-"const res=await fetch('/api/ota_progress');"
-"const data=await res.json();"
-"if(data.in_progress){"
-"document.getElementById('githubUpdateInfo').innerHTML='<div class=\"status success\">⏳ Update in progress...</div>';"
-"startProgressMonitoring();"
-"return true;"
-"}"
-"return false;"
-"}catch(e){console.error('Failed to check ongoing OTA',e);return false;}"
-"}"
-"loadFirmwareInfo();"
-"loadDeviceInfo();"
-"checkOngoingOta().then(inProgress=>{"
-"if(!inProgress){setTimeout(checkGithubUpdate,1000);}"
-"});"
-"</script>"
-"</body>"
-"</html>";
-
-/* Handler pour la page principale */
-static esp_err_t index_handler(httpd_req_t *req)
-{
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html_page, strlen(html_page));
-    return ESP_OK;
-}
+// Upload OTA: blocs de la taille d'un secteur flash, délais de réception tolérés
+#define OTA_UPLOAD_CHUNK_SIZE 4096
+#define OTA_UPLOAD_MAX_TIMEOUTS 3
 
-/* Handler pour les requêtes de détection de portail captif */
-static esp_err_t captive_portal_handler(httpd_req_t *req)
-{
-    // Rediriger vers la page principale pour forcer l'ouverture du portail captif
-    httpd_resp_set_status(req, "302 Found");
-    httpd_resp_set_hdr(req, "Location", "http://192.168.4.1/");
-    httpd_resp_send(req, NULL, 0);
-    return ESP_OK;
-}
-
-/* Handler pour GET /api/status */
-static esp_err_t status_handler(httpd_req_t *req)
+/**
+ * Écrit l'état réseau du device (partagé avec /api/bootstrap)
+ */
+static void write_device_status(json_writer_t *w)
 {
-    cJSON *root = cJSON_CreateObject();
-
     char mac[18];
     if (wifi_manager_get_mac(mac) == ESP_OK) {
-        cJSON_AddStringToObject(root, "mac", mac);
+        json_writer_kv_string(w, "mac", mac);
     }
 
     wifi_manager_state_t state = wifi_manager_get_state();
@@ -339,53 +53,239 @@ static esp_err_t status_handler(httpd_req_t *req)
         case WIFI_STATE_STA_DISCONNECTED: state_str = "Disconnected"; break;
         default: state_str = "Unknown"; break;
     }
-    cJSON_AddStringToObject(root, "state", state_str);
+    json_writer_kv_string(w, "state", state_str);
 
     char ip[16];
     if (wifi_manager_get_ip(ip) == ESP_OK) {
-        cJSON_AddStringToObject(root, "ip", ip);
+        json_writer_kv_string(w, "ip", ip);
     }
+}
 
-    const char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
+/**
+ * Écrit la version et la partition du firmware (partagé avec /api/bootstrap)
+ */
+static void write_firmware_info(json_writer_t *w)
+{
+    json_writer_kv_string(w, "version", ota_manager_get_version());
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    json_writer_kv_string(w, "partition", running->label);
+}
+
+/**
+ * Écrit le résultat d'une vérification GitHub (partagé avec /api/bootstrap)
+ */
+static void write_update_info(json_writer_t *w, const ota_update_info_t *info)
+{
+    json_writer_kv_bool(w, "update_available", info->update_available);
+    json_writer_kv_string(w, "current_version", ota_manager_get_version());
+
+    if (info->update_available) {
+        json_writer_kv_string(w, "new_version", info->version);
+        json_writer_kv_string(w, "download_url", info->download_url);
+    }
+}
 
-    free((void *)json_str);
-    cJSON_Delete(root);
+/*
+ * Cache des réponses JSON
+ * Version et partition ne changent pas pendant un boot: elles sont rendues une
+ * seule fois au démarrage du serveur. L'état réseau (MAC, état, IP) est rendu à
+ * la première requête qui suit un changement d'état WiFi. Les réponses sont
+ * servies avec un ETag fort (empreinte du contenu) et revalidées par
+ * If-None-Match. Rendu et envoi se font sur la tâche httpd: la boucle
+ * d'événements ne fait qu'incrémenter le compteur de génération.
+ */
+#define RESPONSE_CACHE_BODY_SIZE 128   // MAC + état + IP, ou version + partition
+
+typedef struct {
+    char body[RESPONSE_CACHE_BODY_SIZE];
+    size_t len;
+    char etag[12];                  // 8 chiffres hexa entre guillemets
+    uint32_t generation;            // Génération de l'état WiFi au moment du rendu
+    bool valid;
+} cached_response_t;
+
+static cached_response_t s_firmware_cache;
+static cached_response_t s_status_cache;
+static volatile uint32_t s_wifi_generation = 0;
+static esp_event_handler_instance_t s_got_ip_handler = NULL;
+
+static esp_err_t cached_response_append(void *ctx, const char *data, size_t len)
+{
+    cached_response_t *cache = (cached_response_t *)ctx;
+    if (cache->len + len > sizeof(cache->body)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(cache->body + cache->len, data, len);
+    cache->len += len;
     return ESP_OK;
 }
 
-/* Handler pour GET /api/scan */
-static esp_err_t scan_handler(httpd_req_t *req)
+static void cached_response_render(cached_response_t *cache, void (*write)(json_writer_t *w))
 {
-    wifi_ap_record_t ap_records[20];
-    uint16_t ap_count = 0;
+    json_writer_t w;
+    cache->len = 0;
+    json_writer_init(&w, cached_response_append, cache);
+    json_writer_begin_object(&w);
+    write(&w);
+    json_writer_end_object(&w);
+    cache->valid = json_writer_finish(&w) == ESP_OK;
+    if (!cache->valid) {
+        ESP_LOGE(TAG, "Cached response does not fit in %d bytes", RESPONSE_CACHE_BODY_SIZE);
+        return;
+    }
 
-    esp_err_t ret = wifi_manager_scan(ap_records, 20, &ap_count);
+    // ETag fort: empreinte FNV-1a du contenu
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < cache->len; i++) {
+        hash ^= (uint8_t)cache->body[i];
+        hash *= 16777619u;
+    }
+    snprintf(cache->etag, sizeof(cache->etag), "\"%08" PRIx32 "\"", hash);
+}
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON *networks = cJSON_CreateArray();
+static const cached_response_t *firmware_cache_get(void)
+{
+    if (!s_firmware_cache.valid) {
+        cached_response_render(&s_firmware_cache, write_firmware_info);
+    }
+    return &s_firmware_cache;
+}
 
-    if (ret == ESP_OK) {
-        for (int i = 0; i < ap_count; i++) {
-            cJSON *network = cJSON_CreateObject();
-            cJSON_AddStringToObject(network, "ssid", (char *)ap_records[i].ssid);
-            cJSON_AddNumberToObject(network, "rssi", ap_records[i].rssi);
-            cJSON_AddBoolToObject(network, "auth", ap_records[i].authmode != WIFI_AUTH_OPEN);
-            cJSON_AddItemToArray(networks, network);
-        }
+static const cached_response_t *status_cache_get(void)
+{
+    uint32_t generation = s_wifi_generation;
+    if (!s_status_cache.valid || s_status_cache.generation != generation) {
+        cached_response_render(&s_status_cache, write_device_status);
+        s_status_cache.generation = generation;
     }
+    return &s_status_cache;
+}
+
+/* Appelé depuis la boucle d'événements à chaque changement d'état WiFi */
+static void on_wifi_state_changed(wifi_manager_state_t state)
+{
+    s_wifi_generation++;
+}
 
-    cJSON_AddItemToObject(root, "networks", networks);
-    cJSON_AddNumberToObject(root, "count", ap_count);
+/**
+ * Nouvelle adresse en restant STA_CONNECTED (bail DHCP renouvelé avec une
+ * autre IP): l'état ne change pas, wifi_manager ne prévient pas ses abonnés
+ */
+static void on_sta_got_ip(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+    if (event->ip_changed) {
+        s_wifi_generation++;
+    }
+}
+
+static esp_err_t cached_response_send(httpd_req_t *req, const cached_response_t *cache)
+{
+    if (!cache->valid) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_hdr(req, "ETag", cache->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    if (request_etag_matches(req, cache->etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
-    const char *json_str = cJSON_Print(root);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
+    return httpd_resp_send(req, cache->body, cache->len);
+}
 
-    free((void *)json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+/* Écrit un fragment en cache comme valeur de la clé donnée */
+static void write_cached_fragment(json_writer_t *w, const char *key, const cached_response_t *cache)
+{
+    json_writer_key(w, key);
+    if (cache->valid) {
+        json_writer_fragment(w, cache->body, cache->len);
+    } else {
+        json_writer_null(w);
+    }
+}
+
+/* Handler pour GET /api/status */
+static esp_err_t status_handler(httpd_req_t *req)
+{
+    return cached_response_send(req, status_cache_get());
+}
+
+/**
+ * Handler pour GET /api/bootstrap
+ * Tout ce dont l'interface a besoin au chargement, en une seule requête.
+ * La vérification GitHub n'est pas relancée: seul le dernier résultat est servi.
+ */
+static esp_err_t bootstrap_handler(httpd_req_t *req)
+{
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+
+    write_cached_fragment(&w, "status", status_cache_get());
+    write_cached_fragment(&w, "firmware", firmware_cache_get());
+
+    ota_progress_t progress;
+    ota_manager_get_progress(&progress);
+    json_writer_key(&w, "ota");
+    web_events_write_ota_progress(&w, &progress);
+
+    ota_update_info_t info;
+    int64_t age_ms;
+    if (ota_manager_get_last_check(&info, &age_ms)) {
+        json_writer_key(&w, "update");
+        json_writer_begin_object(&w);
+        json_writer_kv_bool(&w, "success", true);
+        json_writer_kv_int(&w, "age_ms", age_ms);
+        write_update_info(&w, &info);
+        json_writer_end_object(&w);
+    }
+
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+/* Handler pour GET /api/scan - résultats en cache, scan relancé en arrière-plan */
+static esp_err_t scan_handler(httpd_req_t *req)
+{
+    // ?refresh=1 force un nouveau scan même si le cache est encore valide
+    char query[32];
+    char refresh[4] = "";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "refresh", refresh, sizeof(refresh));
+    }
+    wifi_scan_request(strcmp(refresh, "1") == 0);
+
+    wifi_scan_result_t results[WIFI_SCAN_MAX_RESULTS];
+    int64_t age_ms;
+    bool scanning;
+    size_t count = wifi_scan_get_results(results, WIFI_SCAN_MAX_RESULTS, &age_ms, &scanning);
+
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+
+    json_writer_key(&w, "networks");
+    json_writer_begin_array(&w);
+    for (size_t i = 0; i < count; i++) {
+        json_writer_begin_object(&w);
+        json_writer_kv_string(&w, "ssid", results[i].ssid);
+        json_writer_kv_int(&w, "rssi", results[i].rssi);
+        json_writer_kv_bool(&w, "auth", results[i].authmode != WIFI_AUTH_OPEN);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_kv_int(&w, "count", count);
+    json_writer_kv_bool(&w, "scanning", scanning);
+    json_writer_kv_int(&w, "age_ms", age_ms);
+
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
 }
 
 /**
@@ -485,94 +385,80 @@ static bool is_valid_ap_timeout(uint32_t timeout)
 /* Handler pour POST /api/configure */
 static esp_err_t configure_handler(httpd_req_t *req)
 {
-    char content[512];
-    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
-    if (ret <= 0) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
+    // Attente avant reboot: traité par un worker pour libérer le serveur
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, configure_handler);
     }
-    content[ret] = '\0';
 
-    cJSON *root = cJSON_Parse(content);
-    if (!root) {
+    // +1 pour le '\0': is_valid_ssid() accepte jusqu'à 32 caractères
+    char ssid[MAX_SSID_LEN + 1];
+    char password[MAX_PASSWORD_LEN + 1] = "";
+    uint32_t timeout = DEFAULT_AP_TIMEOUT;
+    enum { FIELD_SSID, FIELD_PASSWORD, FIELD_AP_TIMEOUT };
+    const json_field_t fields[] = {
+        [FIELD_SSID]       = { "ssid", JSON_FIELD_STRING, ssid, sizeof(ssid) },
+        [FIELD_PASSWORD]   = { "password", JSON_FIELD_STRING, password, sizeof(password) },
+        [FIELD_AP_TIMEOUT] = { "ap_timeout", JSON_FIELD_UINT32, &timeout, 0 },
+    };
+
+    json_reader_t reader;
+    if (json_reader_parse_http(&reader, req, fields, 3) != ESP_OK) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
 
-    cJSON *ssid_json = cJSON_GetObjectItem(root, "ssid");
-    cJSON *password_json = cJSON_GetObjectItem(root, "password");
-    cJSON *timeout_json = cJSON_GetObjectItem(root, "ap_timeout");
-
     bool success = false;
     const char *error_msg = NULL;
 
     // Validation du SSID (obligatoire)
-    if (!ssid_json || !cJSON_IsString(ssid_json)) {
+    if (json_reader_invalid(&reader, FIELD_SSID)) {
+        error_msg = "Invalid SSID format";
+        ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
+    } else if (!json_reader_found(&reader, FIELD_SSID)) {
         error_msg = "Missing or invalid SSID";
         ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
-    } else if (!is_valid_ssid(ssid_json->valuestring)) {
+    } else if (!is_valid_ssid(ssid)) {
         error_msg = "Invalid SSID format";
         ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
+    } else if (json_reader_invalid(&reader, FIELD_PASSWORD) || !is_valid_password(password)) {
+        // Un mot de passe trop long ou non textuel n'est jamais remplacé par ""
+        error_msg = "Invalid password format";
+        ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
+    } else if (json_reader_invalid(&reader, FIELD_AP_TIMEOUT) || !is_valid_ap_timeout(timeout)) {
+        error_msg = "Invalid timeout (must be 10-300 seconds)";
+        ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
     } else {
-        // SSID valide, vérifier le mot de passe
-        const char *password = "";
-        if (password_json && cJSON_IsString(password_json)) {
-            password = password_json->valuestring;
+        // Si tout est valide, sauvegarder
+        miniot_wifi_config_t config = {0};
+        strncpy(config.ssid, ssid, MAX_SSID_LEN - 1);
+        config.ssid[MAX_SSID_LEN - 1] = '\0';  // Assurer la terminaison
+
+        if (strlen(password) > 0) {
+            strncpy(config.password, password, MAX_PASSWORD_LEN - 1);
+            config.password[MAX_PASSWORD_LEN - 1] = '\0';  // Assurer la terminaison
         }
 
-        if (!is_valid_password(password)) {
-            error_msg = "Invalid password format";
-            ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
+        config.ap_timeout = timeout;
+        config.is_configured = true;
+
+        if (nvs_storage_save_wifi_config(&config) == ESP_OK) {
+            success = true;
+            ESP_LOGI(TAG, "WiFi configuration saved, scheduling reboot...");
         } else {
-            // Vérifier le timeout
-            uint32_t timeout = DEFAULT_AP_TIMEOUT;
-            if (timeout_json && cJSON_IsNumber(timeout_json)) {
-                timeout = (uint32_t)timeout_json->valueint;
-                if (!is_valid_ap_timeout(timeout)) {
-                    error_msg = "Invalid timeout (must be 10-300 seconds)";
-                    ESP_LOGW(TAG, "Configuration failed: %s", error_msg);
-                }
-            }
-
-            // Si tout est valide, sauvegarder
-            if (!error_msg) {
-                miniot_wifi_config_t config = {0};
-                strncpy(config.ssid, ssid_json->valuestring, MAX_SSID_LEN - 1);
-                config.ssid[MAX_SSID_LEN - 1] = '\0';  // Assurer la terminaison
-
-                if (strlen(password) > 0) {
-                    strncpy(config.password, password, MAX_PASSWORD_LEN - 1);
-                    config.password[MAX_PASSWORD_LEN - 1] = '\0';  // Assurer la terminaison
-                }
-
-                config.ap_timeout = timeout;
-                config.is_configured = true;
-
-                if (nvs_storage_save_wifi_config(&config) == ESP_OK) {
-                    success = true;
-                    ESP_LOGI(TAG, "WiFi configuration saved, scheduling reboot...");
-                } else {
-                    error_msg = "Failed to save configuration";
-                    ESP_LOGE(TAG, "Configuration failed: %s", error_msg);
-                }
-            }
+            error_msg = "Failed to save configuration";
+            ESP_LOGE(TAG, "Configuration failed: %s", error_msg);
         }
     }
 
-    cJSON_Delete(root);
-
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddBoolToObject(response, "success", success);
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", success);
     if (error_msg) {
-        cJSON_AddStringToObject(response, "error", error_msg);
+        json_writer_kv_string(&w, "error", error_msg);
     }
-
-    const char *json_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-
-    free((void *)json_str);
-    cJSON_Delete(response);
+    json_writer_end_object(&w);
+    json_writer_finish(&w);
 
     if (success) {
         // Reboot après 2 secondes
@@ -586,19 +472,21 @@ static esp_err_t configure_handler(httpd_req_t *req)
 /* Handler pour POST /api/factory_reset */
 static esp_err_t factory_reset_handler(httpd_req_t *req)
 {
+    // Attente avant reboot: traité par un worker pour libérer le serveur
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, factory_reset_handler);
+    }
+
     ESP_LOGW(TAG, "Factory reset requested");
 
     esp_err_t ret = nvs_storage_factory_reset();
 
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddBoolToObject(response, "success", ret == ESP_OK);
-
-    const char *json_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-
-    free((void *)json_str);
-    cJSON_Delete(response);
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", ret == ESP_OK);
+    json_writer_end_object(&w);
+    json_writer_finish(&w);
 
     if (ret == ESP_OK) {
         // Reboot après 2 secondes
@@ -612,17 +500,19 @@ static esp_err_t factory_reset_handler(httpd_req_t *req)
 /* Handler pour POST /api/reboot */
 static esp_err_t reboot_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Reboot requested");
-
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddBoolToObject(response, "success", true);
+    // Attente avant reboot: traité par un worker pour libérer le serveur
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, reboot_handler);
+    }
 
-    const char *json_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
+    ESP_LOGI(TAG, "Reboot requested");
 
-    free((void *)json_str);
-    cJSON_Delete(response);
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", true);
+    json_writer_end_object(&w);
+    json_writer_finish(&w);
 
     // Reboot après 1 seconde
     vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -650,42 +540,27 @@ static void ota_task_function(void *param)
 /* Handler pour POST /api/ota_update */
 static esp_err_t ota_update_handler(httpd_req_t *req)
 {
-    char content[256];
-    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
-    if (ret <= 0) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
-    }
-    content[ret] = '\0';
-
-    cJSON *root = cJSON_Parse(content);
-    if (!root) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
-    }
-
-    cJSON *url_json = cJSON_GetObjectItem(root, "url");
+    // Même taille que ota_update_info_t.download_url
+    char url[256];
+    const json_field_t fields[] = {
+        { "url", JSON_FIELD_STRING, url, sizeof(url) },
+    };
 
-    if (url_json && cJSON_IsString(url_json)) {
-        ESP_LOGI(TAG, "OTA update requested from: %s", url_json->valuestring);
+    json_reader_t reader;
+    if (json_reader_parse_http(&reader, req, fields, 1) == ESP_OK && json_reader_found(&reader, 0)) {
+        ESP_LOGI(TAG, "OTA update requested from: %s", url);
 
-        // IMPORTANT: Copier l'URL AVANT de supprimer le JSON
-        char *url_copy = strdup(url_json->valuestring);
-
-        // Maintenant on peut supprimer le JSON reçu
-        cJSON_Delete(root);
+        // La tâche OTA survit au handler: elle reçoit sa propre copie
+        char *url_copy = strdup(url);
 
         // Répondre immédiatement avant de commencer l'OTA
-        cJSON *response = cJSON_CreateObject();
-        cJSON_AddBoolToObject(response, "success", true);
-        cJSON_AddStringToObject(response, "message", "OTA update started");
-
-        const char *json_str = cJSON_Print(response);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, json_str);
-
-        free((void *)json_str);
-        cJSON_Delete(response);
+        json_writer_t w;
+        json_writer_init_http(&w, req);
+        json_writer_begin_object(&w);
+        json_writer_kv_bool(&w, "success", true);
+        json_writer_kv_string(&w, "message", "OTA update started");
+        json_writer_end_object(&w);
+        json_writer_finish(&w);
 
         // Lancer l'OTA dans une tâche séparée
         xTaskCreate(ota_task_function, "ota_task", 8192, url_copy, 5, NULL);
@@ -693,57 +568,152 @@ static esp_err_t ota_update_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    cJSON_Delete(root);
     httpd_resp_send_500(req);
     return ESP_FAIL;
 }
 
-/* Handler pour GET /api/ota_version */
-static esp_err_t ota_version_handler(httpd_req_t *req)
+/* Réponse d'erreur de /api/ota_upload */
+static esp_err_t ota_upload_send_error(httpd_req_t *req, const char *status, const char *error)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "version", ota_manager_get_version());
+    httpd_resp_set_status(req, status);
+
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", false);
+    json_writer_kv_string(&w, "error", error);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
 
-    const esp_partition_t *running = esp_ota_get_running_partition();
-    cJSON_AddStringToObject(root, "partition", running->label);
+/**
+ * Réponse à un échec d'écriture ou de vérification de l'image reçue
+ * Le contenu envoyé est en cause (400) pour une image étrangère, un patch d'un
+ * autre firmware ou une taille invalide; toute autre erreur (flash, mémoire)
+ * est interne au device (500)
+ */
+static esp_err_t ota_upload_send_failure(httpd_req_t *req, esp_err_t err, const char *internal_error)
+{
+    switch (err) {
+    case ESP_ERR_OTA_VALIDATE_FAILED:
+        return ota_upload_send_error(req, "400 Bad Request", "Not a valid firmware image");
+    case ESP_ERR_INVALID_VERSION:
+        return ota_upload_send_error(req, "400 Bad Request", "Patch does not match installed firmware");
+    case ESP_ERR_INVALID_SIZE:
+        return ota_upload_send_error(req, "400 Bad Request", "Invalid firmware size");
+    default:
+        return ota_upload_send_error(req, "500 Internal Server Error", internal_error);
+    }
+}
 
-    const char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
+/* Handler pour POST /api/ota_upload (corps: image .bin brute) */
+static esp_err_t ota_upload_handler(httpd_req_t *req)
+{
+    // Réception de plusieurs secondes: traité par un worker pour libérer le serveur
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, ota_upload_handler);
+    }
+
+    esp_err_t ret = ota_manager_upload_begin(req->content_len);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        return ota_upload_send_error(req, "409 Conflict", "Update already in progress");
+    } else if (ret == ESP_ERR_INVALID_SIZE) {
+        return ota_upload_send_error(req, "400 Bad Request", "Invalid firmware size");
+    } else if (ret != ESP_OK) {
+        return ota_upload_send_error(req, "500 Internal Server Error", "Failed to start update");
+    }
+
+    char *chunk = malloc(OTA_UPLOAD_CHUNK_SIZE);
+    if (!chunk) {
+        ota_manager_upload_abort("Out of memory");
+        return ota_upload_send_error(req, "500 Internal Server Error", "Out of memory");
+    }
+
+    // Chaque bloc reçu est écrit en flash avant de lire le suivant
+    size_t remaining = req->content_len;
+    int timeouts = 0;
+    ret = ESP_OK;
+
+    while (remaining > 0) {
+        size_t want = remaining < OTA_UPLOAD_CHUNK_SIZE ? remaining : OTA_UPLOAD_CHUNK_SIZE;
+        int received = httpd_req_recv(req, chunk, want);
+        if (received == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts <= OTA_UPLOAD_MAX_TIMEOUTS) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        timeouts = 0;
+
+        ret = ota_manager_upload_write(chunk, received);
+        if (ret != ESP_OK) {
+            break;
+        }
+        remaining -= received;
+    }
+
+    free(chunk);
+
+    if (ret != ESP_OK) {
+        // Réception déjà abandonnée par ota_manager_upload_write()
+        return ota_upload_send_failure(req, ret, "Flash write failed");
+    }
+    if (remaining > 0) {
+        ESP_LOGE(TAG, "OTA upload interrupted (%u bytes missing)", (unsigned)remaining);
+        ota_manager_upload_abort("Upload interrupted");
+        return ota_upload_send_error(req, "400 Bad Request", "Upload interrupted");
+    }
+
+    ret = ota_manager_upload_end();
+    if (ret != ESP_OK) {
+        return ota_upload_send_failure(req, ret, "Image verification failed");
+    }
+
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", true);
+    json_writer_kv_string(&w, "message", "Update installed, rebooting");
+    json_writer_end_object(&w);
+    json_writer_finish(&w);
+
+    // Reboot après 3 secondes, comme la mise à jour par URL
+    vTaskDelay(3000 / portTICK_PERIOD_MS);
+    esp_restart();
 
-    free((void *)json_str);
-    cJSON_Delete(root);
     return ESP_OK;
 }
 
+/* Handler pour GET /api/ota_version */
+static esp_err_t ota_version_handler(httpd_req_t *req)
+{
+    return cached_response_send(req, firmware_cache_get());
+}
+
 /* Handler pour GET /api/check_github_update */
 static esp_err_t check_github_update_handler(httpd_req_t *req)
 {
+    // Aller-retour TLS vers GitHub: traité par un worker pour libérer le serveur
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, check_github_update_handler);
+    }
+
     ota_update_info_t info;
     esp_err_t ret = ota_manager_check_github_update("MatthieuGrr", "miniot", &info);
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddBoolToObject(root, "success", ret == ESP_OK);
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", ret == ESP_OK);
 
     if (ret == ESP_OK) {
-        cJSON_AddBoolToObject(root, "update_available", info.update_available);
-        cJSON_AddStringToObject(root, "current_version", ota_manager_get_version());
-
-        if (info.update_available) {
-            cJSON_AddStringToObject(root, "new_version", info.version);
-            cJSON_AddStringToObject(root, "download_url", info.download_url);
-        }
+        write_update_info(&w, &info);
     } else {
-        cJSON_AddStringToObject(root, "error", "Failed to check for updates");
+        json_writer_kv_string(&w, "error", "Failed to check for updates");
     }
 
-    const char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-
-    free((void *)json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
 }
 
 /* Fonction de tâche pour la mise à jour GitHub */
@@ -766,16 +736,13 @@ static esp_err_t install_github_update_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "GitHub update installation requested");
 
     // Répondre immédiatement
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddBoolToObject(response, "success", true);
-    cJSON_AddStringToObject(response, "message", "GitHub OTA update started");
-
-    const char *json_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-
-    free((void *)json_str);
-    cJSON_Delete(response);
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "success", true);
+    json_writer_kv_string(&w, "message", "GitHub OTA update started");
+    json_writer_end_object(&w);
+    json_writer_finish(&w);
 
     // Lancer l'OTA dans une tâche séparée
     xTaskCreate(github_ota_task_function, "github_ota_task", 8192, NULL, 5, NULL);
@@ -786,130 +753,21 @@ static esp_err_t install_github_update_handler(httpd_req_t *req)
 /* Handler pour GET /api/ota_progress - retourne la progression actuelle */
 static esp_err_t ota_progress_handler(httpd_req_t *req)
 {
-    const ota_progress_t *progress = ota_manager_get_progress();
-
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddBoolToObject(root, "in_progress", progress->in_progress);
-    cJSON_AddNumberToObject(root, "total_size", progress->total_size);
-    cJSON_AddNumberToObject(root, "downloaded", progress->downloaded);
-    cJSON_AddNumberToObject(root, "percent", progress->percent);
-    cJSON_AddStringToObject(root, "status", progress->status);
-
-    const char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-
-    free((void *)json_str);
-    cJSON_Delete(root);
+    ota_progress_t progress;
+    ota_manager_get_progress(&progress);
 
-    return ESP_OK;
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    web_events_write_ota_progress(&w, &progress);
+    return json_writer_finish(&w);
 }
 
 /* Définition des URIs */
-static const httpd_uri_t uri_index = {
-    .uri       = "/",
-    .method    = HTTP_GET,
-    .handler   = index_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_status = {
-    .uri       = "/api/status",
-    .method    = HTTP_GET,
-    .handler   = status_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_scan = {
-    .uri       = "/api/scan",
-    .method    = HTTP_GET,
-    .handler   = scan_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_configure = {
-    .uri       = "/api/configure",
-    .method    = HTTP_POST,
-    .handler   = configure_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_factory_reset = {
-    .uri       = "/api/factory_reset",
-    .method    = HTTP_POST,
-    .handler   = factory_reset_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_reboot = {
-    .uri       = "/api/reboot",
-    .method    = HTTP_POST,
-    .handler   = reboot_handler,
-    .user_ctx  = NULL
-};
-
-/* URIs pour la détection de portail captif (Android, iOS, etc.) */
-static const httpd_uri_t uri_generate_204 = {
-    .uri       = "/generate_204",
-    .method    = HTTP_GET,
-    .handler   = captive_portal_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_gen_204 = {
-    .uri       = "/gen_204",
-    .method    = HTTP_GET,
-    .handler   = captive_portal_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_hotspot_detect = {
-    .uri       = "/hotspot-detect.html",
-    .method    = HTTP_GET,
-    .handler   = captive_portal_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_success_txt = {
-    .uri       = "/success.txt",
-    .method    = HTTP_GET,
-    .handler   = captive_portal_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_ota_update = {
-    .uri       = "/api/ota_update",
-    .method    = HTTP_POST,
-    .handler   = ota_update_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_ota_version = {
-    .uri       = "/api/ota_version",
-    .method    = HTTP_GET,
-    .handler   = ota_version_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_check_github_update = {
-    .uri       = "/api/check_github_update",
-    .method    = HTTP_GET,
-    .handler   = check_github_update_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_install_github_update = {
-    .uri       = "/api/install_github_update",
-    .method    = HTTP_POST,
-    .handler   = install_github_update_handler,
-    .user_ctx  = NULL
-};
-
-static const httpd_uri_t uri_ota_progress = {
-    .uri       = "/api/ota_progress",
-    .method    = HTTP_GET,
-    .handler   = ota_progress_handler,
-    .user_ctx  = NULL
+/* Routes (web_routes.def), sélectionnées par web_router */
+static const web_route_t s_routes[] = {
+#define WEB_ROUTE(method, path, handler) { method, path, handler },
+#include "web_routes.def"
+#undef WEB_ROUTE
 };
 
 esp_err_t web_server_start(void)
@@ -923,7 +781,7 @@ esp_err_t web_server_start(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
     config.stack_size = 8192;  // Augmenter le stack pour éviter overflow
-    config.max_uri_handlers = 16;
+    config.max_uri_handlers = 4;  // Un handler générique par méthode (web_router)
     config.max_resp_headers = 16;
     config.recv_wait_timeout = 10;
     config.uri_match_fn = httpd_uri_match_wildcard;
@@ -931,24 +789,24 @@ esp_err_t web_server_start(void)
     ESP_LOGI(TAG, "Starting HTTP server on port %d", config.server_port);
 
     if (httpd_start(&s_server, &config) == ESP_OK) {
-        ESP_LOGI(TAG, "Registering URI handlers");
-        httpd_register_uri_handler(s_server, &uri_index);
-        httpd_register_uri_handler(s_server, &uri_status);
-        httpd_register_uri_handler(s_server, &uri_scan);
-        httpd_register_uri_handler(s_server, &uri_configure);
-        httpd_register_uri_handler(s_server, &uri_factory_reset);
-        httpd_register_uri_handler(s_server, &uri_reboot);
-        httpd_register_uri_handler(s_server, &uri_ota_update);
-        httpd_register_uri_handler(s_server, &uri_ota_version);
-        httpd_register_uri_handler(s_server, &uri_check_github_update);
-        httpd_register_uri_handler(s_server, &uri_install_github_update);
-        httpd_register_uri_handler(s_server, &uri_ota_progress);
-
-        // Enregistrer les URIs pour la détection de portail captif
-        httpd_register_uri_handler(s_server, &uri_generate_204);
-        httpd_register_uri_handler(s_server, &uri_gen_204);
-        httpd_register_uri_handler(s_server, &uri_hotspot_detect);
-        httpd_register_uri_handler(s_server, &uri_success_txt);
+        // Sondes de portail captif reconnues à leur Host, sur toute URI sans route
+        web_captive_init();
+        if (web_router_start(s_server, s_routes, sizeof(s_routes) / sizeof(s_routes[0]),
+                             web_captive_handler) != ESP_OK) {
+            httpd_stop(s_server);
+            s_server = NULL;
+            return ESP_FAIL;
+        }
+        web_events_start();
+
+        // Fragments immuables rendus une fois, état réseau invalidé par le WiFi
+        firmware_cache_get();
+        wifi_manager_add_event_listener(on_wifi_state_changed);
+        if (!s_got_ip_handler) {
+            esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, on_sta_got_ip,
+                                                NULL, &s_got_ip_handler);
+        }
+        web_async_start();
 
         ESP_LOGI(TAG, "HTTP server started successfully with captive portal support");
         return ESP_OK;
@@ -962,6 +820,11 @@ esp_err_t web_server_stop(void)
 {
     if (s_server) {
         ESP_LOGI(TAG, "Stopping HTTP server");
+        web_events_stop();
+        if (s_got_ip_handler) {
+            esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, s_got_ip_handler);
+            s_got_ip_handler = NULL;
+        }
         httpd_stop(s_server);
         s_server = NULL;
         return ESP_OK;
@@ -0,0 +1,188 @@
+#include "web_ui.h"
+#include "web_assets.h"
+#include "esp_log.h"
+#include "rom/miniz.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+static const char *TAG = "WEB_UI";
+
+#define WEB_UI_WINDOW_SIZE (1u << WEB_UI_WINDOW_BITS)
+
+// En-tête gzip écrit par build_web_ui.py (sans champ optionnel) et trailer CRC32 + taille
+#define GZIP_HEADER_SIZE 10
+#define GZIP_TRAILER_SIZE 8
+
+/**
+ * Vérifie si l'en-tête If-None-Match du client contient l'ETag donné
+ * Accepte une liste d'ETags, la forme faible (W/) et "*"
+ */
+static bool request_etag_matches(httpd_req_t *req, const char *etag)
+{
+    char header[96];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", header, sizeof(header)) != ESP_OK) {
+        return false;
+    }
+    return strstr(header, etag) != NULL || strcmp(header, "*") == 0;
+}
+
+bool web_ui_accepts_encoding(httpd_req_t *req, const char *encoding)
+{
+    char header[128];
+    if (httpd_req_get_hdr_value_len(req, "Accept-Encoding") == 0) {
+        return true;
+    }
+    httpd_req_get_hdr_value_str(req, "Accept-Encoding", header, sizeof(header));
+
+    size_t encoding_len = strlen(encoding);
+    bool accepted = false;
+    char *save = NULL;
+    for (char *token = strtok_r(header, ",", &save); token; token = strtok_r(NULL, ",", &save)) {
+        while (*token == ' ' || *token == '\t') {
+            token++;
+        }
+        size_t name_len = strcspn(token, " \t;");
+        bool exact = name_len == encoding_len && strncasecmp(token, encoding, name_len) == 0;
+        bool any = name_len == 1 && token[0] == '*';
+        if (!exact && !any) {
+            continue;
+        }
+
+        // q=0, q=0.0... : codage explicitement refusé
+        const char *q = strstr(token + name_len, "q=");
+        bool refused = q && strtod(q + 2, NULL) == 0.0;
+        if (exact) {
+            return !refused;
+        }
+        accepted = !refused;
+    }
+
+    return accepted;
+}
+
+/**
+ * Recherche un fichier de l'interface web par URI (query string ignorée)
+ */
+static const web_asset_t *find_web_asset(const char *uri)
+{
+    size_t len = strcspn(uri, "?");
+    for (size_t i = 0; i < web_assets_count; i++) {
+        if (strncmp(web_assets[i].uri, uri, len) == 0 && web_assets[i].uri[len] == '\0') {
+            return &web_assets[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Envoie la forme identity d'un asset gzip, par chunks d'au plus une fenêtre
+ *
+ * La fenêtre est circulaire: tinfl s'arrête en fin de tampon
+ * (HAS_MORE_OUTPUT) et reprend au début une fois le chunk envoyé.
+ * Tout le flux compressé est en flash, d'où l'absence de HAS_MORE_INPUT.
+ */
+static esp_err_t send_inflated(httpd_req_t *req, const web_asset_t *asset)
+{
+    const uint8_t *in = asset->data;
+    if (asset->len < GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE || in[0] != 0x1f || in[1] != 0x8b ||
+        in[2] != 8 || in[3] != 0) {
+        ESP_LOGE(TAG, "Unexpected gzip header for %s", asset->uri);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    tinfl_decompressor *decomp = malloc(sizeof(tinfl_decompressor));
+    uint8_t *window = malloc(WEB_UI_WINDOW_SIZE);
+    if (decomp == NULL || window == NULL) {
+        ESP_LOGE(TAG, "Not enough memory to decompress %s", asset->uri);
+        free(decomp);
+        free(window);
+        return ESP_ERR_NO_MEM;
+    }
+    tinfl_init(decomp);
+
+    in += GZIP_HEADER_SIZE;
+    size_t in_left = asset->len - GZIP_HEADER_SIZE - GZIP_TRAILER_SIZE;
+    size_t window_pos = 0;
+    esp_err_t err = ESP_OK;
+    tinfl_status status;
+    do {
+        size_t in_bytes = in_left;
+        size_t out_bytes = WEB_UI_WINDOW_SIZE - window_pos;
+        status = tinfl_decompress(decomp, in, &in_bytes, window, window + window_pos, &out_bytes, 0);
+        in += in_bytes;
+        in_left -= in_bytes;
+
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Corrupted gzip stream for %s (status %d)", asset->uri, (int)status);
+            err = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        if (out_bytes > 0) {
+            err = httpd_resp_send_chunk(req, (const char *)window + window_pos, out_bytes);
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        window_pos = (window_pos + out_bytes) & (WEB_UI_WINDOW_SIZE - 1);
+    } while (status == TINFL_STATUS_HAS_MORE_OUTPUT);
+
+    free(decomp);
+    free(window);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t web_ui_handler(httpd_req_t *req)
+{
+    const web_asset_t *asset = find_web_asset(req->uri);
+    if (!asset) {
+        // Ancien hash après une mise à jour: le client rechargera la page
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+
+    // Seule la version compressée est embarquée: la forme identity est
+    // décompressée à la volée et porte un ETag faible (mêmes données, autre codage)
+    bool identity = asset->encoding && !web_ui_accepts_encoding(req, asset->encoding);
+    char weak_etag[40];
+    const char *etag = asset->etag;
+    if (identity) {
+        snprintf(weak_etag, sizeof(weak_etag), "W/%s", asset->etag);
+        etag = weak_etag;
+    }
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+    if (asset->encoding) {
+        // Un cache partagé doit distinguer les deux formes, 304 compris
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+
+    if (request_etag_matches(req, asset->etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, asset->content_type);
+    if (identity) {
+        ESP_LOGD(TAG, "Client does not accept %s for %s: decompressing", asset->encoding, req->uri);
+        esp_err_t err = send_inflated(req, asset);
+        if (err == ESP_ERR_NO_MEM || err == ESP_ERR_INVALID_ARG) {
+            // Rien n'a encore été envoyé
+            httpd_resp_send_500(req);
+            return ESP_OK;
+        }
+        return err;
+    }
+
+    if (asset->encoding) {
+        httpd_resp_set_hdr(req, "Content-Encoding", asset->encoding);
+    }
+    httpd_resp_send(req, (const char *)asset->data, asset->len);
+    return ESP_OK;
+}
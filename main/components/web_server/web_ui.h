@@ -0,0 +1,29 @@
+#ifndef WEB_UI_H
+#define WEB_UI_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define WEB_UI_WINDOW_BITS 14           // Fenêtre de décompression: 16 KB (build_web_ui.py)
+
+/**
+ * @brief Handler de la page principale (/) et des assets hashés (/assets/...)
+ *
+ * Les fichiers sont embarqués compressés (gzip, voir web_assets.h) et envoyés
+ * tels quels aux clients qui acceptent ce codage. Les autres reçoivent la
+ * forme identity, décompressée à la volée par le tinfl de la ROM et envoyée
+ * par chunks. Vary: Accept-Encoding accompagne toutes les réponses, 304 compris.
+ */
+esp_err_t web_ui_handler(httpd_req_t *req);
+
+/**
+ * @brief Vérifie si le client accepte le codage donné (Accept-Encoding)
+ *
+ * Sans en-tête, tout codage est acceptable (RFC 9110 §12.5.3); "*" convient
+ * aussi, sauf si le codage ou "*" est exclu par q=0. Un en-tête trop long est
+ * tronqué: seuls les premiers codages sont examinés.
+ */
+bool web_ui_accepts_encoding(httpd_req_t *req, const char *encoding);
+
+#endif // WEB_UI_H
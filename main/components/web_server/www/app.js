@@ -0,0 +1,269 @@
+// Délais du suivi OTA (secondes / millisecondes)
+const OTA_START_TIMEOUT_SEC=2;
+const OTA_COMPLETION_TIMEOUT_SEC=5;
+const OTA_PROGRESS_POLL_INTERVAL_MS=500;
+// Durée max d'attente d'un scan WiFi (millisecondes)
+const SCAN_WAIT_TIMEOUT_MS=10000;
+function showStatus(msg,isError){
+const div=document.getElementById('statusMsg');
+div.className=isError?'status error':'status success';
+div.textContent=msg;
+setTimeout(()=>div.textContent='',5000);
+}
+function renderDeviceInfo(data){
+document.getElementById('ipAddr').textContent=data.ip||'N/A';
+document.getElementById('macAddr').textContent=data.mac||'N/A';
+document.getElementById('wifiState').textContent=data.state||'N/A';
+}
+function renderNetworks(data){
+const div=document.getElementById('networks');
+if(data.networks&&data.networks.length>0){
+div.innerHTML=data.networks.map(n=>
+`<div class='network-item' onclick='selectNetwork("${n.ssid}",${n.rssi})'>
+${n.ssid} (${n.rssi} dBm) ${n.auth?'🔒':''}</div>`
+).join('');
+}else{div.innerHTML='<p>No networks found</p>';}
+}
+async function fetchNetworks(refresh){
+const res=await fetch('/api/scan'+(refresh?'?refresh=1':''));
+return res.json();
+}
+// Attend la fin du scan en arrière-plan: événement "scan" poussé par le device,
+// ou polling si EventSource n'est pas disponible
+function waitScanDone(){
+return new Promise(resolve=>{
+let source=null;
+let timer=null;
+const done=()=>{
+clearTimeout(timer);
+timer=null;
+if(source){source.close();source=null;}
+resolve();
+};
+const check=async()=>{
+try{if(!(await fetchNetworks(false)).scanning){done();}}catch(e){}
+};
+timer=setTimeout(done,SCAN_WAIT_TIMEOUT_MS);
+if(window.EventSource){
+source=new EventSource('/api/events');
+source.addEventListener('scan',done);
+// Le scan a pu se terminer avant l'ouverture du flux
+source.onopen=check;
+source.onerror=()=>{if(source){source.close();source=null;}};
+}else{
+const poll=async()=>{await check();if(timer)setTimeout(poll,1000);};
+poll();
+}
+});
+}
+async function scanNetworks(){
+const div=document.getElementById('networks');
+div.innerHTML='<div class="loading" style="display:block">Scanning...</div>';
+try{
+let data=await fetchNetworks(true);
+if(data.scanning){
+// Afficher les résultats précédents pendant le scan
+if(data.count>0){renderNetworks(data);}
+await waitScanDone();
+data=await fetchNetworks(false);
+}
+renderNetworks(data);
+}catch(e){
+div.innerHTML='<p class="error">Scan failed</p>';
+console.error('Scan failed',e);
+}
+}
+function selectNetwork(ssid,rssi){
+document.getElementById('ssid').value=ssid;
+document.getElementById('password').focus();
+}
+async function saveWifiConfig(){
+const ssid=document.getElementById('ssid').value;
+const password=document.getElementById('password').value;
+const apTimeout=document.getElementById('apTimeout').value;
+if(!ssid){showStatus('Please enter SSID',true);return;}
+try{
+const res=await fetch('/api/configure',{
+method:'POST',
+headers:{'Content-Type':'application/json'},
+body:JSON.stringify({ssid,password,ap_timeout:parseInt(apTimeout)})
+});
+const data=await res.json();
+if(data.success){
+showStatus('Configuration saved! Rebooting...',false);
+setTimeout(()=>location.reload(),3000);
+}else{showStatus('Failed to save configuration',true);}
+}catch(e){
+showStatus('Error saving configuration',true);
+console.error('Save failed',e);
+}
+}
+async function rebootDevice(){
+if(confirm('Reboot the device?')){
+try{
+await fetch('/api/reboot',{method:'POST'});
+showStatus('Rebooting...',false);
+}catch(e){console.error('Reboot failed',e);}
+}
+}
+async function factoryReset(){
+if(confirm('Factory reset will erase all settings. Continue?')){
+try{
+await fetch('/api/factory_reset',{method:'POST'});
+showStatus('Factory reset completed. Rebooting...',false);
+setTimeout(()=>location.reload(),3000);
+}catch(e){console.error('Factory reset failed',e);}
+}
+}
+function renderFirmwareInfo(data){
+document.getElementById('firmwareVersion').textContent=data.version||'N/A';
+document.getElementById('runningPartition').textContent=data.partition||'N/A';
+}
+async function startOtaUpdate(){
+const url=document.getElementById('firmwareUrl').value;
+if(!url){showStatus('Please enter firmware URL',true);return;}
+if(confirm('Start OTA update? Device will reboot after update.')){
+try{
+const res=await fetch('/api/ota_update',{
+method:'POST',
+headers:{'Content-Type':'application/json'},
+body:JSON.stringify({url})
+});
+const data=await res.json();
+if(data.success){
+showStatus('OTA update in progress... Device will reboot automatically.',false);
+startProgressMonitoring();
+}else{showStatus('Failed to start OTA update',true);}
+}catch(e){showStatus('Error starting OTA update',true);console.error('OTA failed',e);}
+}
+}
+async function uploadFirmware(){
+const file=document.getElementById('firmwareFile').files[0];
+if(!file){showStatus('Please select a firmware file',true);return;}
+if(confirm('Upload '+file.name+'? Device will reboot after update.')){
+// Le corps est l'image brute: le device l'écrit en flash au fil de la réception
+startProgressMonitoring();
+try{
+const res=await fetch('/api/ota_upload',{
+method:'POST',
+headers:{'Content-Type':'application/octet-stream'},
+body:file
+});
+const data=await res.json();
+if(data.success){showStatus('Firmware installed. Device is rebooting...',false);}
+else{showStatus('Upload failed: '+data.error,true);}
+}catch(e){showStatus('Error uploading firmware',true);console.error('Upload failed',e);}
+}
+}
+function renderGithubUpdate(data){
+const div=document.getElementById('githubUpdateInfo');
+if(data.success){
+if(data.update_available){
+div.innerHTML='<div class="status success">✅ New version available: <strong>'+data.new_version+'</strong><br>'
++'Current: '+data.current_version+'<br>'
++'<button onclick="installGithubUpdate()">⬆️ Install Update</button></div>';
+}else{
+div.innerHTML='<div class="info">✓ You are running the latest version ('+data.current_version+')</div>';
+}
+}else{
+div.innerHTML='<div class="status error">❌ '+data.error+'</div>';
+}
+}
+async function checkGithubUpdate(){
+const div=document.getElementById('githubUpdateInfo');
+div.innerHTML='<div class="loading" style="display:block">Checking GitHub...</div>';
+try{
+const res=await fetch('/api/check_github_update');
+renderGithubUpdate(await res.json());
+}catch(e){
+div.innerHTML='<div class="status error">❌ Failed to check for updates</div>';
+console.error('Update check failed',e);
+}
+}
+let progressInterval=null;
+let progressSource=null;
+let otaStartTime=0;
+function stopProgressMonitoring(){
+if(progressInterval){clearInterval(progressInterval);progressInterval=null;}
+if(progressSource){progressSource.close();progressSource=null;}
+}
+// Affiche la progression, retourne true quand le suivi est terminé
+function showProgress(data){
+if(data.in_progress){
+document.getElementById('otaProgressBar').style.width=data.percent+'%';
+document.getElementById('otaPercent').textContent=data.percent+'%';
+document.getElementById('otaStatus').textContent=data.status;
+const downloadedKB=(data.downloaded/1024).toFixed(1);
+const totalKB=(data.total_size/1024).toFixed(1);
+const speed=data.throughput?' - '+(data.throughput/1024).toFixed(0)+' KB/s':'';
+document.getElementById('otaDetails').textContent=downloadedKB+' / '+totalKB+' KB'+speed;
+return false;
+}
+const elapsed=(Date.now()-otaStartTime)/1000;
+if(elapsed<OTA_START_TIMEOUT_SEC){return false;}
+if(data.percent===100){
+document.getElementById('otaStatus').textContent='✅ '+data.status;
+}else if(elapsed>OTA_COMPLETION_TIMEOUT_SEC){
+document.getElementById('otaProgressContainer').style.display='none';
+}else{
+document.getElementById('otaStatus').textContent=data.status;
+}
+return true;
+}
+function pollProgress(){
+progressInterval=setInterval(async()=>{
+try{
+const res=await fetch('/api/ota_progress');
+if(showProgress(await res.json())){stopProgressMonitoring();}
+}catch(e){console.error('Progress fetch failed',e);}
+},OTA_PROGRESS_POLL_INTERVAL_MS);
+}
+function startProgressMonitoring(){
+document.getElementById('otaProgressContainer').style.display='block';
+document.getElementById('otaProgressBar').style.width='0%';
+document.getElementById('otaPercent').textContent='0%';
+document.getElementById('otaStatus').textContent='Starting...';
+document.getElementById('otaDetails').textContent='Initializing...';
+otaStartTime=Date.now();
+stopProgressMonitoring();
+if(!window.EventSource){pollProgress();return;}
+// Le device pousse la progression à chaque changement (Server-Sent Events)
+progressSource=new EventSource('/api/events');
+progressSource.addEventListener('ota',e=>{
+if(showProgress(JSON.parse(e.data))){stopProgressMonitoring();}
+});
+progressSource.onerror=()=>{
+// Flux refusé ou coupé: repli sur le polling
+if(progressSource){progressSource.close();progressSource=null;pollProgress();}
+};
+}
+async function installGithubUpdate(){
+if(confirm('Install update from GitHub? Device will reboot after update.')){
+try{
+const res=await fetch('/api/install_github_update',{method:'POST'});
+const data=await res.json();
+if(data.success){
+document.getElementById('githubUpdateInfo').innerHTML='<div class="status success">⏳ Installing update...</div>';
+startProgressMonitoring();
+}else{showStatus('Failed to start GitHub update',true);}
+}catch(e){showStatus('Error starting GitHub update',true);console.error('GitHub OTA failed',e);}
+}
+}
+// Chargement de la page: une seule requête pour l'état complet du device
+async function bootstrap(){
+try{
+const res=await fetch('/api/bootstrap');
+const data=await res.json();
+renderDeviceInfo(data.status);
+renderFirmwareInfo(data.firmware);
+if(data.ota.in_progress){
+document.getElementById('githubUpdateInfo').innerHTML='<div class="status success">⏳ Update in progress...</div>';
+startProgressMonitoring();
+}else if(data.update){
+renderGithubUpdate(data.update);
+}else{
+setTimeout(checkGithubUpdate,1000);
+}
+}catch(e){console.error('Failed to load device state',e);}
+}
+bootstrap();
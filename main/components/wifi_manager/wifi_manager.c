@@ -3,6 +3,7 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -16,10 +17,14 @@ static const char *TAG = "WIFI_MANAGER";
 static EventGroupHandle_t s_wifi_event_group;
 static wifi_manager_state_t s_wifi_state = WIFI_STATE_IDLE;
 static wifi_event_cb_t s_event_callback = NULL;
+static wifi_event_cb_t s_listeners[WIFI_MANAGER_MAX_LISTENERS];
 static int s_retry_num = 0;
 static uint32_t s_sta_timeout_sec = 0;
 static esp_netif_t *s_sta_netif = NULL;
 static esp_netif_t *s_ap_netif = NULL;
+// Premier WIFI_EVENT_STA_DISCONNECTED depuis la dernière connexion (0: lien établi ou jamais perdu)
+// Écrit avant set_state(WIFI_STATE_STA_DISCONNECTED): stable quand les abonnés le lisent
+static int64_t s_link_lost_us = 0;
 
 static void set_state(wifi_manager_state_t new_state)
 {
@@ -30,6 +35,9 @@ static void set_state(wifi_manager_state_t new_state)
         if (s_event_callback) {
             s_event_callback(new_state);
         }
+        for (int i = 0; i < WIFI_MANAGER_MAX_LISTENERS && s_listeners[i]; i++) {
+            s_listeners[i](new_state);
+        }
     }
 }
 
@@ -66,6 +74,9 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 break;
 
             case WIFI_EVENT_STA_DISCONNECTED:
+                if (s_link_lost_us == 0) {
+                    s_link_lost_us = esp_timer_get_time();
+                }
                 if (s_retry_num < WIFI_STA_MAXIMUM_RETRY) {
                     esp_wifi_connect();
                     s_retry_num++;
@@ -86,6 +97,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
         s_retry_num = 0;
+        s_link_lost_us = 0;
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
         set_state(WIFI_STATE_STA_CONNECTED);
     }
@@ -177,6 +189,7 @@ esp_err_t wifi_manager_start_sta(const char *ssid, const char *password, uint32_
 
     s_sta_timeout_sec = timeout_sec;
     s_retry_num = 0;
+    s_link_lost_us = 0;
 
     // Arrêter le WiFi s'il est déjà actif
     esp_wifi_stop();
@@ -231,77 +244,14 @@ esp_err_t wifi_manager_stop(void)
     return ret;
 }
 
-esp_err_t wifi_manager_scan(wifi_ap_record_t *ap_records, uint16_t max_records, uint16_t *count)
+wifi_manager_state_t wifi_manager_get_state(void)
 {
-    if (!ap_records || !count) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    ESP_LOGI(TAG, "Starting WiFi scan...");
-
-    // S'assurer que le WiFi est démarré
-    wifi_mode_t mode;
-    esp_err_t ret = esp_wifi_get_mode(&mode);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get WiFi mode: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
-    // Le scan nécessite que l'interface STA soit active
-    if (mode != WIFI_MODE_STA && mode != WIFI_MODE_APSTA) {
-        ESP_LOGW(TAG, "WiFi not in STA/APSTA mode, current mode: %d", mode);
-        // En mode AP pur, on ne devrait pas arriver ici grâce à APSTA
-        return ESP_ERR_WIFI_MODE;
-    }
-
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = true,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time = {
-            .active = {
-                .min = 100,
-                .max = 300
-            }
-        }
-    };
-
-    ret = esp_wifi_scan_start(&scan_config, true);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "WiFi scan start failed: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
-    // Récupérer d'abord le nombre de réseaux trouvés
-    uint16_t ap_num = 0;
-    ret = esp_wifi_scan_get_ap_num(&ap_num);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get AP count: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
-    ESP_LOGI(TAG, "Scan found %d networks", ap_num);
-
-    // Limiter au nombre demandé
-    *count = (ap_num < max_records) ? ap_num : max_records;
-
-    if (*count > 0) {
-        ret = esp_wifi_scan_get_ap_records(count, ap_records);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to get scan records: %s", esp_err_to_name(ret));
-            return ret;
-        }
-    }
-
-    ESP_LOGI(TAG, "Scan completed, returning %d networks", *count);
-    return ESP_OK;
+    return s_wifi_state;
 }
 
-wifi_manager_state_t wifi_manager_get_state(void)
+int64_t wifi_manager_get_link_lost_time(void)
 {
-    return s_wifi_state;
+    return s_link_lost_us;
 }
 
 void wifi_manager_set_event_callback(wifi_event_cb_t callback)
@@ -309,6 +259,21 @@ void wifi_manager_set_event_callback(wifi_event_cb_t callback)
     s_event_callback = callback;
 }
 
+esp_err_t wifi_manager_add_event_listener(wifi_event_cb_t listener)
+{
+    for (int i = 0; i < WIFI_MANAGER_MAX_LISTENERS; i++) {
+        if (s_listeners[i] == listener) {
+            return ESP_OK;
+        }
+        if (!s_listeners[i]) {
+            s_listeners[i] = listener;
+            return ESP_OK;
+        }
+    }
+    ESP_LOGE(TAG, "Too many state listeners (max %d)", WIFI_MANAGER_MAX_LISTENERS);
+    return ESP_ERR_NO_MEM;
+}
+
 esp_err_t wifi_manager_get_ip(char *ip_str)
 {
     if (!ip_str) {
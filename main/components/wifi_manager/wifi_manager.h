@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include "esp_wifi_types.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #define WIFI_AP_SSID_PREFIX "MiniOT-Setup-"
 #define WIFI_AP_PASSWORD ""  // AP ouvert par défaut
@@ -11,6 +12,7 @@
 #define WIFI_AP_MAX_CONNECTIONS 4
 
 #define WIFI_STA_MAXIMUM_RETRY 5
+#define WIFI_MANAGER_MAX_LISTENERS 4
 
 typedef enum {
     WIFI_STATE_IDLE,
@@ -49,27 +51,38 @@ esp_err_t wifi_manager_start_sta(const char *ssid, const char *password, uint32_
  */
 esp_err_t wifi_manager_stop(void);
 
-/**
- * @brief Lance un scan des réseaux WiFi disponibles
- * @param ap_records Pointeur vers un tableau pour stocker les résultats
- * @param max_records Nombre maximum de réseaux à récupérer
- * @param count Pointeur vers le nombre de réseaux trouvés
- * @return ESP_OK si succès
- */
-esp_err_t wifi_manager_scan(wifi_ap_record_t *ap_records, uint16_t max_records, uint16_t *count);
-
 /**
  * @brief Récupère l'état actuel du WiFi
  * @return État actuel
  */
 wifi_manager_state_t wifi_manager_get_state(void);
 
+/**
+ * @brief Instant de la perte du lien STA (esp_timer_get_time)
+ *
+ * Relevé au premier WIFI_EVENT_STA_DISCONNECTED qui suit la dernière
+ * connexion, avant les tentatives de reconnexion: point de départ de la
+ * bascule STA -> AP.
+ * @return Instant en µs, 0 si le lien est établi ou n'a jamais été perdu
+ */
+int64_t wifi_manager_get_link_lost_time(void);
+
 /**
  * @brief Enregistre un callback pour les événements WiFi
  * @param callback Fonction à appeler lors des changements d'état
  */
 void wifi_manager_set_event_callback(wifi_event_cb_t callback);
 
+/**
+ * @brief Ajoute un abonné supplémentaire aux changements d'état
+ *
+ * Contrairement à wifi_manager_set_event_callback(), ne remplace pas les
+ * abonnés existants. Appelé depuis la boucle d'événements: ne doit pas bloquer.
+ * @param listener Fonction à appeler lors des changements d'état
+ * @return ESP_OK si succès (ou déjà abonné), ESP_ERR_NO_MEM si la table est pleine
+ */
+esp_err_t wifi_manager_add_event_listener(wifi_event_cb_t listener);
+
 /**
  * @brief Récupère l'adresse IP actuelle en mode STA
  * @param ip_str Buffer pour stocker l'IP (minimum 16 caractères)
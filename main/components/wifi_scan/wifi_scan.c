@@ -0,0 +1,209 @@
+#include "wifi_scan.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "WIFI_SCAN";
+
+// Un scan actif complet prend ~2-4 s: au-delà, SCAN_DONE a été perdu (WiFi arrêté)
+#define WIFI_SCAN_TIMEOUT_MS 10000
+
+static wifi_scan_result_t s_results[WIFI_SCAN_MAX_RESULTS];
+static size_t s_result_count = 0;
+static int64_t s_last_scan_us = 0;         // 0 = aucun scan terminé
+static int64_t s_scan_started_us = 0;      // 0 = pas de scan en cours
+static SemaphoreHandle_t s_lock = NULL;
+static wifi_scan_done_cb_t s_done_callback = NULL;
+
+/**
+ * Ajoute un réseau au cache trié (s_lock pris)
+ * Un SSID déjà présent (répéteurs, mesh) n'est gardé qu'une fois, avec le meilleur RSSI
+ */
+static void wifi_scan_insert_locked(const wifi_ap_record_t *record)
+{
+    const char *ssid = (const char *)record->ssid;
+    if (ssid[0] == '\0') {
+        // Réseau caché: inutilisable depuis l'interface
+        return;
+    }
+
+    size_t pos = s_result_count;
+    for (size_t i = 0; i < s_result_count; i++) {
+        if (strcmp(s_results[i].ssid, ssid) == 0) {
+            if (s_results[i].rssi >= record->rssi) {
+                return;
+            }
+            pos = i;
+            break;
+        }
+    }
+
+    if (pos == s_result_count) {
+        if (s_result_count < WIFI_SCAN_MAX_RESULTS) {
+            s_result_count++;
+        } else if (s_results[WIFI_SCAN_MAX_RESULTS - 1].rssi >= record->rssi) {
+            // Cache plein et réseau plus faible que tous les autres
+            return;
+        } else {
+            pos = WIFI_SCAN_MAX_RESULTS - 1;
+        }
+    }
+
+    // Remonter l'entrée jusqu'à sa place (tri par RSSI décroissant)
+    while (pos > 0 && s_results[pos - 1].rssi < record->rssi) {
+        s_results[pos] = s_results[pos - 1];
+        pos--;
+    }
+
+    strncpy(s_results[pos].ssid, ssid, sizeof(s_results[pos].ssid) - 1);
+    s_results[pos].ssid[sizeof(s_results[pos].ssid) - 1] = '\0';
+    s_results[pos].rssi = record->rssi;
+    s_results[pos].authmode = record->authmode;
+}
+
+static void wifi_scan_event_handler(void *arg, esp_event_base_t event_base,
+                                    int32_t event_id, void *event_data)
+{
+    wifi_event_sta_scan_done_t *event = (wifi_event_sta_scan_done_t *)event_data;
+    size_t count;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (event->status == 0) {
+        s_result_count = 0;
+
+        // Lecture enregistrement par enregistrement: pas de tableau de
+        // wifi_ap_record_t sur la pile de la boucle d'événements
+        wifi_ap_record_t record;
+        while (esp_wifi_scan_get_ap_record(&record) == ESP_OK) {
+            wifi_scan_insert_locked(&record);
+        }
+        s_last_scan_us = esp_timer_get_time();
+
+        ESP_LOGI(TAG, "Scan completed in %lld ms: %d APs, %d unique networks",
+                 (long long)((s_last_scan_us - s_scan_started_us) / 1000),
+                 event->number, (int)s_result_count);
+    } else {
+        ESP_LOGW(TAG, "Scan failed (status %d), keeping previous results", (int)event->status);
+    }
+    esp_wifi_clear_ap_list();
+    s_scan_started_us = 0;
+    count = s_result_count;
+    xSemaphoreGive(s_lock);
+
+    if (s_done_callback) {
+        s_done_callback(count);
+    }
+}
+
+esp_err_t wifi_scan_init(void)
+{
+    if (s_lock) {
+        return ESP_OK;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                               &wifi_scan_event_handler, NULL, NULL);
+}
+
+esp_err_t wifi_scan_request(bool force)
+{
+    if (!s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    if (s_scan_started_us != 0 && now - s_scan_started_us < WIFI_SCAN_TIMEOUT_MS * 1000LL) {
+        // Scan déjà en cours: la demande est regroupée avec lui
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+
+    bool fresh = s_last_scan_us != 0 &&
+                 now - s_last_scan_us < CONFIG_MINIOT_WIFI_SCAN_CACHE_TTL_SEC * 1000000LL;
+    if (fresh && !force) {
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+
+    // Le scan nécessite que l'interface STA soit active (APSTA en mode portail)
+    wifi_mode_t mode;
+    if (esp_wifi_get_mode(&mode) != ESP_OK || (mode != WIFI_MODE_STA && mode != WIFI_MODE_APSTA)) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_WIFI_MODE;
+    }
+
+    wifi_scan_config_t scan_config = {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = 0,
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time = {
+            .active = {
+                .min = 100,
+                .max = 300
+            }
+        }
+    };
+
+    // Non bloquant: la fin du scan arrive par WIFI_EVENT_SCAN_DONE
+    ret = esp_wifi_scan_start(&scan_config, false);
+    if (ret == ESP_OK) {
+        s_scan_started_us = now;
+        ESP_LOGI(TAG, "Background scan started");
+    } else {
+        ESP_LOGE(TAG, "WiFi scan start failed: %s", esp_err_to_name(ret));
+    }
+
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+size_t wifi_scan_get_results(wifi_scan_result_t *results, size_t max_results,
+                             int64_t *age_ms, bool *scanning)
+{
+    if (!s_lock) {
+        if (age_ms) {
+            *age_ms = -1;
+        }
+        if (scanning) {
+            *scanning = false;
+        }
+        return 0;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t count = s_result_count < max_results ? s_result_count : max_results;
+    memcpy(results, s_results, count * sizeof(wifi_scan_result_t));
+    if (age_ms) {
+        *age_ms = s_last_scan_us ? (now - s_last_scan_us) / 1000 : -1;
+    }
+    if (scanning) {
+        *scanning = s_scan_started_us != 0 && now - s_scan_started_us < WIFI_SCAN_TIMEOUT_MS * 1000LL;
+    }
+    xSemaphoreGive(s_lock);
+
+    return count;
+}
+
+void wifi_scan_set_done_callback(wifi_scan_done_cb_t callback)
+{
+    s_done_callback = callback;
+}
@@ -0,0 +1,65 @@
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define WIFI_SCAN_MAX_RESULTS 20
+
+/**
+ * @brief Réseau trouvé par le scan (un seul par SSID, le plus fort)
+ */
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_scan_result_t;
+
+/**
+ * @brief Callback appelé à la fin de chaque scan
+ * Appelé depuis la boucle d'événements: ne doit pas bloquer
+ * @param count Nombre de réseaux en cache
+ */
+typedef void (*wifi_scan_done_cb_t)(size_t count);
+
+/**
+ * @brief Initialise le service de scan (abonnement à WIFI_EVENT_SCAN_DONE)
+ * Doit être appelé après wifi_manager_init()
+ * @return ESP_OK si succès
+ */
+esp_err_t wifi_scan_init(void);
+
+/**
+ * @brief Demande un scan en arrière-plan (non bloquant)
+ *
+ * Sans effet si le cache est encore valide (CONFIG_MINIOT_WIFI_SCAN_CACHE_TTL_SEC)
+ * ou si un scan est déjà en cours: les demandes simultanées sont regroupées en
+ * un seul scan radio.
+ *
+ * @param force Ignorer la durée de validité du cache
+ * @return ESP_OK si un scan est en cours ou inutile
+ *         ESP_ERR_WIFI_MODE si l'interface STA n'est pas active
+ */
+esp_err_t wifi_scan_request(bool force);
+
+/**
+ * @brief Copie les derniers résultats, triés par RSSI décroissant
+ * @param results Tableau de sortie
+ * @param max_results Taille du tableau
+ * @param age_ms Âge des résultats en ms (-1 si aucun scan terminé), peut être NULL
+ * @param scanning True si un scan est en cours, peut être NULL
+ * @return Nombre de réseaux copiés
+ */
+size_t wifi_scan_get_results(wifi_scan_result_t *results, size_t max_results,
+                             int64_t *age_ms, bool *scanning);
+
+/**
+ * @brief Enregistre un callback pour la fin des scans
+ * @param callback Fonction à appeler (NULL pour désactiver)
+ */
+void wifi_scan_set_done_callback(wifi_scan_done_cb_t callback);
+
+#endif // WIFI_SCAN_H
@@ -3,9 +3,12 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "nvs_storage.h"
 #include "wifi_manager.h"
 #include "dns_server.h"
+#include "net_reactor.h"
+#include "wifi_scan.h"
 #include "web_server.h"
 #include "mdns_service.h"
 #include "ota_manager.h"
@@ -13,9 +16,28 @@
 static const char *TAG = "MAIN";
 
 // Constants
-#define DNS_INIT_DELAY_MS 2000
 #define MAIN_LOOP_DELAY_MS 10000
 
+typedef enum {
+    APP_MODE_NONE,
+    APP_MODE_AP,
+    APP_MODE_STA
+} app_mode_t;
+
+static app_mode_t s_mode = APP_MODE_NONE;
+static TaskHandle_t s_main_task = NULL;
+
+/**
+ * Callback de changement d'état WiFi: réveille la boucle principale
+ * pour que la bascule de mode ne dépende pas de MAIN_LOOP_DELAY_MS
+ */
+static void on_wifi_state_changed(wifi_manager_state_t state)
+{
+    if (s_main_task) {
+        xTaskNotifyGive(s_main_task);
+    }
+}
+
 /**
  * Start AP mode with captive portal and web server
  * Used for initial setup and when WiFi connection fails
@@ -31,6 +53,8 @@ static void start_ap_mode(bool is_first_boot)
     ESP_LOGI(TAG, "Starting web server...");
     ESP_ERROR_CHECK(web_server_start());
 
+    s_mode = APP_MODE_AP;
+
     if (is_first_boot) {
         ESP_LOGI(TAG, "=== MiniOT Ready (AP Mode - First Boot) ===");
     } else {
@@ -39,11 +63,31 @@ static void start_ap_mode(bool is_first_boot)
     ESP_LOGI(TAG, "Connect to WiFi network and navigate to http://192.168.4.1");
 }
 
+/**
+ * Bascule STA -> AP après une perte de connexion
+ * Le serveur web et mDNS restent actifs (liés à toutes les interfaces), seuls
+ * le WiFi et le DNS captif changent: la bascule ne coûte que le démarrage de l'AP.
+ * La durée est mesurée depuis la perte du lien (tentatives de reconnexion comprises)
+ */
+static void switch_to_ap_mode(void)
+{
+    int64_t link_lost_us = wifi_manager_get_link_lost_time();
+    ESP_LOGW(TAG, "Switching from STA to AP mode");
+    wifi_manager_stop();
+    start_ap_mode(false);
+    if (link_lost_us != 0) {
+        ESP_LOGI(TAG, "STA->AP transition took %lld ms since link loss",
+                 (long long)((esp_timer_get_time() - link_lost_us) / 1000));
+    }
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "=== MiniOT Starting ===");
     ESP_LOGI(TAG, "ESP-IDF Version: %s", esp_get_idf_version());
 
+    s_main_task = xTaskGetCurrentTaskHandle();
+
     // Etape 0 : Initialiser le gestionnaire OTA
     ESP_LOGI(TAG, "Initializing OTA manager...");
     ESP_ERROR_CHECK(ota_manager_init());
@@ -56,6 +100,8 @@ void app_main(void)
     // Étape 2 : Initialiser le gestionnaire WiFi
     ESP_LOGI(TAG, "Initializing WiFi manager...");
     ESP_ERROR_CHECK(wifi_manager_init());
+    wifi_manager_set_event_callback(on_wifi_state_changed);
+    ESP_ERROR_CHECK(wifi_scan_init());
 
     // Étape 3 : Vérifier si une configuration WiFi existe
     miniot_wifi_config_t wifi_config;
@@ -65,10 +111,14 @@ void app_main(void)
         // Configuration trouvée, essayer de se connecter en mode Station
         ESP_LOGI(TAG, "WiFi configuration found, attempting to connect to: %s", wifi_config.ssid);
 
+        int64_t sta_start_us = esp_timer_get_time();
         ret = wifi_manager_start_sta(wifi_config.ssid, wifi_config.password, wifi_config.ap_timeout);
 
         if (ret == ESP_OK) {
+            s_mode = APP_MODE_STA;
             ESP_LOGI(TAG, "Successfully connected to WiFi!");
+            ESP_LOGI(TAG, "->STA transition took %lld ms",
+                     (long long)((esp_timer_get_time() - sta_start_us) / 1000));
 
             char ip[16];
             if (wifi_manager_get_ip(ip) == ESP_OK) {
@@ -81,10 +131,8 @@ void app_main(void)
                 mdns_service_announce_http(80);
             }
 
-            // Attendre que le DNS soit prêt
-            ESP_LOGI(TAG, "Waiting for DNS to be ready...");
-            vTaskDelay(DNS_INIT_DELAY_MS / portTICK_PERIOD_MS);
-
+            // Les serveurs DNS fournis par DHCP sont configurés avant IP_EVENT_STA_GOT_IP,
+            // aucune attente n'est nécessaire avant la première résolution
             // Vérifier les mises à jour GitHub
             ESP_LOGI(TAG, "Checking for firmware updates on GitHub...");
             ota_update_info_t update_info;
@@ -105,14 +153,17 @@ void app_main(void)
             ESP_LOGI(TAG, "Starting web server for configuration...");
             web_server_start();
 
+            // Reprendre un téléchargement OTA interrompu par un reboot (suivi dans l'interface web)
+            if (ota_manager_resume_pending() == ESP_OK) {
+                ESP_LOGW(TAG, "Resuming interrupted firmware update");
+            }
+
             ESP_LOGI(TAG, "=== MiniOT Ready (STA Mode) ===");
             ESP_LOGI(TAG, "Access device at: http://miniot.local or http://%s", ip);
         } else {
             // Échec de connexion, passer en mode AP
             ESP_LOGW(TAG, "Failed to connect to WiFi, switching to AP mode");
-            wifi_manager_stop();
-
-            start_ap_mode(false);
+            switch_to_ap_mode();
         }
     } else {
         // Pas de configuration trouvée, premier boot ou après factory reset
@@ -123,13 +174,17 @@ void app_main(void)
 
     // Boucle principale
     while (1) {
-        vTaskDelay(MAIN_LOOP_DELAY_MS / portTICK_PERIOD_MS);
+        // Réveil immédiat sur changement d'état WiFi, sinon surveillance périodique
+        ulTaskNotifyTake(pdTRUE, MAIN_LOOP_DELAY_MS / portTICK_PERIOD_MS);
 
         // Surveillance de l'état du WiFi
         wifi_manager_state_t state = wifi_manager_get_state();
         ESP_LOGD(TAG, "Current WiFi state: %d", state);
+        net_reactor_log_usage();
 
-        // TODO: Implémenter la logique de reconnexion automatique
-        // Si en mode STA et déconnecté pendant plus de X secondes -> passer en mode AP
+        // Le wifi_manager a épuisé ses tentatives de reconnexion -> passer en mode AP
+        if (s_mode == APP_MODE_STA && state == WIFI_STATE_STA_DISCONNECTED) {
+            switch_to_ap_mode();
+        }
     }
 }
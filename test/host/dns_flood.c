@@ -0,0 +1,264 @@
+// Flood DNS contre le serveur captif (reactor réel, sockets UDP sur loopback)
+//
+// Le reactor et une tâche "HTTP" partagent un même cœur, comme le reactor et
+// httpd sur le cœur 0 de l'ESP32 (même priorité, temps partagé). La tâche HTTP
+// exécute un travail CPU fixe toutes les 2 ms et mesure sa latence, au repos
+// puis pendant qu'un client inonde le port DNS depuis un autre cœur. Un second
+// client, dans sa limite, doit continuer à recevoir ses réponses.
+//
+// Compilé deux fois: avec la limitation par client (configuration par défaut)
+// et sans (DNS_FLOOD_NO_RATE_LIMIT) pour comparer.
+//
+// Usage: dns_flood [paquets/s du flood] [durée de chaque phase en ms]
+#define _GNU_SOURCE
+#include "sdkconfig.h"
+#ifdef DNS_FLOOD_NO_RATE_LIMIT
+#undef CONFIG_MINIOT_DNS_RATE_LIMIT
+#endif
+#include "dns_server.c"
+#include "host_test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define HTTP_PERIOD_US 2000
+#define HTTP_MAX_SAMPLES 20000
+#define CLIENT_PERIOD_MS 100
+#define HTTP_MAX_P99_US 20000         // Borne large: l'hôte de CI peut être chargé
+
+static TaskHandle_t s_reactor_task;
+static atomic_bool s_stop;
+static int s_dns_port;
+static int s_cpus;
+
+static void pin_to_cpu(int cpu)
+{
+    if (s_cpus < 2) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void on_packet(net_reactor_packet_t *packet, void *ctx)
+{
+    s_reactor_task = xTaskGetCurrentTaskHandle();
+    dns_server_on_packet(packet, ctx);
+}
+
+static int client_socket(const char *addr)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in local = { .sin_family = AF_INET };
+    inet_pton(AF_INET, addr, &local.sin_addr);
+    bind(sock, (struct sockaddr *)&local, sizeof(local));
+
+    struct sockaddr_in server = { .sin_family = AF_INET, .sin_port = htons(s_dns_port) };
+    inet_pton(AF_INET, "127.0.0.1", &server.sin_addr);
+    connect(sock, (struct sockaddr *)&server, sizeof(server));
+    return sock;
+}
+
+// Travail CPU fixe représentant le traitement d'une requête HTTP
+static volatile uint32_t s_sink;
+
+static void http_work(long iterations)
+{
+    uint32_t x = 1;
+    for (long i = 0; i < iterations; i++) {
+        x = x * 1664525u + 1013904223u;
+    }
+    s_sink = x;
+}
+
+typedef struct {
+    long work_iterations;
+    uint32_t samples[HTTP_MAX_SAMPLES];     // Latences en µs
+    size_t count;
+} http_phase_t;
+
+static void http_run(http_phase_t *phase, int duration_ms)
+{
+    phase->count = 0;
+    uint64_t end = host_now_ns() + (uint64_t)duration_ms * 1000000;
+    while (host_now_ns() < end && phase->count < HTTP_MAX_SAMPLES) {
+        uint64_t start = host_now_ns();
+        http_work(phase->work_iterations);
+        phase->samples[phase->count++] = (uint32_t)((host_now_ns() - start) / 1000);
+        usleep(HTTP_PERIOD_US);
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(http_phase_t *phase, int pct)
+{
+    qsort(phase->samples, phase->count, sizeof(uint32_t), compare_u32);
+    return phase->samples[(phase->count - 1) * pct / 100];
+}
+
+typedef struct {
+    int rate;
+    long sent;
+    long answered;
+} flood_t;
+
+static void *flood_thread(void *arg)
+{
+    flood_t *flood = arg;
+    pin_to_cpu(1);
+    int sock = client_socket("127.0.0.2");
+    uint8_t query[DNS_MAX_PACKET_SIZE];
+    uint8_t reply[DNS_MAX_PACKET_SIZE];
+    size_t len = dns_message_build_a_query(query, sizeof(query), 0, "flood.example.com");
+
+    // Envoi par lots d'une milliseconde au débit demandé
+    uint64_t start = host_now_ns();
+    while (!atomic_load(&s_stop)) {
+        long due = (long)((host_now_ns() - start) / 1000 * flood->rate / 1000000);
+        while (flood->sent < due) {
+            query[0] = (uint8_t)(flood->sent >> 8);
+            query[1] = (uint8_t)flood->sent;
+            if (send(sock, query, len, 0) < 0) {
+                break;
+            }
+            flood->sent++;
+        }
+        while (recv(sock, reply, sizeof(reply), MSG_DONTWAIT) > 0) {
+            flood->answered++;
+        }
+        usleep(1000);
+    }
+    while (recv(sock, reply, sizeof(reply), MSG_DONTWAIT) > 0) {
+        flood->answered++;
+    }
+    close(sock);
+    return NULL;
+}
+
+typedef struct {
+    atomic_long sent;           // Lus par le thread principal pendant la mesure
+    atomic_long answered;
+} client_t;
+
+static void *client_thread(void *arg)
+{
+    client_t *client = arg;
+    pin_to_cpu(1);
+    int sock = client_socket("127.0.0.3");
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 500000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    uint8_t query[DNS_MAX_PACKET_SIZE];
+    uint8_t reply[DNS_MAX_PACKET_SIZE];
+    while (!atomic_load(&s_stop)) {
+        uint16_t id = (uint16_t)(client->sent + 1);
+        size_t len = dns_message_build_a_query(query, sizeof(query), id, "captive.apple.com");
+        send(sock, query, len, 0);
+        client->sent++;
+        int n = recv(sock, reply, sizeof(reply), 0);
+        if (n >= DNS_HEADER_SIZE && ((reply[0] << 8) | reply[1]) == id) {
+            client->answered++;
+        }
+        usleep(CLIENT_PERIOD_MS * 1000);
+    }
+    close(sock);
+    return NULL;
+}
+
+static void print_phase(const char *name, http_phase_t *phase)
+{
+    uint32_t p50 = percentile(phase, 50);
+    uint32_t p99 = percentile(phase, 99);
+    uint32_t max = phase->samples[phase->count - 1];
+    printf("  %-22s HTTP work p50 %5u us, p99 %5u us, max %6u us (%zu samples)\n",
+           name, p50, p99, max, phase->count);
+}
+
+int main(int argc, char **argv)
+{
+    int rate = argc > 1 ? atoi(argv[1]) : 20000;
+    int duration_ms = argc > 2 ? atoi(argv[2]) : 1500;
+    static http_phase_t idle, flooded;
+
+    s_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    // Le reactor et la tâche HTTP héritent de l'affinité du thread principal
+    pin_to_cpu(0);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    socklen_t addr_len = sizeof(addr);
+    bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(sock, (struct sockaddr *)&addr, &addr_len);
+    s_dns_port = ntohs(addr.sin_port);
+
+    dns_hot_cache_init();
+    CHECK_EQ(net_reactor_start(), ESP_OK);
+    CHECK_EQ(net_reactor_add_udp(sock, on_packet, NULL), ESP_OK);
+
+    // Travail HTTP calibré à ~200 µs au repos
+    uint64_t start = host_now_ns();
+    http_work(10000000);
+    idle.work_iterations = flooded.work_iterations = (long)(10000000 * 200000.0 / (host_now_ns() - start));
+
+    static client_t client;
+    pthread_t client_tid;
+    pthread_create(&client_tid, NULL, client_thread, &client);
+
+    http_run(&idle, duration_ms);
+    long idle_answered = client.answered;
+
+    flood_t flood = { .rate = rate };
+    pthread_t flood_tid;
+    uint64_t cpu_before = s_reactor_task ? host_task_cpu_ns(s_reactor_task) : 0;
+    uint64_t flood_start = host_now_ns();
+    long client_sent_before = client.sent, client_answered_before = client.answered;
+    pthread_create(&flood_tid, NULL, flood_thread, &flood);
+
+    http_run(&flooded, duration_ms);
+
+    atomic_store(&s_stop, true);
+    pthread_join(flood_tid, NULL);
+    pthread_join(client_tid, NULL);
+    double flood_s = (host_now_ns() - flood_start) / 1e9;
+    uint64_t reactor_cpu = host_task_cpu_ns(s_reactor_task) - cpu_before;
+
+    long client_sent = client.sent - client_sent_before;
+    long client_answered = client.answered - client_answered_before;
+
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT
+    printf("DNS flood, per-client limit %d q/s (burst %d), %d CPUs\n",
+           CONFIG_MINIOT_DNS_RATE_LIMIT_QPS, CONFIG_MINIOT_DNS_RATE_LIMIT_BURST, s_cpus);
+#else
+    printf("DNS flood, no rate limit, %d CPUs\n", s_cpus);
+#endif
+    print_phase("idle:", &idle);
+    print_phase("flooded:", &flooded);
+    printf("  flood: %ld packets sent (%.0f/s), %ld answered; reactor CPU %.0f%% of a core\n",
+           flood.sent, flood.sent / flood_s, flood.answered, reactor_cpu / 1e7 / flood_s);
+    printf("  client within its limit: %ld/%ld answered (idle phase %ld)\n",
+           client_answered, client_sent, idle_answered);
+
+    // La latence HTTP reste bornée et le client légitime est servi malgré le flood
+    CHECK(percentile(&flooded, 99) < HTTP_MAX_P99_US);
+    CHECK(client_sent > 0);
+    CHECK(client_answered * 100 >= client_sent * 95);
+#ifdef CONFIG_MINIOT_DNS_RATE_LIMIT
+    // Le flood ne reçoit pas plus que son débit autorisé (+ rafale initiale)
+    CHECK(flood.answered <= CONFIG_MINIOT_DNS_RATE_LIMIT_BURST +
+          (long)(CONFIG_MINIOT_DNS_RATE_LIMIT_QPS * flood_s * 1.1) + 1);
+    CHECK(s_stats.rate_limited > 0);
+#endif
+
+    net_reactor_remove_udp(sock);
+    close(sock);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,117 @@
+// Cache de noms fréquents du serveur DNS: réponses identiques à celles construites
+// paquet par paquet, et comparaison du débit des deux chemins
+//
+// Usage: dns_hot_cache_bench [requêtes par mesure]
+#include "dns_server.c"
+#include "host_test.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+esp_err_t net_reactor_start(void) { return ESP_OK; }
+esp_err_t net_reactor_add_udp(int sock, net_reactor_udp_handler_t handler, void *ctx) { return ESP_OK; }
+esp_err_t net_reactor_remove_udp(int sock) { return ESP_OK; }
+
+typedef struct {
+    uint8_t buf[DNS_MAX_PACKET_SIZE];
+    size_t len;
+} query_t;
+
+static query_t s_exact[DNS_HOT_NAMES_COUNT * 2];        // Casse d'origine: servies par le cache
+static query_t s_mixed[DNS_HOT_NAMES_COUNT * 2];        // Casse 0x20: construites paquet par paquet
+
+static size_t build_query(uint8_t *buf, uint16_t id, const char *name, bool edns)
+{
+    size_t len = dns_message_build_a_query(buf, DNS_MAX_PACKET_SIZE, id, name);
+    if (edns) {
+        static const uint8_t opt[] = {0, 0, DNS_TYPE_OPT, 0x04, 0xD0, 0, 0, 0, 0, 0, 0};
+        memcpy(buf + len, opt, sizeof(opt));
+        len += sizeof(opt);
+        buf[11] = 1;
+    }
+    return len;
+}
+
+static double measure(const query_t *queries, size_t count, long iterations, uint32_t *hits)
+{
+    uint8_t buf[DNS_MAX_PACKET_SIZE];
+    size_t bytes = 0;
+
+    s_stats.cache_hits = 0;
+    uint64_t start = host_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        const query_t *q = &queries[i % count];
+        const uint8_t *resp;
+        memcpy(buf, q->buf, q->len);
+        bytes += dns_handle_query(buf, q->len, sizeof(buf), &resp);
+    }
+    uint64_t elapsed = host_now_ns() - start;
+
+    CHECK(bytes > 0);
+    *hits = s_stats.cache_hits;
+    return iterations * 1e9 / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    size_t count = 0;
+
+    dns_hot_cache_init();
+
+    srand(3);
+    for (size_t i = 0; i < DNS_HOT_NAMES_COUNT; i++) {
+        for (int edns = 0; edns <= 1; edns++) {
+            char mixed[DNS_MAX_NAME_LEN];
+            const char *name = s_hot_names[i];
+            size_t n = strlen(name);
+            // Randomisation 0x20: au moins une lettre en majuscule
+            for (size_t j = 0; j <= n; j++) {
+                mixed[j] = (rand() % 2 || j == 0) ? (char)toupper((unsigned char)name[j]) : name[j];
+            }
+
+            uint16_t id = (uint16_t)rand();
+            s_exact[count].len = build_query(s_exact[count].buf, id, name, edns);
+            s_mixed[count].len = build_query(s_mixed[count].buf, id, mixed, edns);
+            count++;
+        }
+    }
+
+    // Les deux chemins doivent produire la même réponse, à la casse de la question près
+    for (size_t i = 0; i < count; i++) {
+        uint8_t a[DNS_MAX_PACKET_SIZE], b[DNS_MAX_PACKET_SIZE];
+        const uint8_t *resp_a, *resp_b;
+
+        uint32_t hits = s_stats.cache_hits;
+        memcpy(a, s_exact[i].buf, s_exact[i].len);
+        size_t len_a = dns_handle_query(a, s_exact[i].len, sizeof(a), &resp_a);
+        CHECK_EQ(s_stats.cache_hits, hits + 1);
+
+        uint32_t misses = s_stats.cache_misses;
+        memcpy(b, s_mixed[i].buf, s_mixed[i].len);
+        size_t len_b = dns_handle_query(b, s_mixed[i].len, sizeof(b), &resp_b);
+        CHECK_EQ(s_stats.cache_misses, misses + 1);
+
+        CHECK_EQ(len_a, len_b);
+        CHECK(resp_b == b);
+        for (size_t j = 0; j < len_a && j < len_b; j++) {
+            if (tolower(resp_a[j]) != tolower(resp_b[j])) {
+                fprintf(stderr, "Response %zu differs at byte %zu\n", i, j);
+                host_test_failures++;
+                break;
+            }
+        }
+    }
+
+    uint32_t hits_cached, hits_built;
+    double qps_cached = measure(s_exact, count, iterations, &hits_cached);
+    double qps_built = measure(s_mixed, count, iterations, &hits_built);
+    CHECK_EQ(hits_cached, iterations);
+    CHECK_EQ(hits_built, 0);
+
+    printf("%d names, A with and without EDNS, %ld queries per run\n", (int)DNS_HOT_NAMES_COUNT, iterations);
+    printf("  hot-name cache:   %.0f queries/s (%.0f ns/query)\n", qps_cached, 1e9 / qps_cached);
+    printf("  built per packet: %.0f queries/s (%.0f ns/query)\n", qps_built, 1e9 / qps_built);
+    printf("  speedup: x%.2f\n", qps_cached / qps_built);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+// Rejoue un corpus de requêtes de détection de portail captif à travers
+// dns_server.c, vérifie chaque réponse puis mesure le débit du traitement
+//
+// Usage: dns_replay <corpus> [requêtes pour la mesure]
+#include "dns_server.c"
+#include "host_test.h"
+#include <stdlib.h>
+
+// Le reactor n'est pas utilisé: les requêtes sont passées directement à dns_handle_query()
+esp_err_t net_reactor_start(void) { return ESP_OK; }
+esp_err_t net_reactor_add_udp(int sock, net_reactor_udp_handler_t handler, void *ctx) { return ESP_OK; }
+esp_err_t net_reactor_remove_udp(int sock) { return ESP_OK; }
+
+#define REPLAY_MAX_QUERIES 256
+
+typedef struct {
+    char source[16];
+    char expect[16];
+    uint8_t query[DNS_MAX_PACKET_SIZE];
+    size_t len;
+} replay_query_t;
+
+static replay_query_t s_queries[REPLAY_MAX_QUERIES];
+static size_t s_count;
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static int load_corpus(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[1200];
+    while (fgets(line, sizeof(line), f) && s_count < REPLAY_MAX_QUERIES) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        replay_query_t *q = &s_queries[s_count];
+        char hex[1100];
+        if (sscanf(line, "%15s %15s %1099s", q->source, q->expect, hex) != 3) {
+            fprintf(stderr, "Bad corpus line: %s", line);
+            continue;
+        }
+        q->len = host_hex_decode(hex, q->query, sizeof(q->query));
+        s_count++;
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * Vérifie la réponse au regard de la requête et du résultat attendu
+ */
+static void check_response(const replay_query_t *q, const uint8_t *resp, size_t len)
+{
+    if (strcmp(q->expect, "DROP") == 0) {
+        CHECK_EQ(len, 0);
+        return;
+    }
+
+    CHECK(len >= DNS_HEADER_SIZE);
+    if (len < DNS_HEADER_SIZE) {
+        return;
+    }
+
+    uint16_t flags = get_u16(resp + 2);
+    uint8_t rcode = flags & 0x0F;
+    CHECK(memcmp(resp, q->query, 2) == 0);
+    CHECK(flags & 0x8000);
+    // RD recopié
+    CHECK_EQ(flags & 0x0100, get_u16(q->query + 2) & 0x0100);
+
+    if (strcmp(q->expect, "FORMERR") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_FORMERR);
+        CHECK_EQ(len, DNS_HEADER_SIZE);
+        return;
+    }
+    if (strcmp(q->expect, "NOTIMP") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_NOTIMP);
+        return;
+    }
+
+    // Réponse complète: la première question est renvoyée telle quelle
+    dns_query_t query;
+    CHECK_EQ(dns_message_parse_query(q->query, q->len, &query), ESP_OK);
+    CHECK_EQ(get_u16(resp + 4), 1);
+    CHECK(len >= query.question_end);
+    if (len < query.question_end) {
+        return;
+    }
+    CHECK(memcmp(resp + DNS_HEADER_SIZE, q->query + DNS_HEADER_SIZE,
+                 query.question_end - DNS_HEADER_SIZE) == 0);
+    CHECK_EQ(get_u16(resp + 10), query.has_edns ? 1 : 0);
+
+    uint16_t ancount = get_u16(resp + 6);
+    const uint8_t *rr = resp + query.question_end;
+
+    if (strcmp(q->expect, "A") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_NOERROR);
+        CHECK_EQ(ancount, 1);
+        CHECK_EQ(get_u16(rr + 2), DNS_TYPE_A);
+        CHECK(memcmp(rr + 12, s_ap_ip, 4) == 0);
+    } else if (strcmp(q->expect, "PTR") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_NOERROR);
+        CHECK_EQ(ancount, 1);
+        CHECK_EQ(get_u16(rr + 2), DNS_TYPE_PTR);
+    } else if (strcmp(q->expect, "NODATA") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_NOERROR);
+        CHECK_EQ(ancount, 0);
+    } else if (strcmp(q->expect, "NXDOMAIN") == 0) {
+        CHECK_EQ(rcode, DNS_RCODE_NXDOMAIN);
+        CHECK_EQ(ancount, 0);
+    } else if (strcmp(q->expect, "BADVERS") == 0) {
+        // Code étendu 1 dans le TTL de l'OPT
+        CHECK_EQ(ancount, 0);
+        CHECK(len >= query.question_end + 11);
+        CHECK_EQ(rr[5], 1);
+    } else {
+        fprintf(stderr, "Unknown expectation '%s'\n", q->expect);
+        host_test_failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <corpus> [queries]\n", argv[0]);
+        return 2;
+    }
+    if (load_corpus(argv[1]) != 0 || s_count == 0) {
+        return 1;
+    }
+    long iterations = argc > 2 ? atol(argv[2]) : 1000000;
+
+    dns_hot_cache_init();
+
+    uint8_t buf[DNS_MAX_PACKET_SIZE];
+    for (size_t i = 0; i < s_count; i++) {
+        const uint8_t *resp;
+        memcpy(buf, s_queries[i].query, s_queries[i].len);
+        size_t len = dns_handle_query(buf, s_queries[i].len, sizeof(buf), &resp);
+        int failures = host_test_failures;
+        check_response(&s_queries[i], resp, len);
+        if (host_test_failures != failures) {
+            fprintf(stderr, "  in query %zu (%s, expected %s)\n", i, s_queries[i].source, s_queries[i].expect);
+        }
+    }
+
+    // Débit: chaque requête est recopiée dans le buffer de réception comme après recvfrom()
+    memset(&s_stats, 0, sizeof(s_stats));
+    size_t bytes = 0;
+    uint64_t start = host_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        const replay_query_t *q = &s_queries[i % s_count];
+        const uint8_t *resp;
+        memcpy(buf, q->query, q->len);
+        bytes += dns_handle_query(buf, q->len, sizeof(buf), &resp);
+    }
+    uint64_t elapsed = host_now_ns() - start;
+
+    printf("%zu corpus queries, %ld replayed in %.1f ms: %.0f queries/s, %.0f ns/query (%zu response bytes)\n",
+           s_count, iterations, elapsed / 1e6, iterations * 1e9 / elapsed, (double)elapsed / iterations, bytes);
+    printf("A %u, AAAA %u, HTTPS %u, PTR %u, other %u, errors %u, hot-name hits %u, misses %u\n",
+           s_stats.a, s_stats.aaaa, s_stats.https, s_stats.ptr, s_stats.other, s_stats.errors,
+           s_stats.cache_hits, s_stats.cache_misses);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,93 @@
+// Implémentation hôte des quelques fonctions ESP-IDF utilisées par les composants testés
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_OTA_VALIDATE_FAILED: return "ESP_ERR_OTA_VALIDATE_FAILED";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+/**
+ * Niveau d'affichage depuis MINIOT_HOST_LOG (0 = rien ... 3 = info), WARN par défaut
+ * pour que les benchmarks ne mesurent pas le terminal
+ */
+void host_log(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static int max_level = -1;
+    if (max_level < 0) {
+        const char *env = getenv("MINIOT_HOST_LOG");
+        max_level = env ? atoi(env) : ESP_LOG_WARN;
+    }
+    if ((int)level > max_level) {
+        return;
+    }
+
+    // Ligne formatée dans un buffer: vfprintf() sur stderr, non bufferisé, réserve
+    // 8 Ko de pile et fausserait la mesure des piles de tâches
+    static const char letters[] = "NEWIDV";
+    char line[256];
+    int n = snprintf(line, sizeof(line) - 1, "%c (%s) ", letters[level], tag);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line + n, sizeof(line) - 1 - n, format, args);
+    va_end(args);
+    strcat(line, "\n");
+    fputs(line, stderr);
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t)random() ^ ((uint32_t)random() << 16);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return 0;
+}
+
+const char *esp_get_idf_version(void)
+{
+    return "host";
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "esp_restart() called\n");
+    exit(3);
+}
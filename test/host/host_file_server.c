@@ -0,0 +1,312 @@
+// Serveur HTTP de fichiers sur loopback pour les tests OTA
+//
+// Le débit est limité côté serveur, sans crédit accumulé pendant qu'un client
+// lent ne lit pas: avec le petit tampon d'émission de la socket, c'est un lien
+// dont la fenêtre TCP est réduite à quelques Ko, comme avec lwIP.
+#define _GNU_SOURCE
+#include "host_file_server.h"
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HOST_FILE_SERVER_SEND_SIZE 1460     // Un segment TCP
+#define HOST_FILE_SERVER_SNDBUF 4096
+
+typedef struct {
+    char path[64];
+    const uint8_t *data;
+    size_t len;
+    char etag[40];
+} host_file_t;
+
+static struct {
+    pthread_mutex_t lock;
+    int port;
+    host_file_t files[HOST_FILE_SERVER_FILES];
+    int count;
+    size_t drop_after;
+    int drops;                          // Réponses encore à couper
+    uint32_t rate;
+    uint32_t latency_ms;
+    host_file_server_stats_t stats;
+} s_server = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static int64_t host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Valeur d'un champ de l'en-tête de la requête, "" s'il est absent
+ */
+static void host_request_header(const char *request, const char *name, char *value, size_t size)
+{
+    size_t len = strlen(name);
+    value[0] = '\0';
+    for (const char *line = strstr(request, "\r\n"); line != NULL; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, len) == 0 && line[len] == ':') {
+            const char *v = line + len + 1 + strspn(line + len + 1, " \t");
+            snprintf(value, size, "%.*s", (int)strcspn(v, "\r"), v);
+            return;
+        }
+    }
+}
+
+/**
+ * Envoie len octets au débit du lien
+ * @param cut Octets envoyés avant de couper la connexion, len pour tout envoyer
+ * @return false si la connexion est coupée
+ */
+static bool host_file_server_send(int sock, const uint8_t *data, size_t len, size_t cut, uint32_t rate)
+{
+    int64_t next_us = host_now_us();
+    for (size_t sent = 0; sent < len; ) {
+        if (sent >= cut) {
+            shutdown(sock, SHUT_RDWR);
+            return false;
+        }
+        size_t n = len - sent < HOST_FILE_SERVER_SEND_SIZE ? len - sent : HOST_FILE_SERVER_SEND_SIZE;
+        if (n > cut - sent) {
+            n = cut - sent;
+        }
+        if (rate) {
+            // Pas de rattrapage après une attente du client: le lien ne stocke rien
+            int64_t now = host_now_us();
+            if (next_us > now) {
+                usleep(next_us - now);
+            } else {
+                next_us = now;
+            }
+            next_us += (int64_t)n * 1000000 / rate;
+        }
+        ssize_t r = send(sock, data + sent, n, MSG_NOSIGNAL);
+        if (r <= 0) {
+            return false;
+        }
+        sent += r;
+    }
+    return true;
+}
+
+/**
+ * Répond à une requête (en-tête terminé par un NUL)
+ * @return false si la connexion doit être fermée
+ */
+static bool host_file_server_respond(int sock, const char *request)
+{
+    char path[256], range[64], if_range[64], connection[32];
+    if (sscanf(request, "GET %255s HTTP/1.1", path) != 1) {
+        return false;
+    }
+    host_request_header(request, "Range", range, sizeof(range));
+    host_request_header(request, "If-Range", if_range, sizeof(if_range));
+    host_request_header(request, "Connection", connection, sizeof(connection));
+    bool keep_alive = strcasecmp(connection, "close") != 0;
+
+    pthread_mutex_lock(&s_server.lock);
+    uint32_t rate = s_server.rate, latency_ms = s_server.latency_ms;
+    host_file_t file = { .len = 0 };
+    for (int i = 0; i < s_server.count; i++) {
+        if (strcmp(s_server.files[i].path, path) == 0) {
+            file = s_server.files[i];
+        }
+    }
+    s_server.stats.requests++;
+    pthread_mutex_unlock(&s_server.lock);
+
+    if (latency_ms) {
+        usleep(latency_ms * 1000);
+    }
+
+    char header[512];
+    if (strncmp(path, "/redirect/", 10) == 0) {
+        int n = snprintf(header, sizeof(header), "HTTP/1.1 302 Found\r\nLocation: http://127.0.0.1:%d%s\r\n"
+                         "Content-Length: 0\r\n\r\n", s_server.port, path + 9);
+        return send(sock, header, n, MSG_NOSIGNAL) == n && keep_alive;
+    }
+    if (file.data == NULL) {
+        int n = snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        return send(sock, header, n, MSG_NOSIGNAL) == n && keep_alive;
+    }
+
+    // Range ignoré si le fichier a changé depuis l'ETag envoyé en If-Range
+    long long first = -1, last = -1;
+    if (range[0] != '\0' && (if_range[0] == '\0' || strcmp(if_range, file.etag) == 0)) {
+        sscanf(range, "bytes=%lld-%lld", &first, &last);
+    }
+    if (first >= (long long)file.len) {
+        int n = snprintf(header, sizeof(header), "HTTP/1.1 416 Range Not Satisfiable\r\n"
+                         "Content-Range: bytes */%zu\r\nContent-Length: 0\r\n\r\n", file.len);
+        return send(sock, header, n, MSG_NOSIGNAL) == n && keep_alive;
+    }
+
+    int n;
+    const uint8_t *body = file.data;
+    size_t len = file.len;
+    if (first >= 0) {
+        if (last < first || last >= (long long)file.len) {
+            last = file.len - 1;
+        }
+        body += first;
+        len = last - first + 1;
+        n = snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%zu\r\n",
+                     first, last, file.len);
+    } else {
+        n = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n");
+    }
+    n += snprintf(header + n, sizeof(header) - n, "Content-Length: %zu\r\nETag: %s\r\nAccept-Ranges: bytes\r\n\r\n",
+                  len, file.etag);
+
+    size_t cut = len;
+    pthread_mutex_lock(&s_server.lock);
+    if (s_server.drops > 0 && len > s_server.drop_after) {
+        s_server.drops--;
+        s_server.stats.dropped++;
+        cut = s_server.drop_after;
+    }
+    s_server.stats.partial += first >= 0;
+    s_server.stats.body_bytes += cut;
+    pthread_mutex_unlock(&s_server.lock);
+
+    if (send(sock, header, n, MSG_NOSIGNAL) != n) {
+        return false;
+    }
+    return host_file_server_send(sock, body, len, cut, rate) && keep_alive;
+}
+
+static void *host_file_server_connection(void *arg)
+{
+    int sock = (int)(intptr_t)arg;
+    char request[2048];
+    size_t len = 0;
+
+    while (1) {
+        char *end;
+        while ((end = memmem(request, len, "\r\n\r\n", 4)) == NULL) {
+            ssize_t r = len < sizeof(request) ? recv(sock, request + len, sizeof(request) - len, 0) : -1;
+            if (r <= 0) {
+                close(sock);
+                return NULL;
+            }
+            len += r;
+        }
+        *end = '\0';
+        size_t consumed = end + 4 - request;
+        if (!host_file_server_respond(sock, request)) {
+            break;
+        }
+        memmove(request, request + consumed, len - consumed);
+        len -= consumed;
+    }
+    close(sock);
+    return NULL;
+}
+
+static void *host_file_server_accept(void *arg)
+{
+    int listener = (int)(intptr_t)arg;
+    while (1) {
+        int sock = accept(listener, NULL, NULL);
+        if (sock < 0) {
+            continue;
+        }
+        int size = HOST_FILE_SERVER_SNDBUF, one = 1;
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        pthread_t thread;
+        pthread_create(&thread, NULL, host_file_server_connection, (void *)(intptr_t)sock);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+int host_file_server_start(void)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener, 16) != 0 || getsockname(listener, (struct sockaddr *)&addr, &addr_len) != 0) {
+        perror("host_file_server");
+        abort();
+    }
+    s_server.port = ntohs(addr.sin_port);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, host_file_server_accept, (void *)(intptr_t)listener);
+    pthread_detach(thread);
+    return s_server.port;
+}
+
+void host_file_server_add(const char *path, const void *data, size_t len)
+{
+    // ETag: FNV-1a du contenu
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ ((const uint8_t *)data)[i]) * 16777619u;
+    }
+
+    pthread_mutex_lock(&s_server.lock);
+    if (s_server.count == HOST_FILE_SERVER_FILES) {
+        abort();
+    }
+    host_file_t *file = &s_server.files[s_server.count++];
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    file->data = data;
+    file->len = len;
+    snprintf(file->etag, sizeof(file->etag), "\"%08x\"", hash);
+    pthread_mutex_unlock(&s_server.lock);
+}
+
+void host_file_server_set_etag(const char *path, const char *etag)
+{
+    pthread_mutex_lock(&s_server.lock);
+    for (int i = 0; i < s_server.count; i++) {
+        if (strcmp(s_server.files[i].path, path) == 0) {
+            snprintf(s_server.files[i].etag, sizeof(s_server.files[i].etag), "%s", etag);
+        }
+    }
+    pthread_mutex_unlock(&s_server.lock);
+}
+
+void host_file_server_drop(size_t after, int count)
+{
+    pthread_mutex_lock(&s_server.lock);
+    s_server.drop_after = after;
+    s_server.drops = count;
+    pthread_mutex_unlock(&s_server.lock);
+}
+
+void host_file_server_set_link(uint32_t rate, uint32_t latency_ms)
+{
+    pthread_mutex_lock(&s_server.lock);
+    s_server.rate = rate;
+    s_server.latency_ms = latency_ms;
+    pthread_mutex_unlock(&s_server.lock);
+}
+
+void host_file_server_get_stats(host_file_server_stats_t *stats)
+{
+    pthread_mutex_lock(&s_server.lock);
+    *stats = s_server.stats;
+    pthread_mutex_unlock(&s_server.lock);
+}
+
+void host_file_server_reset_stats(void)
+{
+    pthread_mutex_lock(&s_server.lock);
+    memset(&s_server.stats, 0, sizeof(s_server.stats));
+    pthread_mutex_unlock(&s_server.lock);
+}
@@ -0,0 +1,51 @@
+// Serveur HTTP de fichiers sur loopback, pour les tests OTA (host_file_server.c)
+//
+// Sert des fichiers gardés en mémoire avec ETag, Range et If-Range, comme le
+// stockage des releases GitHub; /redirect/<chemin> répond 302 vers <chemin>.
+// Chaque connexion keep-alive est servie par son propre thread. Défaillances
+// injectables: réponses coupées, débit du lien limité, latence par requête.
+#ifndef HOST_FILE_SERVER_H
+#define HOST_FILE_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_FILE_SERVER_FILES 16
+
+typedef struct {
+    uint32_t requests;
+    uint32_t partial;                   // Réponses 206
+    uint32_t dropped;                   // Réponses coupées
+    uint64_t body_bytes;
+} host_file_server_stats_t;
+
+/**
+ * Démarre le serveur sur 127.0.0.1, port choisi par le système
+ * @return Port d'écoute
+ */
+int host_file_server_start(void);
+
+/**
+ * Sert data (gardé par l'appelant) sous path, avec un ETag tiré du contenu
+ */
+void host_file_server_add(const char *path, const void *data, size_t len);
+
+/**
+ * Remplace l'ETag d'un fichier (fichier republié)
+ */
+void host_file_server_set_etag(const char *path, const char *etag);
+
+/**
+ * Coupe les count prochaines réponses après after octets de corps
+ */
+void host_file_server_drop(size_t after, int count);
+
+/**
+ * Débit du lien en octets/s (0: illimité) et délai avant chaque réponse
+ */
+void host_file_server_set_link(uint32_t rate, uint32_t latency_ms);
+
+void host_file_server_get_stats(host_file_server_stats_t *stats);
+void host_file_server_reset_stats(void);
+
+#endif // HOST_FILE_SERVER_H
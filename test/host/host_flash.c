@@ -0,0 +1,145 @@
+// Partitions de la flash simulées en mémoire partagée
+//
+// ota_0 et ota_1 de partitions.csv, effacées (0xff) au premier accès. Les
+// durées d'effacement et d'écriture sont simulées par des pauses.
+#include "esp_partition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HOST_FLASH_PARTITIONS 2
+#define HOST_FLASH_PARTITION_SIZE (1536 * 1024)
+
+static const esp_partition_t s_partitions[HOST_FLASH_PARTITIONS] = {
+    { .type = ESP_PARTITION_TYPE_APP, .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_0, .address = 0x20000,
+      .size = HOST_FLASH_PARTITION_SIZE, .erase_size = SPI_FLASH_SEC_SIZE, .label = "ota_0" },
+    { .type = ESP_PARTITION_TYPE_APP, .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1, .address = 0x1A0000,
+      .size = HOST_FLASH_PARTITION_SIZE, .erase_size = SPI_FLASH_SEC_SIZE, .label = "ota_1" },
+};
+
+struct host_flash {
+    host_flash_stats_t stats;
+    uint32_t erase_us;
+    uint32_t write_us;
+    uint8_t data[HOST_FLASH_PARTITIONS][HOST_FLASH_PARTITION_SIZE];
+};
+
+static struct host_flash *s_flash;
+
+static struct host_flash *host_flash(void)
+{
+    if (!s_flash) {
+        // Partagée avec les processus fils: le contenu survit à un "reboot"
+        void *mem = mmap(NULL, sizeof(struct host_flash), PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("mmap");
+            abort();
+        }
+        s_flash = mem;
+        memset(s_flash->data, 0xff, sizeof(s_flash->data));
+    }
+    return s_flash;
+}
+
+/**
+ * Contenu de la partition, NULL si elle n'est pas simulée
+ */
+static uint8_t *host_flash_find(const esp_partition_t *partition)
+{
+    for (int i = 0; i < HOST_FLASH_PARTITIONS; i++) {
+        if (partition == &s_partitions[i]) {
+            return host_flash()->data[i];
+        }
+    }
+    return NULL;
+}
+
+const esp_partition_t *host_flash_partition(int index)
+{
+    return index >= 0 && index < HOST_FLASH_PARTITIONS ? &s_partitions[index] : NULL;
+}
+
+uint8_t *host_flash_data(const esp_partition_t *partition)
+{
+    return host_flash_find(partition);
+}
+
+void host_flash_get_stats(host_flash_stats_t *stats)
+{
+    *stats = host_flash()->stats;
+}
+
+void host_flash_reset_stats(void)
+{
+    memset(&host_flash()->stats, 0, sizeof(host_flash_stats_t));
+}
+
+void host_flash_set_timing(uint32_t erase_us, uint32_t write_us)
+{
+    host_flash()->erase_us = erase_us;
+    host_flash()->write_us = write_us;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    uint8_t *data = host_flash_find(partition);
+    if (!data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, data + src_offset, size);
+    s_flash->stats.reads++;
+    s_flash->stats.read_bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    uint8_t *data = host_flash_find(partition);
+    if (!data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dst_offset > partition->size || size > partition->size - dst_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t *bytes = src;
+    bool dirty = false;
+    for (size_t i = 0; i < size; i++) {
+        dirty |= (data[dst_offset + i] & bytes[i]) != bytes[i];
+        data[dst_offset + i] &= bytes[i];
+    }
+    s_flash->stats.writes++;
+    s_flash->stats.written_bytes += size;
+    s_flash->stats.dirty_writes += dirty;
+    if (s_flash->write_us) {
+        usleep((useconds_t)((uint64_t)s_flash->write_us * size / SPI_FLASH_SEC_SIZE));
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    uint8_t *data = host_flash_find(partition);
+    if (!data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset > partition->size || size > partition->size - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(data + offset, 0xff, size);
+    s_flash->stats.erases += size / SPI_FLASH_SEC_SIZE;
+    if (s_flash->erase_us) {
+        usleep((useconds_t)s_flash->erase_us * (size / SPI_FLASH_SEC_SIZE));
+    }
+    return ESP_OK;
+}
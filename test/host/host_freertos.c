@@ -0,0 +1,357 @@
+// Tâches, files et sémaphores FreeRTOS sur des threads POSIX
+//
+// Les délais sont en millisecondes (configTICK_RATE_HZ = 1000). Il n'y a ni
+// priorités ni affinité: les tests qui en dépendent épinglent eux-mêmes leurs threads.
+// La pile de chaque tâche est remplie d'un motif au démarrage pour en mesurer
+// l'utilisation maximale (sauf sous AddressSanitizer).
+#define _GNU_SOURCE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_TASK_STACK_SIZE (256 * 1024)   // Pile réelle du thread, la taille demandée n'est qu'une référence
+#define HOST_STACK_PAINT 0xA5
+#define HOST_STACK_SLACK 1024               // Laissé sous le cadre courant pendant le remplissage
+
+#if defined(__SANITIZE_ADDRESS__)
+#define HOST_STACK_TRACKING 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define HOST_STACK_TRACKING 0
+#endif
+#endif
+#ifndef HOST_STACK_TRACKING
+#define HOST_STACK_TRACKING 1
+#endif
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *param;
+    uint32_t stack_size;
+    uint8_t *stack_bottom;              // NULL: pas de suivi de la pile
+    uint8_t *stack_top;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    size_t length;
+    size_t item_size;
+    size_t count;
+    size_t head;
+    uint8_t items[];
+};
+
+static __thread struct host_task *s_current;
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec host_deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/**
+ * Attend cond jusqu'à deadline (aucune limite pour portMAX_DELAY)
+ * Retourne false à l'expiration
+ */
+static bool host_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+                      const struct timespec *deadline)
+{
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) == 0;
+}
+
+static struct host_task *host_task_alloc(void)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    pthread_mutex_init(&task->lock, NULL);
+    host_cond_init(&task->cond);
+    return task;
+}
+
+/**
+ * Remplit la pile libre sous le cadre de l'appelant (top) avec HOST_STACK_PAINT
+ */
+static __attribute__((noinline)) void host_stack_paint(struct host_task *task, uint8_t *top)
+{
+#if HOST_STACK_TRACKING
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return;
+    }
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+
+    volatile uint8_t *p = addr;
+    volatile uint8_t *end = (uint8_t *)__builtin_frame_address(0) - HOST_STACK_SLACK;
+    while (p < end) {
+        *p++ = HOST_STACK_PAINT;
+    }
+    task->stack_bottom = addr;
+    task->stack_top = top;
+#endif
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    s_current = task;
+    host_stack_paint(task, __builtin_frame_address(0));
+    task->function(task->param);
+    // Une tâche FreeRTOS ne doit jamais retourner
+    fprintf(stderr, "FreeRTOS task returned without vTaskDelete\n");
+    abort();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *param, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core)
+{
+    struct host_task *task = host_task_alloc();
+    task->function = function;
+    task->param = param;
+    task->stack_size = stack_size;
+    if (handle) {
+        *handle = task;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, HOST_TASK_STACK_SIZE);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, host_task_entry, task);
+    pthread_attr_destroy(&attr);
+    return err == 0 ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size,
+                       void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_size, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != s_current) {
+        fprintf(stderr, "vTaskDelete of another task is not supported on the host\n");
+        abort();
+    }
+    // Le handle reste alloué: d'autres tâches peuvent encore le comparer
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!s_current) {
+        s_current = host_task_alloc();
+        s_current->thread = pthread_self();
+    }
+    return s_current;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    static struct timespec start;
+    struct timespec now;
+
+    if (start.tv_sec == 0 && start.tv_nsec == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0) {
+        if (ticks == 0 || !host_wait(&task->cond, &task->lock, ticks, &deadline)) {
+            break;
+        }
+    }
+    uint32_t value = task->notify;
+    if (value > 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+size_t host_task_stack_used(TaskHandle_t task)
+{
+    if (!task) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    if (!task->stack_bottom) {
+        return 0;
+    }
+    const uint8_t *p = task->stack_bottom;
+    while (p < task->stack_top && *p == HOST_STACK_PAINT) {
+        p++;
+    }
+    return (size_t)(task->stack_top - p);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (!task) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    size_t used = host_task_stack_used(task);
+    return used < task->stack_size ? (UBaseType_t)(task->stack_size - used) : 0;
+}
+
+uint64_t host_task_cpu_ns(TaskHandle_t task)
+{
+    clockid_t clock;
+    struct timespec ts;
+
+    if (pthread_getcpuclockid(task->thread, &clock) != 0 || clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static QueueHandle_t host_queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count)
+{
+    struct host_queue *queue = calloc(1, sizeof(*queue) + (size_t)length * item_size);
+    if (!queue) {
+        return NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    host_cond_init(&queue->not_empty);
+    host_cond_init(&queue->not_full);
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->count = count;
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return host_queue_create(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (ticks == 0 || !host_wait(&queue->not_full, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    if (queue->item_size) {
+        size_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (ticks == 0 || !host_wait(&queue->not_empty, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    if (queue->item_size) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return host_queue_create(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return host_queue_create(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return host_queue_create(max, 0, initial);
+}
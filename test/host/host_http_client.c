@@ -0,0 +1,451 @@
+// Client HTTP/1.1 minimal sur sockets, même contrat qu'esp_http_client
+//
+// open() envoie la requête, fetch_headers() lit l'en-tête de la réponse
+// (un événement HTTP_EVENT_ON_HEADER par champ), read() remplit le tampon
+// jusqu'à la fin du corps ou une coupure. L'en-tête et le début du corps
+// sont reçus dans un tampon de HOST_HTTP_BUFFER_SIZE octets, la suite du
+// corps directement dans celui de l'appelant.
+#define _GNU_SOURCE
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static const char *TAG = "HOST_HTTP";
+
+#define HOST_HTTP_URL_SIZE 512
+#define HOST_HTTP_HEADERS 8
+#define HOST_HTTP_BUFFER_SIZE 8192
+#define HOST_HTTP_TCP_WINDOW 5760           // CONFIG_LWIP_TCP_WND_DEFAULT
+
+typedef struct {
+    char key[32];                       // Vide: emplacement libre
+    char value[128];
+} host_http_header_t;
+
+struct esp_http_client {
+    esp_http_client_config_t config;
+    char url[HOST_HTTP_URL_SIZE];
+    char location[HOST_HTTP_URL_SIZE];  // Location de la dernière réponse
+    host_http_header_t headers[HOST_HTTP_HEADERS];
+
+    int sock;                           // -1: pas de connexion
+    char peer[160];                     // hôte:port de la connexion ouverte
+    bool reusable;                      // Réponse précédente lue en entier, keep-alive
+
+    int status;
+    int64_t content_length;             // -1: inconnue, corps lu jusqu'à la fermeture
+    int64_t received;
+    bool close_after;                   // Connection: close dans la réponse
+    bool finished;                      // HTTP_EVENT_ON_FINISH envoyé
+    char buffer[HOST_HTTP_BUFFER_SIZE];
+    size_t buffer_len;
+    size_t buffer_pos;                  // Début du corps pas encore lu
+};
+
+static host_http_client_stats_t s_stats;
+
+static void host_http_event(esp_http_client_handle_t client, esp_http_client_event_id_t id,
+                            void *data, int len, char *key, char *value)
+{
+    if (client->config.event_handler) {
+        esp_http_client_event_t evt = {
+            .event_id = id, .client = client, .data = data, .data_len = len,
+            .user_data = client->config.user_data, .header_key = key, .header_value = value,
+        };
+        client->config.event_handler(&evt);
+    }
+}
+
+/**
+ * Découpe une URL http://hôte[:port]/chemin
+ */
+static esp_err_t host_http_parse_url(const char *url, char *host, size_t host_size, int *port,
+                                     const char **path)
+{
+    if (strncmp(url, "http://", 7) != 0) {
+        ESP_LOGE(TAG, "Unsupported URL: %s", url);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const char *start = url + 7;
+    const char *end = start + strcspn(start, ":/");
+    size_t len = end - start;
+    if (len == 0 || len >= host_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+
+    *port = 80;
+    if (*end == ':') {
+        *port = atoi(end + 1);
+        end += strcspn(end, "/");
+    }
+    *path = *end ? end : "/";
+    return ESP_OK;
+}
+
+static esp_err_t host_http_connect(esp_http_client_handle_t client, const char *host, int port)
+{
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addr;
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &addr) != 0) {
+        ESP_LOGE(TAG, "Cannot resolve %s", host);
+        return ESP_FAIL;
+    }
+
+    int sock = socket(addr->ai_family, addr->ai_socktype, 0);
+    int timeout_ms = client->config.timeout_ms > 0 ? client->config.timeout_ms : 5000;
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    int one = 1, window = HOST_HTTP_TCP_WINDOW;
+    // Fenêtre de réception de lwIP: un client lent freine l'envoi
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int ret = connect(sock, addr->ai_addr, addr->ai_addrlen);
+    freeaddrinfo(addr);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Cannot connect to %s:%d", host, port);
+        close(sock);
+        return ESP_FAIL;
+    }
+
+    client->sock = sock;
+    snprintf(client->peer, sizeof(client->peer), "%s:%d", host, port);
+    s_stats.connections++;
+    host_http_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t client = calloc(1, sizeof(*client));
+    if (client == NULL) {
+        return NULL;
+    }
+    client->config = *config;
+    client->sock = -1;
+    client->content_length = -1;
+    snprintf(client->url, sizeof(client->url), "%s", config->url);
+    return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    snprintf(client->url, sizeof(client->url), "%s", url);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    host_http_header_t *slot = NULL;
+    for (int i = 0; i < HOST_HTTP_HEADERS; i++) {
+        host_http_header_t *h = &client->headers[i];
+        if (strcasecmp(h->key, key) == 0) {
+            slot = h;
+            break;
+        }
+        if (h->key[0] == '\0' && slot == NULL) {
+            slot = h;
+        }
+    }
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    snprintf(slot->key, sizeof(slot->key), "%s", key);
+    snprintf(slot->value, sizeof(slot->value), "%s", value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    for (int i = 0; i < HOST_HTTP_HEADERS; i++) {
+        if (strcasecmp(client->headers[i].key, key) == 0) {
+            client->headers[i].key[0] = '\0';
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    char host[128];
+    int port;
+    const char *path;
+    esp_err_t err = host_http_parse_url(client->url, host, sizeof(host), &port, &path);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    char peer[sizeof(client->peer)];
+    snprintf(peer, sizeof(peer), "%s:%d", host, port);
+    if (client->sock >= 0 && (!client->reusable || strcmp(peer, client->peer) != 0)) {
+        esp_http_client_close(client);
+    }
+    if (client->sock < 0) {
+        err = host_http_connect(client, host, port);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    char request[1024];
+    int n = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\nConnection: %s\r\n",
+                     path, peer, client->config.user_agent ? client->config.user_agent : "ESP32 HTTP Client/1.0",
+                     client->config.keep_alive_enable ? "keep-alive" : "close");
+    for (int i = 0; i < HOST_HTTP_HEADERS && n < (int)sizeof(request); i++) {
+        if (client->headers[i].key[0] != '\0') {
+            n += snprintf(request + n, sizeof(request) - n, "%s: %s\r\n",
+                          client->headers[i].key, client->headers[i].value);
+        }
+    }
+    if (n < (int)sizeof(request)) {
+        n += snprintf(request + n, sizeof(request) - n, "\r\n");
+    }
+    if (n >= (int)sizeof(request)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (send(client->sock, request, n, MSG_NOSIGNAL) != n) {
+        esp_http_client_close(client);
+        return ESP_FAIL;
+    }
+
+    s_stats.requests++;
+    client->reusable = false;
+    client->status = 0;
+    client->content_length = -1;
+    client->received = 0;
+    client->close_after = !client->config.keep_alive_enable;
+    client->finished = false;
+    client->buffer_len = 0;
+    client->buffer_pos = 0;
+    client->location[0] = '\0';
+    host_http_event(client, HTTP_EVENT_HEADERS_SENT, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (client->sock < 0) {
+        return ESP_FAIL;
+    }
+
+    char *end;
+    while ((end = memmem(client->buffer, client->buffer_len, "\r\n\r\n", 4)) == NULL) {
+        if (client->buffer_len == sizeof(client->buffer)) {
+            ESP_LOGE(TAG, "Response header too large");
+            esp_http_client_close(client);
+            return ESP_FAIL;
+        }
+        ssize_t r = recv(client->sock, client->buffer + client->buffer_len,
+                         sizeof(client->buffer) - client->buffer_len, 0);
+        if (r <= 0) {
+            esp_http_client_close(client);
+            return ESP_FAIL;
+        }
+        client->buffer_len += r;
+    }
+    client->buffer_pos = end + 4 - client->buffer;
+    *end = '\0';
+
+    if (sscanf(client->buffer, "HTTP/1.%*d %d", &client->status) != 1) {
+        ESP_LOGE(TAG, "Invalid status line");
+        esp_http_client_close(client);
+        return ESP_FAIL;
+    }
+
+    // Champs de l'en-tête, après la ligne de statut
+    char *line = strstr(client->buffer, "\r\n");
+    while (line != NULL) {
+        line += 2;
+        char *next = strstr(line, "\r\n");
+        if (next != NULL) {
+            *next = '\0';
+        }
+        char *colon = strchr(line, ':');
+        if (colon != NULL) {
+            *colon = '\0';
+            char *value = colon + 1 + strspn(colon + 1, " \t");
+            if (strcasecmp(line, "Content-Length") == 0) {
+                client->content_length = strtoll(value, NULL, 10);
+            } else if (strcasecmp(line, "Location") == 0) {
+                snprintf(client->location, sizeof(client->location), "%s", value);
+            } else if (strcasecmp(line, "Connection") == 0 && strcasecmp(value, "close") == 0) {
+                client->close_after = true;
+            }
+            host_http_event(client, HTTP_EVENT_ON_HEADER, NULL, 0, line, value);
+        }
+        line = next;
+    }
+    return client->content_length;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client->content_length;
+}
+
+/**
+ * Lit le corps jusqu'à len octets, sa fin ou une coupure
+ * @return Octets lus, -1 si la connexion est perdue avant tout octet
+ */
+static int host_http_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    int got = 0;
+    while (got < len) {
+        int64_t left = client->content_length < 0 ? len - got : client->content_length - client->received;
+        if (left == 0) {
+            break;
+        }
+        size_t want = left < len - got ? (size_t)left : (size_t)(len - got);
+
+        ssize_t r;
+        if (client->buffer_pos < client->buffer_len) {
+            r = client->buffer_len - client->buffer_pos < want ? client->buffer_len - client->buffer_pos : want;
+            memcpy(buffer + got, client->buffer + client->buffer_pos, r);
+            client->buffer_pos += r;
+        } else if (client->sock >= 0) {
+            r = recv(client->sock, buffer + got, want, 0);
+        } else {
+            r = -1;
+        }
+
+        if (r <= 0) {
+            bool body_end = r == 0 && client->content_length < 0;
+            esp_http_client_close(client);
+            if (!body_end && got == 0) {
+                return -1;
+            }
+            break;
+        }
+        client->received += r;
+        got += r;
+    }
+
+    if (got > 0) {
+        s_stats.body_bytes += got;
+        host_http_event(client, HTTP_EVENT_ON_DATA, buffer, got, NULL, NULL);
+    }
+    if (!client->finished && esp_http_client_is_complete_data_received(client)) {
+        client->finished = true;
+        client->reusable = client->sock >= 0 && !client->close_after;
+        host_http_event(client, HTTP_EVENT_ON_FINISH, NULL, 0, NULL, NULL);
+    }
+    return got;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    s_stats.reads++;
+    return host_http_read(client, buffer, len);
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    return client->content_length >= 0 && client->received == client->content_length;
+}
+
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client, int *len)
+{
+    char discard[1024];
+    int total = 0, r;
+    while ((r = host_http_read(client, discard, sizeof(discard))) > 0) {
+        total += r;
+    }
+    if (len) {
+        *len = total;
+    }
+    return r < 0 ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client)
+{
+    if (client->location[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (client->location[0] == '/') {
+        // Chemin seul: même serveur
+        char host[128];
+        int port;
+        const char *path;
+        esp_err_t err = host_http_parse_url(client->url, host, sizeof(host), &port, &path);
+        if (err != ESP_OK) {
+            return err;
+        }
+        size_t prefix = path - client->url;
+        if (prefix + strlen(client->location) >= sizeof(client->url)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        strcpy(client->url + prefix, client->location);
+    } else {
+        snprintf(client->url, sizeof(client->url), "%s", client->location);
+    }
+    host_http_event(client, HTTP_EVENT_REDIRECT, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    esp_http_client_fetch_headers(client);
+    if (client->status == 0) {
+        return ESP_FAIL;
+    }
+
+    char data[1024];
+    int r;
+    while ((r = esp_http_client_read(client, data, sizeof(data))) > 0) {
+    }
+    return r < 0 ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (client->sock >= 0) {
+        close(client->sock);
+        client->sock = -1;
+        client->reusable = false;
+        host_http_event(client, HTTP_EVENT_DISCONNECTED, NULL, 0, NULL, NULL);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    esp_http_client_close(client);
+    free(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_crt_bundle_attach(void *conf)
+{
+    return ESP_OK;
+}
+
+void host_http_client_get_stats(host_http_client_stats_t *stats)
+{
+    *stats = s_stats;
+}
@@ -0,0 +1,234 @@
+// Implémentation hôte du sous-ensemble d'esp_http_server utilisé par les composants web
+#include "host_httpd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static host_httpd_t *host_of(httpd_req_t *req)
+{
+    return req->aux;
+}
+
+void host_httpd_req_init(httpd_req_t *req, host_httpd_t *host, const char *uri, const char *body)
+{
+    memset(req, 0, sizeof(*req));
+    memset(host, 0, sizeof(*host));
+    snprintf(req->uri, sizeof(req->uri), "%s", uri);
+    req->aux = host;
+    req->handle = host;             // Une "session" par requête simulée
+    host->sockfd = -1;
+    strcpy(host->status, "200 OK");
+    if (body) {
+        host->body = body;
+        host->body_len = strlen(body);
+        req->content_len = host->body_len;
+    }
+}
+
+void host_httpd_add_header(host_httpd_t *host, const char *field, const char *value)
+{
+    for (int i = 0; i < HOST_HTTPD_MAX_HEADERS; i++) {
+        if (!host->headers[i][0]) {
+            host->headers[i][0] = field;
+            host->headers[i][1] = value;
+            return;
+        }
+    }
+    fprintf(stderr, "host_httpd: too many headers\n");
+    abort();
+}
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len)
+{
+    host_httpd_t *host = host_of(req);
+    host->recv_calls++;
+
+    if (host->stalled) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    if (host->timeouts_left > 0) {
+        host->timeouts_left--;
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+
+    size_t remaining = host->body_len - host->body_off;
+    if (remaining == 0) {
+        return 0;
+    }
+    size_t n = buf_len < remaining ? buf_len : remaining;
+    if (host->max_segment > 0) {
+        size_t segment = 1 + (size_t)rand_r(&host->seed) % host->max_segment;
+        n = n < segment ? n : segment;
+    }
+    memcpy(buf, host->body + host->body_off, n);
+    host->body_off += n;
+    host->timeouts_left = host->timeouts_per_segment;
+    return (int)n;
+}
+
+static const char *host_header(httpd_req_t *req, const char *field)
+{
+    host_httpd_t *host = host_of(req);
+    for (int i = 0; i < HOST_HTTPD_MAX_HEADERS && host->headers[i][0]; i++) {
+        if (strcasecmp(host->headers[i][0], field) == 0) {
+            return host->headers[i][1];
+        }
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *req, const char *field)
+{
+    const char *value = host_header(req, field);
+    return value ? strlen(value) : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size)
+{
+    const char *value = host_header(req, field);
+    if (!value) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    snprintf(val, val_size, "%s", value);
+    return strlen(value) < val_size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status)
+{
+    snprintf(host_of(req)->status, sizeof(host_of(req)->status), "%s", status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    snprintf(host_of(req)->type, sizeof(host_of(req)->type), "%s", type);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value)
+{
+    host_httpd_t *host = host_of(req);
+    for (int i = 0; i < HOST_HTTPD_MAX_HEADERS; i++) {
+        if (!host->resp_headers[i][0]) {
+            host->resp_headers[i][0] = field;
+            host->resp_headers[i][1] = value;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_HTTPD_RESP_HDR;
+}
+
+const char *host_httpd_resp_header(const host_httpd_t *host, const char *field)
+{
+    for (int i = 0; i < HOST_HTTPD_MAX_HEADERS && host->resp_headers[i][0]; i++) {
+        if (strcasecmp(host->resp_headers[i][0], field) == 0) {
+            return host->resp_headers[i][1];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t host_append(host_httpd_t *host, const char *buf, size_t len)
+{
+    if (host->response_len + len > sizeof(host->response)) {
+        return ESP_FAIL;
+    }
+    memcpy(host->response + host->response_len, buf, len);
+    host->response_len += len;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+    host_httpd_t *host = host_of(req);
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = (ssize_t)strlen(buf);
+    }
+    host->sends++;
+    return host_append(host, buf, (size_t)buf_len);
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+    host_httpd_t *host = host_of(req);
+    if (buf == NULL || buf_len == 0) {
+        host->chunked_done = true;
+        return ESP_OK;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = (ssize_t)strlen(buf);
+    }
+    host->chunks++;
+    return host_append(host, buf, (size_t)buf_len);
+}
+
+esp_err_t httpd_resp_send_404(httpd_req_t *req)
+{
+    httpd_resp_set_status(req, "404 Not Found");
+    return httpd_resp_sendstr(req, "Nothing matches the given URI");
+}
+
+esp_err_t httpd_resp_send_500(httpd_req_t *req)
+{
+    httpd_resp_set_status(req, "500 Internal Server Error");
+    return httpd_resp_sendstr(req, "Internal Server Error");
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r)
+{
+    return host_of(r)->sockfd;
+}
+
+esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func)
+{
+    host_httpd_t *host = hd;
+    if (host->sockfd != sockfd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host->send_override = send_func;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
+{
+    httpd_req_t *copy = malloc(sizeof(*copy));
+    if (!copy) {
+        return ESP_ERR_NO_MEM;
+    }
+    *copy = *r;
+    host_of(r)->async_begun++;
+    *out = copy;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r)
+{
+    host_httpd_t *host = host_of(r);
+    free(r);
+    if (host->on_async_complete) {
+        host->on_async_complete(host);
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    return ESP_OK;
+}
+
+// Sous-ensemble de la fonction d'ESP-IDF: chemin exact ou préfixe terminé par '*'
+bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match, size_t match_upto)
+{
+    size_t len = strlen(uri_template);
+    if (len > 0 && uri_template[len - 1] == '*') {
+        return match_upto >= len - 1 && strncmp(uri_template, uri_to_match, len - 1) == 0;
+    }
+    return len == match_upto && strncmp(uri_template, uri_to_match, len) == 0;
+}
+
+const char *http_method_str(enum http_method m)
+{
+    static const char *names[] = { "DELETE", "GET", "HEAD", "POST", "PUT" };
+    return (unsigned)m < sizeof(names) / sizeof(names[0]) ? names[m] : "<unknown>";
+}
@@ -0,0 +1,62 @@
+// Requêtes HTTP simulées pour le stub esp_http_server (host_httpd.c)
+//
+// Le corps est livré par segments de taille aléatoire (1 à max_segment octets,
+// graine seed), éventuellement précédés de timeouts; la réponse est capturée
+// sans allocation.
+#ifndef HOST_HTTPD_H
+#define HOST_HTTPD_H
+
+#include "esp_http_server.h"
+#include <stdint.h>
+
+#define HOST_HTTPD_MAX_HEADERS 8
+#define HOST_HTTPD_RESPONSE_SIZE 16384
+
+typedef struct host_httpd host_httpd_t;
+
+struct host_httpd {
+    // Requête
+    const char *headers[HOST_HTTPD_MAX_HEADERS][2];
+    const char *body;
+    size_t body_len;
+    size_t body_off;
+    size_t max_segment;             // 0: tout ce qui est demandé
+    unsigned int seed;
+    int timeouts_per_segment;       // HTTPD_SOCK_ERR_TIMEOUT renvoyés avant chaque segment
+    int timeouts_left;
+    bool stalled;                   // Plus aucune donnée: timeouts indéfiniment
+    int recv_calls;
+    int sockfd;                     // httpd_req_to_sockfd (-1 par défaut)
+    httpd_send_func_t send_override;    // httpd_sess_set_send_override
+
+    // Réponse
+    char status[32];
+    char type[48];
+    const char *resp_headers[HOST_HTTPD_MAX_HEADERS][2];   // httpd_resp_set_hdr (chaînes de l'appelant)
+    char response[HOST_HTTPD_RESPONSE_SIZE];
+    size_t response_len;
+    int sends;                      // httpd_resp_send
+    int chunks;                     // httpd_resp_send_chunk avec données
+    bool chunked_done;              // Chunk final (NULL, 0) reçu
+
+    // Requêtes asynchrones: copie allouée par httpd_req_async_handler_begin
+    int async_begun;
+    void (*on_async_complete)(host_httpd_t *host);  // Appelé par httpd_req_async_handler_complete
+};
+
+/**
+ * Prépare une requête sur uri, avec un corps éventuel (NULL pour aucun)
+ */
+void host_httpd_req_init(httpd_req_t *req, host_httpd_t *host, const char *uri, const char *body);
+
+/**
+ * Ajoute un en-tête de requête (chaînes conservées par l'appelant)
+ */
+void host_httpd_add_header(host_httpd_t *host, const char *field, const char *value);
+
+/**
+ * Valeur d'un en-tête de réponse (NULL si absent)
+ */
+const char *host_httpd_resp_header(const host_httpd_t *host, const char *field);
+
+#endif // HOST_HTTPD_H
@@ -0,0 +1,51 @@
+// SHA-256 de mbedTLS sur la libcrypto d'OpenSSL
+#include "mbedtls/sha256.h"
+#include <openssl/evp.h>
+#include <stdlib.h>
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    ctx->md = NULL;
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    EVP_MD_CTX_free(ctx->md);
+    ctx->md = NULL;
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src)
+{
+    if (!dst->md) {
+        dst->md = EVP_MD_CTX_new();
+    }
+    if (!dst->md || !EVP_MD_CTX_copy_ex(dst->md, src->md)) {
+        abort();
+    }
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    if (!ctx->md) {
+        ctx->md = EVP_MD_CTX_new();
+    }
+    if (!ctx->md) {
+        return -1;
+    }
+    return EVP_DigestInit_ex(ctx->md, is224 ? EVP_sha224() : EVP_sha256(), NULL) ? 0 : -1;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen)
+{
+    return EVP_DigestUpdate(ctx->md, input, ilen) ? 0 : -1;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char *output)
+{
+    return EVP_DigestFinal_ex(ctx->md, output, NULL) ? 0 : -1;
+}
+
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char *output, int is224)
+{
+    return EVP_Digest(input, ilen, output, NULL, is224 ? EVP_sha224() : EVP_sha256(), NULL) ? 0 : -1;
+}
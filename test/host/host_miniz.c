@@ -0,0 +1,74 @@
+// tinfl (miniz de la ROM) sur zlib
+//
+// zlib garde sa propre fenêtre: la sortie peut être écrite n'importe où, le
+// tampon circulaire de l'appelant n'a pas à contenir l'historique. Les
+// allocations de zlib sont prises dans m_host, sans libération: l'arène
+// repart de zéro à chaque nouveau flux.
+#include "rom/miniz.h"
+#include <zlib.h>
+#include <stdlib.h>
+
+typedef struct {
+    z_stream stream;
+    size_t used;                        // Octets de l'arène déjà alloués
+    _Alignas(16) unsigned char arena[];
+} host_inflate_t;
+
+_Static_assert(sizeof(host_inflate_t) < TINFL_HOST_STATE_SIZE, "tinfl_decompressor too small");
+
+static voidpf host_inflate_alloc(voidpf opaque, uInt items, uInt size)
+{
+    host_inflate_t *h = opaque;
+    size_t len = ((size_t)items * size + 15) & ~(size_t)15;
+    if (len > TINFL_HOST_STATE_SIZE - sizeof(host_inflate_t) - h->used) {
+        return Z_NULL;
+    }
+    void *p = h->arena + h->used;
+    h->used += len;
+    return p;
+}
+
+static void host_inflate_free(voidpf opaque, voidpf address)
+{
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *pIn_buf_next, size_t *pIn_buf_size,
+                              mz_uint8 *pOut_buf_start, mz_uint8 *pOut_buf_next, size_t *pOut_buf_size,
+                              const mz_uint32 decomp_flags)
+{
+    host_inflate_t *h = (host_inflate_t *)r->m_host;
+
+    if (r->m_state == 0) {
+        h->used = 0;
+        h->stream = (z_stream){ .zalloc = host_inflate_alloc, .zfree = host_inflate_free, .opaque = h };
+        int bits = decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER ? MAX_WBITS : -MAX_WBITS;
+        if (inflateInit2(&h->stream, bits) != Z_OK) {
+            *pIn_buf_size = *pOut_buf_size = 0;
+            return TINFL_STATUS_BAD_PARAM;
+        }
+        r->m_state = 1;
+    }
+
+    size_t in_size = *pIn_buf_size, out_size = *pOut_buf_size;
+    h->stream.next_in = (Bytef *)pIn_buf_next;
+    h->stream.avail_in = (uInt)in_size;
+    h->stream.next_out = pOut_buf_next;
+    h->stream.avail_out = (uInt)out_size;
+
+    int ret = inflate(&h->stream, Z_NO_FLUSH);
+    *pIn_buf_size = in_size - h->stream.avail_in;
+    *pOut_buf_size = out_size - h->stream.avail_out;
+
+    if (ret == Z_STREAM_END) {
+        return TINFL_STATUS_DONE;
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        return TINFL_STATUS_FAILED;
+    }
+    if (h->stream.avail_out == 0) {
+        return TINFL_STATUS_HAS_MORE_OUTPUT;
+    }
+    // Entrée épuisée avant la fin du flux
+    return decomp_flags & TINFL_FLAG_HAS_MORE_INPUT ? TINFL_STATUS_NEEDS_MORE_INPUT :
+                                                      TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS;
+}
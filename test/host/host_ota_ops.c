@@ -0,0 +1,125 @@
+// Partitions OTA (app_update) sur la flash simulée
+//
+// La vérification de esp_ota_set_boot_partition() est celle du bootloader:
+// segments dans la partition, somme de contrôle des données et SHA-256 ajouté
+// à la fin de l'image.
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const char *TAG = "HOST_OTA";
+
+static const esp_partition_t **s_boot;     // Partagée avec les processus fils
+
+static const esp_partition_t **host_ota_boot(void)
+{
+    if (!s_boot) {
+        void *mem = mmap(NULL, sizeof(*s_boot), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("mmap");
+            abort();
+        }
+        s_boot = mem;
+    }
+    return s_boot;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return host_flash_partition(0);
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return host_flash_partition(1);
+}
+
+/**
+ * Longueur de l'image valide au début de la partition, 0 si elle est invalide
+ */
+static size_t host_ota_verify(const esp_partition_t *partition)
+{
+    const uint8_t *data = host_flash_data(partition);
+    const esp_image_header_t *header = (const esp_image_header_t *)data;
+    if (!data || header->magic != ESP_IMAGE_HEADER_MAGIC) {
+        return 0;
+    }
+
+    size_t pos = sizeof(esp_image_header_t);
+    uint8_t checksum = ESP_IMAGE_CHECKSUM_SEED;
+    for (int i = 0; i < header->segment_count; i++) {
+        esp_image_segment_header_t segment;
+        if (pos + sizeof(segment) > partition->size) {
+            return 0;
+        }
+        memcpy(&segment, data + pos, sizeof(segment));
+        pos += sizeof(segment);
+        if (segment.data_len > partition->size - pos) {
+            return 0;
+        }
+        for (uint32_t j = 0; j < segment.data_len; j++) {
+            checksum ^= data[pos + j];
+        }
+        pos += segment.data_len;
+    }
+
+    // Somme de contrôle dans le dernier octet d'un bloc de 16
+    size_t len = (pos + 16) & ~(size_t)15;
+    if (len + (header->hash_appended ? 32 : 0) > partition->size || data[len - 1] != checksum) {
+        return 0;
+    }
+    if (header->hash_appended) {
+        uint8_t digest[32];
+        mbedtls_sha256(data, len, digest, 0);
+        if (memcmp(digest, data + len, sizeof(digest)) != 0) {
+            return 0;
+        }
+        len += sizeof(digest);
+    }
+    return len;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    size_t len = host_ota_verify(partition);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Image in partition %s failed verification", partition->label);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    ESP_LOGI(TAG, "Boot partition set to %s (%zu byte image)", partition->label, len);
+    *host_ota_boot() = partition;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state)
+{
+    *ota_state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void)
+{
+    return ESP_OK;
+}
+
+const esp_app_desc_t *esp_app_get_description(void)
+{
+    static esp_app_desc_t desc;
+    const uint8_t *image = host_flash_data(esp_ota_get_running_partition());
+    memcpy(&desc, image + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(desc));
+    return &desc;
+}
+
+const esp_partition_t *host_ota_boot_partition(void)
+{
+    return *host_ota_boot();
+}
+
+void host_ota_reset_boot_partition(void)
+{
+    *host_ota_boot() = NULL;
+}
@@ -0,0 +1,23 @@
+// strlcpy de newlib (ESP-IDF), absente de la glibc avant 2.38: incluse d'office
+// dans chaque source (-include) quand la bibliothèque C ne la fournit pas.
+// Aucun en-tête de la libc ici: les sources définissent _GNU_SOURCE avant les leurs.
+#ifndef HOST_STRLCPY_H
+#define HOST_STRLCPY_H
+
+#include <stddef.h>
+
+static inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = 0;
+    for (; src[len]; len++) {
+        if (len + 1 < size) {
+            dst[len] = src[len];
+        }
+    }
+    if (size) {
+        dst[len < size ? len : size - 1] = '\0';
+    }
+    return len;
+}
+
+#endif // HOST_STRLCPY_H
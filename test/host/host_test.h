@@ -0,0 +1,84 @@
+// Assertions et mesure du temps communes aux tests hôte
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int host_test_failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) do { \
+        long long check_a_ = (long long)(a), check_b_ = (long long)(b); \
+        if (check_a_ != check_b_) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s == %s (%lld != %lld)\n", \
+                    __FILE__, __LINE__, #a, #b, check_a_, check_b_); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+// Code de sortie pour ctest
+#define HOST_TEST_RESULT() (host_test_failures == 0 ? 0 : 1)
+
+static inline uint64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Décode une chaîne hexadécimale (sans séparateurs) dans out
+ * Retourne le nombre d'octets écrits, 0 si la chaîne est invalide ou trop longue
+ */
+static inline size_t host_hex_decode(const char *hex, uint8_t *out, size_t size)
+{
+    size_t n = 0;
+    while (hex[0] && hex[1] && hex[0] != '\n') {
+        unsigned int byte;
+        if (n == size || sscanf(hex, "%2x", &byte) != 1) {
+            return 0;
+        }
+        out[n++] = (uint8_t)byte;
+        hex += 2;
+    }
+    return n;
+}
+
+/**
+ * Lit un fichier entier dans un tampon alloué (à libérer par free)
+ * Retourne NULL, message affiché, si le fichier ne peut pas être lu
+ */
+static inline uint8_t *host_read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long size = -1;
+    if (f && fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc(size > 0 ? size : 1);
+        if (data && fread(data, 1, size, f) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    if (f) {
+        fclose(f);
+    }
+    if (!data) {
+        perror(path);
+        return NULL;
+    }
+    *len = (size_t)size;
+    return data;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,363 @@
+// json_writer: sortie exacte (échappements, entiers extrêmes, découpage en
+// chunks HTTP) puis comparaison avec cJSON sur les réponses /api/status et
+// /api/scan telles que les construisait l'ancien code (arbre cJSON + cJSON_Print)
+//
+// Les allocations sont comptées par --wrap=malloc/calloc/realloc/free. La
+// comparaison avec cJSON n'est compilée que si ses sources sont trouvées
+// (MINIOT_HOST_CJSON_DIR, par défaut celles d'ESP-IDF).
+//
+// Usage: json_writer_bench [réponses par mesure]
+#include "json_writer.h"
+#include "host_httpd.h"
+#include "host_test.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+// Compteurs d'allocations de tout le programme
+static long s_allocs;
+static long s_frees;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    s_allocs++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    s_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr) {
+        s_frees++;
+    }
+    __real_free(ptr);
+}
+
+// Sortie en mémoire, comme le buffer d'envoi du socket
+typedef struct {
+    char data[4096];
+    size_t len;
+    int calls;
+    bool fail;
+} sink_t;
+
+static esp_err_t sink_flush(void *ctx, const char *data, size_t len)
+{
+    sink_t *sink = ctx;
+    sink->calls++;
+    if (sink->fail || sink->len + len > sizeof(sink->data)) {
+        return ESP_FAIL;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    return ESP_OK;
+}
+
+static void check_output(sink_t *sink, json_writer_t *w, const char *expected)
+{
+    CHECK_EQ(json_writer_finish(w), ESP_OK);
+    sink->data[sink->len] = '\0';
+    if (strcmp(sink->data, expected) != 0) {
+        fprintf(stderr, "got      %s\nexpected %s\n", sink->data, expected);
+        host_test_failures++;
+    }
+}
+
+static void test_output(void)
+{
+    json_writer_t w;
+    sink_t sink = {0};
+
+    // Séparateurs, échappements et valeurs
+    json_writer_init(&w, sink_flush, &sink);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "a\"b", "x\x01\n\r\t\\/\x7f" "é");
+    json_writer_kv_string(&w, "null", NULL);
+    json_writer_key(&w, "ints");
+    json_writer_begin_array(&w);
+    json_writer_int(&w, 0);
+    json_writer_int(&w, -1);
+    json_writer_int(&w, INT64_MAX);
+    json_writer_int(&w, INT64_MIN);
+    json_writer_end_array(&w);
+    json_writer_key(&w, "nested");
+    json_writer_begin_array(&w);
+    json_writer_begin_object(&w);
+    json_writer_end_object(&w);
+    json_writer_begin_array(&w);
+    json_writer_end_array(&w);
+    json_writer_bool(&w, true);
+    json_writer_bool(&w, false);
+    json_writer_end_array(&w);
+    json_writer_key(&w, "fragment");
+    json_writer_fragment(&w, "{\"cached\":1}", 12);
+    json_writer_kv_bool(&w, "last", true);
+    json_writer_end_object(&w);
+    check_output(&sink, &w,
+                 "{\"a\\\"b\":\"x\\u0001\\n\\r\\t\\\\/\x7f" "é\",\"null\":null,"
+                 "\"ints\":[0,-1,9223372036854775807,-9223372036854775808],"
+                 "\"nested\":[{},[],true,false],\"fragment\":{\"cached\":1},\"last\":true}");
+    CHECK_EQ(sink.calls, 1);
+
+    // Plus grand que le buffer: plusieurs vidages, même contenu
+    memset(&sink, 0, sizeof(sink));
+    json_writer_init(&w, sink_flush, &sink);
+    json_writer_begin_array(&w);
+    for (int i = 0; i < 100; i++) {
+        json_writer_int(&w, i * -123456789012LL);
+    }
+    json_writer_end_array(&w);
+    CHECK_EQ(json_writer_finish(&w), ESP_OK);
+    CHECK(sink.calls > 1);
+    CHECK(sink.len > JSON_WRITER_BUFFER_SIZE);
+    CHECK_EQ(sink.data[0], '[');
+    CHECK_EQ(sink.data[sink.len - 1], ']');
+    CHECK(memcmp(sink.data + 1, "0,-123456789012,-246913578024,", 30) == 0);
+
+    // Erreur de sortie: conservée, plus aucun appel
+    memset(&sink, 0, sizeof(sink));
+    sink.fail = true;
+    json_writer_init(&w, sink_flush, &sink);
+    for (int i = 0; i < 200; i++) {
+        json_writer_string(&w, "0123456789");
+    }
+    CHECK_EQ(json_writer_finish(&w), ESP_FAIL);
+    CHECK_EQ(sink.calls, 1);
+}
+
+static void test_http(void)
+{
+    httpd_req_t req;
+    host_httpd_t host;
+    json_writer_t w;
+
+    // Petite réponse: un seul httpd_resp_send (Content-Length)
+    host_httpd_req_init(&req, &host, "/api/status", NULL);
+    json_writer_init_http(&w, &req);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "state", "Connected");
+    json_writer_end_object(&w);
+    CHECK_EQ(json_writer_finish(&w), ESP_OK);
+    CHECK_EQ(host.sends, 1);
+    CHECK_EQ(host.chunks, 0);
+    CHECK(strcmp(host.type, "application/json") == 0);
+    CHECK_EQ(host.response_len, 21);
+
+    // Grande réponse: chunks puis chunk final
+    host_httpd_req_init(&req, &host, "/api/scan", NULL);
+    json_writer_init_http(&w, &req);
+    json_writer_begin_array(&w);
+    for (int i = 0; i < 100; i++) {
+        json_writer_string(&w, "network");
+    }
+    json_writer_end_array(&w);
+    CHECK_EQ(json_writer_finish(&w), ESP_OK);
+    CHECK_EQ(host.sends, 0);
+    CHECK(host.chunks >= 4);
+    CHECK(host.chunked_done);
+    CHECK_EQ(host.response_len, 2 + 100 * 9 + 99);
+}
+
+// Données représentatives: l'AP du device et un scan de 20 réseaux
+#define SCAN_COUNT 20
+
+typedef struct {
+    const char *ssid;
+    int rssi;
+    bool auth;
+} network_t;
+
+static const network_t s_networks[SCAN_COUNT] = {
+    {"Livebox-3A1F", -41, true}, {"FreeWifi_secure", -48, true}, {"SFR_8C20", -52, true},
+    {"Bbox-71E2D4C1", -55, true}, {"FreeWifi", -57, false}, {"DIRECT-4B-HP OfficeJet", -60, true},
+    {"Maison", -62, true}, {"Livebox-Guest", -66, false}, {"iPhone de Camille", -67, true},
+    {"orange", -70, false}, {"NETGEAR42", -71, true}, {"TP-Link_5G_B7C1", -73, true},
+    {"Galaxy A52 7F3D", -75, true}, {"SFR WiFi FON", -78, false}, {"Freebox-9A4C2E", -80, true},
+    {"AndroidAP", -82, true}, {"Bouygues Telecom Wi-Fi", -84, false}, {"ESP_3C71BF", -86, false},
+    {"Chromecast1234.b", -88, false}, {"Atelier", -90, true},
+};
+
+static void writer_status(json_writer_t *w)
+{
+    json_writer_begin_object(w);
+    json_writer_kv_string(w, "mac", "84:F7:03:12:AB:CD");
+    json_writer_kv_string(w, "state", "Connected");
+    json_writer_kv_string(w, "ip", "192.168.1.42");
+    json_writer_end_object(w);
+}
+
+static void writer_scan(json_writer_t *w)
+{
+    json_writer_begin_object(w);
+    json_writer_key(w, "networks");
+    json_writer_begin_array(w);
+    for (int i = 0; i < SCAN_COUNT; i++) {
+        json_writer_begin_object(w);
+        json_writer_kv_string(w, "ssid", s_networks[i].ssid);
+        json_writer_kv_int(w, "rssi", s_networks[i].rssi);
+        json_writer_kv_bool(w, "auth", s_networks[i].auth);
+        json_writer_end_object(w);
+    }
+    json_writer_end_array(w);
+    json_writer_kv_int(w, "count", SCAN_COUNT);
+    json_writer_end_object(w);
+}
+
+typedef struct {
+    double ns;
+    double cycles;                  // Ticks TSC (0 hors x86)
+    double allocs;
+    size_t bytes;
+} result_t;
+
+static uint64_t s_checksum;
+
+static inline uint64_t cycles_now(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static result_t bench_writer(void (*build)(json_writer_t *), long iterations)
+{
+    sink_t sink = {0};
+    json_writer_t w;
+    result_t r = {0};
+
+    long allocs = s_allocs;
+    uint64_t start = host_now_ns();
+    uint64_t start_cycles = cycles_now();
+    for (long i = 0; i < iterations; i++) {
+        sink.len = 0;
+        json_writer_init(&w, sink_flush, &sink);
+        build(&w);
+        json_writer_finish(&w);
+        s_checksum += sink.len;
+    }
+    r.cycles = (double)(cycles_now() - start_cycles) / iterations;
+    r.ns = (double)(host_now_ns() - start) / iterations;
+    r.allocs = (double)(s_allocs - allocs) / iterations;
+    r.bytes = sink.len;
+    return r;
+}
+
+#ifdef HAVE_CJSON
+static cJSON *cjson_status(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "mac", "84:F7:03:12:AB:CD");
+    cJSON_AddStringToObject(root, "state", "Connected");
+    cJSON_AddStringToObject(root, "ip", "192.168.1.42");
+    return root;
+}
+
+static cJSON *cjson_scan(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *networks = cJSON_CreateArray();
+    for (int i = 0; i < SCAN_COUNT; i++) {
+        cJSON *network = cJSON_CreateObject();
+        cJSON_AddStringToObject(network, "ssid", s_networks[i].ssid);
+        cJSON_AddNumberToObject(network, "rssi", s_networks[i].rssi);
+        cJSON_AddBoolToObject(network, "auth", s_networks[i].auth);
+        cJSON_AddItemToArray(networks, network);
+    }
+    cJSON_AddItemToObject(root, "networks", networks);
+    cJSON_AddNumberToObject(root, "count", SCAN_COUNT);
+    return root;
+}
+
+static result_t bench_cjson(cJSON *(*build)(void), bool formatted, long iterations)
+{
+    sink_t sink = {0};
+    result_t r = {0};
+
+    long allocs = s_allocs;
+    uint64_t start = host_now_ns();
+    uint64_t start_cycles = cycles_now();
+    for (long i = 0; i < iterations; i++) {
+        cJSON *root = build();
+        char *json = formatted ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+        sink.len = 0;
+        sink_flush(&sink, json, strlen(json));
+        s_checksum += sink.len;
+        free(json);
+        cJSON_Delete(root);
+    }
+    r.cycles = (double)(cycles_now() - start_cycles) / iterations;
+    r.ns = (double)(host_now_ns() - start) / iterations;
+    r.allocs = (double)(s_allocs - allocs) / iterations;
+    r.bytes = sink.len;
+    return r;
+}
+#endif
+
+static void print_result(const char *name, result_t r)
+{
+    printf("  %-30s %7.0f ns  %8.0f cycles  %5.1f allocs  %5zu bytes\n",
+           name, r.ns, r.cycles, r.allocs, r.bytes);
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+
+    test_output();
+    test_http();
+
+    long frees = s_frees;
+    result_t status = bench_writer(writer_status, iterations);
+    result_t scan = bench_writer(writer_scan, iterations / 10);
+    CHECK_EQ(status.allocs, 0);
+    CHECK_EQ(scan.allocs, 0);
+    CHECK_EQ(s_frees, frees);
+
+    printf("Responses as built by the handlers (%ld status, %ld scan with %d networks)\n",
+           iterations, iterations / 10, SCAN_COUNT);
+    printf("/api/status\n");
+    print_result("json_writer", status);
+#ifdef HAVE_CJSON
+    result_t status_pretty = bench_cjson(cjson_status, true, iterations);
+    print_result("cJSON tree + cJSON_Print", status_pretty);
+    print_result("cJSON tree + PrintUnformatted", bench_cjson(cjson_status, false, iterations));
+#endif
+    printf("/api/scan\n");
+    print_result("json_writer", scan);
+#ifdef HAVE_CJSON
+    result_t scan_pretty = bench_cjson(cjson_scan, true, iterations / 10);
+    print_result("cJSON tree + cJSON_Print", scan_pretty);
+    print_result("cJSON tree + PrintUnformatted", bench_cjson(cjson_scan, false, iterations / 10));
+    CHECK(status_pretty.allocs > 0);
+    CHECK(scan.bytes < scan_pretty.bytes);
+#else
+    printf("(cJSON sources not found: set MINIOT_HOST_CJSON_DIR to compare)\n");
+#endif
+
+    return HOST_TEST_RESULT();
+}
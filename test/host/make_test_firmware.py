@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Images de firmware synthétiques pour les tests OTA sur l'hôte
+
+Deux versions d'une même application au format des images ESP-IDF (en-tête,
+premier segment, description de l'app, somme de contrôle et SHA-256), acceptées
+par ota_manager et par la vérification de esp_ota_set_boot_partition():
+- l'ancienne: des fonctions qui se référencent par adresses absolues (pools
+  de littéraux), suivies de chaînes
+- la nouvelle: une fonction ajoutée au milieu, ce qui décale toutes les
+  adresses suivantes comme une recompilation, une constante modifiée et la
+  version changée
+
+Le contenu est déterministe: tailles de patch et taux de compression mesurés
+par les tests sont reproductibles.
+
+Usage: make_test_firmware.py <ancien.bin> <nouveau.bin>
+"""
+
+import functools
+import hashlib
+import itertools
+import operator
+import random
+import struct
+import sys
+
+PROJECT = b'miniot'
+CHIP_ID = 9             # ESP32-S3, CONFIG_IDF_FIRMWARE_CHIP_ID
+LOAD_ADDR = 0x42000020  # Adresse du code en flash mappée
+FUNCTIONS = 1200
+STRINGS = 800
+INSN_WORDS = 400        # Vocabulaire d'instructions (2 ou 3 octets)
+LITERAL_EVERY = 48      # Octets de code entre deux adresses absolues
+WORDS = ('wifi', 'ota', 'http', 'dns', 'scan', 'config', 'failed', 'start', 'stop',
+         'client', 'server', 'update', 'partition', 'timeout', 'invalid', 'bytes')
+
+
+def make_functions(rng, count):
+    words = [bytes(rng.randrange(256) for _ in range(rng.choice((2, 3))))
+             for _ in range(INSN_WORDS)]
+    cum_weights = list(itertools.accumulate(1.0 / (i + 1) for i in range(INSN_WORDS)))
+    functions = []
+    for _ in range(count):
+        size = rng.randrange(64, 512)
+        body = []                   # Octets, ou ('fn', index) / ('str', index)
+        since_literal = 0
+        while len(body) < size:
+            if since_literal >= LITERAL_EVERY:
+                kind = 'fn' if rng.random() < 0.7 else 'str'
+                body.append((kind, rng.randrange(FUNCTIONS if kind == 'fn' else STRINGS)))
+                since_literal = 0
+            else:
+                word = rng.choices(words, cum_weights=cum_weights)[0]
+                body.extend(word)
+                since_literal += len(word)
+        functions.append(body)
+    return functions
+
+
+def make_strings(rng):
+    return [(' '.join(rng.choice(WORDS) for _ in range(rng.randrange(2, 7)))).encode() + b'\0'
+            for _ in range(STRINGS)]
+
+
+def link(functions, order, strings):
+    """Place les fonctions dans l'ordre donné puis les chaînes, et résout les adresses"""
+    addr = LOAD_ADDR
+    fn_addr = {}
+    for index in order:
+        fn_addr[index] = addr
+        addr += sum(4 if isinstance(x, tuple) else 1 for x in functions[index])
+    str_addr = []
+    for s in strings:
+        str_addr.append(addr)
+        addr += len(s)
+
+    code = bytearray()
+    for index in order:
+        for x in functions[index]:
+            if isinstance(x, tuple):
+                kind, target = x
+                code += struct.pack('<I', (fn_addr if kind == 'fn' else str_addr)[target])
+            else:
+                code.append(x)
+    return bytes(code) + b''.join(strings)
+
+
+def image(version, payload):
+    desc = struct.pack('<II8x32s32s16s16s32s32s', 0xABCD5432, 0, version, PROJECT,
+                       b'00:00:00', b'Jan  1 2025', b'v5.3', bytes(32))
+    desc += bytes(256 - len(desc))
+    segment = desc + payload
+    segment += bytes(-len(segment) % 4)
+    header = struct.pack('<BBBBIB3sHBHH4sB', 0xE9, 1, 2, 0x2F, LOAD_ADDR, 0xEE, bytes(3),
+                         CHIP_ID, 0, 0, 0xFFFF, bytes(4), 1)
+    data = header + struct.pack('<II', LOAD_ADDR, len(segment)) + segment
+
+    # Comme esptool: somme de contrôle dans le dernier octet d'un bloc de 16,
+    # puis SHA-256 de tout ce qui précède (hash_appended)
+    checksum = functools.reduce(operator.xor, segment, 0xEF)
+    data += bytes(15 - len(data) % 16) + bytes([checksum])
+    return data + hashlib.sha256(data).digest()
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    rng = random.Random(2025)
+    functions = make_functions(rng, FUNCTIONS)
+    strings = make_strings(rng)
+    order = list(range(FUNCTIONS))
+    old = image(b'v1.0.0', link(functions, order, strings))
+
+    # Nouvelle version: fonction insérée, constante modifiée, une chaîne de plus
+    functions += make_functions(random.Random(7), 1)
+    order.insert(FUNCTIONS // 2, FUNCTIONS)
+    functions[100] = functions[100][:20] + list(b'\x12\x34\x56') + functions[100][23:]
+    strings = strings + [b'ota resumed\0']
+    new = image(b'v1.0.1', link(functions, order, strings))
+
+    with open(sys.argv[1], 'wb') as f:
+        f.write(old)
+    with open(sys.argv[2], 'wb') as f:
+        f.write(new)
+    print('Firmware images: %d and %d bytes' % (len(old), len(new)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
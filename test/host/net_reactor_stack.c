@@ -0,0 +1,95 @@
+// Pic d'utilisation de la pile de la tâche du reactor avec le serveur DNS
+//
+// Le corpus de requêtes est envoyé sur loopback au reactor réel (tous les
+// chemins du serveur: réponses, erreurs journalisées, limitation par client),
+// puis la pile utilisée par la tâche est relevée sur sa pile remplie d'un motif.
+// La mesure porte sur le code du reactor et des services compilé pour l'hôte:
+// sur la cible s'y ajoutent les appels lwIP (select/recvfrom/sendto), que le
+// rapport de net_reactor_log_usage() permet de vérifier.
+//
+// Usage: net_reactor_stack <corpus>
+#include "dns_server.c"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define REPLAY_TIMEOUT_MS 50
+
+static TaskHandle_t s_reactor_task;
+
+static void on_packet(net_reactor_packet_t *packet, void *ctx)
+{
+    s_reactor_task = xTaskGetCurrentTaskHandle();
+    dns_server_on_packet(packet, ctx);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <corpus>\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    socklen_t addr_len = sizeof(addr);
+    bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(sock, (struct sockaddr *)&addr, &addr_len);
+
+    dns_hot_cache_init();
+    CHECK_EQ(net_reactor_start(), ESP_OK);
+    CHECK_EQ(net_reactor_add_udp(sock, on_packet, NULL), ESP_OK);
+
+    int client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = REPLAY_TIMEOUT_MS * 1000 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    connect(client, (struct sockaddr *)&addr, sizeof(addr));
+
+    // Deux passes: la seconde, sans attendre les réponses, dépasse la rafale
+    // autorisée et passe par la limitation
+    char line[1200];
+    int sent = 0, answered = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        rewind(f);
+        while (fgets(line, sizeof(line), f)) {
+            char source[16], expect[16], hex[1100];
+            uint8_t query[DNS_MAX_PACKET_SIZE], reply[DNS_MAX_PACKET_SIZE];
+            if (line[0] == '#' || sscanf(line, "%15s %15s %1099s", source, expect, hex) != 3) {
+                continue;
+            }
+            size_t len = host_hex_decode(hex, query, sizeof(query));
+            send(client, query, len, 0);
+            sent++;
+            if (pass == 0 && strcmp(expect, "DROP") != 0 && recv(client, reply, sizeof(reply), 0) > 0) {
+                answered++;
+            }
+        }
+    }
+    fclose(f);
+    vTaskDelay(pdMS_TO_TICKS(REPLAY_TIMEOUT_MS));
+
+    CHECK(s_reactor_task != NULL);
+    CHECK(answered > 0);
+    CHECK(s_stats.rate_limited > 0);
+
+    net_reactor_remove_udp(sock);
+    close(sock);
+    close(client);
+
+    size_t used = host_task_stack_used(s_reactor_task);
+    printf("%d queries sent, %d answered, %u rate-limited\n", sent, answered, (unsigned)s_stats.rate_limited);
+    if (used == 0) {
+        printf("  stack tracking unavailable (sanitizer build)\n");
+    } else {
+        printf("  reactor task stack: %zu bytes used of %d (high water mark %u)\n",
+               used, NET_REACTOR_TASK_STACK_SIZE, (unsigned)uxTaskGetStackHighWaterMark(s_reactor_task));
+        CHECK(used < NET_REACTOR_TASK_STACK_SIZE);
+    }
+
+    return HOST_TEST_RESULT();
+}
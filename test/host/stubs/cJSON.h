@@ -0,0 +1,28 @@
+// Stub hôte: sous-ensemble de l'API de cJSON lu par ota_manager (vérification
+// GitHub), fourni par le test qui en a besoin. json_writer_bench compile le
+// vrai cJSON, dont le répertoire passe avant stubs/.
+#ifndef cJSON__h
+#define cJSON__h
+
+typedef int cJSON_bool;
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+int cJSON_GetArraySize(const cJSON *array);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+cJSON_bool cJSON_IsString(const cJSON *item);
+cJSON_bool cJSON_IsArray(const cJSON *item);
+
+#endif // cJSON__h
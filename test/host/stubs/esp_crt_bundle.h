@@ -0,0 +1,9 @@
+// Stub hôte: bundle de certificats (HTTPS non pris en charge par host_http_client.c)
+#ifndef ESP_CRT_BUNDLE_H
+#define ESP_CRT_BUNDLE_H
+
+#include "esp_err.h"
+
+esp_err_t esp_crt_bundle_attach(void *conf);
+
+#endif // ESP_CRT_BUNDLE_H
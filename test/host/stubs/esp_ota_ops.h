@@ -0,0 +1,43 @@
+// Stub hôte: partitions OTA sur la flash simulée (host_ota_ops.c)
+//
+// Le firmware courant tourne depuis ota_0, les mises à jour vont dans ota_1.
+// La partition choisie pour le boot suivant est gardée en mémoire partagée,
+// comme la flash.
+#ifndef ESP_OTA_OPS_H
+#define ESP_OTA_OPS_H
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_app_format.h"
+
+#define ESP_ERR_OTA_BASE 0x1500
+#define ESP_ERR_OTA_VALIDATE_FAILED (ESP_ERR_OTA_BASE + 0x03)
+
+typedef enum {
+    ESP_OTA_IMG_NEW = 0x0,
+    ESP_OTA_IMG_PENDING_VERIFY = 0x1,
+    ESP_OTA_IMG_VALID = 0x2,
+    ESP_OTA_IMG_INVALID = 0x3,
+    ESP_OTA_IMG_ABORTED = 0x4,
+    ESP_OTA_IMG_UNDEFINED = 0xFFFFFFFF,
+} esp_ota_img_states_t;
+
+const esp_partition_t *esp_ota_get_running_partition(void);
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from);
+
+// Vérifie l'image (segments, somme de contrôle, SHA-256 ajouté) avant de la retenir
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void);
+
+// Description de l'application lue dans l'image de la partition courante
+const esp_app_desc_t *esp_app_get_description(void);
+
+// Extension hôte: partition retenue par esp_ota_set_boot_partition(), NULL si aucune
+const esp_partition_t *host_ota_boot_partition(void);
+
+// Extension hôte: oublie la partition retenue
+void host_ota_reset_boot_partition(void);
+
+#endif // ESP_OTA_OPS_H
@@ -0,0 +1,65 @@
+// Stub hôte: partitions de la flash simulées en mémoire (host_flash.c)
+//
+// Sémantique de la flash NOR: effacement par secteurs de 4 KB à 0xff, une
+// écriture ne fait que passer des bits à 0. La mémoire est partagée entre
+// processus (fork): un test peut simuler un reboot en continuant dans un fils.
+#ifndef ESP_PARTITION_H
+#define ESP_PARTITION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_APP_OTA_0 = 0x10,
+    ESP_PARTITION_SUBTYPE_APP_OTA_1 = 0x11,
+} esp_partition_subtype_t;
+
+typedef struct {
+    void *flash_chip;
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+    bool encrypted;
+    bool readonly;
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+// Extension hôte: partitions ota_0 (index 0) et ota_1 (index 1) de partitions.csv
+const esp_partition_t *host_flash_partition(int index);
+
+// Extension hôte: contenu d'une partition, accessible directement par les tests
+uint8_t *host_flash_data(const esp_partition_t *partition);
+
+// Extension hôte: compteurs depuis le démarrage (tous processus confondus)
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t erases;                    // Secteurs effacés
+    uint32_t dirty_writes;              // Écritures sur des octets non effacés
+    uint64_t read_bytes;
+    uint64_t written_bytes;
+} host_flash_stats_t;
+
+void host_flash_get_stats(host_flash_stats_t *stats);
+void host_flash_reset_stats(void);
+
+// Extension hôte: durées simulées d'un effacement de secteur et de l'écriture
+// de 4 KB, en µs (0 par défaut)
+void host_flash_set_timing(uint32_t erase_us, uint32_t write_us);
+
+#endif // ESP_PARTITION_H
@@ -0,0 +1,9 @@
+// Stub hôte: générateur aléatoire (host_esp.c)
+#ifndef ESP_RANDOM_H
+#define ESP_RANDOM_H
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
+
+#endif // ESP_RANDOM_H
@@ -0,0 +1,42 @@
+// Stub hôte: tâches FreeRTOS sur des threads POSIX (host_freertos.c)
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#define taskENTER_CRITICAL(mux) portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux) portEXIT_CRITICAL(mux)
+
+// La priorité et le cœur sont ignorés, la pile est celle du thread
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size,
+                       void *param, UBaseType_t priority, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *param, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+// Millisecondes depuis le démarrage du processus
+TickType_t xTaskGetTickCount(void);
+
+// Notifications (compteur, comme xTaskNotifyGive/ulTaskNotifyTake)
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+// Octets jamais utilisés de la pile demandée à la création (0 si inconnu ou dépassé)
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+// Extension hôte: pic d'utilisation de la pile depuis l'entrée de la tâche, en
+// octets (0 sous AddressSanitizer ou pour un thread non créé par xTaskCreate)
+size_t host_task_stack_used(TaskHandle_t task);
+
+// Extension hôte: temps CPU consommé par la tâche, en nanosecondes
+uint64_t host_task_cpu_ns(TaskHandle_t task);
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,17 @@
+// Stub hôte: constantes netconn utilisées par le hook de résolution
+#ifndef LWIP_API_H
+#define LWIP_API_H
+
+#include "lwip/ip_addr.h"
+
+typedef int8_t err_t;
+
+#define ERR_OK 0
+#define ERR_VAL -6
+
+#define NETCONN_DNS_IPV4 0
+#define NETCONN_DNS_IPV6 1
+#define NETCONN_DNS_IPV4_IPV6 2
+#define NETCONN_DNS_IPV6_IPV4 3
+
+#endif // LWIP_API_H
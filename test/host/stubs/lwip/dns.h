@@ -0,0 +1,11 @@
+// Stub hôte: serveurs DNS de lwIP, fournis par le test
+#ifndef LWIP_DNS_H
+#define LWIP_DNS_H
+
+#include "lwip/ip_addr.h"
+
+#define DNS_MAX_SERVERS 3
+
+const ip_addr_t *dns_getserver(u8_t numdns);
+
+#endif // LWIP_DNS_H
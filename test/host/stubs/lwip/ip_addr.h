@@ -0,0 +1,45 @@
+// Stub hôte: adresses IP lwIP (IPv4 seulement)
+#ifndef LWIP_IP_ADDR_H
+#define LWIP_IP_ADDR_H
+
+#include <stdint.h>
+#include <arpa/inet.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+
+typedef struct {
+    u32_t addr;                         // Ordre réseau
+} ip4_addr_t;
+
+typedef struct {
+    union {
+        ip4_addr_t ip4;
+    } u_addr;
+    u8_t type;
+} ip_addr_t;
+
+#define IPADDR_TYPE_V4 0U
+#define IPADDR_TYPE_V6 6U
+
+#define IP_IS_V4(ip) ((ip)->type == IPADDR_TYPE_V4)
+#define ip_2_ip4(ip) (&(ip)->u_addr.ip4)
+#define ip4_addr_isany_val(ip4) ((ip4).addr == 0)
+#define ip4_addr_get_u32(ip4) ((ip4)->addr)
+#define IP_ADDR4(ip, a, b, c, d) do { \
+        (ip)->type = IPADDR_TYPE_V4; \
+        (ip)->u_addr.ip4.addr = htonl(((u32_t)(a) << 24) | ((u32_t)(b) << 16) | ((u32_t)(c) << 8) | (u32_t)(d)); \
+    } while (0)
+
+static inline int ip4addr_aton(const char *cp, ip4_addr_t *addr)
+{
+    struct in_addr in;
+    if (!inet_aton(cp, &in)) {
+        return 0;
+    }
+    addr->addr = in.s_addr;
+    return 1;
+}
+
+#endif // LWIP_IP_ADDR_H
@@ -0,0 +1,7 @@
+// Stub hôte: résolution de noms POSIX
+#ifndef LWIP_NETDB_H
+#define LWIP_NETDB_H
+
+#include <netdb.h>
+
+#endif // LWIP_NETDB_H
@@ -0,0 +1,16 @@
+// Stub hôte: l'API sockets de lwIP est compatible POSIX
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Descripteurs POSIX: les sockets commencent après stdin/stdout/stderr
+#define LWIP_SOCKET_OFFSET 3
+
+#endif // LWIP_SOCKETS_H
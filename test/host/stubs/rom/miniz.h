@@ -0,0 +1,44 @@
+// Stub hôte: décompresseur tinfl de la ROM, même interface, sur zlib (host_miniz.c)
+//
+// Seul le flux deflate brut est pris en charge (ni en-tête zlib ni Adler-32).
+// Comme dans la ROM, tinfl_init() remet seulement m_state à zéro: l'état zlib
+// est gardé dans la structure et réinitialisé au tinfl_decompress() suivant.
+#ifndef ROM_MINIZ_H
+#define ROM_MINIZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned char mz_uint8;
+typedef uint32_t mz_uint32;
+
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+#define TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF 4
+#define TINFL_FLAG_COMPUTE_ADLER32 8
+
+typedef enum {
+    TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS = -4,
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+// z_stream puis ses allocations (état d'inflate et fenêtre de 32 KB)
+#define TINFL_HOST_STATE_SIZE (48 * 1024)
+
+typedef struct {
+    mz_uint32 m_state;                  // 0: nouveau flux
+    _Alignas(16) unsigned char m_host[TINFL_HOST_STATE_SIZE];
+} tinfl_decompressor;
+
+#define tinfl_init(r) do { (r)->m_state = 0; } while (0)
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *pIn_buf_next, size_t *pIn_buf_size,
+                              mz_uint8 *pOut_buf_start, mz_uint8 *pOut_buf_next, size_t *pOut_buf_size,
+                              const mz_uint32 decomp_flags);
+
+#endif // ROM_MINIZ_H
@@ -0,0 +1,18 @@
+// Stub hôte: valeurs par défaut de main/Kconfig.projbuild
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_MINIOT_DNS_RATE_LIMIT 1
+#define CONFIG_MINIOT_DNS_RATE_LIMIT_QPS 20
+#define CONFIG_MINIOT_DNS_RATE_LIMIT_BURST 40
+#define CONFIG_MINIOT_DNS_RATE_LIMIT_CLIENTS 8
+#define CONFIG_MINIOT_WIFI_SCAN_CACHE_TTL_SEC 30
+#define CONFIG_MINIOT_CAPTIVE_STA_ANSWERS 1
+
+// Défaut d'ESP-IDF (sockets lwIP simultanés)
+#define CONFIG_LWIP_MAX_SOCKETS 10
+
+// Cible: ESP32-S3 (esp_chip_id_t)
+#define CONFIG_IDF_FIRMWARE_CHIP_ID 0x0009
+
+#endif // SDKCONFIG_H
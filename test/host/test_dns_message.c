@@ -0,0 +1,399 @@
+// Tests du parser et du writer DNS (dns_message.c)
+#include "dns_message.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Construit une requête: en-tête, questions, puis un OPT optionnel
+typedef struct {
+    uint8_t buf[512];
+    size_t len;
+} packet_t;
+
+static void put_u16(packet_t *p, uint16_t v)
+{
+    p->buf[p->len++] = (uint8_t)(v >> 8);
+    p->buf[p->len++] = (uint8_t)v;
+}
+
+static void begin_query(packet_t *p, uint16_t id, uint16_t flags, uint16_t qdcount, uint16_t arcount)
+{
+    p->len = 0;
+    put_u16(p, id);
+    put_u16(p, flags);
+    put_u16(p, qdcount);
+    put_u16(p, 0);
+    put_u16(p, 0);
+    put_u16(p, arcount);
+}
+
+static void put_question(packet_t *p, const char *name, uint16_t qtype)
+{
+    p->len += dns_message_encode_name(p->buf + p->len, sizeof(p->buf) - p->len, name);
+    put_u16(p, qtype);
+    put_u16(p, DNS_CLASS_IN);
+}
+
+static void put_opt(packet_t *p, uint16_t udp_size, uint8_t version)
+{
+    p->buf[p->len++] = 0;
+    put_u16(p, DNS_TYPE_OPT);
+    put_u16(p, udp_size);
+    p->buf[p->len++] = 0;
+    p->buf[p->len++] = version;
+    put_u16(p, 0);
+    put_u16(p, 0);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void test_parse_query(void)
+{
+    packet_t p;
+    dns_query_t q;
+
+    begin_query(&p, 0x1234, 0x0100, 1, 0);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+    CHECK_EQ(q.id, 0x1234);
+    CHECK_EQ(q.qtype, DNS_TYPE_A);
+    CHECK_EQ(q.qclass, DNS_CLASS_IN);
+    CHECK_EQ(q.qname_len, 19);
+    CHECK_EQ(q.question_end, p.len);
+    CHECK(!q.has_edns);
+
+    // EDNS0 dans la section additional
+    begin_query(&p, 1, 0x0100, 1, 1);
+    put_question(&p, "connectivitycheck.gstatic.com", DNS_TYPE_AAAA);
+    size_t question_end = p.len;
+    put_opt(&p, 1232, 0);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+    CHECK(q.has_edns);
+    CHECK_EQ(q.edns_udp_size, 1232);
+    CHECK_EQ(q.edns_version, 0);
+    CHECK_EQ(q.question_end, question_end);
+
+    // Deuxième question compressée vers la première: acceptée, seule la première compte
+    begin_query(&p, 2, 0x0100, 2, 0);
+    put_question(&p, "www.msftconnecttest.com", DNS_TYPE_A);
+    question_end = p.len;
+    p.buf[p.len++] = 0xC0;
+    p.buf[p.len++] = DNS_HEADER_SIZE;
+    put_u16(&p, DNS_TYPE_AAAA);
+    put_u16(&p, DNS_CLASS_IN);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+    CHECK_EQ(q.qdcount, 2);
+    CHECK_EQ(q.question_end, question_end);
+}
+
+static void test_parse_errors(void)
+{
+    packet_t p;
+    dns_query_t q;
+
+    begin_query(&p, 1, 0x0100, 1, 0);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+
+    CHECK_EQ(dns_message_parse_query(p.buf, DNS_HEADER_SIZE - 1, &q), ESP_ERR_INVALID_SIZE);
+    // Question tronquée à chaque longueur possible
+    for (size_t len = DNS_HEADER_SIZE; len < p.len; len++) {
+        CHECK_EQ(dns_message_parse_query(p.buf, len, &q), ESP_ERR_INVALID_ARG);
+    }
+
+    p.buf[2] |= 0x80;
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_RESPONSE);
+    p.buf[2] = 0x11;    // Opcode STATUS
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_NOT_SUPPORTED);
+
+    // Aucune question
+    begin_query(&p, 1, 0x0100, 0, 0);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+
+    // Pointeur de compression dans la première question
+    begin_query(&p, 1, 0x0100, 1, 0);
+    p.buf[p.len++] = 0xC0;
+    p.buf[p.len++] = DNS_HEADER_SIZE;
+    put_u16(&p, DNS_TYPE_A);
+    put_u16(&p, DNS_CLASS_IN);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+
+    // Label étendu (0x40)
+    begin_query(&p, 1, 0x0100, 1, 0);
+    p.buf[p.len++] = 0x41;
+    p.buf[p.len++] = 'a';
+    p.buf[p.len++] = 0;
+    put_u16(&p, DNS_TYPE_A);
+    put_u16(&p, DNS_CLASS_IN);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+
+    // Nom de plus de 255 octets: 5 labels de 63
+    begin_query(&p, 1, 0x0100, 1, 0);
+    for (int i = 0; i < 5; i++) {
+        p.buf[p.len++] = 63;
+        memset(p.buf + p.len, 'a', 63);
+        p.len += 63;
+    }
+    p.buf[p.len++] = 0;
+    put_u16(&p, DNS_TYPE_A);
+    put_u16(&p, DNS_CLASS_IN);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+
+    // OPT en double, puis OPT annoncé mais absent
+    begin_query(&p, 1, 0x0100, 1, 2);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    put_opt(&p, 512, 0);
+    put_opt(&p, 512, 0);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+
+    begin_query(&p, 1, 0x0100, 1, 1);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_ERR_INVALID_ARG);
+}
+
+static void test_build_response(void)
+{
+    packet_t p;
+    dns_query_t q;
+    dns_writer_t w;
+    static const uint8_t ip[4] = {192, 168, 4, 1};
+
+    // A + OPT: la requête est réécrite en place
+    begin_query(&p, 0xBEEF, 0x0100, 1, 1);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    size_t question_end = p.len;
+    uint8_t sent[512];
+    memcpy(sent, p.buf, question_end);
+    put_opt(&p, 4096, 0);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+
+    dns_message_begin_response(&w, p.buf, sizeof(p.buf), &q, DNS_RCODE_NOERROR);
+    dns_message_add_a(&w, ip, 60);
+    size_t len = dns_message_finish(&w, &q);
+    CHECK_EQ(len, question_end + 16 + 11);
+    CHECK_EQ(get_u16(p.buf), 0xBEEF);
+    CHECK_EQ(get_u16(p.buf + 2), 0x8180);
+    CHECK_EQ(get_u16(p.buf + 4), 1);
+    CHECK_EQ(get_u16(p.buf + 6), 1);
+    CHECK_EQ(get_u16(p.buf + 10), 1);
+    const uint8_t *rr = p.buf + question_end;
+    CHECK_EQ(get_u16(rr), 0xC00C);
+    CHECK_EQ(get_u16(rr + 2), DNS_TYPE_A);
+    CHECK_EQ(get_u16(rr + 10), 4);
+    CHECK(memcmp(rr + 12, ip, 4) == 0);
+    // OPT: taille UDP 512, aucune option
+    CHECK_EQ(get_u16(rr + 16 + 1), DNS_TYPE_OPT);
+    CHECK_EQ(get_u16(rr + 16 + 3), 512);
+
+    // La réponse doit se relire comme une réponse A
+    uint8_t found[4];
+    uint32_t ttl = 0;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, len, sent, question_end, found, &ttl), ESP_OK);
+    CHECK(memcmp(found, ip, 4) == 0);
+    CHECK_EQ(ttl, 60);
+
+    // PTR
+    begin_query(&p, 7, 0x0100, 1, 0);
+    put_question(&p, "1.4.168.192.in-addr.arpa", DNS_TYPE_PTR);
+    question_end = p.len;
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+    CHECK(dns_message_qname_equals(p.buf, &q, "1.4.168.192.IN-ADDR.arpa"));
+    CHECK(!dns_message_qname_equals(p.buf, &q, "1.4.168.192.in-addr"));
+    dns_message_begin_response(&w, p.buf, sizeof(p.buf), &q, DNS_RCODE_NOERROR);
+    dns_message_add_ptr(&w, "miniot.local", 60);
+    len = dns_message_finish(&w, &q);
+    CHECK_EQ(len, question_end + 12 + 14);
+    CHECK_EQ(get_u16(p.buf + 10), 0);
+
+    // Buffer trop petit pour la réponse: rien à envoyer
+    begin_query(&p, 1, 0x0100, 1, 0);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    CHECK_EQ(dns_message_parse_query(p.buf, p.len, &q), ESP_OK);
+    dns_message_begin_response(&w, p.buf, p.len + 8, &q, DNS_RCODE_NOERROR);
+    dns_message_add_a(&w, ip, 60);
+    CHECK_EQ(dns_message_finish(&w, &q), 0);
+
+    // Erreur sans question: ID, opcode et RD conservés
+    begin_query(&p, 0x4242, 0x1100, 1, 0);
+    put_question(&p, "captive.apple.com", DNS_TYPE_A);
+    CHECK_EQ(dns_message_build_error(p.buf, p.len, DNS_RCODE_NOTIMP), DNS_HEADER_SIZE);
+    CHECK_EQ(get_u16(p.buf), 0x4242);
+    CHECK_EQ(get_u16(p.buf + 2), 0x9104);
+    CHECK_EQ(get_u16(p.buf + 4), 0);
+}
+
+static void test_names(void)
+{
+    uint8_t out[300];
+
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), "captive.apple.com"), 19);
+    CHECK(memcmp(out, "\x07" "captive" "\x05" "apple" "\x03" "com", 19) == 0);
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), ""), 0);
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), ".a"), 0);
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), "a..b"), 0);
+    CHECK_EQ(dns_message_encode_name(out, 10, "captive.apple.com"), 0);
+
+    char label[80];
+    memset(label, 'x', 64);
+    label[64] = '\0';
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), label), 0);
+    label[63] = '\0';
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), label), 65);
+
+    // Nom absolu: le point final n'ajoute pas de label vide
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), "api.github.com."), 16);
+    CHECK(memcmp(out, "\x03" "api" "\x06" "github" "\x03" "com", 16) == 0);
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), "."), 0);
+    CHECK_EQ(dns_message_encode_name(out, sizeof(out), "a.."), 0);
+
+    // Hash insensible à la casse (le cache de noms fréquents en dépend)
+    packet_t a, b;
+    dns_query_t qa, qb;
+    begin_query(&a, 1, 0x0100, 1, 0);
+    put_question(&a, "Captive.Apple.COM", DNS_TYPE_A);
+    begin_query(&b, 1, 0x0100, 1, 0);
+    put_question(&b, "captive.apple.com", DNS_TYPE_A);
+    CHECK_EQ(dns_message_parse_query(a.buf, a.len, &qa), ESP_OK);
+    CHECK_EQ(dns_message_parse_query(b.buf, b.len, &qb), ESP_OK);
+    CHECK_EQ(dns_message_qname_hash(a.buf, &qa), dns_message_qname_hash(b.buf, &qb));
+}
+
+static void test_a_response(void)
+{
+    uint8_t buf[512];
+    uint8_t ip[4];
+    uint32_t ttl;
+
+    size_t len = dns_message_build_a_query(buf, sizeof(buf), 0x5555, "api.github.com");
+    CHECK_EQ(len, DNS_HEADER_SIZE + 16 + 4);
+    CHECK_EQ(get_u16(buf + 2), 0x0100);
+
+    // Réponse: CNAME (TTL 30) puis A (TTL 300), le TTL retenu est le minimum
+    packet_t p;
+    memcpy(p.buf, buf, len);
+    p.len = len;
+    p.buf[2] = 0x81;
+    p.buf[3] = 0x80;
+    p.buf[7] = 2;
+    static const uint8_t cname[] = {
+        0xC0, 0x0C, 0x00, 0x05, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x04,
+        0x01, 'x', 0xC0, 0x10,
+    };
+    static const uint8_t a[] = {
+        0xC0, 0x2C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2C, 0x00, 0x04,
+        140, 82, 112, 6,
+    };
+    memcpy(p.buf + p.len, cname, sizeof(cname));
+    p.len += sizeof(cname);
+    memcpy(p.buf + p.len, a, sizeof(a));
+    p.len += sizeof(a);
+
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_OK);
+    CHECK(ip[0] == 140 && ip[3] == 6);
+    CHECK_EQ(ttl, 30);
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len - 1, buf, len, ip, &ttl), ESP_ERR_INVALID_RESPONSE);
+
+    // La casse du nom peut différer (0x20), pas l'ID, le nom ni le type
+    p.buf[DNS_HEADER_SIZE + 1] = 'A';
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_OK);
+    buf[1]++;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_ERR_INVALID_RESPONSE);
+    buf[1]--;
+    p.buf[DNS_HEADER_SIZE + 2] = 'q';
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_ERR_INVALID_RESPONSE);
+    p.buf[DNS_HEADER_SIZE + 2] = 'p';
+    p.buf[len - 3] = DNS_TYPE_AAAA;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_ERR_INVALID_RESPONSE);
+    p.buf[len - 3] = DNS_TYPE_A;
+
+    // Réponses négatives: NXDOMAIN, NODATA
+    p.buf[3] = 0x83;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_ERR_NOT_FOUND);
+    p.buf[3] = 0x80;
+    p.buf[7] = 0;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_ERR_NOT_FOUND);
+
+    // NODATA tronqué: pas une réponse définitive
+    p.buf[2] |= 0x02;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_FAIL);
+    p.buf[2] &= ~0x02;
+
+    // Échecs du serveur: à reposer ailleurs
+    p.buf[3] = 0x82;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_FAIL);
+    p.buf[3] = 0x85;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, p.len, buf, len, ip, &ttl), ESP_FAIL);
+
+    // FORMERR sans question (en-tête seul)
+    memcpy(p.buf, buf, len);
+    CHECK_EQ(dns_message_build_error(p.buf, len, DNS_RCODE_FORMERR), DNS_HEADER_SIZE);
+    CHECK_EQ(dns_message_parse_a_response(p.buf, DNS_HEADER_SIZE, buf, len, ip, &ttl), ESP_FAIL);
+    // ... mais un en-tête seul NOERROR n'est pas une réponse
+    p.buf[3] = 0x80;
+    CHECK_EQ(dns_message_parse_a_response(p.buf, DNS_HEADER_SIZE, buf, len, ip, &ttl), ESP_ERR_INVALID_RESPONSE);
+}
+
+/**
+ * Paquets aléatoires ou mutés: le parser ne doit jamais lire hors du paquet
+ * (à lancer avec MINIOT_HOST_SANITIZE pour que ASan le vérifie)
+ */
+static void test_random_packets(void)
+{
+    uint8_t buf[512];
+    static const uint8_t ip[4] = {1, 2, 3, 4};
+
+    srand(1);
+    for (int i = 0; i < 200000; i++) {
+        size_t len = DNS_HEADER_SIZE + rand() % 80;
+        for (size_t j = 0; j < len; j++) {
+            buf[j] = (uint8_t)rand();
+        }
+        if (rand() % 2) {
+            // En-tête plausible et labels courts pour aller plus loin dans le parser
+            buf[2] &= 0x01;
+            buf[3] = 0;
+            buf[4] = 0;
+            buf[5] = 1 + rand() % 2;
+            memset(buf + 6, 0, 5);
+            buf[11] = rand() % 2;
+            size_t off = DNS_HEADER_SIZE;
+            while (off + 6 < len) {
+                uint8_t label = rand() % 8;
+                buf[off] = label;
+                off += label + 1;
+                if (label == 0) {
+                    break;
+                }
+            }
+        }
+
+        dns_query_t q;
+        if (dns_message_parse_query(buf, len, &q) == ESP_OK) {
+            CHECK(q.question_end <= len);
+            dns_writer_t w;
+            dns_message_begin_response(&w, buf, sizeof(buf), &q, DNS_RCODE_NOERROR);
+            dns_message_add_a(&w, ip, 60);
+            dns_message_qname_hash(buf, &q);
+            dns_message_qname_equals(buf, &q, "a.b");
+            CHECK(dns_message_finish(&w, &q) <= sizeof(buf));
+        }
+
+        uint8_t found[4];
+        uint32_t ttl;
+        // La requête est le paquet lui-même: la question est toujours reconnue
+        dns_message_parse_a_response(buf, len, buf, len, found, &ttl);
+    }
+}
+
+int main(void)
+{
+    test_parse_query();
+    test_parse_errors();
+    test_build_response();
+    test_names();
+    test_a_response();
+    test_random_packets();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,358 @@
+// Résolveur amont avec cache: faux serveurs DNS sur loopback (127.0.0.2 primaire,
+// 127.0.0.3 secondaire) dont on choisit la réponse: adresse, NXDOMAIN, NODATA,
+// SERVFAIL, silence, réponse usurpée... Vérifie le repli sur le secondaire et
+// sur lwIP, et le cache sous résolutions concurrentes.
+#include "lwip/sockets.h"
+#include "lwip/dns.h"
+#include "lwip/api.h"
+#include "host_test.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define FAKE_SERVER_COUNT 2
+#define FAKE_SERVER_TTL 300
+
+typedef enum {
+    FAKE_SILENT,
+    FAKE_ANSWER,
+    FAKE_NXDOMAIN,
+    FAKE_NODATA,
+    FAKE_SERVFAIL,
+    FAKE_FORMERR_NO_QUESTION,
+    FAKE_SPOOF_THEN_ANSWER,     // Même ID mais autre question, puis la vraie réponse
+} fake_mode_t;
+
+typedef struct {
+    const char *addr;
+    int sock;
+    int port;
+    atomic_int mode;
+    atomic_int queries;
+    atomic_int delay_ms;
+    uint8_t last_query[512];
+    size_t last_query_len;
+} fake_server_t;
+
+static fake_server_t s_servers[FAKE_SERVER_COUNT] = {
+    { .addr = "127.0.0.2" },
+    { .addr = "127.0.0.3" },
+};
+static ip_addr_t s_dns_servers[3];
+static atomic_bool s_stop;
+
+const ip_addr_t *dns_getserver(u8_t numdns)
+{
+    return numdns < 3 ? &s_dns_servers[numdns] : NULL;
+}
+
+// Les faux serveurs écoutent sur des ports non privilégiés: le port 53 utilisé
+// par le résolveur est traduit à l'envoi et à la réception
+static fake_server_t *fake_server_by_addr(in_addr_t addr)
+{
+    for (int i = 0; i < FAKE_SERVER_COUNT; i++) {
+        if (inet_addr(s_servers[i].addr) == addr) {
+            return &s_servers[i];
+        }
+    }
+    return NULL;
+}
+
+static ssize_t test_sendto(int sock, const void *buf, size_t len, int flags,
+                           const struct sockaddr *to, socklen_t to_len)
+{
+    struct sockaddr_in addr = *(const struct sockaddr_in *)to;
+    fake_server_t *server = fake_server_by_addr(addr.sin_addr.s_addr);
+    if (server && addr.sin_port == htons(53)) {
+        addr.sin_port = htons(server->port);
+    }
+    return sendto(sock, buf, len, flags, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+static ssize_t test_recvfrom(int sock, void *buf, size_t len, int flags,
+                             struct sockaddr *from, socklen_t *from_len)
+{
+    ssize_t n = recvfrom(sock, buf, len, flags, from, from_len);
+    struct sockaddr_in *addr = (struct sockaddr_in *)from;
+    fake_server_t *server = n >= 0 ? fake_server_by_addr(addr->sin_addr.s_addr) : NULL;
+    if (server && addr->sin_port == htons(server->port)) {
+        addr->sin_port = htons(53);
+    }
+    return n;
+}
+
+#define sendto test_sendto
+#define recvfrom test_recvfrom
+#include "dns_resolver.c"
+#undef sendto
+#undef recvfrom
+
+static void fake_reply(fake_server_t *server, int index, uint8_t *buf, size_t len,
+                       const struct sockaddr_in *client)
+{
+    fake_mode_t mode = atomic_load(&server->mode);
+    uint8_t rcode = DNS_RCODE_NOERROR;
+
+    if (mode == FAKE_SILENT) {
+        return;
+    }
+    if (atomic_load(&server->delay_ms)) {
+        usleep(atomic_load(&server->delay_ms) * 1000);
+    }
+
+    if (mode == FAKE_SPOOF_THEN_ANSWER) {
+        uint8_t spoof[512];
+        memcpy(spoof, buf, len);
+        spoof[2] = 0x81;
+        spoof[3] = 0x80;
+        spoof[DNS_HEADER_SIZE + 1] ^= 0x01;     // Premier caractère du nom modifié
+        static const uint8_t rr[] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0x0E, 0x10, 0, 4, 6, 6, 6, 6};
+        memcpy(spoof + len, rr, sizeof(rr));
+        spoof[7] = 1;
+        sendto(server->sock, spoof, len + sizeof(rr), 0, (const struct sockaddr *)client, sizeof(*client));
+        mode = FAKE_ANSWER;
+    }
+
+    switch (mode) {
+    case FAKE_NXDOMAIN:
+        rcode = DNS_RCODE_NXDOMAIN;
+        break;
+    case FAKE_SERVFAIL:
+        rcode = DNS_RCODE_SERVFAIL;
+        break;
+    case FAKE_FORMERR_NO_QUESTION:
+        len = dns_message_build_error(buf, len, DNS_RCODE_FORMERR);
+        sendto(server->sock, buf, len, 0, (const struct sockaddr *)client, sizeof(*client));
+        return;
+    default:
+        break;
+    }
+
+    buf[2] = 0x81;
+    buf[3] = 0x80 | rcode;
+    if (mode == FAKE_ANSWER) {
+        // Adresse 10.0.0.<numéro du serveur> pour savoir qui a répondu
+        const uint8_t rr[] = {
+            0xC0, 0x0C, 0, DNS_TYPE_A, 0, DNS_CLASS_IN,
+            0, 0, FAKE_SERVER_TTL >> 8, FAKE_SERVER_TTL & 0xFF, 0, 4, 10, 0, 0, (uint8_t)(index + 1),
+        };
+        memcpy(buf + len, rr, sizeof(rr));
+        len += sizeof(rr);
+        buf[7] = 1;
+    }
+    sendto(server->sock, buf, len, 0, (const struct sockaddr *)client, sizeof(*client));
+}
+
+static void *fake_server_thread(void *arg)
+{
+    fake_server_t *server = arg;
+    int index = (int)(server - s_servers);
+
+    while (!atomic_load(&s_stop)) {
+        uint8_t buf[512];
+        struct sockaddr_in client;
+        socklen_t client_len = sizeof(client);
+        ssize_t len = recvfrom(server->sock, buf, 256, 0, (struct sockaddr *)&client, &client_len);
+        if (len < 0) {
+            continue;
+        }
+        memcpy(server->last_query, buf, len);
+        server->last_query_len = len;
+        atomic_fetch_add(&server->queries, 1);
+        fake_reply(server, index, buf, len, &client);
+    }
+    return NULL;
+}
+
+static void fake_servers_start(void)
+{
+    for (int i = 0; i < FAKE_SERVER_COUNT; i++) {
+        fake_server_t *server = &s_servers[i];
+        server->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = inet_addr(server->addr) };
+        socklen_t addr_len = sizeof(addr);
+        CHECK_EQ(bind(server->sock, (struct sockaddr *)&addr, sizeof(addr)), 0);
+        getsockname(server->sock, (struct sockaddr *)&addr, &addr_len);
+        server->port = ntohs(addr.sin_port);
+
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = 50000 };
+        setsockopt(server->sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        pthread_t tid;
+        pthread_create(&tid, NULL, fake_server_thread, server);
+        pthread_detach(tid);
+
+        IP_ADDR4(&s_dns_servers[i], 127, 0, 0, 2 + i);
+    }
+}
+
+/**
+ * Vide le cache et fixe le comportement des deux serveurs
+ */
+static void reset(fake_mode_t primary, fake_mode_t secondary)
+{
+    dns_resolver_flush();
+    atomic_store(&s_servers[0].mode, primary);
+    atomic_store(&s_servers[1].mode, secondary);
+    for (int i = 0; i < FAKE_SERVER_COUNT; i++) {
+        atomic_store(&s_servers[i].queries, 0);
+        atomic_store(&s_servers[i].delay_ms, 0);
+    }
+}
+
+static int queries(int server)
+{
+    return atomic_load(&s_servers[server].queries);
+}
+
+static void test_answers(void)
+{
+    uint8_t ip[4];
+
+    // Réponse du primaire, puis servie par le cache
+    reset(FAKE_ANSWER, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("api.github.com", ip), ESP_OK);
+    CHECK(ip[0] == 10 && ip[3] == 1);
+    CHECK_EQ(dns_resolver_lookup("API.github.com", ip), ESP_OK);
+    CHECK_EQ(queries(0), 1);
+    CHECK_EQ(queries(1), 0);
+
+    // Nom absolu: question bien formée, même entrée de cache
+    reset(FAKE_ANSWER, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("api.github.com.", ip), ESP_OK);
+    dns_query_t query;
+    CHECK_EQ(dns_message_parse_query(s_servers[0].last_query, s_servers[0].last_query_len, &query), ESP_OK);
+    CHECK_EQ(query.question_end, s_servers[0].last_query_len);
+    CHECK_EQ(query.qtype, DNS_TYPE_A);
+    CHECK(dns_message_qname_equals(s_servers[0].last_query, &query, "api.github.com"));
+    CHECK_EQ(dns_resolver_lookup("api.github.com", ip), ESP_OK);
+    CHECK_EQ(queries(0), 1);
+
+    // Réponse usurpée (même ID, autre question) ignorée
+    reset(FAKE_SPOOF_THEN_ANSWER, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("spoof.example.com", ip), ESP_OK);
+    CHECK(ip[0] == 10 && ip[3] == 1);
+}
+
+static void test_negative_answers(void)
+{
+    uint8_t ip[4];
+    ip_addr_t addr;
+    err_t err = ERR_OK;
+
+    // NXDOMAIN et NODATA sont des réponses définitives: pas de secondaire ni de lwIP
+    reset(FAKE_NXDOMAIN, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("missing.example.com", ip), ESP_ERR_NOT_FOUND);
+    CHECK_EQ(queries(1), 0);
+    CHECK_EQ(lwip_hook_netconn_external_resolve("missing.example.com", &addr, NETCONN_DNS_IPV4, &err), 1);
+    CHECK_EQ(err, ERR_VAL);
+
+    reset(FAKE_NODATA, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("v6only.example.com", ip), ESP_ERR_NOT_FOUND);
+    CHECK_EQ(queries(1), 0);
+}
+
+static void test_server_failures(void)
+{
+    uint8_t ip[4];
+    ip_addr_t addr;
+    err_t err = ERR_OK;
+
+    // SERVFAIL ou FORMERR sans question du primaire: le secondaire répond
+    reset(FAKE_SERVFAIL, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("servfail.example.com", ip), ESP_OK);
+    CHECK(ip[0] == 10 && ip[3] == 2);
+
+    reset(FAKE_FORMERR_NO_QUESTION, FAKE_ANSWER);
+    CHECK_EQ(dns_resolver_lookup("formerr.example.com", ip), ESP_OK);
+    CHECK(ip[3] == 2);
+
+    // Primaire muet: le secondaire répond après un seul timeout
+    reset(FAKE_SILENT, FAKE_ANSWER);
+    uint64_t start = host_now_ns();
+    CHECK_EQ(dns_resolver_lookup("silent.example.com", ip), ESP_OK);
+    CHECK(ip[3] == 2);
+    CHECK((host_now_ns() - start) / 1000000 < DNS_RESOLVER_TIMEOUT_MS * 3 / 2);
+
+    // Tous les serveurs en échec: repli sur le résolveur lwIP
+    reset(FAKE_SERVFAIL, FAKE_SERVFAIL);
+    CHECK_EQ(dns_resolver_lookup("down.example.com", ip), ESP_FAIL);
+    CHECK_EQ(queries(0), DNS_RESOLVER_RETRIES);
+    CHECK_EQ(queries(1), DNS_RESOLVER_RETRIES);
+    CHECK_EQ(lwip_hook_netconn_external_resolve("down.example.com", &addr, NETCONN_DNS_IPV4, &err), 0);
+
+    // Adresses littérales, noms courts et .local: toujours laissés à lwIP
+    reset(FAKE_ANSWER, FAKE_ANSWER);
+    CHECK_EQ(lwip_hook_netconn_external_resolve("192.168.1.10", &addr, NETCONN_DNS_IPV4, &err), 0);
+    CHECK_EQ(lwip_hook_netconn_external_resolve("router", &addr, NETCONN_DNS_IPV4, &err), 0);
+    CHECK_EQ(lwip_hook_netconn_external_resolve("miniot.local.", &addr, NETCONN_DNS_IPV4, &err), 0);
+    CHECK_EQ(queries(0), 0);
+}
+
+static void *lookup_thread(void *arg)
+{
+    uint8_t ip[4];
+    CHECK_EQ(dns_resolver_lookup(arg, ip), ESP_OK);
+    return NULL;
+}
+
+static void concurrent_lookups(const char *a, const char *b)
+{
+    pthread_t ta, tb;
+    pthread_create(&ta, NULL, lookup_thread, (void *)a);
+    usleep(10000);
+    pthread_create(&tb, NULL, lookup_thread, (void *)b);
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+}
+
+static int cache_entries(const char *host)
+{
+    int count = 0;
+    for (int i = 0; i < DNS_RESOLVER_CACHE_SIZE; i++) {
+        if (s_cache[i].expires_us != 0 && strcasecmp(s_cache[i].host, host) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void test_concurrent_lookups(void)
+{
+    uint8_t ip[4];
+    char names[DNS_RESOLVER_CACHE_SIZE][32];
+
+    // Cache plein, puis deux résolutions amont simultanées de noms différents:
+    // chacune doit obtenir sa propre entrée
+    reset(FAKE_ANSWER, FAKE_ANSWER);
+    for (int i = 0; i < DNS_RESOLVER_CACHE_SIZE; i++) {
+        snprintf(names[i], sizeof(names[i]), "host%d.example.com", i);
+        CHECK_EQ(dns_resolver_lookup(names[i], ip), ESP_OK);
+    }
+    atomic_store(&s_servers[0].delay_ms, 100);
+    concurrent_lookups("race-a.example.com", "race-b.example.com");
+    CHECK_EQ(cache_entries("race-a.example.com"), 1);
+    CHECK_EQ(cache_entries("race-b.example.com"), 1);
+    CHECK_EQ(cache_entries(names[0]) + cache_entries(names[1]), 0);
+
+    // Même nom résolu deux fois en parallèle: une seule entrée
+    concurrent_lookups("race-c.example.com", "race-c.example.com");
+    CHECK_EQ(cache_entries("race-c.example.com"), 1);
+    CHECK_EQ(cache_entries("race-a.example.com") + cache_entries("race-b.example.com"), 2);
+}
+
+int main(void)
+{
+    fake_servers_start();
+
+    test_answers();
+    test_negative_answers();
+    test_server_failures();
+    test_concurrent_lookups();
+
+    dns_resolver_stats_t stats;
+    dns_resolver_get_stats(&stats);
+    printf("resolver: %u hits, %u misses, %u failures\n", stats.hits, stats.misses, stats.failures);
+
+    atomic_store(&s_stop, true);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,438 @@
+// Tests du lecteur JSON en flux (json_reader.c)
+//
+// Chaque document est lu d'un bloc, octet par octet, découpé aléatoirement et
+// par json_reader_parse_http avec des segments de taille aléatoire entrecoupés
+// de délais de réception: le résultat doit être identique. Des documents
+// aléatoires (valides, puis tronqués ou altérés) complètent les cas écrits.
+//
+// Usage: test_json_reader [documents aléatoires]
+#include "json_reader.h"
+#include "host_httpd.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum { FIELD_SSID, FIELD_PASSWORD, FIELD_AP_TIMEOUT, FIELD_URL, FIELD_COUNT };
+
+typedef struct {
+    esp_err_t err;
+    uint32_t found;
+    uint32_t invalid;
+    char ssid[33];
+    char password[65];
+    uint32_t ap_timeout;
+    char url[16];
+} result_t;
+
+static void fields_init(json_field_t *fields, result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    memset(res->ssid, 'X', sizeof(res->ssid));
+    memset(res->password, 'X', sizeof(res->password));
+    memset(res->url, 'X', sizeof(res->url));
+    res->ap_timeout = 777;
+    fields[FIELD_SSID] = (json_field_t){ "ssid", JSON_FIELD_STRING, res->ssid, sizeof(res->ssid) };
+    fields[FIELD_PASSWORD] = (json_field_t){ "password", JSON_FIELD_STRING, res->password, sizeof(res->password) };
+    fields[FIELD_AP_TIMEOUT] = (json_field_t){ "ap_timeout", JSON_FIELD_UINT32, &res->ap_timeout, 0 };
+    fields[FIELD_URL] = (json_field_t){ "url", JSON_FIELD_STRING, res->url, sizeof(res->url) };
+}
+
+/**
+ * Ne garde que ce qui est défini par le contrat: valeurs des champs trouvés
+ */
+static void result_finish(result_t *res, const json_reader_t *r, esp_err_t err)
+{
+    res->err = err;
+    res->found = err == ESP_OK ? r->found : 0;
+    res->invalid = err == ESP_OK ? r->invalid : 0;
+    if (!(res->found & (1u << FIELD_SSID))) {
+        memset(res->ssid, 0, sizeof(res->ssid));
+    }
+    if (!(res->found & (1u << FIELD_PASSWORD))) {
+        memset(res->password, 0, sizeof(res->password));
+    }
+    if (!(res->found & (1u << FIELD_AP_TIMEOUT))) {
+        res->ap_timeout = 0;
+    }
+    if (!(res->found & (1u << FIELD_URL))) {
+        memset(res->url, 0, sizeof(res->url));
+    }
+}
+
+/**
+ * Lit doc en morceaux: cuts[] sont les positions de coupure, croissantes
+ */
+static void parse_cuts(const char *doc, size_t len, const size_t *cuts, int ncuts, result_t *res)
+{
+    json_field_t fields[FIELD_COUNT];
+    json_reader_t r;
+    fields_init(fields, res);
+    json_reader_init(&r, fields, FIELD_COUNT);
+
+    esp_err_t err = ESP_OK;
+    size_t pos = 0;
+    for (int i = 0; i <= ncuts && err == ESP_OK; i++) {
+        size_t end = i < ncuts ? cuts[i] : len;
+        err = json_reader_feed(&r, doc + pos, end - pos);
+        pos = end;
+    }
+    if (err == ESP_OK) {
+        err = json_reader_finish(&r);
+    }
+    result_finish(res, &r, err);
+}
+
+static void parse_http(const char *doc, unsigned int seed, size_t max_segment, int timeouts, result_t *res)
+{
+    json_field_t fields[FIELD_COUNT];
+    json_reader_t r;
+    static httpd_req_t req;
+    static host_httpd_t host;
+
+    fields_init(fields, res);
+    host_httpd_req_init(&req, &host, "/api/configure", doc);
+    host.seed = seed;
+    host.max_segment = max_segment;
+    host.timeouts_per_segment = timeouts;
+    host.timeouts_left = timeouts;
+    esp_err_t err = json_reader_parse_http(&r, &req, fields, FIELD_COUNT);
+    result_finish(res, &r, err);
+}
+
+static int compare_size(const void *a, const void *b)
+{
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool result_equal(const result_t *a, const result_t *b)
+{
+    return a->err == b->err && a->found == b->found && a->invalid == b->invalid &&
+           memcmp(a->ssid, b->ssid, sizeof(a->ssid)) == 0 &&
+           memcmp(a->password, b->password, sizeof(a->password)) == 0 &&
+           a->ap_timeout == b->ap_timeout && memcmp(a->url, b->url, sizeof(a->url)) == 0;
+}
+
+/**
+ * Lit doc de toutes les façons et vérifie qu'elles concordent
+ */
+static void parse_all(const char *doc, unsigned int seed, result_t *ref)
+{
+    size_t len = strlen(doc);
+    result_t res;
+    size_t cuts[16];
+
+    parse_cuts(doc, len, NULL, 0, ref);
+
+    // Une coupure à chaque position
+    for (size_t i = 0; i <= len; i++) {
+        cuts[0] = i;
+        parse_cuts(doc, len, cuts, 1, &res);
+        if (!result_equal(&res, ref)) {
+            fprintf(stderr, "cut at %zu differs: %s\n", i, doc);
+            host_test_failures++;
+            return;
+        }
+    }
+
+    // Coupures aléatoires
+    for (int it = 0; it < 50; it++) {
+        int ncuts = 1 + rand_r(&seed) % 16;
+        for (int i = 0; i < ncuts; i++) {
+            cuts[i] = (size_t)rand_r(&seed) % (len + 1);
+        }
+        qsort(cuts, ncuts, sizeof(size_t), compare_size);
+        parse_cuts(doc, len, cuts, ncuts, &res);
+        if (!result_equal(&res, ref)) {
+            fprintf(stderr, "random cuts (seed %u) differ: %s\n", seed, doc);
+            host_test_failures++;
+            return;
+        }
+    }
+
+    // Requête HTTP: segments de 1 à max octets, délais tolérés entre eux
+    if (len == 0 || len > JSON_READER_MAX_BODY) {
+        return;
+    }
+    for (int it = 0; it < 8; it++) {
+        parse_http(doc, seed + it, 1 + it * 3, it % 4, &res);
+        if (!result_equal(&res, ref)) {
+            fprintf(stderr, "HTTP segments (seed %u, max %d) differ: %s\n", seed + it, 1 + it * 3, doc);
+            host_test_failures++;
+            return;
+        }
+    }
+}
+
+typedef struct {
+    const char *doc;
+    bool ok;
+    uint32_t found;
+    uint32_t invalid;
+    const char *ssid;
+    const char *password;
+    uint32_t ap_timeout;
+} json_case_t;
+
+#define F(field) (1u << FIELD_##field)
+
+static const json_case_t s_cases[] = {
+    { "{\"ssid\":\"abc\",\"password\":\"12345678\",\"ap_timeout\":60}", true,
+      F(SSID) | F(PASSWORD) | F(AP_TIMEOUT), 0, "abc", "12345678", 60 },
+    { " \r\n{ \"ssid\" : \"a b\" ,\t\"ap_timeout\" :0 } \n", true, F(SSID) | F(AP_TIMEOUT), 0, "a b", NULL, 0 },
+    { "{}", true, 0, 0 },
+
+    // Échappements et Unicode
+    { "{\"ssid\":\"a\\u00e9\\ud83d\\ude00\\\"\\\\\\/\\n\"}", true, F(SSID), 0, "a\xc3\xa9\xf0\x9f\x98\x80\"\\/\n" },
+    { "{\"ssid\":\"\\ud83d!\"}", true, F(SSID), 0, "\xef\xbf\xbd!" },
+    { "{\"ssid\":\"\\ude00\"}", true, F(SSID), 0, "\xef\xbf\xbd" },
+    { "{\"ssid\":\"caf\xc3\xa9\"}", true, F(SSID), 0, "caf\xc3\xa9" },
+    { "{\"ssid\":\"a\\u0000b\"}", false },
+    { "{\"ssid\":\"a\\x\"}", false },
+    { "{\"ssid\":\"a\\u12g4\"}", false },
+    { "{\"ssid\":\"a\nb\"}", false },
+
+    // Entiers
+    { "{\"ap_timeout\":4294967295}", true, F(AP_TIMEOUT), 0, NULL, NULL, 4294967295u },
+    { "{\"ap_timeout\":4294967296}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":60.5}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":1.5e+3}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":0E-2}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":-3}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":true}", true, 0, F(AP_TIMEOUT) },
+    { "{\"ap_timeout\":\"60\"}", true, 0, F(AP_TIMEOUT) },
+    { "{\"other\":-0,\"ap_timeout\":0}", true, F(AP_TIMEOUT), 0, NULL, NULL, 0 },
+    { "{\"other\":-0.0e0}", true, 0, 0 },
+
+    // Nombres mal formés, y compris dans les clés ignorées
+    { "{\"ap_timeout\":-}", false },
+    { "{\"ap_timeout\":-a}", false },
+    { "{\"ap_timeout\":01}", false },
+    { "{\"other\":-01}", false },
+    { "{\"ap_timeout\":1e}", false },
+    { "{\"ap_timeout\":1e+}", false },
+    { "{\"ap_timeout\":1.}", false },
+    { "{\"ap_timeout\":1.e3}", false },
+    { "{\"ap_timeout\":.5}", false },
+    { "{\"ap_timeout\":+1}", false },
+    { "{\"ap_timeout\":1-2}", false },
+    { "{\"ap_timeout\":12", false },
+
+    // Types et tailles
+    { "{\"ssid\":123}", true, 0, F(SSID) },
+    { "{\"ssid\":null}", true, 0, F(SSID) },
+    { "{\"ssid\":[\"a\"]}", true, 0, F(SSID) },
+    { "{\"ssid\":\"012345678901234567890123456789012\"}", true, 0, F(SSID) },
+    { "{\"ssid\":\"01234567890123456789012345678901\"}", true, F(SSID), 0, "01234567890123456789012345678901" },
+
+    // Valeurs ignorées, clés répétées ou inconnues
+    { "{\"x\":{\"a\":[1,2,\"}]\\\"\"]},\"ssid\":\"ok\"}", true, F(SSID), 0, "ok" },
+    { "{\"ssid\":\"a\",\"ssid\":\"b\"}", true, F(SSID), 0, "b" },
+    { "{\"ssid\":1,\"ssid\":\"b\"}", true, F(SSID), 0, "b" },
+    { "{\"ss\\u0069d\":\"a\"}", true, 0, 0 },
+    { "{\"a_key_longer_than_the_limit_ssid\":\"a\"}", true, 0, 0 },
+    { "{\"t\":true,\"f\":false,\"n\":null}", true, 0, 0 },
+
+    // Structure
+    { "{\"ssid\":\"abc\" \"x\":1}", false },
+    { "{\"ssid\":\"abc\",}", false },
+    { "{\"ssid\" \"abc\"}", false },
+    { "{\"ssid\":\"abc\"} x", false },
+    { "{\"ssid\":\"abc\"", false },
+    { "{\"t\":tru}", false },
+    { "[]", false },
+    { "", false },
+};
+
+static void test_cases(void)
+{
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        const json_case_t *c = &s_cases[i];
+        result_t res;
+        parse_all(c->doc, (unsigned int)i, &res);
+
+        bool ok = res.err == ESP_OK &&
+                  res.found == c->found && res.invalid == c->invalid &&
+                  (!c->ssid || strcmp(res.ssid, c->ssid) == 0) &&
+                  (!c->password || strcmp(res.password, c->password) == 0) &&
+                  (!(c->found & F(AP_TIMEOUT)) || res.ap_timeout == c->ap_timeout);
+        if (c->ok ? !ok : res.err == ESP_OK) {
+            fprintf(stderr, "case %zu: %s -> err 0x%x found 0x%x invalid 0x%x ssid [%s]\n",
+                    i, c->doc, res.err, (unsigned)res.found, (unsigned)res.invalid, res.ssid);
+            host_test_failures++;
+        }
+    }
+}
+
+static void test_http_errors(void)
+{
+    static const char body[] = "{\"ssid\":\"abc\",\"password\":\"12345678\"}";
+    json_field_t fields[FIELD_COUNT];
+    result_t res;
+    json_reader_t r;
+    httpd_req_t req;
+    static host_httpd_t host;
+
+    fields_init(fields, &res);
+
+    // Délais de réception consécutifs: 3 tolérés, pas 4
+    host_httpd_req_init(&req, &host, "/api/configure", body);
+    host.max_segment = 5;
+    host.timeouts_per_segment = host.timeouts_left = 3;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_OK);
+
+    host_httpd_req_init(&req, &host, "/api/configure", body);
+    host.max_segment = 5;
+    host.timeouts_per_segment = host.timeouts_left = 4;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_ERR_TIMEOUT);
+    CHECK_EQ(host.recv_calls, 4);
+
+    // Client muet: abandon au lieu d'attendre indéfiniment
+    host_httpd_req_init(&req, &host, "/api/configure", body);
+    host.stalled = true;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_ERR_TIMEOUT);
+    CHECK_EQ(host.recv_calls, 4);
+
+    // Connexion fermée avant content_len
+    host_httpd_req_init(&req, &host, "/api/configure", body);
+    req.content_len += 10;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_FAIL);
+
+    // Tailles refusées sans rien lire
+    host_httpd_req_init(&req, &host, "/api/configure", body);
+    req.content_len = 0;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_ERR_INVALID_SIZE);
+    req.content_len = JSON_READER_MAX_BODY + 1;
+    CHECK_EQ(json_reader_parse_http(&r, &req, fields, FIELD_COUNT), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(host.recv_calls, 0);
+}
+
+/* Documents aléatoires */
+
+typedef struct {
+    char buf[2048];
+    size_t len;
+    bool truncated;                 // Morceau omis faute de place: plus forcément valide
+    unsigned int seed;
+} doc_t;
+
+static void put(doc_t *d, const char *s)
+{
+    size_t n = strlen(s);
+    if (d->len + n < sizeof(d->buf)) {
+        memcpy(d->buf + d->len, s, n);
+        d->len += n;
+    } else {
+        d->truncated = true;
+    }
+    d->buf[d->len] = '\0';
+}
+
+static int pick(doc_t *d, int n)
+{
+    return rand_r(&d->seed) % n;
+}
+
+static void put_string(doc_t *d)
+{
+    static const char *parts[] = {
+        "a", "Box", " ", "\\\"", "\\\\", "\\/", "\\n", "\\t", "\\u00e9", "\\ud83d\\ude00",
+        "\\ud83d", "\\uDE00", "\xc3\xa9", "}", "]", ",", ":", "{",
+    };
+    put(d, "\"");
+    for (int i = pick(d, 24); i > 0; i--) {
+        put(d, parts[pick(d, sizeof(parts) / sizeof(parts[0]))]);
+    }
+    put(d, "\"");
+}
+
+static void put_value(doc_t *d, int depth)
+{
+    static const char *numbers[] = {
+        "0", "7", "60", "4294967295", "4294967296", "99999999999999999999", "-3", "-0",
+        "1.5", "0.25e-3", "2E+10", "1e9",
+    };
+    static const char *literals[] = { "true", "false", "null" };
+    static const char *spaces[] = { "", "", " ", "\n\t" };
+
+    put(d, spaces[pick(d, 4)]);
+    int kind = pick(d, depth < 3 ? 6 : 4);
+    if (kind <= 1) {
+        put_string(d);
+    } else if (kind == 2) {
+        put(d, numbers[pick(d, sizeof(numbers) / sizeof(numbers[0]))]);
+    } else if (kind == 3) {
+        put(d, literals[pick(d, 3)]);
+    } else if (kind == 4) {
+        put(d, "[");
+        for (int i = pick(d, 4); i > 0; i--) {
+            put_value(d, depth + 1);
+            put(d, i > 1 ? "," : "");
+        }
+        put(d, "]");
+    } else {
+        put(d, "{");
+        for (int i = pick(d, 4); i > 0; i--) {
+            put_string(d);
+            put(d, ":");
+            put_value(d, depth + 1);
+            put(d, i > 1 ? "," : "");
+        }
+        put(d, "}");
+    }
+    put(d, spaces[pick(d, 4)]);
+}
+
+static void test_random(int count)
+{
+    static const char *keys[] = { "\"ssid\"", "\"password\"", "\"ap_timeout\"", "\"url\"", "\"other\"" };
+    int valid_ok = 0;
+
+    for (int i = 0; i < count; i++) {
+        doc_t d = { .len = 0, .truncated = false, .seed = (unsigned int)i };
+        d.buf[0] = '\0';
+        put(&d, "{");
+        for (int n = pick(&d, 6); n > 0; n--) {
+            if (pick(&d, 4) == 0) {
+                put_string(&d);
+            } else {
+                put(&d, keys[pick(&d, 5)]);
+            }
+            put(&d, pick(&d, 2) ? ":" : " : ");
+            put_value(&d, 1);
+            put(&d, n > 1 ? "," : "");
+        }
+        put(&d, "}");
+
+        result_t res;
+        parse_all(d.buf, d.seed, &res);
+        if (!d.truncated) {
+            CHECK_EQ(res.err, ESP_OK);
+            valid_ok += res.err == ESP_OK;
+        }
+
+        // Document tronqué ou altéré: jamais accepté à moitié, mêmes résultats
+        // quelle que soit la découpe
+        if (d.len > 1) {
+            size_t pos = (size_t)pick(&d, (int)d.len - 1);
+            if (pick(&d, 2)) {
+                d.buf[pos] = '\0';
+            } else {
+                d.buf[pos] = "{}[]\",:\\0-.e \x01"[pick(&d, 14)];
+            }
+            parse_all(d.buf, d.seed, &res);
+        }
+    }
+    printf("%d random documents, %d valid ones accepted\n", count, valid_ok);
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+
+    test_cases();
+    test_http_errors();
+    test_random(count);
+
+    return HOST_TEST_RESULT();
+}
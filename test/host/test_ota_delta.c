@@ -0,0 +1,208 @@
+// Patchs OTA (ota_delta): application en flux contre la partition courante
+//
+// Les images viennent de make_test_firmware.py et le patch de make_delta.py
+// (générés au build). La nouvelle image doit être reproduite à l'octet près
+// quelle que soit la découpe du patch en morceaux reçus; une autre source, un
+// patch tronqué ou corrompu sont refusés sans jamais produire plus que la
+// taille annoncée. Affiche la taille du patch face à l'image complète et le
+// débit d'application.
+//
+// Usage: test_ota_delta <ancien.bin> <nouveau.bin> <patch.mdl>
+#include "ota_delta.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_RUNS 300
+
+static uint8_t *s_target;
+static size_t s_target_len;
+
+// Sortie du patch, comparée au fil de l'eau à l'image attendue
+static struct {
+    size_t len;
+    size_t mismatch;                    // Octets différents de l'image attendue
+    size_t fail_after;                  // Erreur simulée au-delà (0: jamais)
+    int calls;
+} s_out;
+
+static esp_err_t output(const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    s_out.calls++;
+    if (s_out.fail_after && s_out.len + len > s_out.fail_after) {
+        return ESP_FAIL;
+    }
+    for (size_t i = 0; i < len; i++) {
+        size_t pos = s_out.len + i;
+        s_out.mismatch += pos >= s_target_len || bytes[i] != s_target[pos];
+    }
+    s_out.len += len;
+    return ESP_OK;
+}
+
+/**
+ * Applique le patch par morceaux de chunk octets (0: taille aléatoire jusqu'à 4 KB)
+ * @return Première erreur de begin, feed ou finish
+ */
+static esp_err_t apply(const uint8_t *patch, size_t len, size_t chunk, unsigned int seed)
+{
+    static ota_delta_t d;
+    memset(&s_out, 0, sizeof(s_out));
+
+    esp_err_t err = ota_delta_begin(&d, (const ota_delta_header_t *)patch, host_flash_partition(0), output);
+    size_t pos = sizeof(ota_delta_header_t);
+    while (err == ESP_OK && pos < len) {
+        size_t n = chunk ? chunk : 1 + rand_r(&seed) % 4096;
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        err = ota_delta_feed(&d, patch + pos, n);
+        pos += n;
+    }
+    if (err == ESP_OK) {
+        err = ota_delta_finish(&d);
+    }
+    // Jamais plus que la taille annoncée, même d'un patch invalide
+    CHECK(s_out.len <= d.target_size);
+    return err;
+}
+
+static void test_apply(const uint8_t *patch, size_t len)
+{
+    static const size_t chunks[] = { 1, 7, 12, 1000, 1460, 4096, 65536 };
+
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        CHECK_EQ(apply(patch, len, chunks[i], 0), ESP_OK);
+        CHECK_EQ(s_out.len, s_target_len);
+        CHECK_EQ(s_out.mismatch, 0);
+    }
+    for (unsigned int seed = 1; seed <= 20; seed++) {
+        CHECK_EQ(apply(patch, len, 0, seed), ESP_OK);
+        CHECK_EQ(s_out.len, s_target_len);
+        CHECK_EQ(s_out.mismatch, 0);
+    }
+}
+
+static void test_wrong_source(const uint8_t *patch, size_t len)
+{
+    uint8_t *source = host_flash_data(host_flash_partition(0));
+
+    // Un seul octet différent dans la source: refusé avant toute sortie
+    source[1000] ^= 0x01;
+    CHECK_EQ(apply(patch, len, 4096, 0), ESP_ERR_INVALID_VERSION);
+    CHECK_EQ(s_out.calls, 0);
+    source[1000] ^= 0x01;
+
+    // Source plus grande que la partition
+    uint8_t *copy = malloc(len);
+    memcpy(copy, patch, len);
+    ota_delta_header_t *header = (ota_delta_header_t *)copy;
+    header->source_size = host_flash_partition(0)->size + 1;
+    CHECK_EQ(apply(copy, len, 4096, 0), ESP_ERR_INVALID_SIZE);
+    header->source_size = 0;
+    CHECK_EQ(apply(copy, len, 4096, 0), ESP_ERR_INVALID_SIZE);
+    free(copy);
+}
+
+static void test_truncated(const uint8_t *patch, size_t len)
+{
+    size_t body = len - sizeof(ota_delta_header_t);
+    for (int i = 1; i < 64; i++) {
+        size_t cut = sizeof(ota_delta_header_t) + body * i / 64;
+        CHECK(apply(patch, cut, 1460, 0) != ESP_OK);
+    }
+    CHECK(apply(patch, len - 1, 1460, 0) != ESP_OK);
+}
+
+/**
+ * Octets du patch modifiés au hasard: erreur, ou image différente que le
+ * SHA-256 final d'ota_manager refusera, mais jamais de débordement
+ */
+static void test_corrupted(const uint8_t *patch, size_t len)
+{
+    uint8_t *copy = malloc(len);
+    unsigned int seed = 42;
+    int rejected = 0, wrong = 0;
+
+    for (int run = 0; run < FUZZ_RUNS; run++) {
+        memcpy(copy, patch, len);
+        int flips = 1 + rand_r(&seed) % 8;
+        for (int i = 0; i < flips; i++) {
+            size_t pos = sizeof(ota_delta_header_t) + rand_r(&seed) % (len - sizeof(ota_delta_header_t));
+            copy[pos] ^= 1 + rand_r(&seed) % 255;
+        }
+        if (apply(copy, len, 0, seed) != ESP_OK) {
+            rejected++;
+        } else if (s_out.mismatch != 0) {
+            wrong++;
+        }
+    }
+    printf("Corrupted patches: %d rejected, %d producing a wrong image, %d unchanged output\n",
+           rejected, wrong, FUZZ_RUNS - rejected - wrong);
+    free(copy);
+}
+
+static void test_output_error(const uint8_t *patch, size_t len)
+{
+    static ota_delta_t d;
+    memset(&s_out, 0, sizeof(s_out));
+    s_out.fail_after = s_target_len / 2;
+
+    esp_err_t err = ota_delta_begin(&d, (const ota_delta_header_t *)patch, host_flash_partition(0), output);
+    for (size_t pos = sizeof(ota_delta_header_t); err == ESP_OK && pos < len; pos += 1460) {
+        err = ota_delta_feed(&d, patch + pos, len - pos < 1460 ? len - pos : 1460);
+    }
+    CHECK_EQ(err, ESP_FAIL);
+    CHECK(s_out.len <= s_out.fail_after);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <old.bin> <new.bin> <patch.mdl>\n", argv[0]);
+        return 2;
+    }
+
+    size_t source_len, len;
+    uint8_t *source = host_read_file(argv[1], &source_len);
+    s_target = host_read_file(argv[2], &s_target_len);
+    uint8_t *patch = host_read_file(argv[3], &len);
+    if (!source || !s_target || !patch) {
+        return 2;
+    }
+    CHECK_EQ(sizeof(ota_delta_header_t), 76);
+    CHECK(ota_delta_is_patch(patch));
+    CHECK(!ota_delta_is_patch(s_target));
+
+    // Partition courante: l'ancienne image, suivie de flash effacée
+    memcpy(host_flash_data(host_flash_partition(0)), source, source_len);
+
+    test_apply(patch, len);
+    test_wrong_source(patch, len);
+    test_truncated(patch, len);
+    test_corrupted(patch, len);
+    test_output_error(patch, len);
+
+    // Mesure: application complète, lecture de la source comprise
+    host_flash_stats_t stats;
+    host_flash_reset_stats();
+    uint64_t start = host_now_ns();
+    CHECK_EQ(apply(patch, len, 1460, 0), ESP_OK);
+    double ms = (host_now_ns() - start) / 1e6;
+    host_flash_get_stats(&stats);
+
+    printf("Image %zu bytes, patch %zu bytes (%.1f%%, x%.0f less to download)\n",
+           s_target_len, len, 100.0 * len / s_target_len, (double)s_target_len / len);
+    printf("Applied in %.1f ms (%.0f MB/s), %u source reads (%llu bytes, SHA-256 check included), "
+           "state %zu bytes\n", ms, s_target_len / ms / 1000, stats.reads,
+           (unsigned long long)stats.read_bytes, sizeof(ota_delta_t));
+
+    // Un patch ne vaut que s'il est nettement plus petit que l'image
+    CHECK(len * 10 < s_target_len);
+
+    free(source);
+    free(s_target);
+    free(patch);
+    return HOST_TEST_RESULT();
+}
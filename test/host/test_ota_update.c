@@ -0,0 +1,684 @@
+// Mise à jour OTA de bout en bout: ota_manager face à un serveur HTTP local
+//
+// Chaque mise à jour tourne dans un processus fils, comme un boot du device:
+// la flash, la partition retenue pour le boot et le point de reprise NVS sont
+// en mémoire partagée, esp_restart() termine le fils. La partition courante
+// contient l'ancienne image (make_test_firmware.py); la nouvelle doit arriver
+// à l'octet près dans ota_1 et y être retenue, qu'elle soit téléchargée
+// complète, compressée (make_compressed.py), en patch (make_delta.py) ou en
+// patch compressé, directement ou après une redirection. Une image étrangère,
+// un flux compressé corrompu ou tronqué et un fichier absent sont refusés sans
+// rien retenir.
+//
+// Reprise: connexions coupées en cours de transfert (suite demandée par Range,
+// délai entre tentatives remis à zéro tant que le téléchargement progresse,
+// abandon après des coupures sans progression), coupure de courant pendant
+// l'écriture en flash puis reprise au boot suivant depuis le point de reprise
+// NVS, sauf si le fichier a été republié (ETag) ou si la partition a changé.
+//
+// Upload (POST /api/ota_upload, enchaînement d'ota_upload_handler): chaque
+// format installé, image étrangère refusée avant tout effacement, corps
+// tronqué refusé, aucun autre départ possible pendant un upload.
+//
+// Mesure ensuite chaque format sur un lien au débit limité (KB/s, 1024 par
+// défaut): octets reçus, requêtes et durée de bout en bout, connexion comprise,
+// puis la durée et le débit du même fichier poussé par upload au même débit.
+// Puis l'image complète avec les durées de la flash de l'ESP32-S3, sur un lien
+// lent: durée face au lien seul et à la flash seule, soit ce qu'un recouvrement
+// parfait de la réception et de l'écriture pourrait gagner. Enfin la taille de
+// lecture adaptée au débit face à des lectures fixes de 4 KB, avec un coût
+// ajouté à chaque appel à esp_http_client_read() (TLS, lwIP).
+//
+// Usage: test_ota_update <répertoire des images> [débit du lien en KB/s]
+#include "ota_manager.h"
+#include "nvs_storage.h"
+#include "host_file_server.h"
+#include "host_test.h"
+#include "esp_http_client.h"
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define LINK_RATE_KBPS 1024
+#define SLOW_LINK_RATE_KBPS 100
+#define FLASH_ERASE_US 30000                // Effacement d'un secteur
+#define FLASH_WRITE_US 10000                // Écriture de 4 KB
+#define FIXED_READ_SIZE 4096                // Lecture avant l'adaptation au débit
+
+// Résultat d'un boot et NVS, partagés avec les processus fils
+typedef struct {
+    uint8_t nvs[512];                   // Point de reprise OTA
+    size_t nvs_len;                     // 0: aucun
+    esp_err_t err;                      // Retour d'ota_manager_start_update
+    bool restarted;                     // esp_restart() appelé
+    int delays;                         // Appels à vTaskDelay (attentes, non subies)
+    uint32_t delay_ms;
+    int64_t elapsed_us;                 // Jusqu'à esp_restart() ou l'échec
+    uint32_t power_cut;                 // Écriture en flash au-delà de cet octet: coupure (0: jamais)
+    bool power_lost;
+    uint32_t read_overhead_us;          // Ajouté à chaque lecture HTTP
+    int read_size;                      // Lectures limitées à cette taille (0: taille demandée)
+    host_http_client_stats_t http;
+    char status[64];
+} shared_t;
+
+static shared_t *s_shared;
+static int64_t s_start_us;
+static volatile bool s_update_done;     // Mise à jour en tâche de fond terminée sans redémarrer
+static int s_port;
+
+typedef struct {
+    const char *name;
+    uint8_t *data;
+    size_t len;
+} image_t;
+
+static image_t s_old = { "old.bin" }, s_new = { "new.bin" };
+static uint8_t *s_foreign;              // Image d'une autre puce
+
+// Fichiers servis, dans l'ordre de la mesure
+static image_t s_files[] = {
+    { "new.bin" }, { "new.mdz" }, { "new.mdl" }, { "new.mdl.mdz" },
+};
+
+// nvs_storage: point de reprise en mémoire partagée
+
+esp_err_t nvs_storage_save_ota_checkpoint(const void *data, size_t len)
+{
+    if (len > sizeof(s_shared->nvs)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(s_shared->nvs, data, len);
+    s_shared->nvs_len = len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_storage_load_ota_checkpoint(void *data, size_t len)
+{
+    if (s_shared->nvs_len == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len != s_shared->nvs_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(data, s_shared->nvs, len);
+    return ESP_OK;
+}
+
+esp_err_t nvs_storage_clear_ota_checkpoint(void)
+{
+    s_shared->nvs_len = 0;
+    return ESP_OK;
+}
+
+// cJSON: la vérification GitHub n'est pas testée ici
+
+cJSON *cJSON_Parse(const char *value) { return NULL; }
+void cJSON_Delete(cJSON *item) {}
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string) { return NULL; }
+int cJSON_GetArraySize(const cJSON *array) { return 0; }
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index) { return NULL; }
+cJSON_bool cJSON_IsString(const cJSON *item) { return 0; }
+cJSON_bool cJSON_IsArray(const cJSON *item) { return 0; }
+
+/**
+ * Relève le résultat du boot en cours dans la mémoire partagée
+ */
+static void boot_end(esp_err_t err, bool restarted)
+{
+    ota_progress_t progress;
+    ota_manager_get_progress(&progress);
+    s_shared->err = err;
+    s_shared->restarted = restarted;
+    s_shared->elapsed_us = esp_timer_get_time() - s_start_us;
+    host_http_client_get_stats(&s_shared->http);
+    snprintf(s_shared->status, sizeof(s_shared->status), "%s", progress.status);
+}
+
+// Liaison avec --wrap: le redémarrage termine le boot, les attentes sont comptées
+void __wrap_esp_restart(void)
+{
+    boot_end(ESP_OK, true);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+}
+
+void __wrap_vTaskDelay(TickType_t ticks)
+{
+    s_shared->delays++;
+    s_shared->delay_ms += ticks * portTICK_PERIOD_MS;
+}
+
+// Coupure de courant: le boot s'arrête net avant l'écriture, secteur déjà effacé
+esp_err_t __real_esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                                     const void *src, size_t size);
+
+esp_err_t __wrap_esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                                     const void *src, size_t size)
+{
+    if (s_shared->power_cut && dst_offset + size > s_shared->power_cut) {
+        s_shared->power_lost = true;
+        _exit(0);
+    }
+    return __real_esp_partition_write(partition, dst_offset, src, size);
+}
+
+int __real_esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+
+int __wrap_esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    if (s_shared->read_overhead_us) {
+        usleep(s_shared->read_overhead_us);
+    }
+    if (s_shared->read_size && len > s_shared->read_size) {
+        len = s_shared->read_size;
+    }
+    return __real_esp_http_client_read(client, buffer, len);
+}
+
+static void on_progress(const ota_progress_t *progress)
+{
+    if (!progress->in_progress) {
+        s_update_done = true;
+    }
+}
+
+/**
+ * Démarre le device dans un processus fils et y exécute device(arg)
+ */
+static void fork_device(const char *name, void (*device)(const void *arg), const void *arg)
+{
+    s_shared->err = ESP_FAIL;
+    s_shared->restarted = false;
+    s_shared->delays = 0;
+    s_shared->delay_ms = 0;
+    s_shared->power_lost = false;
+    s_shared->status[0] = '\0';
+    host_file_server_reset_stats();
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        s_start_us = esp_timer_get_time();
+        ota_manager_init();
+        device(arg);
+        _exit(0);
+    }
+    int status = -1;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: boot crashed (status 0x%x)\n", name, status);
+        host_test_failures++;
+    }
+}
+
+static void url_of(char *url, size_t size, const char *path)
+{
+    snprintf(url, size, "http://127.0.0.1:%d%s", s_port, path);
+}
+
+static void device_pull(const void *arg)
+{
+    const char *path = arg;
+    if (path) {
+        char url[128];
+        url_of(url, sizeof(url), path);
+        boot_end(ota_manager_start_update(url), false);
+        return;
+    }
+    ota_manager_set_progress_callback(on_progress);
+    esp_err_t err = ota_manager_resume_pending();
+    while (err == ESP_OK && !s_update_done) {
+        usleep(1000);
+    }
+    boot_end(err == ESP_OK ? ESP_FAIL : err, false);
+}
+
+/**
+ * Démarre le device et lance la mise à jour depuis path, ou reprend celle
+ * interrompue (ota_manager_resume_pending) si path est NULL
+ */
+static void boot(const char *path)
+{
+    fork_device(path ? path : "resume", device_pull, path);
+}
+
+// Corps d'un POST /api/ota_upload
+typedef struct {
+    const uint8_t *data;
+    size_t len;                         // Content-Length
+    size_t body_len;                    // Octets effectivement reçus (< len: corps tronqué)
+    uint32_t rate_kbps;                 // Débit du client (0: illimité)
+} upload_t;
+
+/**
+ * Enchaînement d'ota_upload_handler (web_server.c): blocs de 4 KB écrits au
+ * fil de la réception, vérification, puis redémarrage
+ */
+static void device_upload(const void *arg)
+{
+    const upload_t *upload = arg;
+    esp_err_t err = ota_manager_upload_begin(upload->len);
+    size_t sent = 0;
+    while (err == ESP_OK && sent < upload->body_len) {
+        size_t n = upload->body_len - sent < 4096 ? upload->body_len - sent : 4096;
+        if (upload->rate_kbps) {
+            // Bloc disponible une fois reçu en entier au débit du client
+            int64_t due_us = (int64_t)(sent + n) * 1000000 / (upload->rate_kbps * 1024);
+            int64_t wait_us = due_us - (esp_timer_get_time() - s_start_us);
+            if (wait_us > 0) {
+                usleep(wait_us);
+            }
+        }
+        err = ota_manager_upload_write(upload->data + sent, n);
+        sent += n;
+    }
+    if (err == ESP_OK) {
+        err = ota_manager_upload_end();
+    }
+    if (err == ESP_OK) {
+        esp_restart();
+    }
+    boot_end(err, false);
+}
+
+static void upload(const char *name, const uint8_t *data, size_t len, size_t body_len, uint32_t rate_kbps)
+{
+    upload_t body = { data, len, body_len, rate_kbps };
+    fork_device(name, device_upload, &body);
+}
+
+/**
+ * Remet le device dans l'état d'avant la mise à jour: ota_1 contient une
+ * ancienne image quelconque (à effacer avant d'écrire), rien n'est retenu
+ */
+static void reset_device(void)
+{
+    const esp_partition_t *update = host_flash_partition(1);
+    memset(host_flash_data(update), 0x5a, update->size);
+    host_ota_reset_boot_partition();
+    s_shared->nvs_len = 0;
+    s_shared->power_cut = 0;
+    host_flash_reset_stats();
+}
+
+/**
+ * La nouvelle image est dans ota_1, retenue pour le boot, et le device redémarre
+ */
+static void check_updated(const char *path)
+{
+    host_flash_stats_t stats;
+    host_flash_get_stats(&stats);
+    if (!s_shared->restarted || host_ota_boot_partition() != host_flash_partition(1) ||
+        memcmp(host_flash_data(host_flash_partition(1)), s_new.data, s_new.len) != 0) {
+        fprintf(stderr, "%s: update not installed (%s, status '%s')\n",
+                path, esp_err_to_name(s_shared->err), s_shared->status);
+        host_test_failures++;
+    }
+    CHECK_EQ(stats.dirty_writes, 0);
+    CHECK_EQ(s_shared->nvs_len, 0);
+}
+
+/**
+ * La mise à jour échoue sans redémarrer ni rien retenir
+ */
+static void check_refused(const char *path)
+{
+    if (s_shared->err == ESP_OK || s_shared->restarted || host_ota_boot_partition() != NULL) {
+        fprintf(stderr, "%s: bad update accepted (%s, status '%s')\n",
+                path, esp_err_to_name(s_shared->err), s_shared->status);
+        host_test_failures++;
+    }
+    CHECK_EQ(s_shared->nvs_len, 0);
+}
+
+static void test_formats(void)
+{
+    char path[64];
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        snprintf(path, sizeof(path), "/%s", s_files[i].name);
+        reset_device();
+        boot(path);
+        check_updated(path);
+    }
+
+    // Lien de release GitHub: 302 vers le stockage
+    reset_device();
+    boot("/redirect/new.mdz");
+    check_updated("/redirect/new.mdz");
+}
+
+static void test_refused(void)
+{
+    // Image d'une autre cible: refusée avant tout effacement
+    reset_device();
+    boot("/foreign.bin");
+    check_refused("/foreign.bin");
+    host_flash_stats_t stats;
+    host_flash_get_stats(&stats);
+    CHECK_EQ(stats.erases, 0);
+
+    reset_device();
+    boot("/corrupt.mdz");
+    check_refused("/corrupt.mdz");
+
+    reset_device();
+    boot("/truncated.mdz");
+    check_refused("/truncated.mdz");
+
+    // Pas de nouvelle tentative sur une 404
+    reset_device();
+    boot("/missing.bin");
+    check_refused("/missing.bin");
+    CHECK_EQ(s_shared->delays, 0);
+    CHECK_EQ(s_shared->http.requests, 1);
+}
+
+static void test_dropped(void)
+{
+    host_file_server_stats_t server;
+    char path[64];
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        // Trois coupures, chacune après un quart du reste: le délai ne s'allonge pas
+        snprintf(path, sizeof(path), "/%s", s_files[i].name);
+        reset_device();
+        host_file_server_drop(s_files[i].len / 4, 3);
+        boot(path);
+        check_updated(path);
+        host_file_server_get_stats(&server);
+        CHECK_EQ(server.dropped, 3);
+        CHECK_EQ(server.partial, 3);
+        CHECK_EQ(s_shared->http.body_bytes, s_files[i].len);
+        CHECK_EQ(s_shared->delays, 4);
+        CHECK_EQ(s_shared->delay_ms, 3 * 1000 + 3000);
+    }
+
+    // Coupures avant le premier octet: attentes de 1, 2, 4, 8, 16 puis 30 s et abandon
+    reset_device();
+    host_file_server_drop(0, 100);
+    boot("/new.bin");
+    host_file_server_drop(0, 0);
+    CHECK(s_shared->err != ESP_OK);
+    CHECK(!s_shared->restarted);
+    CHECK(host_ota_boot_partition() == NULL);
+    CHECK_EQ(s_shared->delays, 6);
+    CHECK_EQ(s_shared->delay_ms, 61000);
+    CHECK_EQ(s_shared->http.requests, 7);
+}
+
+/**
+ * Un upload en cours bloque tout autre départ (upload ou URL), jusqu'à son abandon
+ */
+static void device_upload_busy(const void *arg)
+{
+    char url[128];
+    url_of(url, sizeof(url), "/new.bin");
+    esp_err_t first = ota_manager_upload_begin(s_new.len);
+    esp_err_t second = ota_manager_upload_begin(s_new.len);
+    esp_err_t pull = ota_manager_start_update(url);
+    ota_manager_upload_abort("Upload interrupted");
+    esp_err_t after = ota_manager_upload_begin(s_new.len);
+    ota_manager_upload_abort("Upload interrupted");
+
+    bool ok = first == ESP_OK && second == ESP_ERR_INVALID_STATE &&
+              pull == ESP_ERR_INVALID_STATE && after == ESP_OK;
+    boot_end(ok ? ESP_OK : ESP_FAIL, false);
+}
+
+static void test_upload(void)
+{
+    char name[64];
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        snprintf(name, sizeof(name), "upload %s", s_files[i].name);
+        reset_device();
+        upload(name, s_files[i].data, s_files[i].len, s_files[i].len, 0);
+        check_updated(name);
+    }
+
+    // Image d'une autre cible: refusée (400) avant tout effacement
+    host_flash_stats_t stats;
+    reset_device();
+    upload("upload foreign.bin", s_foreign, s_new.len, s_new.len, 0);
+    check_refused("upload foreign.bin");
+    CHECK_EQ(s_shared->err, ESP_ERR_OTA_VALIDATE_FAILED);
+    host_flash_get_stats(&stats);
+    CHECK_EQ(stats.erases, 0);
+
+    // Corps plus court que Content-Length: image incomplète (400)
+    reset_device();
+    upload("upload truncated", s_new.data, s_new.len, s_new.len / 2, 0);
+    check_refused("upload truncated");
+    CHECK_EQ(s_shared->err, ESP_ERR_INVALID_SIZE);
+
+    reset_device();
+    fork_device("upload busy", device_upload_busy, NULL);
+    CHECK_EQ(s_shared->err, ESP_OK);
+    CHECK_EQ(s_shared->http.requests, 0);
+    CHECK(host_ota_boot_partition() == NULL);
+}
+
+/**
+ * Coupe le courant pendant la mise à jour depuis path, au-delà de cut octets
+ * de l'image écrits en flash
+ */
+static void power_loss(const char *path, uint32_t cut)
+{
+    reset_device();
+    s_shared->power_cut = cut;
+    boot(path);
+    s_shared->power_cut = 0;
+    CHECK(s_shared->power_lost);
+    CHECK(host_ota_boot_partition() == NULL);
+}
+
+static void test_power_loss(void)
+{
+    host_file_server_stats_t server;
+    char path[64];
+    for (size_t i = 0; i < 2; i++) {
+        // Image complète, compressée ou non: reprise au boot suivant
+        snprintf(path, sizeof(path), "/%s", s_files[i].name);
+        power_loss(path, 200000);
+        CHECK(s_shared->nvs_len != 0);
+        boot(NULL);
+        check_updated(path);
+        host_file_server_get_stats(&server);
+        CHECK_EQ(server.partial, 1);
+        CHECK(s_shared->http.body_bytes < s_files[i].len);
+    }
+
+    // Fichier republié entre les deux boots: If-Range ne correspond plus, tout est retéléchargé
+    power_loss("/new.bin", 200000);
+    host_file_server_set_etag("/new.bin", "\"republished\"");
+    boot(NULL);
+    check_updated("/new.bin (republished)");
+    host_file_server_get_stats(&server);
+    CHECK_EQ(server.partial, 0);
+    CHECK_EQ(s_shared->http.body_bytes, s_new.len);
+
+    // Secteur déjà écrit modifié depuis le point de reprise: téléchargement recommencé
+    power_loss("/new.bin", 200000);
+    host_flash_data(host_flash_partition(1))[4096] ^= 0xff;
+    boot(NULL);
+    check_updated("/new.bin (flash changed)");
+    host_file_server_get_stats(&server);
+    CHECK_EQ(server.partial, 0);
+    CHECK_EQ(s_shared->http.body_bytes, s_new.len);
+
+    // Un patch ne laisse pas de point de reprise: rien à reprendre, nouvelle mise à jour complète
+    power_loss("/new.mdl", 200000);
+    CHECK_EQ(s_shared->nvs_len, 0);
+    boot(NULL);
+    CHECK_EQ(s_shared->err, ESP_ERR_NOT_FOUND);
+    CHECK_EQ(s_shared->http.requests, 0);
+    boot("/new.mdl");
+    check_updated("/new.mdl (after power loss)");
+}
+
+static void measure(uint32_t rate_kbps)
+{
+    char path[64];
+    host_file_server_set_link(rate_kbps * 1024, 0);
+    printf("Link %u KB/s, image %zu bytes: pulled by URL / pushed by POST /api/ota_upload\n",
+           rate_kbps, s_new.len);
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        snprintf(path, sizeof(path), "/%s", s_files[i].name);
+        reset_device();
+        boot(path);
+        check_updated(path);
+        double pull_ms = s_shared->elapsed_us / 1000.0;
+        uint64_t wire_bytes = s_shared->http.body_bytes;
+        uint32_t requests = s_shared->http.requests;
+
+        snprintf(path, sizeof(path), "upload %s", s_files[i].name);
+        reset_device();
+        upload(path, s_files[i].data, s_files[i].len, s_files[i].len, rate_kbps);
+        check_updated(path);
+        double upload_ms = s_shared->elapsed_us / 1000.0;
+
+        printf("  %-12s %7llu wire bytes (%5.1f%%)  %u requests  %6.0f ms %5.0f KB/s  /  upload %6.0f ms %5.0f KB/s\n",
+               s_files[i].name, (unsigned long long)wire_bytes, 100.0 * wire_bytes / s_new.len, requests,
+               pull_ms, s_files[i].len / 1.024 / pull_ms, upload_ms, s_files[i].len / 1.024 / upload_ms);
+    }
+    host_file_server_set_link(0, 0);
+}
+
+/**
+ * Sur la cible, la réception s'arrête aussi pendant les opérations flash (cache
+ * coupé sur les deux cœurs): cette mesure ne le simule pas et donne donc le
+ * gain maximal d'une écriture en parallèle.
+ */
+static void measure_flash(void)
+{
+    uint32_t sectors = (s_new.len + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE;
+    double link_ms = s_new.len * 1000.0 / (SLOW_LINK_RATE_KBPS * 1024);
+    double flash_ms = sectors * (FLASH_ERASE_US + FLASH_WRITE_US) / 1000.0;
+    double bound_ms = link_ms > flash_ms ? link_ms : flash_ms;
+
+    host_file_server_set_link(SLOW_LINK_RATE_KBPS * 1024, 0);
+    host_flash_set_timing(FLASH_ERASE_US, FLASH_WRITE_US);
+    reset_device();
+    boot("/new.bin");
+    check_updated("/new.bin (flash timing)");
+    host_flash_set_timing(0, 0);
+    host_file_server_set_link(0, 0);
+
+    double ms = s_shared->elapsed_us / 1000.0;
+    printf("Link %u KB/s, flash %u ms erase + %u ms write per sector: %s in %.0f ms\n",
+           SLOW_LINK_RATE_KBPS, FLASH_ERASE_US / 1000, FLASH_WRITE_US / 1000, s_new.name, ms);
+    printf("  link alone %.0f ms, flash alone %.0f ms: full overlap would save at most %.0f ms (%.1f%%)\n",
+           link_ms, flash_ms, ms - bound_ms, 100 * (ms - bound_ms) / ms);
+}
+
+/**
+ * Lectures de 4 KB puis taille adaptée, pour plusieurs coûts par lecture
+ */
+static void measure_read_size(uint32_t rate_kbps)
+{
+    static const uint32_t overheads_us[] = { 0, 2000, 5000 };
+
+    host_file_server_set_link(rate_kbps * 1024, 0);
+    printf("Link %u KB/s, %s: read size fixed at %d bytes / adapted to throughput\n",
+           rate_kbps, s_new.name, FIXED_READ_SIZE);
+    for (size_t i = 0; i < sizeof(overheads_us) / sizeof(overheads_us[0]); i++) {
+        double ms[2];
+        uint32_t reads[2];
+        for (int adaptive = 0; adaptive <= 1; adaptive++) {
+            s_shared->read_overhead_us = overheads_us[i];
+            s_shared->read_size = adaptive ? 0 : FIXED_READ_SIZE;
+            reset_device();
+            boot("/new.bin");
+            check_updated("/new.bin (read size)");
+            ms[adaptive] = s_shared->elapsed_us / 1000.0;
+            reads[adaptive] = s_shared->http.reads;
+        }
+        // Jamais moins de 4 KB par lecture, sauf lente (plus d'une seconde)
+        CHECK(reads[1] <= reads[0]);
+        printf("  %u ms per read: %6.0f ms, %3u reads / %6.0f ms, %3u reads\n",
+               overheads_us[i] / 1000, ms[0], reads[0], ms[1], reads[1]);
+    }
+    s_shared->read_overhead_us = 0;
+    s_shared->read_size = 0;
+    host_file_server_set_link(0, 0);
+}
+
+static bool load(const char *dir, image_t *image)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, image->name);
+    image->data = host_read_file(path, &image->len);
+    return image->data != NULL;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <image dir> [link KB/s]\n", argv[0]);
+        return 2;
+    }
+    uint32_t rate_kbps = argc == 3 ? (uint32_t)atoi(argv[2]) : LINK_RATE_KBPS;
+
+    bool loaded = load(argv[1], &s_old) && load(argv[1], &s_new);
+    for (size_t i = 0; loaded && i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        loaded = load(argv[1], &s_files[i]);
+    }
+    if (!loaded) {
+        return 2;
+    }
+
+    // Mémoire partagée créée avant le premier fork
+    s_shared = mmap(NULL, sizeof(*s_shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (s_shared == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    memcpy(host_flash_data(host_flash_partition(0)), s_old.data, s_old.len);
+    host_ota_reset_boot_partition();
+
+    s_port = host_file_server_start();
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/%s", s_files[i].name);
+        host_file_server_add(path, s_files[i].data, s_files[i].len);
+    }
+
+    // Image d'une autre puce (chip_id de l'en-tête)
+    s_foreign = malloc(s_new.len);
+    memcpy(s_foreign, s_new.data, s_new.len);
+    s_foreign[12] ^= 0x01;
+    host_file_server_add("/foreign.bin", s_foreign, s_new.len);
+
+    // Deuxième bloc deflate de type invalide (BTYPE=3), puis fichier coupé en deux
+    const image_t *mdz = &s_files[1];
+    uint8_t *corrupt = malloc(mdz->len);
+    memcpy(corrupt, mdz->data, mdz->len);
+    uint32_t frame_len;
+    memcpy(&frame_len, corrupt + 12, sizeof(frame_len));
+    corrupt[12 + 4 + frame_len + 4] = 0xff;
+    host_file_server_add("/corrupt.mdz", corrupt, mdz->len);
+    host_file_server_add("/truncated.mdz", mdz->data, mdz->len / 2);
+
+    test_formats();
+    test_refused();
+    test_dropped();
+    test_power_loss();
+    test_upload();
+    measure(rate_kbps);
+    measure_flash();
+    measure_read_size(rate_kbps);
+
+    free(s_foreign);
+    free(corrupt);
+    free(s_old.data);
+    free(s_new.data);
+    for (size_t i = 0; i < sizeof(s_files) / sizeof(s_files[0]); i++) {
+        free(s_files[i].data);
+    }
+    return HOST_TEST_RESULT();
+}
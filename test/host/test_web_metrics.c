@@ -0,0 +1,355 @@
+// Tests de la sortie /api/metrics (web_metrics.c)
+//
+// Des requêtes sont enregistrées sur deux routes, dont deux de plus de 4295 s
+// (au-delà de 32 bits en µs), avec des octets émis par la fonction d'envoi de
+// la session sur une socketpair. La sortie est ensuite analysée ligne à ligne:
+// format d'exposition texte de Prometheus (HELP puis TYPE avant chaque
+// famille, noms, labels, valeurs, suffixe _total des compteurs), histogrammes
+// cumulés et cohérents avec _count, somme et octets sur 64 bits, compteurs du
+// résolveur et du serveur DNS.
+//
+// Usage: test_web_metrics
+#include "web_metrics.h"
+#include "dns_resolver.h"
+#include "dns_server.h"
+#include "host_httpd.h"
+#include "host_test.h"
+#include "esp_timer.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define STATUS_REQUESTS 10
+#define STATUS_BYTES 100
+#define LONG_REQUEST_US 5000000000LL    // 5000 s: plus de UINT32_MAX µs
+#define MAX_FAMILIES 64
+
+// Composants DNS: compteurs fixes
+
+void dns_resolver_get_stats(dns_resolver_stats_t *stats)
+{
+    *stats = (dns_resolver_stats_t){
+        .hits = 3000000000u, .misses = 12, .failures = 1, .saved_ms = 1234567,
+    };
+}
+
+void dns_server_get_stats(dns_server_stats_t *stats)
+{
+    *stats = (dns_server_stats_t){
+        .a = 40, .aaaa = 7, .https = 5, .ptr = 2, .other = 1, .errors = 3,
+        .cache_hits = 36, .cache_misses = 4, .rate_limited = 9,
+    };
+}
+
+static int s_peer = -1;                 // Extrémité lue de la socketpair
+
+/**
+ * Réponse de /api/status, émise comme le ferait httpd_resp_send: par la
+ * fonction d'envoi de la session, remplacée par web_metrics_call()
+ */
+static esp_err_t status_handler(httpd_req_t *req)
+{
+    host_httpd_t *host = req->aux;
+    char body[STATUS_BYTES];
+    memset(body, 'x', sizeof(body));
+    CHECK(host->send_override != NULL);
+    if (host->send_override) {
+        CHECK_EQ(host->send_override(req->handle, host->sockfd, body, sizeof(body), 0), sizeof(body));
+        char sink[STATUS_BYTES];
+        CHECK_EQ(read(s_peer, sink, sizeof(sink)), sizeof(sink));
+    }
+    return ESP_OK;
+}
+
+static void record_requests(void)
+{
+    int sv[2];
+    CHECK_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    s_peer = sv[1];
+
+    web_metrics_entry_t *status = web_metrics_entry(HTTP_GET, "/api/status");
+    web_metrics_entry_t *upload = web_metrics_entry(HTTP_POST, "/api/ota_upload");
+    CHECK(status != NULL && upload != NULL && status != upload);
+    CHECK(web_metrics_entry(HTTP_GET, "/api/status") == status);
+
+    httpd_req_t req;
+    host_httpd_t host;
+    for (int i = 0; i < STATUS_REQUESTS; i++) {
+        host_httpd_req_init(&req, &host, "/api/status", NULL);
+        host.sockfd = sv[0];
+        CHECK_EQ(web_metrics_call(status, &req, status_handler), ESP_OK);
+    }
+
+    // Durée de 5000 s: bucket +Inf, pas de troncature à 32 bits
+    for (int i = 0; i < 2; i++) {
+        host_httpd_req_init(&req, &host, "/api/ota_upload", NULL);
+        req.user_ctx = upload;
+        web_metrics_sample_t sample = { .start_us = esp_timer_get_time() - LONG_REQUEST_US };
+        web_metrics_end(&req, &sample);
+    }
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+typedef struct {
+    char name[96];
+    char type[16];
+} family_t;
+
+static bool valid_name(const char *name, size_t len)
+{
+    if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_' || name[0] == ':')) {
+        return false;
+    }
+    for (size_t i = 1; i < len; i++) {
+        if (!(isalnum((unsigned char)name[i]) || name[i] == '_' || name[i] == ':')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Labels {a="x",b="y"}: retourne la longueur, 0 si invalides
+ */
+static size_t parse_labels(const char *p)
+{
+    const char *start = p++;
+    while (*p != '}') {
+        size_t name_len = strcspn(p, "=");
+        if (!valid_name(p, name_len) || p[name_len + 1] != '"') {
+            return 0;
+        }
+        p += name_len + 2;
+        while (*p != '"') {
+            if (*p == '\0' || *p == '\n' || (*p == '\\' && p[1] == '\0')) {
+                return 0;
+            }
+            p += *p == '\\' ? 2 : 1;
+        }
+        p++;
+        if (*p == ',') {
+            p++;
+        } else if (*p != '}') {
+            return 0;
+        }
+    }
+    return (size_t)(p + 1 - start);
+}
+
+static const family_t *find_family(const family_t *families, int count, const char *name, size_t len)
+{
+    for (int i = 0; i < count; i++) {
+        if (strlen(families[i].name) == len && strncmp(families[i].name, name, len) == 0) {
+            return &families[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Famille d'une série: nom exact, ou histogramme avec suffixe _bucket/_sum/_count
+ */
+static const family_t *series_family(const family_t *families, int count, const char *name, size_t len)
+{
+    const family_t *family = find_family(families, count, name, len);
+    if (family) {
+        return strcmp(family->type, "histogram") == 0 ? NULL : family;
+    }
+    static const char *suffixes[] = { "_bucket", "_sum", "_count" };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t suffix_len = strlen(suffixes[i]);
+        if (len > suffix_len && strncmp(name + len - suffix_len, suffixes[i], suffix_len) == 0) {
+            family = find_family(families, count, name, len - suffix_len);
+            if (family && strcmp(family->type, "histogram") == 0) {
+                return family;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Vérifie chaque ligne de la sortie; retourne le nombre de séries
+ */
+static int check_format(const char *text)
+{
+    family_t families[MAX_FAMILIES];
+    int family_count = 0;
+    int series = 0;
+    char help[96] = "";
+
+    for (const char *line = text; *line; ) {
+        const char *end = strchr(line, '\n');
+        if (!end) {
+            fprintf(stderr, "Last line not terminated: %s\n", line);
+            host_test_failures++;
+            break;
+        }
+        int len = (int)(end - line);
+        bool ok = false;
+
+        if (strncmp(line, "# HELP ", 7) == 0) {
+            const char *name = line + 7;
+            size_t name_len = strcspn(name, " \n");
+            ok = valid_name(name, name_len) && name[name_len] == ' ' && name + name_len + 1 < end &&
+                 !find_family(families, family_count, name, name_len) && name_len < sizeof(help);
+            if (ok) {
+                snprintf(help, sizeof(help), "%.*s", (int)name_len, name);
+            }
+        } else if (strncmp(line, "# TYPE ", 7) == 0) {
+            const char *name = line + 7;
+            size_t name_len = strcspn(name, " \n");
+            const char *type = name + name_len + 1;
+            int type_len = (int)(end - type);
+            bool counter = type_len == 7 && strncmp(type, "counter", 7) == 0;
+            bool known = counter || (type_len == 5 && strncmp(type, "gauge", 5) == 0) ||
+                         (type_len == 9 && strncmp(type, "histogram", 9) == 0);
+            // HELP juste avant; un compteur se termine par _total
+            ok = known && family_count < MAX_FAMILIES && strlen(help) == name_len &&
+                 strncmp(help, name, name_len) == 0 &&
+                 (!counter || (name_len > 6 && strncmp(name + name_len - 6, "_total", 6) == 0));
+            if (ok) {
+                snprintf(families[family_count].name, sizeof(families[0].name), "%s", help);
+                snprintf(families[family_count].type, sizeof(families[0].type), "%.*s", type_len, type);
+                family_count++;
+            }
+            help[0] = '\0';
+        } else {
+            size_t name_len = strcspn(line, "{ \n");
+            const char *p = line + name_len;
+            size_t labels_len = *p == '{' ? parse_labels(p) : 0;
+            ok = valid_name(line, name_len) && (*p != '{' || labels_len > 0) &&
+                 series_family(families, family_count, line, name_len) != NULL;
+            p += labels_len;
+            if (ok && *p == ' ') {
+                char *value_end;
+                double value = strtod(p + 1, &value_end);
+                ok = value_end == end && p + 1 < end && value >= 0;
+            } else {
+                ok = false;
+            }
+            series++;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid metrics line: %.*s\n", len, line);
+            host_test_failures++;
+        }
+        line = end + 1;
+    }
+    return series;
+}
+
+/**
+ * Valeur de la série donnée (nom et labels exacts), NAN si absente
+ */
+static double series_value(const char *text, const char *series)
+{
+    size_t len = strlen(series);
+    for (const char *line = text; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL) {
+        if (strncmp(line, series, len) == 0 && line[len] == ' ') {
+            return strtod(line + len + 1, NULL);
+        }
+    }
+    fprintf(stderr, "Missing series %s\n", series);
+    host_test_failures++;
+    return NAN;
+}
+
+/**
+ * Valeur entière exacte (pas d'arrondi double), UINT64_MAX si absente
+ */
+static uint64_t series_u64(const char *text, const char *series)
+{
+    size_t len = strlen(series);
+    for (const char *line = text; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL) {
+        if (strncmp(line, series, len) == 0 && line[len] == ' ') {
+            return strtoull(line + len + 1, NULL, 10);
+        }
+    }
+    fprintf(stderr, "Missing series %s\n", series);
+    host_test_failures++;
+    return UINT64_MAX;
+}
+
+static void check_histogram(const char *text, const char *labels, uint64_t count)
+{
+    static const char *bounds[] = {
+        "0.000100", "0.000500", "0.001000", "0.005000", "0.010000",
+        "0.050000", "0.100000", "0.500000", "1.000000", "5.000000", "+Inf",
+    };
+    char series[160];
+    uint64_t previous = 0;
+    for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+        snprintf(series, sizeof(series), "miniot_http_request_duration_seconds_bucket{%s,le=\"%s\"}",
+                 labels, bounds[i]);
+        uint64_t cumulative = series_u64(text, series);
+        CHECK(cumulative >= previous);
+        previous = cumulative;
+    }
+    CHECK_EQ(previous, count);
+    snprintf(series, sizeof(series), "miniot_http_request_duration_seconds_count{%s}", labels);
+    CHECK_EQ(series_u64(text, series), count);
+}
+
+static void test_output(void)
+{
+    httpd_req_t req;
+    static host_httpd_t host;
+    host_httpd_req_init(&req, &host, "/api/metrics", NULL);
+    CHECK_EQ(web_metrics_handler(&req), ESP_OK);
+    CHECK(host.chunked_done);
+    CHECK(strncmp(host.type, "text/plain; version=0.0.4", 25) == 0);
+    CHECK(host.response_len < sizeof(host.response));
+    host.response[host.response_len] = '\0';
+    const char *text = host.response;
+
+    int series = check_format(text);
+
+    // Histogrammes
+    check_histogram(text, "method=\"GET\",uri=\"/api/status\"", STATUS_REQUESTS);
+    check_histogram(text, "method=\"POST\",uri=\"/api/ota_upload\"", 2);
+    CHECK_EQ(series_u64(text, "miniot_http_request_duration_seconds_bucket"
+                              "{method=\"POST\",uri=\"/api/ota_upload\",le=\"5.000000\"}"), 0);
+    double sum = series_value(text, "miniot_http_request_duration_seconds_sum"
+                                    "{method=\"POST\",uri=\"/api/ota_upload\"}");
+    CHECK(sum >= 2 * LONG_REQUEST_US / 1e6 && sum < 2 * LONG_REQUEST_US / 1e6 + 1);
+    CHECK(series_value(text, "miniot_http_request_duration_seconds_sum"
+                             "{method=\"GET\",uri=\"/api/status\"}") < 1);
+
+    // Octets émis par la fonction d'envoi de la session
+    CHECK_EQ(series_u64(text, "miniot_http_response_bytes_total{method=\"GET\",uri=\"/api/status\"}"),
+             STATUS_REQUESTS * STATUS_BYTES);
+    CHECK_EQ(series_u64(text, "miniot_http_response_bytes_total{method=\"POST\",uri=\"/api/ota_upload\"}"), 0);
+    CHECK_EQ(series_u64(text, "miniot_http_metrics_recorded_total"), STATUS_REQUESTS + 2);
+
+    // DNS
+    CHECK_EQ(series_u64(text, "miniot_dns_resolver_cache_hits_total"), 3000000000u);
+    CHECK_EQ(series_u64(text, "miniot_dns_resolver_cache_misses_total"), 12);
+    CHECK_EQ(series_u64(text, "miniot_dns_resolver_failures_total"), 1);
+    CHECK(strstr(text, "\nminiot_dns_resolver_saved_seconds_total 1234.567\n") != NULL);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_queries_total{type=\"A\"}"), 40);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_queries_total{type=\"AAAA\"}"), 7);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_queries_total{type=\"HTTPS\"}"), 5);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_queries_total{type=\"PTR\"}"), 2);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_queries_total{type=\"other\"}"), 1);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_errors_total"), 3);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_cache_hits_total"), 36);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_cache_misses_total"), 4);
+    CHECK_EQ(series_u64(text, "miniot_dns_server_rate_limited_total"), 9);
+
+    printf("%zu bytes, %d series, %d chunks\n", host.response_len, series, host.chunks);
+}
+
+int main(void)
+{
+    record_requests();
+    test_output();
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,167 @@
+// Tests du service de l'interface web embarquée (web_ui.c)
+//
+// Les assets sont ceux du firmware, préparés par build_web_ui.py au build et
+// liés sous les symboles de target_add_binary_data. Sont vérifiés: l'analyse
+// d'Accept-Encoding, la forme gzip envoyée telle quelle, la forme identity
+// décompressée par tinfl identique au contenu minifié, Vary et ETag sur
+// toutes les réponses (304 compris) et le 404 des anciens hash.
+//
+// Usage: test_web_ui
+#include "web_ui.h"
+#include "web_assets.h"
+#include "host_httpd.h"
+#include "host_test.h"
+#include <string.h>
+#include <zlib.h>
+
+// Équivalent de target_add_binary_data: fichiers .gz générés dans WEB_UI_OUT_DIR
+#define WEB_UI_BLOB(file, sym) \
+    __asm__(".section .rodata\n.global " sym "\n" sym ":\n.incbin \"" WEB_UI_OUT_DIR "/" file "\"\n.previous\n")
+WEB_UI_BLOB("app.css.gz", "_binary_app_css_gz_start");
+WEB_UI_BLOB("app.js.gz", "_binary_app_js_gz_start");
+WEB_UI_BLOB("index.html.gz", "_binary_index_html_gz_start");
+
+static void test_accept_encoding(void)
+{
+    static const struct {
+        const char *header;             // NULL: en-tête absent
+        bool accepted;
+    } cases[] = {
+        { NULL, true },
+        { "", true },
+        { "gzip", true },
+        { "GZip", true },
+        { "gzip, deflate, br", true },
+        { "br,gzip", true },
+        { " \tgzip ;q=1", true },
+        { "gzip;q=0.5", true },
+        { "deflate, br", false },
+        { "identity", false },
+        { "x-gzip", false },
+        { "gzip;q=0", false },
+        { "gzip; q=0.000", false },
+        { "*", true },
+        { "*;q=0", false },
+        { "br, *;q=0.1", true },
+        { "gzip;q=0, *", false },       // Le codage nommé l'emporte sur "*"
+        { "*;q=0, gzip", true },
+        // Tronqué à 127 caractères: gzip n'est plus examiné
+        { "a-very-long-encoding-name-1, a-very-long-encoding-name-2, a-very-long-encoding-name-3, "
+          "a-very-long-encoding-name-4, a-very-long-encoding-name-5, gzip", false },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        httpd_req_t req;
+        host_httpd_t host;
+        host_httpd_req_init(&req, &host, "/", NULL);
+        if (cases[i].header) {
+            host_httpd_add_header(&host, "Accept-Encoding", cases[i].header);
+        }
+        if (web_ui_accepts_encoding(&req, "gzip") != cases[i].accepted) {
+            fprintf(stderr, "Accept-Encoding '%s': expected %s\n",
+                    cases[i].header ? cases[i].header : "(absent)",
+                    cases[i].accepted ? "accepted" : "refused");
+            host_test_failures++;
+        }
+    }
+}
+
+/**
+ * Décompresse un asset avec zlib (référence indépendante de tinfl), fenêtre
+ * du device: une distance au-delà de WEB_UI_WINDOW_BITS est une erreur
+ */
+static size_t gunzip(const web_asset_t *asset, uint8_t *out, size_t size)
+{
+    z_stream z = { 0 };
+    CHECK_EQ(inflateInit2(&z, 16 + WEB_UI_WINDOW_BITS), Z_OK);
+    z.next_in = (Bytef *)asset->data;
+    z.avail_in = (uInt)asset->len;
+    z.next_out = out;
+    z.avail_out = (uInt)size;
+    CHECK_EQ(inflate(&z, Z_FINISH), Z_STREAM_END);
+    size_t len = size - z.avail_out;
+    inflateEnd(&z);
+    return len;
+}
+
+static void serve(httpd_req_t *req, host_httpd_t *host, const char *uri,
+                  const char *accept_encoding, const char *if_none_match)
+{
+    host_httpd_req_init(req, host, uri, NULL);
+    if (accept_encoding) {
+        host_httpd_add_header(host, "Accept-Encoding", accept_encoding);
+    }
+    if (if_none_match) {
+        host_httpd_add_header(host, "If-None-Match", if_none_match);
+    }
+    CHECK_EQ(web_ui_handler(req), ESP_OK);
+}
+
+static void test_asset(const web_asset_t *asset)
+{
+    static uint8_t plain[HOST_HTTPD_RESPONSE_SIZE];
+    httpd_req_t req;
+    host_httpd_t host;
+    size_t plain_len = gunzip(asset, plain, sizeof(plain));
+    char weak_etag[40];
+    snprintf(weak_etag, sizeof(weak_etag), "W/%s", asset->etag);
+
+    // Forme gzip: données embarquées envoyées en une fois
+    serve(&req, &host, asset->uri, "gzip, deflate, br", NULL);
+    CHECK(strcmp(host.status, "200 OK") == 0);
+    CHECK(strcmp(host.type, asset->content_type) == 0);
+    CHECK_EQ(host.sends, 1);
+    CHECK(host.response_len == asset->len && memcmp(host.response, asset->data, asset->len) == 0);
+    CHECK(host_httpd_resp_header(&host, "Content-Encoding") != NULL);
+    CHECK(host_httpd_resp_header(&host, "Vary") != NULL);
+    CHECK(strcmp(host_httpd_resp_header(&host, "ETag"), asset->etag) == 0);
+    CHECK(strcmp(host_httpd_resp_header(&host, "Cache-Control"), asset->cache_control) == 0);
+
+    // Forme identity: décompressée par chunks, ETag faible
+    serve(&req, &host, asset->uri, "identity", NULL);
+    CHECK(strcmp(host.status, "200 OK") == 0);
+    CHECK(strcmp(host.type, asset->content_type) == 0);
+    CHECK_EQ(host.sends, 0);
+    CHECK(host.chunks >= 1 && host.chunked_done);
+    CHECK(host.response_len == plain_len && memcmp(host.response, plain, plain_len) == 0);
+    CHECK(host_httpd_resp_header(&host, "Content-Encoding") == NULL);
+    CHECK(host_httpd_resp_header(&host, "Vary") != NULL);
+    CHECK(strcmp(host_httpd_resp_header(&host, "ETag"), weak_etag) == 0);
+
+    // 304 pour l'une ou l'autre forme, Vary compris
+    const char *validators[] = { asset->etag, weak_etag };
+    for (int i = 0; i < 2; i++) {
+        serve(&req, &host, asset->uri, i == 0 ? "gzip" : "identity", validators[i]);
+        CHECK(strcmp(host.status, "304 Not Modified") == 0);
+        CHECK_EQ(host.response_len, 0);
+        CHECK(host_httpd_resp_header(&host, "Vary") != NULL);
+        CHECK(host_httpd_resp_header(&host, "ETag") != NULL);
+    }
+
+    printf("%-28s %5zu bytes gzip, %5zu bytes identity\n", asset->uri, asset->len, plain_len);
+}
+
+static void test_assets(void)
+{
+    CHECK_EQ(web_assets_count, 3);
+    for (size_t i = 0; i < web_assets_count; i++) {
+        test_asset(&web_assets[i]);
+    }
+
+    // Ancien hash après une mise à jour, query string ignorée
+    httpd_req_t req;
+    host_httpd_t host;
+    serve(&req, &host, "/assets/app.00000000.js", "gzip", NULL);
+    CHECK(strcmp(host.status, "404 Not Found") == 0);
+    serve(&req, &host, "/?lang=fr", "gzip", NULL);
+    CHECK(strcmp(host.status, "200 OK") == 0);
+    CHECK(host.response_len == web_assets[2].len);
+}
+
+int main(void)
+{
+    test_accept_encoding();
+    test_assets();
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,317 @@
+// Latence par endpoint sous clients concurrents, avec et sans le pool web_async
+//
+// Une tâche "httpd" unique traite les requêtes comme le serveur d'ESP-IDF.
+// Des clients interrogent en boucle les endpoints rapides (/api/status,
+// /api/ota_progress) pendant qu'un autre enchaîne les endpoints lents
+// (/api/configure et sa pause avant redémarrage du WiFi, /api/check_update et
+// son aller-retour TLS, durées réduites). La latence est mesurée côté client,
+// de l'envoi à la fin de la réponse, d'abord sans pool (handlers lents exécutés
+// dans la tâche httpd) puis avec. Pour finir, une rafale de requêtes lentes
+// dépasse workers + file et doit recevoir des 503.
+//
+// Usage: web_async_latency [durée de chaque phase en ms]
+#include "web_async.c"
+#include "json_writer.h"
+#include "host_httpd.h"
+#include "host_test.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CONFIGURE_DELAY_MS 200          // vTaskDelay de configure_handler (1 s sur la cible)
+#define CHECK_UPDATE_DELAY_MS 300       // Requête TLS vers l'API GitHub
+#define FAST_CLIENTS 3
+#define FAST_PERIOD_US 10000
+#define MAX_SAMPLES 4096
+#define FAST_MAX_P99_US 50000           // Borne large: l'hôte de CI peut être chargé
+
+// Mesure des workers: la latence est relevée par les clients
+void web_metrics_begin(web_metrics_sample_t *sample)
+{
+    sample->start_us = esp_timer_get_time();
+    sample->free_heap = 0;
+}
+
+void web_metrics_end(httpd_req_t *req, const web_metrics_sample_t *sample) {}
+void web_metrics_defer(void) {}
+
+/* Handlers, sur le modèle de web_server.c */
+
+static esp_err_t status_handler(httpd_req_t *req)
+{
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "mac", "84:F7:03:12:AB:CD");
+    json_writer_kv_string(&w, "state", "Connected");
+    json_writer_kv_string(&w, "ip", "192.168.1.42");
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+static esp_err_t ota_progress_handler(httpd_req_t *req)
+{
+    json_writer_t w;
+    json_writer_init_http(&w, req);
+    json_writer_begin_object(&w);
+    json_writer_kv_bool(&w, "in_progress", false);
+    json_writer_kv_int(&w, "percent", 0);
+    json_writer_kv_string(&w, "status", "Idle");
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+static esp_err_t configure_handler(httpd_req_t *req)
+{
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, configure_handler);
+    }
+    httpd_resp_sendstr(req, "{\"success\":true}");
+    vTaskDelay(pdMS_TO_TICKS(CONFIGURE_DELAY_MS));
+    return ESP_OK;
+}
+
+static esp_err_t check_update_handler(httpd_req_t *req)
+{
+    if (!web_async_is_worker()) {
+        return web_async_submit(req, check_update_handler);
+    }
+    vTaskDelay(pdMS_TO_TICKS(CHECK_UPDATE_DELAY_MS));
+    httpd_resp_sendstr(req, "{\"update_available\":false}");
+    return ESP_OK;
+}
+
+/* Serveur: une seule tâche, comme httpd_start */
+
+typedef struct {
+    host_httpd_t host;              // En premier: retrouvé depuis on_async_complete
+    httpd_req_t req;
+    esp_err_t (*handler)(httpd_req_t *req);
+    atomic_int events;              // Retour du handler + fins de requêtes asynchrones
+    SemaphoreHandle_t done;
+} client_request_t;
+
+static QueueHandle_t s_server_queue;
+
+/**
+ * La réponse est complète quand le handler a rendu la main et que chaque
+ * requête asynchrone qu'il a ouverte est terminée
+ */
+static void request_event(client_request_t *request)
+{
+    if (atomic_fetch_add(&request->events, 1) + 1 == 1 + request->host.async_begun) {
+        xSemaphoreGive(request->done);
+    }
+}
+
+static void on_async_complete(host_httpd_t *host)
+{
+    request_event((client_request_t *)host);
+}
+
+static void server_task(void *pvParameters)
+{
+    client_request_t *request;
+    while (xQueueReceive(s_server_queue, &request, portMAX_DELAY) == pdTRUE) {
+        request->handler(&request->req);
+        request_event(request);
+    }
+}
+
+static void request_init(client_request_t *request, const char *uri, esp_err_t (*handler)(httpd_req_t *req))
+{
+    SemaphoreHandle_t done = request->done ? request->done : xSemaphoreCreateBinary();
+    host_httpd_req_init(&request->req, &request->host, uri, NULL);
+    request->host.on_async_complete = on_async_complete;
+    request->handler = handler;
+    atomic_store(&request->events, 0);
+    request->done = done;
+}
+
+static void request_send(client_request_t *request)
+{
+    xQueueSend(s_server_queue, &request, portMAX_DELAY);
+}
+
+/**
+ * Envoie une requête et attend la réponse complète
+ * @return Latence en µs
+ */
+static uint32_t request_run(client_request_t *request, const char *uri, esp_err_t (*handler)(httpd_req_t *req))
+{
+    request_init(request, uri, handler);
+    uint64_t start = host_now_ns();
+    request_send(request);
+    xSemaphoreTake(request->done, portMAX_DELAY);
+    return (uint32_t)((host_now_ns() - start) / 1000);
+}
+
+/* Clients et statistiques */
+
+typedef struct {
+    const char *uri;
+    esp_err_t (*handler)(httpd_req_t *req);
+    uint32_t samples[MAX_SAMPLES];
+    atomic_size_t count;
+    atomic_int errors;              // Statut autre que 200 ou réponse vide
+} endpoint_t;
+
+static endpoint_t s_endpoints[] = {
+    { "/api/status", status_handler },
+    { "/api/ota_progress", ota_progress_handler },
+    { "/api/configure", configure_handler },
+    { "/api/check_update", check_update_handler },
+};
+#define ENDPOINT_STATUS 0
+#define ENDPOINT_CONFIGURE 2
+#define ENDPOINT_COUNT (sizeof(s_endpoints) / sizeof(s_endpoints[0]))
+
+static atomic_bool s_stop;
+
+static void endpoint_call(client_request_t *request, endpoint_t *endpoint)
+{
+    uint32_t latency = request_run(request, endpoint->uri, endpoint->handler);
+    if (strcmp(request->host.status, "200 OK") != 0 || request->host.response_len == 0) {
+        atomic_fetch_add(&endpoint->errors, 1);
+    }
+    size_t n = atomic_fetch_add(&endpoint->count, 1);
+    if (n < MAX_SAMPLES) {
+        endpoint->samples[n] = latency;
+    }
+}
+
+static void *fast_client(void *arg)
+{
+    static client_request_t requests[FAST_CLIENTS];
+    client_request_t *request = &requests[(intptr_t)arg];
+    for (int i = 0; !atomic_load(&s_stop); i++) {
+        endpoint_call(request, &s_endpoints[ENDPOINT_STATUS + i % 2]);
+        usleep(FAST_PERIOD_US);
+    }
+    return NULL;
+}
+
+static void *slow_client(void *arg)
+{
+    static client_request_t request;
+    for (int i = 0; !atomic_load(&s_stop); i++) {
+        endpoint_call(&request, &s_endpoints[ENDPOINT_CONFIGURE + i % 2]);
+    }
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(endpoint_t *endpoint, int pct)
+{
+    size_t count = atomic_load(&endpoint->count);
+    if (count > MAX_SAMPLES) {
+        count = MAX_SAMPLES;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    qsort(endpoint->samples, count, sizeof(uint32_t), compare_u32);
+    return endpoint->samples[(count - 1) * pct / 100];
+}
+
+/**
+ * Une phase: clients concurrents pendant duration_ms
+ * @return p99 le plus élevé des endpoints rapides (µs)
+ */
+static uint32_t run_phase(const char *name, int duration_ms)
+{
+    for (size_t i = 0; i < ENDPOINT_COUNT; i++) {
+        atomic_store(&s_endpoints[i].count, 0);
+        atomic_store(&s_endpoints[i].errors, 0);
+    }
+    atomic_store(&s_stop, false);
+
+    pthread_t fast[FAST_CLIENTS], slow;
+    for (intptr_t i = 0; i < FAST_CLIENTS; i++) {
+        pthread_create(&fast[i], NULL, fast_client, (void *)i);
+    }
+    pthread_create(&slow, NULL, slow_client, NULL);
+    usleep(duration_ms * 1000);
+    atomic_store(&s_stop, true);
+    for (int i = 0; i < FAST_CLIENTS; i++) {
+        pthread_join(fast[i], NULL);
+    }
+    pthread_join(slow, NULL);
+
+    uint32_t fast_p99 = 0;
+    printf("%s\n", name);
+    for (size_t i = 0; i < ENDPOINT_COUNT; i++) {
+        endpoint_t *endpoint = &s_endpoints[i];
+        uint32_t p50 = percentile(endpoint, 50);
+        uint32_t p99 = percentile(endpoint, 99);
+        printf("  %-18s p50 %7u us, p99 %7u us (%zu requests)\n",
+               endpoint->uri, p50, p99, atomic_load(&endpoint->count));
+        CHECK(atomic_load(&endpoint->count) > 0);
+        CHECK_EQ(atomic_load(&endpoint->errors), 0);
+        if (i < ENDPOINT_CONFIGURE && p99 > fast_p99) {
+            fast_p99 = p99;
+        }
+    }
+    return fast_p99;
+}
+
+/**
+ * Rafale de requêtes lentes: au-delà des workers et de la file, 503
+ */
+static void test_busy(void)
+{
+    enum { BURST = WEB_ASYNC_WORKERS + WEB_ASYNC_QUEUE_SIZE + 2 };
+    static client_request_t requests[BURST];
+
+    for (int i = 0; i < BURST; i++) {
+        request_init(&requests[i], "/api/configure", configure_handler);
+        request_send(&requests[i]);
+    }
+
+    int ok = 0, busy = 0;
+    for (int i = 0; i < BURST; i++) {
+        xSemaphoreTake(requests[i].done, portMAX_DELAY);
+        if (strcmp(requests[i].host.status, "200 OK") == 0) {
+            ok++;
+        } else if (strncmp(requests[i].host.status, "503", 3) == 0) {
+            busy++;
+        }
+    }
+    printf("Burst of %d slow requests: %d served, %d rejected with 503\n", BURST, ok, busy);
+    CHECK_EQ(ok + busy, BURST);
+    CHECK(ok >= WEB_ASYNC_QUEUE_SIZE);
+    CHECK(busy >= BURST - WEB_ASYNC_WORKERS - WEB_ASYNC_QUEUE_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    int duration_ms = argc > 1 ? atoi(argv[1]) : 2000;
+
+    s_server_queue = xQueueCreate(16, sizeof(client_request_t *));
+    xTaskCreate(server_task, "httpd", 4096, NULL, 5, NULL);
+
+    printf("%d fast clients every %d ms, one client chaining slow requests (%d ms, %d ms)\n",
+           FAST_CLIENTS, FAST_PERIOD_US / 1000, CONFIGURE_DELAY_MS, CHECK_UPDATE_DELAY_MS);
+
+    // Sans pool: web_async_submit exécute le handler dans la tâche httpd
+    uint32_t inline_p99 = run_phase("Slow handlers in the server task:", duration_ms);
+
+    CHECK_EQ(web_async_start(), ESP_OK);
+    uint32_t pool_p99 = run_phase("Slow handlers in web_async workers:", duration_ms);
+
+    // Les requêtes rapides n'attendent plus derrière les lentes
+    CHECK(inline_p99 >= CONFIGURE_DELAY_MS * 1000 / 2);
+    CHECK(pool_p99 < FAST_MAX_P99_US);
+
+    test_busy();
+
+    return HOST_TEST_RESULT();
+}
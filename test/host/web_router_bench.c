@@ -0,0 +1,161 @@
+// Routeur HTTP: chaque route retrouvée (query string ignorée, méthode vérifiée,
+// préfixes après les routes exactes), puis coût de sélection face à la
+// recherche d'esp_http_server (un handler par route, httpd_uri_match_wildcard
+// dans l'ordre d'enregistrement)
+//
+// Compilé pour la table du firmware et pour routes/web_routes_large.def
+// (WEB_ROUTES_DEF), chacune avec la table générée par build_routes.py.
+//
+// Usage: web_router_bench [recherches par mesure]
+#include "web_router.h"
+#include "web_metrics.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+web_metrics_entry_t *web_metrics_entry(httpd_method_t method, const char *uri) { return NULL; }
+
+esp_err_t web_metrics_call(web_metrics_entry_t *entry, httpd_req_t *req,
+                           esp_err_t (*handler)(httpd_req_t *req))
+{
+    return handler(req);
+}
+
+static esp_err_t route_handler(httpd_req_t *req)
+{
+    return ESP_OK;
+}
+
+static const web_route_t s_routes[] = {
+#define WEB_ROUTE(method, path, handler) { method, path, route_handler },
+#include WEB_ROUTES_DEF
+#undef WEB_ROUTE
+};
+#define ROUTE_COUNT (sizeof(s_routes) / sizeof(s_routes[0]))
+
+// Requêtes sans route: sondes de portail captif, chemins voisins des routes
+static const char *s_misses[] = {
+    "/generate_204", "/hotspot-detect.html", "/favicon.ico", "/api/statu",
+    "/api/status/", "/api/statusx", "/api", "/assets", "",
+};
+#define MISS_COUNT (sizeof(s_misses) / sizeof(s_misses[0]))
+
+/**
+ * Sélection d'esp_http_server: premier handler enregistré qui correspond
+ */
+static const web_route_t *linear_lookup(httpd_method_t method, const char *uri)
+{
+    size_t len = strcspn(uri, "?");
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        if (s_routes[i].method == method && httpd_uri_match_wildcard(s_routes[i].path, uri, len)) {
+            return &s_routes[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_prefix(const web_route_t *route)
+{
+    return route->path[strlen(route->path) - 1] == '*';
+}
+
+// URI de requête qui doit aboutir à la route i
+static void route_uri(size_t i, char *uri, size_t size)
+{
+    const char *path = s_routes[i].path;
+    if (is_prefix(&s_routes[i])) {
+        snprintf(uri, size, "%.*sapp.js", (int)strlen(path) - 1, path);
+    } else {
+        snprintf(uri, size, "%s%s", path, i % 2 ? "?t=1700000000" : "");
+    }
+}
+
+static void test_lookup(void)
+{
+    char uri[128];
+
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        const web_route_t *route = &s_routes[i];
+        route_uri(i, uri, sizeof(uri));
+        if (web_router_lookup(route->method, uri) != route) {
+            fprintf(stderr, "%s %s not routed to its handler\n", http_method_str(route->method), uri);
+            host_test_failures++;
+        }
+        CHECK(linear_lookup(route->method, uri) == route);
+
+        // Une autre méthode n'aboutit jamais à cette route
+        httpd_method_t other = route->method == HTTP_GET ? HTTP_POST : HTTP_GET;
+        CHECK(web_router_lookup(other, uri) != route);
+        CHECK(web_router_lookup(HTTP_PUT, uri) == NULL);
+    }
+
+    for (size_t i = 0; i < MISS_COUNT; i++) {
+        CHECK(web_router_lookup(HTTP_GET, s_misses[i]) == NULL);
+        CHECK(web_router_lookup(HTTP_POST, s_misses[i]) == NULL);
+    }
+}
+
+typedef struct {
+    httpd_method_t method;
+    char uri[128];
+} request_t;
+
+static uintptr_t s_checksum;
+
+static double measure(const web_route_t *(*lookup)(httpd_method_t, const char *),
+                      const request_t *requests, size_t count, long iterations)
+{
+    uint64_t start = host_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        const request_t *r = &requests[i % count];
+        s_checksum += (uintptr_t)lookup(r->method, r->uri);
+    }
+    return (double)(host_now_ns() - start) / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+
+    CHECK_EQ(web_router_start(NULL, s_routes, ROUTE_COUNT - 1, NULL), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(web_router_start(NULL, s_routes, ROUTE_COUNT, NULL), ESP_OK);
+    test_lookup();
+
+    // Toutes les routes à tour de rôle, plus une requête sans route sur dix
+    static request_t mix[ROUTE_COUNT + ROUTE_COUNT / 10 + 1];
+    size_t count = 0;
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        mix[count].method = s_routes[i].method;
+        route_uri(i, mix[count++].uri, sizeof(mix[0].uri));
+        if (i % 10 == 9) {
+            mix[count].method = HTTP_GET;
+            snprintf(mix[count++].uri, sizeof(mix[0].uri), "%s", s_misses[i / 10 % MISS_COUNT]);
+        }
+    }
+
+    // Dernière route exacte de la table: pire cas de la recherche linéaire
+    request_t last = { .method = HTTP_GET };
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        if (!is_prefix(&s_routes[i])) {
+            last.method = s_routes[i].method;
+            snprintf(last.uri, sizeof(last.uri), "%s", s_routes[i].path);
+        }
+    }
+
+    double router_mix = measure(web_router_lookup, mix, count, iterations);
+    double linear_mix = measure(linear_lookup, mix, count, iterations);
+    double router_last = measure(web_router_lookup, &last, 1, iterations);
+    double linear_last = measure(linear_lookup, &last, 1, iterations);
+
+    int prefixes = 0;
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        prefixes += is_prefix(&s_routes[i]);
+    }
+    printf("%zu routes (%d prefix), %ld lookups per run\n", ROUTE_COUNT, prefixes, iterations);
+    printf("  all routes + 10%% misses: perfect hash %6.1f ns, linear match %7.1f ns (x%.1f)\n",
+           router_mix, linear_mix, linear_mix / router_mix);
+    printf("  last route only:          perfect hash %6.1f ns, linear match %7.1f ns (x%.1f) %s\n",
+           router_last, linear_last, linear_last / router_last, last.uri);
+
+    return HOST_TEST_RESULT();
+}